@@ -0,0 +1,1103 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 ArthurPV
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#define _XOPEN_SOURCE 700
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "json.h"
+
+// Usage: json_bench [--runs N] [--scale N] [file.json | file.ndjson ...]
+//
+// Without files, the benchmark generates corpora shaped like the usual
+// twitter.json, canada.json and citm_catalog.json documents, plus a NDJSON
+// log. Files ending with `.ndjson` are parsed line by line.
+//
+// Each corpus is loaded and measured in its own child process, so that the
+// peak RSS column only accounts for that corpus.
+
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_DEFAULT_SCALE 1
+#define BENCH_LOOKUP_BATCH 1000
+#define BENCH_LOOKUP_BATCHES 16
+#define BENCH_LOOKUP_PATHS 64
+#define BENCH_LOOKUP_DEPTH 8
+
+#define FATAL(msg, ...) \
+	fprintf(stderr, "FATAL(%d): "msg"\n", __LINE__, ##__VA_ARGS__); \
+	exit(1);
+
+// Allocation counting relies on overriding the libc allocator, which is only
+// possible with glibc.
+#if defined(__GLIBC__)
+#define BENCH_COUNT_ALLOCATIONS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static size_t allocation_count = 0;
+
+void *
+malloc(size_t size)
+{
+	++allocation_count;
+
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t count, size_t size)
+{
+	++allocation_count;
+
+	return __libc_calloc(count, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	++allocation_count;
+
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+struct BenchBuffer {
+	char *buffer;
+	size_t len;
+	size_t capacity;
+};
+
+static inline struct BenchBuffer
+init__BenchBuffer(void);
+
+static void
+reserve__BenchBuffer(struct BenchBuffer *self, size_t additional);
+
+static void
+push__BenchBuffer(struct BenchBuffer *self, const char *s, size_t s_len);
+
+static void
+push_format__BenchBuffer(struct BenchBuffer *self, const char *fmt, ...);
+
+static void
+indent__BenchBuffer(struct BenchBuffer *self, size_t indent_width);
+
+static inline void
+deinit__BenchBuffer(const struct BenchBuffer *self);
+
+struct BenchRandom {
+	uint64_t state;
+};
+
+static inline uint64_t
+next__BenchRandom(struct BenchRandom *self);
+
+static inline uint64_t
+range__BenchRandom(struct BenchRandom *self, uint64_t min, uint64_t max);
+
+static inline double
+next_double__BenchRandom(struct BenchRandom *self);
+
+enum BenchCorpusKind {
+	BENCH_CORPUS_KIND_DOCUMENT,
+	BENCH_CORPUS_KIND_NDJSON
+};
+
+struct BenchCorpus {
+	const char *name;
+	enum BenchCorpusKind kind;
+	struct BenchBuffer content;
+};
+
+static void
+generate_twitter__BenchCorpus(struct BenchCorpus *self, size_t scale);
+
+static void
+generate_canada__BenchCorpus(struct BenchCorpus *self, size_t scale);
+
+static void
+generate_citm__BenchCorpus(struct BenchCorpus *self, size_t scale);
+
+static void
+generate_ndjson__BenchCorpus(struct BenchCorpus *self, size_t scale);
+
+static bool
+load__BenchCorpus(struct BenchCorpus *self, const char *path);
+
+static inline void
+deinit__BenchCorpus(const struct BenchCorpus *self);
+
+// A member of a document reached from its root, one member name or array
+// index per step.
+struct BenchPathStep {
+	const char *key; // NULL for an array index
+	size_t key_len;
+	size_t index;
+};
+
+struct BenchPath {
+	struct BenchPathStep steps[BENCH_LOOKUP_DEPTH];
+	size_t len;
+};
+
+// A uniform sample of the member paths of a document, nested ones included,
+// kept by reservoir sampling.
+struct BenchPaths {
+	struct BenchPath buffer[BENCH_LOOKUP_PATHS];
+	size_t len;
+	size_t seen;
+	struct BenchRandom random;
+};
+
+static void
+collect__BenchPaths(struct BenchPaths *self, const JSONValue *value, struct BenchPath *path);
+
+static inline const JSONValue *
+walk__BenchPath(const struct BenchPath *self, const JSONValue *value);
+
+struct BenchSamples {
+	double *buffer;
+	size_t len;
+};
+
+static inline struct BenchSamples
+init__BenchSamples(size_t capacity);
+
+static int
+compare_double__BenchSamples(const void *a, const void *b);
+
+static double
+percentile__BenchSamples(struct BenchSamples *self, double percentile);
+
+static inline void
+deinit__BenchSamples(const struct BenchSamples *self);
+
+struct BenchReport {
+	struct BenchSamples parse_seconds;
+	struct BenchSamples serialize_seconds;
+	struct BenchSamples lookup_nanoseconds;
+	size_t serialized_len;
+	size_t documents;
+	size_t allocations;
+};
+
+static inline double
+now__Bench(void);
+
+static inline long
+peak_rss_kib__Bench(void);
+
+static size_t
+count_documents__Bench(const struct BenchCorpus *corpus);
+
+static size_t
+next_document__Bench(const struct BenchCorpus *corpus, size_t offset, const char **document, size_t *document_len);
+
+static void
+run_once__Bench(const struct BenchCorpus *corpus, struct BenchReport *report, bool count_allocations);
+
+static void
+run__Bench(const struct BenchCorpus *corpus, size_t runs);
+
+static void
+run_isolated__Bench(const char *path, void (*generate)(struct BenchCorpus *, size_t), size_t scale, size_t runs);
+
+struct BenchBuffer
+init__BenchBuffer(void)
+{
+	return (struct BenchBuffer){
+		.buffer = NULL,
+		.len = 0,
+		.capacity = 0
+	};
+}
+
+void
+reserve__BenchBuffer(struct BenchBuffer *self, size_t additional)
+{
+	if (self->len + additional + 1 <= self->capacity) {
+		return;
+	}
+
+	size_t new_capacity = self->capacity ? self->capacity : 4096;
+
+	while (self->len + additional + 1 > new_capacity) {
+		new_capacity *= 2;
+	}
+
+	self->buffer = realloc(self->buffer, new_capacity);
+	self->capacity = new_capacity;
+
+	if (!self->buffer) {
+		FATAL("Out of memory");
+	}
+}
+
+void
+push__BenchBuffer(struct BenchBuffer *self, const char *s, size_t s_len)
+{
+	reserve__BenchBuffer(self, s_len);
+	memcpy(self->buffer + self->len, s, s_len);
+
+	self->len += s_len;
+	self->buffer[self->len] = 0;
+}
+
+void
+push_format__BenchBuffer(struct BenchBuffer *self, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+
+	int n = vsnprintf(NULL, 0, fmt, args);
+
+	va_end(args);
+
+	if (n < 0) {
+		FATAL("Invalid format");
+	}
+
+	reserve__BenchBuffer(self, n);
+	va_start(args, fmt);
+	vsnprintf(self->buffer + self->len, n + 1, fmt, args);
+	va_end(args);
+
+	self->len += n;
+}
+
+void
+indent__BenchBuffer(struct BenchBuffer *self, size_t indent_width)
+{
+	// Re-indent a compact document, the same way citm_catalog.json is
+	// pretty-printed.
+	struct BenchBuffer res = init__BenchBuffer();
+	size_t depth = 0;
+	bool in_string = false;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		char c = self->buffer[i];
+
+		if (in_string) {
+			push__BenchBuffer(&res, &c, 1);
+
+			if (c == '\\') {
+				push__BenchBuffer(&res, &self->buffer[++i], 1);
+			} else if (c == '"') {
+				in_string = false;
+			}
+
+			continue;
+		}
+
+		switch (c) {
+			case '"':
+				in_string = true;
+				push__BenchBuffer(&res, &c, 1);
+
+				break;
+			case '{':
+			case '[':
+				push__BenchBuffer(&res, &c, 1);
+
+				// Keep empty containers on one line.
+				if (i + 1 < self->len && (self->buffer[i + 1] == '}' || self->buffer[i + 1] == ']')) {
+					push__BenchBuffer(&res, &self->buffer[++i], 1);
+
+					break;
+				}
+
+				push_format__BenchBuffer(&res, "\n%*s", (int)(++depth * indent_width), "");
+
+				break;
+			case '}':
+			case ']':
+				push_format__BenchBuffer(&res, "\n%*s", (int)(--depth * indent_width), "");
+				push__BenchBuffer(&res, &c, 1);
+
+				break;
+			case ',':
+				push_format__BenchBuffer(&res, ",\n%*s", (int)(depth * indent_width), "");
+
+				break;
+			case ':':
+				push__BenchBuffer(&res, " : ", 3);
+
+				break;
+			default:
+				push__BenchBuffer(&res, &c, 1);
+		}
+	}
+
+	deinit__BenchBuffer(self);
+
+	*self = res;
+}
+
+void
+deinit__BenchBuffer(const struct BenchBuffer *self)
+{
+	free(self->buffer);
+}
+
+uint64_t
+next__BenchRandom(struct BenchRandom *self)
+{
+	// xorshift64*
+	self->state ^= self->state >> 12;
+	self->state ^= self->state << 25;
+	self->state ^= self->state >> 27;
+
+	return self->state * 0x2545F4914F6CDD1DULL;
+}
+
+uint64_t
+range__BenchRandom(struct BenchRandom *self, uint64_t min, uint64_t max)
+{
+	return min + next__BenchRandom(self) % (max - min + 1);
+}
+
+double
+next_double__BenchRandom(struct BenchRandom *self)
+{
+	return (next__BenchRandom(self) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static const char *bench_words[] = {
+	"lorem", "ipsum", "dolor", "sit", "amet", "json", "parser", "benchmark",
+	"\xe3\x81\x82\xe3\x82\x8a\xe3\x81\x8c\xe3\x81\xa8\xe3\x81\x86", // ありがとう
+	"\xe6\x9d\xb1\xe4\xba\xac", // 東京
+	"caf\xc3\xa9", "\xf0\x9f\x98\x81", "line\\nbreak", "\\u3042\\u3044",
+	"quote\\\"d", "slash\\/path"
+};
+
+#define BENCH_WORDS_LEN (sizeof(bench_words) / sizeof(*bench_words))
+
+static void
+push_sentence__BenchBuffer(struct BenchBuffer *self, struct BenchRandom *random, size_t words)
+{
+	for (size_t i = 0; i < words; ++i) {
+		const char *word = bench_words[range__BenchRandom(random, 0, BENCH_WORDS_LEN - 1)];
+
+		push_format__BenchBuffer(self, i ? " %s" : "%s", word);
+	}
+}
+
+void
+generate_twitter__BenchCorpus(struct BenchCorpus *self, size_t scale)
+{
+	struct BenchRandom random = { .state = 0x7477697474657231ULL };
+	struct BenchBuffer *b = &self->content;
+	size_t statuses = 100 * scale;
+
+	push__BenchBuffer(b, "{\"statuses\":[", 13);
+
+	for (size_t i = 0; i < statuses; ++i) {
+		uint64_t id = 505874924095815680ULL + range__BenchRandom(&random, 0, 1000000);
+		uint64_t user_id = range__BenchRandom(&random, 1000000, 3000000000ULL);
+
+		push_format__BenchBuffer(b,
+			"%s{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"},"
+			"\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"",
+			i ? "," : "", (unsigned long long)id, (unsigned long long)id);
+		push_sentence__BenchBuffer(b, &random, range__BenchRandom(&random, 4, 20));
+		push_format__BenchBuffer(b,
+			"\",\"source\":\"<a href=\\\"https://mobile.twitter.com\\\" rel=\\\"nofollow\\\">Mobile Web</a>\","
+			"\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_status_id_str\":null,"
+			"\"in_reply_to_user_id\":null,\"in_reply_to_user_id_str\":null,\"in_reply_to_screen_name\":null,"
+			"\"user\":{\"id\":%llu,\"id_str\":\"%llu\",\"name\":\"",
+			(unsigned long long)user_id, (unsigned long long)user_id);
+		push_sentence__BenchBuffer(b, &random, 2);
+		push_format__BenchBuffer(b,
+			"\",\"screen_name\":\"user_%zu\",\"location\":\"\",\"description\":\"",
+			i);
+		push_sentence__BenchBuffer(b, &random, range__BenchRandom(&random, 5, 25));
+		push_format__BenchBuffer(b,
+			"\",\"url\":null,\"entities\":{\"description\":{\"urls\":[]}},\"protected\":false,"
+			"\"followers_count\":%llu,\"friends_count\":%llu,\"listed_count\":%llu,"
+			"\"created_at\":\"Sun Mar 09 02:32:41 +0000 2014\",\"favourites_count\":%llu,"
+			"\"utc_offset\":null,\"time_zone\":null,\"geo_enabled\":false,\"verified\":false,"
+			"\"statuses_count\":%llu,\"lang\":\"ja\",\"contributors_enabled\":false,"
+			"\"is_translator\":false,\"is_translation_enabled\":false,"
+			"\"profile_background_color\":\"C0DEED\","
+			"\"profile_background_image_url\":\"http://abs.twimg.com/images/themes/theme1/bg.png\","
+			"\"profile_background_tile\":false,"
+			"\"profile_image_url\":\"http://pbs.twimg.com/profile_images/%llu/normal.jpeg\","
+			"\"profile_link_color\":\"0084B4\",\"profile_sidebar_border_color\":\"C0DEED\","
+			"\"profile_sidebar_fill_color\":\"DDEEF6\",\"profile_text_color\":\"333333\","
+			"\"profile_use_background_image\":true,\"default_profile\":true,"
+			"\"default_profile_image\":false,\"following\":false,\"follow_request_sent\":false,"
+			"\"notifications\":false},\"geo\":null,\"coordinates\":null,\"place\":null,"
+			"\"contributors\":null,\"retweet_count\":%llu,\"favorite_count\":%llu,"
+			"\"entities\":{\"hashtags\":[],\"symbols\":[],\"urls\":[{\"url\":\"http://t.co/%llx\","
+			"\"expanded_url\":\"http://example.com/%llu\",\"display_url\":\"example.com\","
+			"\"indices\":[%llu,%llu]}],\"user_mentions\":[{\"screen_name\":\"user_%llu\","
+			"\"name\":\"mention\",\"id\":%llu,\"id_str\":\"%llu\",\"indices\":[3,%llu]}]},"
+			"\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}",
+			(unsigned long long)range__BenchRandom(&random, 0, 100000),
+			(unsigned long long)range__BenchRandom(&random, 0, 5000),
+			(unsigned long long)range__BenchRandom(&random, 0, 100),
+			(unsigned long long)range__BenchRandom(&random, 0, 10000),
+			(unsigned long long)range__BenchRandom(&random, 0, 100000),
+			(unsigned long long)next__BenchRandom(&random) % 1000000000000ULL,
+			(unsigned long long)range__BenchRandom(&random, 0, 1000),
+			(unsigned long long)range__BenchRandom(&random, 0, 1000),
+			(unsigned long long)next__BenchRandom(&random),
+			(unsigned long long)range__BenchRandom(&random, 0, 1000000),
+			(unsigned long long)range__BenchRandom(&random, 0, 40),
+			(unsigned long long)range__BenchRandom(&random, 41, 140),
+			(unsigned long long)range__BenchRandom(&random, 0, 100000),
+			(unsigned long long)user_id + 1,
+			(unsigned long long)user_id + 1,
+			(unsigned long long)range__BenchRandom(&random, 4, 20));
+	}
+
+	push_format__BenchBuffer(b,
+		"],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,"
+		"\"max_id_str\":\"505874924095815681\",\"next_results\":\"?max_id=505874847260352512&q=%%E4%%B8%%80&count=100&include_entities=1\","
+		"\"query\":\"%%E4%%B8%%80\",\"refresh_url\":\"?since_id=505874924095815681&q=%%E4%%B8%%80&include_entities=1\","
+		"\"count\":%zu,\"since_id\":0,\"since_id_str\":\"0\"}}",
+		statuses);
+
+	self->name = "twitter";
+	self->kind = BENCH_CORPUS_KIND_DOCUMENT;
+}
+
+void
+generate_canada__BenchCorpus(struct BenchCorpus *self, size_t scale)
+{
+	struct BenchRandom random = { .state = 0x63616e6164613132ULL };
+	struct BenchBuffer *b = &self->content;
+	size_t rings = 480 * scale;
+
+	push_format__BenchBuffer(b,
+		"{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\","
+		"\"properties\":{\"name\":\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[");
+
+	for (size_t i = 0; i < rings; ++i) {
+		size_t points = range__BenchRandom(&random, 20, 214);
+		double x = -140.0 + next_double__BenchRandom(&random) * 88.0;
+		double y = 42.0 + next_double__BenchRandom(&random) * 40.0;
+
+		push__BenchBuffer(b, i ? ",[" : "[", i ? 2 : 1);
+
+		for (size_t j = 0; j < points; ++j) {
+			x += (next_double__BenchRandom(&random) - 0.5) * 0.01;
+			y += (next_double__BenchRandom(&random) - 0.5) * 0.01;
+
+			push_format__BenchBuffer(b, j ? ",[%.15f,%.15f]" : "[%.15f,%.15f]", x, y);
+		}
+
+		push__BenchBuffer(b, "]", 1);
+	}
+
+	push__BenchBuffer(b, "]}}]}", 5);
+
+	self->name = "canada";
+	self->kind = BENCH_CORPUS_KIND_DOCUMENT;
+}
+
+void
+generate_citm__BenchCorpus(struct BenchCorpus *self, size_t scale)
+{
+	struct BenchRandom random = { .state = 0x6369746d63617431ULL };
+	struct BenchBuffer *b = &self->content;
+	size_t events = 184 * scale;
+	size_t performances = 243 * scale;
+
+	push__BenchBuffer(b, "{\"areaNames\":{", 14);
+
+	for (size_t i = 0; i < 17; ++i) {
+		push_format__BenchBuffer(b, "%s\"%zu\":\"", i ? "," : "", 205705993 + i);
+		push_sentence__BenchBuffer(b, &random, 2);
+		push__BenchBuffer(b, "\"", 1);
+	}
+
+	push_format__BenchBuffer(b,
+		"},\"audienceSubCategoryNames\":{\"337100890\":\"Abonn\xc3\xa9\"},\"blockNames\":{},"
+		"\"events\":{");
+
+	for (size_t i = 0; i < events; ++i) {
+		uint64_t id = 138586341 + i;
+
+		push_format__BenchBuffer(b,
+			"%s\"%llu\":{\"description\":null,\"id\":%llu,\"logo\":\"/images/UE0AAAAACEKo6QAAAAZDSVRN\","
+			"\"name\":\"",
+			i ? "," : "", (unsigned long long)id, (unsigned long long)id);
+		push_sentence__BenchBuffer(b, &random, 3);
+		push_format__BenchBuffer(b,
+			"\",\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,"
+			"\"topicIds\":[324846099,107888604]}");
+	}
+
+	push__BenchBuffer(b, "},\"performances\":[", 18);
+
+	for (size_t i = 0; i < performances; ++i) {
+		size_t prices = range__BenchRandom(&random, 1, 6);
+
+		push_format__BenchBuffer(b,
+			"%s{\"eventId\":%llu,\"id\":%llu,\"logo\":\"/images/UE0AAAAACEKo6QAAAAZDSVRN\","
+			"\"name\":null,\"prices\":[",
+			i ? "," : "",
+			(unsigned long long)(138586341 + range__BenchRandom(&random, 0, events - 1)),
+			(unsigned long long)(339887544 + i));
+
+		for (size_t j = 0; j < prices; ++j) {
+			push_format__BenchBuffer(b,
+				"%s{\"amount\":%llu,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":%llu}",
+				j ? "," : "",
+				(unsigned long long)range__BenchRandom(&random, 10, 300) * 1000,
+				(unsigned long long)(338937295 + j));
+		}
+
+		push__BenchBuffer(b, "],\"seatCategories\":[", 20);
+
+		for (size_t j = 0; j < prices; ++j) {
+			push_format__BenchBuffer(b,
+				"%s{\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},{\"areaId\":205705998,\"blockIds\":[]}],"
+				"\"seatCategoryId\":%llu}",
+				j ? "," : "",
+				(unsigned long long)(338937295 + j));
+		}
+
+		push_format__BenchBuffer(b,
+			"],\"seatMapImage\":null,\"start\":%llu,\"venueCode\":\"PLEYEL_PLEYEL\"}",
+			(unsigned long long)(1372701600000ULL + i * 86400000ULL));
+	}
+
+	push_format__BenchBuffer(b,
+		"],\"seatCategoryNames\":{\"338937295\":\"1\xc3\xa8re cat\xc3\xa9gorie\"},"
+		"\"subTopicNames\":{\"337184262\":\"Musique amplifi\xc3\xa9" "e\"},\"subjectNames\":{},"
+		"\"topicNames\":{\"107888604\":\"Activit\xc3\xa9\"},"
+		"\"topicSubTopics\":{\"107888604\":[337184283,337184263]},"
+		"\"venueNames\":{\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}");
+
+	indent__BenchBuffer(b, 4);
+
+	self->name = "citm_catalog";
+	self->kind = BENCH_CORPUS_KIND_DOCUMENT;
+}
+
+void
+generate_ndjson__BenchCorpus(struct BenchCorpus *self, size_t scale)
+{
+	static const char *levels[] = { "debug", "info", "info", "info", "warn", "error" };
+	static const char *services[] = { "api", "auth", "billing", "search", "gateway" };
+	static const unsigned statuses[] = { 200, 200, 200, 201, 204, 301, 400, 404, 500 };
+
+	struct BenchRandom random = { .state = 0x6e646a736f6e3031ULL };
+	struct BenchBuffer *b = &self->content;
+	size_t lines = 20000 * scale;
+
+	for (size_t i = 0; i < lines; ++i) {
+		push_format__BenchBuffer(b,
+			"{\"ts\":\"2026-10-18T12:%02llu:%02llu.%03lluZ\",\"level\":\"%s\",\"service\":\"%s\",\"msg\":\"",
+			(unsigned long long)range__BenchRandom(&random, 0, 59),
+			(unsigned long long)range__BenchRandom(&random, 0, 59),
+			(unsigned long long)range__BenchRandom(&random, 0, 999),
+			levels[range__BenchRandom(&random, 0, 5)],
+			services[range__BenchRandom(&random, 0, 4)]);
+		push_sentence__BenchBuffer(b, &random, range__BenchRandom(&random, 3, 12));
+		push_format__BenchBuffer(b,
+			"\",\"request_id\":\"%016llx\",\"status\":%u,\"latency_ms\":%.3f,"
+			"\"user\":{\"id\":%llu,\"ip\":\"10.%llu.%llu.%llu\"},\"tags\":[\"edge\",\"v2\"]}\n",
+			(unsigned long long)next__BenchRandom(&random),
+			statuses[range__BenchRandom(&random, 0, 8)],
+			next_double__BenchRandom(&random) * 250.0,
+			(unsigned long long)range__BenchRandom(&random, 1, 1000000),
+			(unsigned long long)range__BenchRandom(&random, 0, 255),
+			(unsigned long long)range__BenchRandom(&random, 0, 255),
+			(unsigned long long)range__BenchRandom(&random, 0, 255));
+	}
+
+	self->name = "logs.ndjson";
+	self->kind = BENCH_CORPUS_KIND_NDJSON;
+}
+
+bool
+load__BenchCorpus(struct BenchCorpus *self, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	if (!file) {
+		return false;
+	}
+
+	char chunk[65536];
+	size_t n;
+
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		push__BenchBuffer(&self->content, chunk, n);
+	}
+
+	fclose(file);
+
+	size_t path_len = strlen(path);
+
+	self->name = path;
+	self->kind = path_len > 7 && !strcmp(path + path_len - 7, ".ndjson") ? BENCH_CORPUS_KIND_NDJSON : BENCH_CORPUS_KIND_DOCUMENT;
+
+	return true;
+}
+
+void
+deinit__BenchCorpus(const struct BenchCorpus *self)
+{
+	deinit__BenchBuffer(&self->content);
+}
+
+void
+collect__BenchPaths(struct BenchPaths *self, const JSONValue *value, struct BenchPath *path)
+{
+	if (path->len == BENCH_LOOKUP_DEPTH) {
+		return;
+	}
+
+	struct BenchPathStep *step = &path->steps[path->len++];
+
+	switch (value->kind) {
+		case JSON_VALUE_KIND_OBJECT:
+			for (size_t i = 0; i < value->object.map->len; ++i) {
+				const JSONValueObjectKeyValue *member = &value->object.map->members[i];
+				size_t slot = self->seen++;
+
+				*step = (struct BenchPathStep){ .key = member->key.buffer, .key_len = member->key.len };
+
+				if (slot >= BENCH_LOOKUP_PATHS) {
+					slot = next__BenchRandom(&self->random) % self->seen;
+				} else {
+					++self->len;
+				}
+
+				if (slot < BENCH_LOOKUP_PATHS) {
+					self->buffer[slot] = *path;
+				}
+
+				collect__BenchPaths(self, member->value, path);
+			}
+
+			break;
+		case JSON_VALUE_KIND_ARRAY:
+			// NOTE: Packed arrays only hold scalars, there is no member
+			// below them.
+			if (get_kind__JSONValueArray(&value->array) != JSON_VALUE_ARRAY_KIND_VALUES) {
+				break;
+			}
+
+			for (size_t i = 0; i < value->array.len; ++i) {
+				*step = (struct BenchPathStep){ .key = NULL, .index = i };
+
+				collect__BenchPaths(self, &value->array.buffer[i], path);
+			}
+
+			break;
+		default:
+			break;
+	}
+
+	--path->len;
+}
+
+const JSONValue *
+walk__BenchPath(const struct BenchPath *self, const JSONValue *value)
+{
+	JSONElement element;
+
+	for (size_t i = 0; i < self->len && value; ++i) {
+		const struct BenchPathStep *step = &self->steps[i];
+
+		value = step->key ? get_member__JSONValue(value, step->key, step->key_len) : get_element__JSONValue(value, step->index, &element);
+	}
+
+	return value;
+}
+
+struct BenchSamples
+init__BenchSamples(size_t capacity)
+{
+	double *buffer = malloc(sizeof(double) * (capacity ? capacity : 1));
+
+	if (!buffer) {
+		FATAL("Out of memory");
+	}
+
+	return (struct BenchSamples){
+		.buffer = buffer,
+		.len = 0
+	};
+}
+
+int
+compare_double__BenchSamples(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+double
+percentile__BenchSamples(struct BenchSamples *self, double percentile)
+{
+	if (self->len == 0) {
+		return 0;
+	}
+
+	qsort(self->buffer, self->len, sizeof(double), &compare_double__BenchSamples);
+
+	// Nearest-rank method.
+	size_t rank = (size_t)(percentile / 100.0 * self->len + 0.999999);
+
+	return self->buffer[rank ? rank - 1 : 0];
+}
+
+void
+deinit__BenchSamples(const struct BenchSamples *self)
+{
+	free(self->buffer);
+}
+
+double
+now__Bench(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+long
+peak_rss_kib__Bench(void)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage)) {
+		return -1;
+	}
+
+	// NOTE: Linux reports kibibytes, macOS reports bytes.
+#if defined(__APPLE__)
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+size_t
+count_documents__Bench(const struct BenchCorpus *corpus)
+{
+	size_t documents = 0;
+	size_t offset = 0;
+
+	while (offset < corpus->content.len) {
+		const char *document;
+		size_t document_len;
+
+		offset = next_document__Bench(corpus, offset, &document, &document_len);
+		documents += document_len > 0;
+	}
+
+	return documents;
+}
+
+size_t
+next_document__Bench(const struct BenchCorpus *corpus, size_t offset, const char **document, size_t *document_len)
+{
+	const char *content = corpus->content.buffer;
+	size_t len = corpus->content.len;
+
+	if (corpus->kind == BENCH_CORPUS_KIND_DOCUMENT) {
+		*document = content;
+		*document_len = len;
+
+		return len;
+	}
+
+	while (offset < len && (content[offset] == '\n' || content[offset] == '\r')) {
+		++offset;
+	}
+
+	const char *line_end = offset < len ? memchr(content + offset, '\n', len - offset) : NULL;
+	size_t end = line_end ? (size_t)(line_end - content) : len;
+
+	*document = content + offset;
+	*document_len = end - offset;
+
+	return end;
+}
+
+void
+run_once__Bench(const struct BenchCorpus *corpus, struct BenchReport *report, bool count_allocations)
+{
+	double parse_seconds = 0;
+	double serialize_seconds = 0;
+	size_t serialized_len = 0;
+	size_t documents = 0;
+	size_t offset = 0;
+	size_t lookup_batches = 0;
+
+	while (offset < corpus->content.len) {
+		const char *document;
+		size_t document_len;
+
+		offset = next_document__Bench(corpus, offset, &document, &document_len);
+
+		if (document_len == 0) {
+			continue;
+		}
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+		size_t allocations_before = allocation_count;
+#endif
+		double start = now__Bench();
+		JSONValueResult result = parse__JSON(document, document_len);
+
+		parse_seconds += now__Bench() - start;
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+		if (count_allocations) {
+			report->allocations += allocation_count - allocations_before;
+		}
+#endif
+
+		if (is_err__JSONValueResult(&result)) {
+			FATAL("%s: %s", corpus->name, result.err.msg);
+		}
+
+		const JSONValue *value = unwrap__JSONValueResult(&result);
+
+		start = now__Bench();
+
+		char *s = to_string__JSONValue(value);
+
+		serialize_seconds += now__Bench() - start;
+
+		if (!s) {
+			FATAL("%s: out of memory", corpus->name);
+		}
+
+		serialized_len += strlen(s);
+		free(s);
+
+		// Lookups are measured by batch, the clock being too coarse for a
+		// single member access. The batches are spread over the documents of
+		// the corpus, each one walking paths sampled from its document.
+		if (lookup_batches < BENCH_LOOKUP_BATCHES && lookup_batches * report->documents / BENCH_LOOKUP_BATCHES == documents) {
+			struct BenchPaths paths = { .len = 0, .seen = 0, .random = { .state = 0x9E3779B97F4A7C15ULL + documents } };
+			struct BenchPath path = { .len = 0 };
+
+			collect__BenchPaths(&paths, value, &path);
+
+			for (; lookup_batches < BENCH_LOOKUP_BATCHES && lookup_batches * report->documents / BENCH_LOOKUP_BATCHES == documents; ++lookup_batches) {
+				size_t found = 0;
+
+				if (paths.len == 0) {
+					continue;
+				}
+
+				start = now__Bench();
+
+				for (size_t i = 0; i < BENCH_LOOKUP_BATCH; ++i) {
+					found += walk__BenchPath(&paths.buffer[i % paths.len], value) != NULL;
+				}
+
+				report->lookup_nanoseconds.buffer[report->lookup_nanoseconds.len++] = (now__Bench() - start) * 1e9 / BENCH_LOOKUP_BATCH;
+
+				if (found != BENCH_LOOKUP_BATCH) {
+					FATAL("%s: missing lookup path", corpus->name);
+				}
+			}
+		}
+
+		deinit__JSONValueResult(&result);
+
+		++documents;
+	}
+
+	report->parse_seconds.buffer[report->parse_seconds.len++] = parse_seconds;
+	report->serialize_seconds.buffer[report->serialize_seconds.len++] = serialize_seconds;
+	report->serialized_len = serialized_len;
+}
+
+void
+run__Bench(const struct BenchCorpus *corpus, size_t runs)
+{
+	struct BenchReport report = {
+		.parse_seconds = init__BenchSamples(runs),
+		.serialize_seconds = init__BenchSamples(runs),
+		.lookup_nanoseconds = init__BenchSamples(runs * BENCH_LOOKUP_BATCHES),
+		.serialized_len = 0,
+		.documents = count_documents__Bench(corpus),
+		.allocations = 0
+	};
+
+	// Warm-up run, also used to count allocations.
+	run_once__Bench(corpus, &report, true);
+
+	report.parse_seconds.len = 0;
+	report.serialize_seconds.len = 0;
+	report.lookup_nanoseconds.len = 0;
+
+	for (size_t i = 0; i < runs; ++i) {
+		run_once__Bench(corpus, &report, false);
+	}
+
+	double mb = corpus->content.len / 1e6;
+	double serialized_mb = report.serialized_len / 1e6;
+
+	printf("%-16s %9.2f %10zu %9.1f %9.1f %9.1f %9.1f",
+		corpus->name,
+		mb,
+		report.documents,
+		mb / percentile__BenchSamples(&report.parse_seconds, 50),
+		mb / percentile__BenchSamples(&report.parse_seconds, 99),
+		serialized_mb / percentile__BenchSamples(&report.serialize_seconds, 50),
+		serialized_mb / percentile__BenchSamples(&report.serialize_seconds, 99));
+
+	if (report.lookup_nanoseconds.len > 0) {
+		printf(" %9.1f %9.1f",
+			percentile__BenchSamples(&report.lookup_nanoseconds, 50),
+			percentile__BenchSamples(&report.lookup_nanoseconds, 99));
+	} else {
+		printf(" %9s %9s", "-", "-");
+	}
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+	printf(" %11.1f", (double)report.allocations / report.documents);
+#else
+	printf(" %11s", "-");
+#endif
+
+	printf(" %10.1f\n", peak_rss_kib__Bench() / 1024.0);
+
+	deinit__BenchSamples(&report.parse_seconds);
+	deinit__BenchSamples(&report.serialize_seconds);
+	deinit__BenchSamples(&report.lookup_nanoseconds);
+}
+
+void
+run_isolated__Bench(const char *path, void (*generate)(struct BenchCorpus *, size_t), size_t scale, size_t runs)
+{
+	// NOTE: ru_maxrss is a high-water mark of the whole process, so measuring
+	// each corpus in a fresh child keeps earlier corpora out of its peak.
+	fflush(stdout);
+
+	pid_t pid = fork();
+
+	if (pid < 0) {
+		FATAL("Cannot fork");
+	}
+
+	if (pid == 0) {
+		struct BenchCorpus corpus = { .content = init__BenchBuffer() };
+
+		if (path) {
+			if (!load__BenchCorpus(&corpus, path)) {
+				FATAL("Cannot read %s", path);
+			}
+		} else {
+			generate(&corpus, scale);
+		}
+
+		run__Bench(&corpus, runs);
+		deinit__BenchCorpus(&corpus);
+		fflush(stdout);
+		_exit(0);
+	}
+
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		FATAL("Corpus %s failed", path ? path : "generator");
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t runs = BENCH_DEFAULT_RUNS;
+	size_t scale = BENCH_DEFAULT_SCALE;
+	int first_file = argc;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+			runs = strtoul(argv[++i], NULL, 10);
+		} else if (!strcmp(argv[i], "--scale") && i + 1 < argc) {
+			scale = strtoul(argv[++i], NULL, 10);
+		} else if (!strcmp(argv[i], "--help")) {
+			printf("Usage: %s [--runs N] [--scale N] [file.json | file.ndjson ...]\n", argv[0]);
+
+			return 0;
+		} else {
+			first_file = i;
+
+			break;
+		}
+	}
+
+	if (runs == 0 || scale == 0) {
+		FATAL("--runs and --scale must be greater than 0");
+	}
+
+	printf("%-16s %9s %10s %9s %9s %9s %9s %9s %9s %11s %10s\n",
+		"corpus", "MB", "documents",
+		"parse", "parse", "serialize", "serialize", "lookup", "lookup",
+		"allocs", "peak RSS");
+	printf("%-16s %9s %10s %9s %9s %9s %9s %9s %9s %11s %10s\n",
+		"", "", "",
+		"MB/s p50", "MB/s p99", "MB/s p50", "MB/s p99", "ns p50", "ns p99",
+		"per doc", "MiB/corpus");
+
+	if (first_file < argc) {
+		for (int i = first_file; i < argc; ++i) {
+			run_isolated__Bench(argv[i], NULL, scale, runs);
+		}
+
+		return 0;
+	}
+
+	void (*generators[])(struct BenchCorpus *, size_t) = {
+		&generate_twitter__BenchCorpus,
+		&generate_canada__BenchCorpus,
+		&generate_citm__BenchCorpus,
+		&generate_ndjson__BenchCorpus
+	};
+
+	for (size_t i = 0; i < sizeof(generators) / sizeof(*generators); ++i) {
+		run_isolated__Bench(NULL, generators[i], scale, runs);
+	}
+
+	return 0;
+}
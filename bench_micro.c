@@ -0,0 +1,630 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 ArthurPV
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <time.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// The parser hot paths are static, the micro-benchmarks are therefore built
+// in the same translation unit.
+#include "json.c"
+
+// Usage: json_bench_micro [--runs N]
+//
+// Each micro-benchmark isolates one stage of the parser and reports, per unit
+// of work (byte or insert), the wall-clock time, the cycles and instructions,
+// and the branch and cache misses per 1000 units. Hardware counters come from
+// perf_event_open(2); when they are unavailable (non-Linux, containers,
+// perf_event_paranoid), only the wall-clock time is reported.
+
+#define MICRO_DEFAULT_RUNS 10
+
+enum MicroCounterKind {
+	MICRO_COUNTER_KIND_CYCLES,
+	MICRO_COUNTER_KIND_INSTRUCTIONS,
+	MICRO_COUNTER_KIND_BRANCH_MISSES,
+	MICRO_COUNTER_KIND_CACHE_MISSES,
+	MICRO_COUNTER_KIND_COUNT
+};
+
+struct MicroCounters {
+	int fds[MICRO_COUNTER_KIND_COUNT];
+	bool is_available;
+};
+
+struct MicroSample {
+	double nanoseconds;
+	double counters[MICRO_COUNTER_KIND_COUNT];
+};
+
+static struct MicroCounters
+init__MicroCounters(void);
+
+static void
+start__MicroCounters(struct MicroCounters *self);
+
+static void
+stop__MicroCounters(struct MicroCounters *self, struct MicroSample *sample);
+
+static void
+deinit__MicroCounters(const struct MicroCounters *self);
+
+struct MicroInput {
+	char *buffer;
+	size_t len;
+	size_t capacity;
+};
+
+static void
+push__MicroInput(struct MicroInput *self, const char *s, size_t s_len);
+
+static inline void
+deinit__MicroInput(const struct MicroInput *self);
+
+struct MicroBench {
+	const char *name;
+	const char *unit;
+	void (*setup)(struct MicroInput *input);
+	size_t (*run)(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+};
+
+static inline double
+now__Micro(void);
+
+static int
+compare_double__Micro(const void *a, const void *b);
+
+static double
+median__Micro(double *values, size_t len);
+
+static void
+setup_spaces__Micro(struct MicroInput *input);
+
+static size_t
+run_skip_spaces__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+static void
+setup_string__Micro(struct MicroInput *input);
+
+static size_t
+run_string__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+static void
+setup_numbers__Micro(struct MicroInput *input);
+
+static size_t
+run_numbers__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+static void
+setup_object_inserts__Micro(struct MicroInput *input);
+
+static size_t
+run_object_inserts__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+static void
+setup_to_string__Micro(struct MicroInput *input);
+
+static size_t
+run_to_string__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+static size_t
+run_skip_value__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample);
+
+struct MicroCounters
+init__MicroCounters(void)
+{
+	struct MicroCounters self = { .is_available = false };
+
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		self.fds[i] = -1;
+	}
+
+#if defined(__linux__)
+	static const struct {
+		uint32_t type;
+		uint64_t config;
+	} events[MICRO_COUNTER_KIND_COUNT] = {
+		[MICRO_COUNTER_KIND_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		[MICRO_COUNTER_KIND_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		[MICRO_COUNTER_KIND_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		[MICRO_COUNTER_KIND_CACHE_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+	};
+
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		struct perf_event_attr attr;
+
+		memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.disabled = i == 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		self.fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : self.fds[0], 0);
+
+		if (self.fds[i] < 0) {
+			deinit__MicroCounters(&self);
+
+			return self;
+		}
+	}
+
+	self.is_available = true;
+#endif
+
+	return self;
+}
+
+void
+start__MicroCounters(struct MicroCounters *self)
+{
+#if defined(__linux__)
+	if (self->is_available) {
+		ioctl(self->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(self->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+void
+stop__MicroCounters(struct MicroCounters *self, struct MicroSample *sample)
+{
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		sample->counters[i] = 0;
+	}
+
+#if defined(__linux__)
+	if (!self->is_available) {
+		return;
+	}
+
+	ioctl(self->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		// value, time_enabled, time_running
+		uint64_t values[3];
+
+		if (read(self->fds[i], values, sizeof(values)) != sizeof(values)) {
+			continue;
+		}
+
+		// Scale the counter when the PMU was multiplexed.
+		sample->counters[i] = values[2] ? (double)values[0] * values[1] / values[2] : 0;
+	}
+#endif
+}
+
+void
+deinit__MicroCounters(const struct MicroCounters *self)
+{
+#if defined(__linux__)
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		if (self->fds[i] >= 0) {
+			close(self->fds[i]);
+		}
+	}
+#endif
+}
+
+void
+push__MicroInput(struct MicroInput *self, const char *s, size_t s_len)
+{
+	if (self->len + s_len + 1 > self->capacity) {
+		self->capacity = (self->len + s_len + 1) * 2;
+		self->buffer = realloc(self->buffer, self->capacity);
+
+		if (!self->buffer) {
+			FATAL("Out of memory");
+		}
+	}
+
+	memcpy(self->buffer + self->len, s, s_len);
+
+	self->len += s_len;
+	self->buffer[self->len] = 0;
+}
+
+void
+deinit__MicroInput(const struct MicroInput *self)
+{
+	free(self->buffer);
+}
+
+double
+now__Micro(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int
+compare_double__Micro(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+double
+median__Micro(double *values, size_t len)
+{
+	qsort(values, len, sizeof(double), &compare_double__Micro);
+
+	return values[len / 2];
+}
+
+#define MICRO_MEASURE(counters, sample, ...) \
+	do { \
+		double micro_start = now__Micro(); \
+		start__MicroCounters(counters); \
+		__VA_ARGS__; \
+		stop__MicroCounters(counters, sample); \
+		(sample)->nanoseconds = now__Micro() - micro_start; \
+	} while (0)
+
+void
+setup_spaces__Micro(struct MicroInput *input)
+{
+	static const char spaces[] = " \t\n\r    \n        ";
+
+	while (input->len < (1 << 20)) {
+		push__MicroInput(input, spaces, sizeof(spaces) - 1);
+	}
+
+	push__MicroInput(input, "x", 1);
+}
+
+size_t
+run_skip_spaces__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	struct JSONContentIterator iter = init__JSONContentIterator(input->buffer, input->len);
+	uint32_t current;
+
+	MICRO_MEASURE(counters, sample, current = skip_spaces__JSONContentIterator(&iter));
+
+	if (current != 'x') {
+		FATAL("skip_spaces__JSONContentIterator stopped early");
+	}
+
+	return iter.count;
+}
+
+void
+setup_string__Micro(struct MicroInput *input)
+{
+	static const char chunk[] =
+		"The quick brown fox jumps over the lazy dog "
+		"caf\xc3\xa9 \xe6\x9d\xb1\xe4\xba\xac \xf0\x9f\x98\x81 "
+		"\\n\\t\\\"\\\\\\/ \\u3042\\u00e9 ";
+
+	push__MicroInput(input, "\"", 1);
+
+	while (input->len < (1 << 18)) {
+		push__MicroInput(input, chunk, sizeof(chunk) - 1);
+	}
+
+	push__MicroInput(input, "\" ", 2);
+}
+
+size_t
+run_string__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	struct JSONContentIterator iter = init__JSONContentIterator(input->buffer, input->len);
+	JSONValueResult result;
+
+	MICRO_MEASURE(counters, sample, result = parse_string_value__JSON(&iter));
+
+	if (is_err__JSONValueResult(&result)) {
+		FATAL("parse_string_value__JSON: %s", result.err.msg);
+	}
+
+	deinit__JSONValueResult(&result);
+
+	return iter.count;
+}
+
+void
+setup_numbers__Micro(struct MicroInput *input)
+{
+	static const char *numbers[] = {
+		"0", "-1", "42", "1234567890", "-65.613616999999977", "43.420273000000009",
+		"3.1000e+3", "0.005", "-2.5E-10", "18446744073709551615"
+	};
+
+	char number[64];
+
+	for (size_t i = 0; input->len < (1 << 18); ++i) {
+		int n = snprintf(number, sizeof(number), "%s,", numbers[i % (sizeof(numbers) / sizeof(*numbers))]);
+
+		push__MicroInput(input, number, n);
+	}
+
+	push__MicroInput(input, " ", 1);
+}
+
+size_t
+run_numbers__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	struct JSONContentIterator iter = init__JSONContentIterator(input->buffer, input->len);
+	JSONValueResult results[64];
+	size_t results_len = 0;
+	double nanoseconds = 0;
+	struct MicroSample batch_sample;
+
+	for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+		sample->counters[i] = 0;
+	}
+
+	// The numbers are released between batches, outside of the measurement.
+	while (current__JSONContentIterator(&iter) != ' ') {
+		MICRO_MEASURE(counters, &batch_sample, {
+			for (results_len = 0; results_len < 64 && current__JSONContentIterator(&iter) != ' '; ++results_len) {
+				results[results_len] = parse_number_value__JSON(&iter);
+				next__JSONContentIterator(&iter); // Skip `,`
+			}
+		});
+
+		nanoseconds += batch_sample.nanoseconds;
+
+		for (size_t i = 0; i < MICRO_COUNTER_KIND_COUNT; ++i) {
+			sample->counters[i] += batch_sample.counters[i];
+		}
+
+		for (size_t i = 0; i < results_len; ++i) {
+			if (is_err__JSONValueResult(&results[i])) {
+				FATAL("parse_number_value__JSON: %s", results[i].err.msg);
+			}
+
+			deinit__JSONValueResult(&results[i]);
+		}
+	}
+
+	sample->nanoseconds = nanoseconds;
+
+	return iter.count;
+}
+
+#define MICRO_OBJECT_INSERTS 100000
+
+void
+setup_object_inserts__Micro(struct MicroInput *input)
+{
+	char key[32];
+
+	for (size_t i = 0; i < MICRO_OBJECT_INSERTS; ++i) {
+		int n = snprintf(key, sizeof(key), "member_%zu", i * 2654435761u % 1000003);
+
+		// Keys are NUL separated.
+		push__MicroInput(input, key, n + 1);
+	}
+}
+
+size_t
+run_object_inserts__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	JSONValueObjectKeyValue *pairs = malloc(sizeof(JSONValueObjectKeyValue) * MICRO_OBJECT_INSERTS);
+
+	if (!pairs) {
+		FATAL("Out of memory");
+	}
+
+	const char *key = input->buffer;
+
+	for (size_t i = 0; i < MICRO_OBJECT_INSERTS; ++i) {
+		JSONValueString key_s = init__JSONValueString();
+		size_t key_len = strlen(key);
+
+		if (!push_characters__JSONValueString(&key_s, (char *)key, key_len)) {
+			FATAL("Out of memory");
+		}
+
+		pairs[i] = init__JSONValueObjectKeyValue(key_s, init_null__JSONValue());
+		key += key_len + 1;
+	}
+
+	JSONValueObjectKeyValueMap map = init__JSONValueObjectKeyValueMap();
+	size_t inserted = 0;
+
+	MICRO_MEASURE(counters, sample, {
+		for (size_t i = 0; i < MICRO_OBJECT_INSERTS; ++i) {
+			inserted += push__JSONValueObjectKeyValueMap(&map, pairs[i]) == OBJECT_KEY_VALUE_MAP_NO_ERROR;
+		}
+	});
+
+	if (inserted != MICRO_OBJECT_INSERTS) {
+		FATAL("push__JSONValueObjectKeyValueMap failed");
+	}
+
+	deinit__JSONValueObjectKeyValueMap(&map);
+	free(pairs);
+
+	return inserted;
+}
+
+void
+setup_to_string__Micro(struct MicroInput *input)
+{
+	char record[256];
+
+	push__MicroInput(input, "{\"records\":[", 12);
+
+	for (size_t i = 0; i < 2000; ++i) {
+		int n = snprintf(record, sizeof(record),
+			"%s{\"id\":%zu,\"name\":\"user \\\"%zu\\\"\",\"score\":%zu.%02zu,"
+			"\"active\":%s,\"tags\":[\"a\",\"b\\/c\"],\"parent\":null}",
+			i ? "," : "", i, i, i % 100, i % 97, i % 3 ? "true" : "false");
+
+		push__MicroInput(input, record, n);
+	}
+
+	push__MicroInput(input, "]}", 2);
+}
+
+size_t
+run_to_string__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	JSONValueResult result = parse__JSON(input->buffer, input->len);
+
+	if (is_err__JSONValueResult(&result)) {
+		FATAL("parse__JSON: %s", result.err.msg);
+	}
+
+	char *s;
+
+	MICRO_MEASURE(counters, sample, s = to_string__JSONValue(unwrap__JSONValueResult(&result)));
+
+	if (!s) {
+		FATAL("Out of memory");
+	}
+
+	size_t len = strlen(s);
+
+	free(s);
+	deinit__JSONValueResult(&result);
+
+	return len;
+}
+
+size_t
+run_skip_value__Micro(const struct MicroInput *input, struct MicroCounters *counters, struct MicroSample *sample)
+{
+	struct JSONContentIterator iter = init__JSONContentIterator(input->buffer, input->len);
+	uint32_t res;
+
+	MICRO_MEASURE(counters, sample, res = skip_value__JSONContentIterator(&iter));
+
+	if (res || iter.count != input->len) {
+		FATAL("skip_value__JSONContentIterator stopped early");
+	}
+
+	return iter.count;
+}
+
+static const struct MicroBench micro_benches[] = {
+	{ "skip_spaces", "byte", &setup_spaces__Micro, &run_skip_spaces__Micro },
+	{ "string", "byte", &setup_string__Micro, &run_string__Micro },
+	{ "number", "byte", &setup_numbers__Micro, &run_numbers__Micro },
+	{ "object_insert", "insert", &setup_object_inserts__Micro, &run_object_inserts__Micro },
+	{ "to_string", "byte", &setup_to_string__Micro, &run_to_string__Micro },
+	{ "skip_value", "byte", &setup_to_string__Micro, &run_skip_value__Micro }
+};
+
+int
+main(int argc, char **argv)
+{
+	size_t runs = MICRO_DEFAULT_RUNS;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+			runs = strtoul(argv[++i], NULL, 10);
+		} else {
+			printf("Usage: %s [--runs N]\n", argv[0]);
+
+			return strcmp(argv[i], "--help") != 0;
+		}
+	}
+
+	if (runs == 0) {
+		FATAL("--runs must be greater than 0");
+	}
+
+	struct MicroCounters counters = init__MicroCounters();
+
+	if (!counters.is_available) {
+		printf("Hardware counters are unavailable, falling back to wall-clock timing.\n");
+	}
+
+	printf("%-14s %-7s %10s %10s %10s %14s %14s\n",
+		"bench", "unit", "ns/unit", "cycles/unit", "instr/unit", "br-miss/1k", "cache-miss/1k");
+
+	double *values = malloc(sizeof(double) * runs);
+
+	if (!values) {
+		FATAL("Out of memory");
+	}
+
+	for (size_t i = 0; i < sizeof(micro_benches) / sizeof(*micro_benches); ++i) {
+		const struct MicroBench *bench = &micro_benches[i];
+		struct MicroInput input = { .buffer = NULL, .len = 0, .capacity = 0 };
+		struct MicroSample *samples = malloc(sizeof(struct MicroSample) * runs);
+		size_t units = 0;
+
+		if (!samples) {
+			FATAL("Out of memory");
+		}
+
+		bench->setup(&input);
+
+		// Warm-up
+		bench->run(&input, &counters, &samples[0]);
+
+		for (size_t j = 0; j < runs; ++j) {
+			units = bench->run(&input, &counters, &samples[j]);
+		}
+
+		for (size_t j = 0; j < runs; ++j) {
+			values[j] = samples[j].nanoseconds / units;
+		}
+
+		printf("%-14s %-7s %10.3f", bench->name, bench->unit, median__Micro(values, runs));
+
+		if (counters.is_available) {
+			for (size_t k = 0; k < MICRO_COUNTER_KIND_COUNT; ++k) {
+				double scale = k >= MICRO_COUNTER_KIND_BRANCH_MISSES ? 1000.0 : 1.0;
+
+				for (size_t j = 0; j < runs; ++j) {
+					values[j] = samples[j].counters[k] * scale / units;
+				}
+
+				printf(k >= MICRO_COUNTER_KIND_BRANCH_MISSES ? " %14.3f" : " %10.3f", median__Micro(values, runs));
+			}
+		} else {
+			printf(" %10s %10s %14s %14s", "-", "-", "-", "-");
+		}
+
+		printf("\n");
+
+		free(samples);
+		deinit__MicroInput(&input);
+	}
+
+	free(values);
+	deinit__MicroCounters(&counters);
+
+	return 0;
+}
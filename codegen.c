@@ -0,0 +1,1475 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 ArthurPV
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+#include "json.h"
+
+// Usage: json_codegen <schema.json> <output.c> <output.h>
+//
+// Generates a parser specialized for a JSON Schema subset:
+//
+// - the root schema is an object, its `title` names the generated struct;
+// - `type` is one of `integer` (int64_t), `number` (double), `boolean`
+//   (bool), `string` (JSONStringSlice), `object` (nested struct, named after
+//   its `title` or its parent, objects with the same title and schema share
+//   one struct) or `array`;
+// - an array has `items` (any type above except array) and `maxItems`, the
+//   elements are stored inline and the length in `<name>_len`;
+// - `required` lists the members which must be present.
+//
+// The generated code uses json.h for JSONStringSlice, JSONStatus and
+// skip_value__JSON, which steps over unknown members. Member names are
+// matched by length then by memcmp against constants, and each scalar is
+// decoded by a routine specialized for its type.
+
+#define FATAL(msg, ...) \
+	fprintf(stderr, "FATAL(%d): "msg"\n", __LINE__, ##__VA_ARGS__); \
+	exit(1);
+
+#define CODEGEN_MAX_REQUIRED 64
+
+struct CodegenBuffer {
+	char *buffer;
+	size_t len;
+	size_t capacity;
+};
+
+static void
+push__CodegenBuffer(struct CodegenBuffer *self, const char *fmt, ...);
+
+static void
+push_template__CodegenBuffer(struct CodegenBuffer *self, const char *template, const char *name, const char *upper_name);
+
+static void
+push_literal__CodegenBuffer(struct CodegenBuffer *self, const char *s, size_t s_len);
+
+static inline void
+deinit__CodegenBuffer(const struct CodegenBuffer *self);
+
+enum CodegenTypeKind {
+	CODEGEN_TYPE_KIND_INT,
+	CODEGEN_TYPE_KIND_DOUBLE,
+	CODEGEN_TYPE_KIND_BOOLEAN,
+	CODEGEN_TYPE_KIND_STRING,
+	CODEGEN_TYPE_KIND_STRUCT,
+	CODEGEN_TYPE_KIND_ARRAY
+};
+
+struct CodegenField;
+
+// The C names given to the structs and to the array parsers, shared by the
+// whole schema. Two structs with the same title share a name only when their
+// schemas are equal, the next ones get a numeric suffix.
+struct CodegenName {
+	char *c_name;
+	const JSONValue *schema;
+};
+
+struct CodegenNames {
+	struct CodegenName *buffer;
+	size_t len;
+	size_t capacity;
+};
+
+static char *
+add__CodegenNames(struct CodegenNames *self, const char *c_name, const JSONValue *schema, bool *is_duplicate);
+
+static void
+deinit__CodegenNames(const struct CodegenNames *self);
+
+struct CodegenType {
+	enum CodegenTypeKind kind;
+	// CODEGEN_TYPE_KIND_STRUCT
+	char *c_name;
+	struct CodegenField *fields;
+	size_t fields_len;
+	bool is_duplicate; // Already generated under the same name
+	// CODEGEN_TYPE_KIND_ARRAY
+	struct CodegenType *items;
+	size_t max_items;
+};
+
+struct CodegenField {
+	const char *name; // Borrowed from the schema
+	size_t name_len;
+	char *c_name;
+	char *array_c_name; // CODEGEN_TYPE_KIND_ARRAY, names its parser
+	struct CodegenType type;
+	bool is_required;
+};
+
+static enum CodegenTypeKind
+get_kind__CodegenType(const JSONValue *schema, const char *path);
+
+static void
+init__CodegenType(struct CodegenType *self, const JSONValue *schema, const char *c_name, struct CodegenNames *names);
+
+static bool
+has_field__CodegenType(const struct CodegenType *self, const char *c_name);
+
+static bool
+is_taken__CodegenType(const struct CodegenType *self, const char *c_name, bool is_array);
+
+static void
+deinit__CodegenType(const struct CodegenType *self);
+
+struct Codegen {
+	const char *name; // Name of the root struct
+	char *parser_name; // e.g. EventParser
+	char *upper_name; // e.g. EVENT_PARSER
+	struct CodegenBuffer header;
+	struct CodegenBuffer source;
+};
+
+static char *
+format__Codegen(const char *fmt, ...);
+
+static char *
+sanitize_identifier__Codegen(const char *s, size_t s_len);
+
+static bool
+is_reserved__Codegen(const char *s);
+
+static char *
+upper_snake_case__Codegen(const char *s);
+
+static const char *
+c_type__Codegen(const struct CodegenType *type);
+
+static void
+generate_struct__Codegen(struct Codegen *self, const struct CodegenType *type);
+
+static void
+generate_value__Codegen(struct Codegen *self, const struct CodegenType *type, const char *lvalue);
+
+static void
+generate_array__Codegen(struct Codegen *self, const struct CodegenType *parent, const struct CodegenField *field);
+
+static void
+generate_parse__Codegen(struct Codegen *self, const struct CodegenType *type);
+
+static char *
+read_file__Codegen(const char *path, size_t *len);
+
+static void
+write_file__Codegen(const char *path, const struct CodegenBuffer *buffer);
+
+void
+push__CodegenBuffer(struct CodegenBuffer *self, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+
+	int n = vsnprintf(NULL, 0, fmt, args);
+
+	va_end(args);
+
+	if (n < 0) {
+		FATAL("Invalid format");
+	}
+
+	if (self->len + n + 1 > self->capacity) {
+		self->capacity = (self->len + n + 1) * 2;
+		self->buffer = realloc(self->buffer, self->capacity);
+
+		if (!self->buffer) {
+			FATAL("Out of memory");
+		}
+	}
+
+	va_start(args, fmt);
+	vsnprintf(self->buffer + self->len, n + 1, fmt, args);
+	va_end(args);
+
+	self->len += n;
+}
+
+void
+push_template__CodegenBuffer(struct CodegenBuffer *self, const char *template, const char *name, const char *upper_name)
+{
+	// `@` is replaced by the parser name and `$` by its upper snake case
+	// counterpart.
+	for (const char *c = template; *c; ++c) {
+		switch (*c) {
+			case '@':
+				push__CodegenBuffer(self, "%s", name);
+
+				break;
+			case '$':
+				push__CodegenBuffer(self, "%s", upper_name);
+
+				break;
+			default:
+				push__CodegenBuffer(self, "%c", *c);
+		}
+	}
+}
+
+void
+push_literal__CodegenBuffer(struct CodegenBuffer *self, const char *s, size_t s_len)
+{
+	push__CodegenBuffer(self, "\"");
+
+	for (size_t i = 0; i < s_len; ++i) {
+		unsigned char c = s[i];
+
+		if (c == '"' || c == '\\') {
+			push__CodegenBuffer(self, "\\%c", c);
+		} else if (c < 0x20 || c >= 0x7F || c == '?') {
+			// Octal escapes never swallow the next character, unlike \x.
+			push__CodegenBuffer(self, "\\%03o", c);
+		} else {
+			push__CodegenBuffer(self, "%c", c);
+		}
+	}
+
+	push__CodegenBuffer(self, "\"");
+}
+
+void
+deinit__CodegenBuffer(const struct CodegenBuffer *self)
+{
+	free(self->buffer);
+}
+
+char *
+add__CodegenNames(struct CodegenNames *self, const char *c_name, const JSONValue *schema, bool *is_duplicate)
+{
+	char *res = format__Codegen("%s", c_name);
+
+	*is_duplicate = false;
+
+	for (size_t n = 2;; ++n) {
+		const struct CodegenName *name = NULL;
+
+		for (size_t i = 0; i < self->len && !name; ++i) {
+			if (!strcmp(self->buffer[i].c_name, res)) {
+				name = &self->buffer[i];
+			}
+		}
+
+		if (!name) {
+			break;
+		} else if (eq__JSONValue(name->schema, schema)) {
+			*is_duplicate = true;
+
+			return res;
+		}
+
+		free(res);
+		res = format__Codegen("%s%zu", c_name, n);
+	}
+
+	if (self->len == self->capacity) {
+		self->capacity = self->capacity ? self->capacity * 2 : 16;
+		self->buffer = realloc(self->buffer, self->capacity * sizeof(struct CodegenName));
+
+		if (!self->buffer) {
+			FATAL("Out of memory");
+		}
+	}
+
+	self->buffer[self->len++] = (struct CodegenName){
+		.c_name = format__Codegen("%s", res),
+		.schema = schema
+	};
+
+	return res;
+}
+
+void
+deinit__CodegenNames(const struct CodegenNames *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->buffer[i].c_name);
+	}
+
+	free(self->buffer);
+}
+
+enum CodegenTypeKind
+get_kind__CodegenType(const JSONValue *schema, const char *path)
+{
+	const JSONValue *type = get_member__JSONValue(schema, "type", 4);
+
+	if (!type || type->kind != JSON_VALUE_KIND_STRING) {
+		FATAL("%s: expected `type` to be a string", path);
+	}
+
+	static const struct {
+		const char *name;
+		enum CodegenTypeKind kind;
+	} kinds[] = {
+		{ "integer", CODEGEN_TYPE_KIND_INT },
+		{ "number", CODEGEN_TYPE_KIND_DOUBLE },
+		{ "boolean", CODEGEN_TYPE_KIND_BOOLEAN },
+		{ "string", CODEGEN_TYPE_KIND_STRING },
+		{ "object", CODEGEN_TYPE_KIND_STRUCT },
+		{ "array", CODEGEN_TYPE_KIND_ARRAY }
+	};
+
+	for (size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+		if (type->string.len == strlen(kinds[i].name) && !memcmp(type->string.buffer, kinds[i].name, type->string.len)) {
+			return kinds[i].kind;
+		}
+	}
+
+	FATAL("%s: unsupported type `%s`", path, type->string.buffer);
+}
+
+void
+init__CodegenType(struct CodegenType *self, const JSONValue *schema, const char *c_name, struct CodegenNames *names)
+{
+	*self = (struct CodegenType){
+		.kind = get_kind__CodegenType(schema, c_name)
+	};
+
+	if (self->kind == CODEGEN_TYPE_KIND_ARRAY) {
+		const JSONValue *items = get_member__JSONValue(schema, "items", 5);
+		const JSONValue *max_items = get_member__JSONValue(schema, "maxItems", 8);
+
+		if (!items || items->kind != JSON_VALUE_KIND_OBJECT) {
+			FATAL("%s: expected `items` to be an object", c_name);
+		} else if (!max_items || max_items->kind != JSON_VALUE_KIND_NUMBER || (self->max_items = strtoul(max_items->number.buffer, NULL, 10)) == 0) {
+			FATAL("%s: expected `maxItems` to be a positive integer", c_name);
+		}
+
+		char *items_c_name = format__Codegen("%s_item", c_name);
+
+		self->items = malloc(sizeof(struct CodegenType));
+
+		if (!self->items) {
+			FATAL("Out of memory");
+		}
+
+		init__CodegenType(self->items, items, items_c_name, names);
+		free(items_c_name);
+
+		if (self->items->kind == CODEGEN_TYPE_KIND_ARRAY) {
+			FATAL("%s: nested arrays are not supported", c_name);
+		}
+
+		return;
+	} else if (self->kind != CODEGEN_TYPE_KIND_STRUCT) {
+		return;
+	}
+
+	const JSONValue *title = get_member__JSONValue(schema, "title", 5);
+	const JSONValue *properties = get_member__JSONValue(schema, "properties", 10);
+	const JSONValue *required = get_member__JSONValue(schema, "required", 8);
+
+	char *title_c_name = title && title->kind == JSON_VALUE_KIND_STRING
+		? sanitize_identifier__Codegen(title->string.buffer, title->string.len)
+		: format__Codegen("%s", c_name);
+
+	self->c_name = add__CodegenNames(names, title_c_name, schema, &self->is_duplicate);
+	free(title_c_name);
+
+	if (!properties || properties->kind != JSON_VALUE_KIND_OBJECT) {
+		FATAL("%s: expected `properties` to be an object", self->c_name);
+	}
+
+	// The fields follow the order of the members in the schema
+	JSONObjectIterator iter = init__JSONObjectIterator(properties);
+	const JSONValueObjectKeyValue *member;
+
+	self->fields = calloc(iter.len ? iter.len : 1, sizeof(struct CodegenField));
+
+	if (!self->fields) {
+		FATAL("Out of memory");
+	}
+
+	while ((member = next__JSONObjectIterator(&iter))) {
+		struct CodegenField *field = &self->fields[self->fields_len];
+
+		field->name = member->key.buffer ? member->key.buffer : "";
+		field->name_len = member->key.len;
+
+		// Distinct names can be sanitized to the same identifier (`a-b` and
+		// `a_b`), or to the `<name>_len` of an array.
+		char *base_c_name = sanitize_identifier__Codegen(field->name, field->name_len);
+		bool is_array = get_kind__CodegenType(member->value, base_c_name) == CODEGEN_TYPE_KIND_ARRAY;
+
+		field->c_name = format__Codegen("%s", base_c_name);
+
+		for (size_t n = 2; is_taken__CodegenType(self, field->c_name, is_array); ++n) {
+			free(field->c_name);
+			field->c_name = format__Codegen("%s_%zu", base_c_name, n);
+		}
+
+		free(base_c_name);
+
+		char *field_type_name = format__Codegen("%s_%s", self->c_name, field->c_name);
+
+		init__CodegenType(&field->type, member->value, field_type_name, names);
+
+		if (is_array) {
+			bool is_duplicate;
+
+			field->array_c_name = add__CodegenNames(names, field_type_name, member->value, &is_duplicate);
+		}
+
+		free(field_type_name);
+		++self->fields_len;
+	}
+
+	if (required && required->kind == JSON_VALUE_KIND_ARRAY) {
+		for (size_t i = 0; i < required->array.len; ++i) {
+			const JSONValue *name = &required->array.buffer[i];
+			bool is_found = false;
+
+			for (size_t j = 0; name->kind == JSON_VALUE_KIND_STRING && j < self->fields_len; ++j) {
+				if (self->fields[j].name_len == name->string.len && !memcmp(self->fields[j].name, name->string.buffer, name->string.len)) {
+					self->fields[j].is_required = is_found = true;
+				}
+			}
+
+			if (!is_found) {
+				FATAL("%s: unknown required member", self->c_name);
+			}
+		}
+	}
+
+	size_t required_count = 0;
+
+	for (size_t i = 0; i < self->fields_len; ++i) {
+		required_count += self->fields[i].is_required;
+	}
+
+	if (required_count > CODEGEN_MAX_REQUIRED) {
+		FATAL("%s: too many required members", self->c_name);
+	}
+}
+
+bool
+has_field__CodegenType(const struct CodegenType *self, const char *c_name)
+{
+	size_t c_name_len = strlen(c_name);
+
+	for (size_t i = 0; i < self->fields_len; ++i) {
+		const struct CodegenField *field = &self->fields[i];
+		size_t field_c_name_len = strlen(field->c_name);
+
+		if (!strcmp(field->c_name, c_name)) {
+			return true;
+		} else if (field->type.kind == CODEGEN_TYPE_KIND_ARRAY && c_name_len == field_c_name_len + 4 && !strncmp(c_name, field->c_name, field_c_name_len) && !strcmp(c_name + field_c_name_len, "_len")) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool
+is_taken__CodegenType(const struct CodegenType *self, const char *c_name, bool is_array)
+{
+	if (has_field__CodegenType(self, c_name)) {
+		return true;
+	} else if (!is_array) {
+		return false;
+	}
+
+	char *len_c_name = format__Codegen("%s_len", c_name);
+	bool res = has_field__CodegenType(self, len_c_name);
+
+	free(len_c_name);
+
+	return res;
+}
+
+void
+deinit__CodegenType(const struct CodegenType *self)
+{
+	switch (self->kind) {
+		case CODEGEN_TYPE_KIND_STRUCT:
+			for (size_t i = 0; i < self->fields_len; ++i) {
+				free(self->fields[i].c_name);
+				free(self->fields[i].array_c_name);
+				deinit__CodegenType(&self->fields[i].type);
+			}
+
+			free(self->fields);
+			free(self->c_name);
+
+			break;
+		case CODEGEN_TYPE_KIND_ARRAY:
+			deinit__CodegenType(self->items);
+			free(self->items);
+
+			break;
+		default:
+			break;
+	}
+}
+
+char *
+format__Codegen(const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+
+	int n = vsnprintf(NULL, 0, fmt, args);
+
+	va_end(args);
+
+	char *res = malloc(n + 1);
+
+	if (!res) {
+		FATAL("Out of memory");
+	}
+
+	va_start(args, fmt);
+	vsnprintf(res, n + 1, fmt, args);
+	va_end(args);
+
+	return res;
+}
+
+char *
+sanitize_identifier__Codegen(const char *s, size_t s_len)
+{
+	char *res = malloc(s_len + 3);
+	size_t len = 0;
+
+	if (!res) {
+		FATAL("Out of memory");
+	}
+
+	if (s_len == 0 || isdigit((unsigned char)s[0])) {
+		res[len++] = '_';
+	}
+
+	for (size_t i = 0; i < s_len; ++i) {
+		res[len++] = isalnum((unsigned char)s[i]) ? s[i] : '_';
+	}
+
+	res[len] = 0;
+
+	// `default` becomes `default_`
+	if (is_reserved__Codegen(res)) {
+		res[len++] = '_';
+		res[len] = 0;
+	}
+
+	return res;
+}
+
+bool
+is_reserved__Codegen(const char *s)
+{
+	// The C99 keywords, and the names the generated code relies on.
+	static const char *reserved[] = {
+		"auto", "break", "case", "char", "const", "continue", "default", "do",
+		"double", "else", "enum", "extern", "float", "for", "goto", "if",
+		"inline", "int", "long", "register", "restrict", "return", "short",
+		"signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+		"unsigned", "void", "volatile", "while", "_Bool", "_Complex",
+		"_Imaginary", "bool", "true", "false", "int64_t", "uint32_t",
+		"uint64_t", "size_t", "JSONStringSlice", "JSONStatus"
+	};
+
+	for (size_t i = 0; i < sizeof(reserved) / sizeof(*reserved); ++i) {
+		if (!strcmp(s, reserved[i])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+char *
+upper_snake_case__Codegen(const char *s)
+{
+	size_t s_len = strlen(s);
+	char *res = malloc(s_len * 2 + 1);
+	size_t len = 0;
+
+	if (!res) {
+		FATAL("Out of memory");
+	}
+
+	for (size_t i = 0; i < s_len; ++i) {
+		if (i > 0 && isupper((unsigned char)s[i]) && islower((unsigned char)s[i - 1])) {
+			res[len++] = '_';
+		}
+
+		res[len++] = toupper((unsigned char)s[i]);
+	}
+
+	res[len] = 0;
+
+	return res;
+}
+
+const char *
+c_type__Codegen(const struct CodegenType *type)
+{
+	switch (type->kind) {
+		case CODEGEN_TYPE_KIND_INT:
+			return "int64_t";
+		case CODEGEN_TYPE_KIND_DOUBLE:
+			return "double";
+		case CODEGEN_TYPE_KIND_BOOLEAN:
+			return "bool";
+		case CODEGEN_TYPE_KIND_STRING:
+			return "JSONStringSlice";
+		case CODEGEN_TYPE_KIND_STRUCT:
+			return type->c_name;
+		default:
+			FATAL("Unexpected type");
+	}
+}
+
+void
+generate_struct__Codegen(struct Codegen *self, const struct CodegenType *type)
+{
+	if (type->is_duplicate) {
+		return;
+	}
+
+	// Nested structs first
+	for (size_t i = 0; i < type->fields_len; ++i) {
+		const struct CodegenType *field_type = &type->fields[i].type;
+
+		if (field_type->kind == CODEGEN_TYPE_KIND_ARRAY) {
+			field_type = field_type->items;
+		}
+
+		if (field_type->kind == CODEGEN_TYPE_KIND_STRUCT) {
+			generate_struct__Codegen(self, field_type);
+		}
+	}
+
+	push__CodegenBuffer(&self->header, "typedef struct %s {\n", type->c_name);
+
+	for (size_t i = 0; i < type->fields_len; ++i) {
+		const struct CodegenField *field = &type->fields[i];
+
+		if (field->type.kind == CODEGEN_TYPE_KIND_ARRAY) {
+			push__CodegenBuffer(&self->header, "\t%s %s[%zu];\n\tsize_t %s_len;\n",
+				c_type__Codegen(field->type.items), field->c_name, field->type.max_items, field->c_name);
+		} else {
+			push__CodegenBuffer(&self->header, "\t%s %s;\n", c_type__Codegen(&field->type), field->c_name);
+		}
+	}
+
+	if (type->fields_len == 0) {
+		push__CodegenBuffer(&self->header, "\tchar unused;\n");
+	}
+
+	push__CodegenBuffer(&self->header, "} %s;\n\n", type->c_name);
+}
+
+void
+generate_value__Codegen(struct Codegen *self, const struct CodegenType *type, const char *lvalue)
+{
+	switch (type->kind) {
+		case CODEGEN_TYPE_KIND_INT:
+			push__CodegenBuffer(&self->source, "parse_int__%s(self, &%s)", self->parser_name, lvalue);
+
+			break;
+		case CODEGEN_TYPE_KIND_DOUBLE:
+			push__CodegenBuffer(&self->source, "parse_double__%s(self, &%s)", self->parser_name, lvalue);
+
+			break;
+		case CODEGEN_TYPE_KIND_BOOLEAN:
+			push__CodegenBuffer(&self->source, "parse_boolean__%s(self, &%s)", self->parser_name, lvalue);
+
+			break;
+		case CODEGEN_TYPE_KIND_STRING:
+			push__CodegenBuffer(&self->source, "parse_string__%s(self, &%s)", self->parser_name, lvalue);
+
+			break;
+		case CODEGEN_TYPE_KIND_STRUCT:
+			push__CodegenBuffer(&self->source, "parse_%s__%s(self, &%s)", type->c_name, self->parser_name, lvalue);
+
+			break;
+		default:
+			FATAL("Unexpected type");
+	}
+}
+
+void
+generate_array__Codegen(struct Codegen *self, const struct CodegenType *parent, const struct CodegenField *field)
+{
+	push__CodegenBuffer(&self->source,
+		"static uint32_t\n"
+		"parse_%s__%s(struct %s *self, %s *res)\n"
+		"{\n"
+		"\tif (peek__%s(self) != '[') {\n"
+		"\t\treturn %s_EXPECTED_ARRAY;\n"
+		"\t}\n"
+		"\n"
+		"\t++self->count;\n"
+		"\n"
+		"\tsize_t len = 0;\n"
+		"\tunsigned char c = skip_whitespace__%s(self);\n"
+		"\n"
+		"\twhile (c != ']') {\n"
+		"\t\tuint32_t status;\n"
+		"\n"
+		"\t\tif (len == %zu) {\n"
+		"\t\t\treturn %s_ARRAY_CAPACITY_EXCEEDED;\n"
+		"\t\t} else if (!skip_null__%s(self) && (status = ",
+		field->array_c_name, self->parser_name, self->parser_name, parent->c_name,
+		self->parser_name,
+		self->upper_name,
+		self->parser_name,
+		field->type.max_items,
+		self->upper_name,
+		self->parser_name);
+
+	char *lvalue = format__Codegen("res->%s[len]", field->c_name);
+
+	generate_value__Codegen(self, field->type.items, lvalue);
+	free(lvalue);
+
+	push__CodegenBuffer(&self->source,
+		")) {\n"
+		"\t\t\treturn status;\n"
+		"\t\t}\n"
+		"\n"
+		"\t\t++len;\n"
+		"\t\tc = skip_whitespace__%s(self);\n"
+		"\n"
+		"\t\tif (c == ',') {\n"
+		"\t\t\t++self->count;\n"
+		"\t\t\tskip_whitespace__%s(self);\n"
+		"\t\t} else if (c != ']') {\n"
+		"\t\t\treturn %s_EXPECTED_VALUE_SEPARATOR;\n"
+		"\t\t}\n"
+		"\t}\n"
+		"\n"
+		"\t++self->count; // Skip `]`\n"
+		"\n"
+		"\tres->%s_len = len;\n"
+		"\n"
+		"\treturn %s_NO_ERROR;\n"
+		"}\n\n",
+		self->parser_name,
+		self->parser_name,
+		self->upper_name,
+		field->c_name,
+		self->upper_name);
+}
+
+void
+generate_parse__Codegen(struct Codegen *self, const struct CodegenType *type)
+{
+	uint64_t required_mask = 0;
+	size_t max_name_len = 0;
+
+	if (type->is_duplicate) {
+		return;
+	}
+
+	for (size_t i = 0; i < type->fields_len; ++i) {
+		const struct CodegenField *field = &type->fields[i];
+		const struct CodegenType *field_type = field->type.kind == CODEGEN_TYPE_KIND_ARRAY ? field->type.items : &field->type;
+
+		if (field_type->kind == CODEGEN_TYPE_KIND_STRUCT) {
+			generate_parse__Codegen(self, field_type);
+		}
+
+		if (field->type.kind == CODEGEN_TYPE_KIND_ARRAY) {
+			generate_array__Codegen(self, type, field);
+		}
+
+		if (field->name_len > max_name_len) {
+			max_name_len = field->name_len;
+		}
+	}
+
+	push__CodegenBuffer(&self->source,
+		"static uint32_t\n"
+		"parse_%s__%s(struct %s *self, %s *res)\n"
+		"{\n"
+		"\tif (peek__%s(self) != '{') {\n"
+		"\t\treturn %s_EXPECTED_OBJECT;\n"
+		"\t}\n"
+		"\n"
+		"\t++self->count;\n"
+		"\n"
+		"\tuint64_t seen = 0;\n"
+		"\tunsigned char c = skip_whitespace__%s(self);\n"
+		"\n"
+		"\twhile (c != '}') {\n"
+		"\t\tconst char *key;\n"
+		"\t\tsize_t key_len;\n"
+		"\t\tchar key_buffer[%zu];\n"
+		"\t\tuint32_t status;\n"
+		"\n"
+		"\t\tif (c != '\"') {\n"
+		"\t\t\treturn %s_EXPECTED_MEMBER;\n"
+		"\t\t} else if ((status = parse_key__%s(self, key_buffer, sizeof(key_buffer), &key, &key_len))) {\n"
+		"\t\t\treturn status;\n"
+		"\t\t}\n"
+		"\n"
+		"\t\tstatus = %s_UNKNOWN_MEMBER;\n"
+		"\n"
+		"\t\tswitch (key_len) {\n",
+		type->c_name, self->parser_name, self->parser_name, type->c_name,
+		self->parser_name,
+		self->upper_name,
+		self->parser_name,
+		max_name_len > 0 ? max_name_len : 1, // Room for the longest name
+		self->upper_name,
+		self->parser_name,
+		self->upper_name);
+
+	size_t required_index = 0;
+
+	for (size_t len = 0; len <= max_name_len; ++len) {
+		bool has_case = false;
+
+		for (size_t i = 0; i < type->fields_len; ++i) {
+			const struct CodegenField *field = &type->fields[i];
+
+			if (field->name_len != len) {
+				continue;
+			}
+
+			if (!has_case) {
+				push__CodegenBuffer(&self->source, "\t\t\tcase %zu:\n\t\t\t\tif (", len);
+				has_case = true;
+			} else {
+				push__CodegenBuffer(&self->source, " else if (");
+			}
+
+			if (len > 0) {
+				push__CodegenBuffer(&self->source, "!memcmp(key, ");
+				push_literal__CodegenBuffer(&self->source, field->name, field->name_len);
+				push__CodegenBuffer(&self->source, ", %zu)", len);
+			} else {
+				push__CodegenBuffer(&self->source, "true");
+			}
+
+			push__CodegenBuffer(&self->source, ") {\n\t\t\t\t\tstatus = skip_null__%s(self) ? %s_NO_ERROR : ", self->parser_name, self->upper_name);
+
+			if (field->type.kind == CODEGEN_TYPE_KIND_ARRAY) {
+				push__CodegenBuffer(&self->source, "parse_%s__%s(self, res)", field->array_c_name, self->parser_name);
+			} else {
+				char *lvalue = format__Codegen("res->%s", field->c_name);
+
+				generate_value__Codegen(self, &field->type, lvalue);
+				free(lvalue);
+			}
+
+			push__CodegenBuffer(&self->source, ";\n");
+
+			if (field->is_required) {
+				required_mask |= (uint64_t)1 << required_index;
+				push__CodegenBuffer(&self->source, "\t\t\t\t\tseen |= (uint64_t)1 << %zu;\n", required_index++);
+			}
+
+			push__CodegenBuffer(&self->source, "\t\t\t\t}");
+		}
+
+		if (has_case) {
+			push__CodegenBuffer(&self->source, "\n\n\t\t\t\tbreak;\n");
+		}
+	}
+
+	push__CodegenBuffer(&self->source,
+		"\t\t}\n"
+		"\n"
+		"\t\tif (status == %s_UNKNOWN_MEMBER) {\n"
+		"\t\t\tstatus = skip_value__%s(self);\n"
+		"\t\t}\n"
+		"\n"
+		"\t\tif (status) {\n"
+		"\t\t\treturn status;\n"
+		"\t\t}\n"
+		"\n"
+		"\t\tc = skip_whitespace__%s(self);\n"
+		"\n"
+		"\t\tif (c == ',') {\n"
+		"\t\t\t++self->count;\n"
+		"\n"
+		"\t\t\tif ((c = skip_whitespace__%s(self)) == '}') {\n"
+		"\t\t\t\treturn %s_EXPECTED_MEMBER;\n"
+		"\t\t\t}\n"
+		"\t\t} else if (c != '}') {\n"
+		"\t\t\treturn %s_EXPECTED_VALUE_SEPARATOR;\n"
+		"\t\t}\n"
+		"\t}\n"
+		"\n"
+		"\t++self->count; // Skip `}`\n"
+		"\n"
+		"\tif ((seen & 0x%llxULL) != 0x%llxULL) {\n"
+		"\t\treturn %s_MISSING_REQUIRED_MEMBER;\n"
+		"\t}\n"
+		"\n"
+		"\treturn %s_NO_ERROR;\n"
+		"}\n\n",
+		self->upper_name,
+		self->parser_name,
+		self->parser_name,
+		self->parser_name,
+		self->upper_name,
+		self->upper_name,
+		(unsigned long long)required_mask, (unsigned long long)required_mask,
+		self->upper_name,
+		self->upper_name);
+}
+
+// The runtime shared by every generated struct parser. `@` stands for the
+// parser name and `$` for its upper snake case counterpart.
+static const char *codegen_prelude =
+	"struct @ {\n"
+	"\tconst char *content;\n"
+	"\tsize_t len;\n"
+	"\tsize_t count;\n"
+	"};\n"
+	"\n"
+	"#define $_NO_ERROR 0\n"
+	"#define $_EXPECTED_OBJECT 1\n"
+	"#define $_EXPECTED_ARRAY 2\n"
+	"#define $_EXPECTED_MEMBER 3\n"
+	"#define $_EXPECTED_NAME_SEPARATOR 4\n"
+	"#define $_EXPECTED_VALUE_SEPARATOR 5\n"
+	"#define $_EXPECTED_INTEGER 6\n"
+	"#define $_EXPECTED_NUMBER 7\n"
+	"#define $_EXPECTED_BOOLEAN 8\n"
+	"#define $_EXPECTED_STRING 9\n"
+	"#define $_INTEGER_OVERFLOW 10\n"
+	"#define $_ARRAY_CAPACITY_EXCEEDED 11\n"
+	"#define $_MISSING_REQUIRED_MEMBER 12\n"
+	"#define $_INVALID_VALUE 13\n"
+	"#define $_UNKNOWN_MEMBER 14\n"
+	"#define $_TRAILING_CONTENT 15\n"
+	"\n"
+	"static inline unsigned char\n"
+	"peek__@(const struct @ *self)\n"
+	"{\n"
+	"\treturn self->count < self->len ? self->content[self->count] : 0;\n"
+	"}\n"
+	"\n"
+	"static inline unsigned char\n"
+	"skip_whitespace__@(struct @ *self)\n"
+	"{\n"
+	"\twhile (self->count < self->len) {\n"
+	"\t\tswitch (self->content[self->count]) {\n"
+	"\t\t\tcase ' ':\n"
+	"\t\t\tcase '\\t':\n"
+	"\t\t\tcase '\\n':\n"
+	"\t\t\tcase '\\r':\n"
+	"\t\t\t\t++self->count;\n"
+	"\n"
+	"\t\t\t\tbreak;\n"
+	"\t\t\tdefault:\n"
+	"\t\t\t\treturn self->content[self->count];\n"
+	"\t\t}\n"
+	"\t}\n"
+	"\n"
+	"\treturn 0;\n"
+	"}\n"
+	"\n"
+	"static inline bool\n"
+	"skip_null__@(struct @ *self)\n"
+	"{\n"
+	"\tif (self->len - self->count >= 4 && !memcmp(self->content + self->count, \"null\", 4)) {\n"
+	"\t\tself->count += 4;\n"
+	"\n"
+	"\t\treturn true;\n"
+	"\t}\n"
+	"\n"
+	"\treturn false;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"skip_string__@(struct @ *self, bool *has_escapes)\n"
+	"{\n"
+	"\t++self->count; // Skip `\"`\n"
+	"\n"
+	"\twhile (self->count < self->len) {\n"
+	"\t\tunsigned char c = self->content[self->count++];\n"
+	"\n"
+	"\t\tif (c == '\"') {\n"
+	"\t\t\treturn $_NO_ERROR;\n"
+	"\t\t} else if (c == '\\\\') {\n"
+	"\t\t\t*has_escapes = true;\n"
+	"\t\t\t++self->count;\n"
+	"\t\t} else if (c < 0x20) {\n"
+	"\t\t\treturn $_INVALID_VALUE;\n"
+	"\t\t}\n"
+	"\t}\n"
+	"\n"
+	"\treturn $_INVALID_VALUE;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"skip_value__@(struct @ *self)\n"
+	"{\n"
+	"\tJSONStatus status = skip_value__JSON(self->content, self->len, self->count, &self->count);\n"
+	"\n"
+	"\treturn is_err__JSONStatus(&status) ? $_INVALID_VALUE : $_NO_ERROR;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"parse_key__@(struct @ *self, char *buffer, size_t buffer_capacity, const char **key, size_t *key_len)\n"
+	"{\n"
+	"\t// NOTE: Escaped member names are decoded into `buffer`, which has room\n"
+	"\t// for the longest known name. A name which does not fit, or with an\n"
+	"\t// invalid escape, gets a length of SIZE_MAX and matches no member.\n"
+	"\tsize_t start = self->count + 1;\n"
+	"\tbool has_escapes = false;\n"
+	"\n"
+	"\tif (skip_string__@(self, &has_escapes)) {\n"
+	"\t\treturn $_INVALID_VALUE;\n"
+	"\t}\n"
+	"\n"
+	"\t*key = self->content + start;\n"
+	"\t*key_len = self->count - 1 - start;\n"
+	"\n"
+	"\tif (has_escapes) {\n"
+	"\t\t*key_len = unescape__JSON(*key, *key_len, buffer, buffer_capacity);\n"
+	"\t\t*key = buffer;\n"
+	"\t}\n"
+	"\n"
+	"\tif (skip_whitespace__@(self) != ':') {\n"
+	"\t\treturn $_EXPECTED_NAME_SEPARATOR;\n"
+	"\t}\n"
+	"\n"
+	"\t++self->count;\n"
+	"\tskip_whitespace__@(self);\n"
+	"\n"
+	"\treturn $_NO_ERROR;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"scan_digits__@(struct @ *self, uint64_t *mantissa, int *digits)\n"
+	"{\n"
+	"\tsize_t start = self->count;\n"
+	"\n"
+	"\twhile (self->count < self->len && (unsigned char)(self->content[self->count] - '0') < 10) {\n"
+	"\t\tif (*digits < 19) {\n"
+	"\t\t\t*mantissa = *mantissa * 10 + (self->content[self->count] - '0');\n"
+	"\t\t}\n"
+	"\n"
+	"\t\t*digits += *mantissa != 0;\n"
+	"\t\t++self->count;\n"
+	"\t}\n"
+	"\n"
+	"\treturn self->count > start ? $_NO_ERROR : $_EXPECTED_NUMBER;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"parse_int__@(struct @ *self, int64_t *res)\n"
+	"{\n"
+	"\tbool is_negative = peek__@(self) == '-';\n"
+	"\tuint64_t limit = is_negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;\n"
+	"\tuint64_t value = 0;\n"
+	"\n"
+	"\tself->count += is_negative;\n"
+	"\n"
+	"\tif (peek__@(self) == '0') {\n"
+	"\t\t++self->count;\n"
+	"\t} else if ((unsigned char)(peek__@(self) - '0') < 10) {\n"
+	"\t\twhile (self->count < self->len && (unsigned char)(self->content[self->count] - '0') < 10) {\n"
+	"\t\t\tuint64_t digit = self->content[self->count++] - '0';\n"
+	"\n"
+	"\t\t\tif (value > (limit - digit) / 10) {\n"
+	"\t\t\t\treturn $_INTEGER_OVERFLOW;\n"
+	"\t\t\t}\n"
+	"\n"
+	"\t\t\tvalue = value * 10 + digit;\n"
+	"\t\t}\n"
+	"\t} else {\n"
+	"\t\treturn $_EXPECTED_INTEGER;\n"
+	"\t}\n"
+	"\n"
+	"\tswitch (peek__@(self)) {\n"
+	"\t\tcase '.':\n"
+	"\t\tcase 'e':\n"
+	"\t\tcase 'E':\n"
+	"\t\t\treturn $_EXPECTED_INTEGER;\n"
+	"\t}\n"
+	"\n"
+	"\t*res = is_negative ? (int64_t)(0 - value) : (int64_t)value;\n"
+	"\n"
+	"\treturn $_NO_ERROR;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"parse_double__@(struct @ *self, double *res)\n"
+	"{\n"
+	"\t// Exact when the significand fits in 53 bits and the power of ten is\n"
+	"\t// exactly representable (Clinger's fast path), strtod otherwise.\n"
+	"\tstatic const double powers_of_ten[] = {\n"
+	"\t\t1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,\n"
+	"\t\t1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22\n"
+	"\t};\n"
+	"\n"
+	"\tsize_t start = self->count;\n"
+	"\tbool is_negative = peek__@(self) == '-';\n"
+	"\tuint64_t mantissa = 0;\n"
+	"\tint digits = 0;\n"
+	"\tint exponent = 0;\n"
+	"\n"
+	"\tself->count += is_negative;\n"
+	"\n"
+	"\tif (peek__@(self) == '0') {\n"
+	"\t\t++self->count;\n"
+	"\t} else if (scan_digits__@(self, &mantissa, &digits)) {\n"
+	"\t\treturn $_EXPECTED_NUMBER;\n"
+	"\t}\n"
+	"\n"
+	"\tif (peek__@(self) == '.') {\n"
+	"\t\t++self->count;\n"
+	"\n"
+	"\t\tsize_t fraction_start = self->count;\n"
+	"\n"
+	"\t\tif (scan_digits__@(self, &mantissa, &digits)) {\n"
+	"\t\t\treturn $_EXPECTED_NUMBER;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\texponent -= (int)(self->count - fraction_start);\n"
+	"\t}\n"
+	"\n"
+	"\tif (peek__@(self) == 'e' || peek__@(self) == 'E') {\n"
+	"\t\t++self->count;\n"
+	"\n"
+	"\t\tbool is_exponent_negative = peek__@(self) == '-';\n"
+	"\t\tint explicit_exponent = 0;\n"
+	"\n"
+	"\t\tself->count += peek__@(self) == '-' || peek__@(self) == '+';\n"
+	"\n"
+	"\t\tif ((unsigned char)(peek__@(self) - '0') >= 10) {\n"
+	"\t\t\treturn $_EXPECTED_NUMBER;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\twhile ((unsigned char)(peek__@(self) - '0') < 10) {\n"
+	"\t\t\tif (explicit_exponent < 10000) {\n"
+	"\t\t\t\texplicit_exponent = explicit_exponent * 10 + (self->content[self->count] - '0');\n"
+	"\t\t\t}\n"
+	"\n"
+	"\t\t\t++self->count;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\texponent += is_exponent_negative ? -explicit_exponent : explicit_exponent;\n"
+	"\t}\n"
+	"\n"
+	"\tif (digits <= 15 && exponent >= -22 && exponent <= 22) {\n"
+	"\t\tdouble value = (double)mantissa;\n"
+	"\n"
+	"\t\tvalue = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];\n"
+	"\t\t*res = is_negative ? -value : value;\n"
+	"\n"
+	"\t\treturn $_NO_ERROR;\n"
+	"\t}\n"
+	"\n"
+	"\tchar number[128];\n"
+	"\tsize_t number_len = self->count - start;\n"
+	"\n"
+	"\tif (number_len >= sizeof(number)) {\n"
+	"\t\treturn $_EXPECTED_NUMBER;\n"
+	"\t}\n"
+	"\n"
+	"\tmemcpy(number, self->content + start, number_len);\n"
+	"\tnumber[number_len] = 0;\n"
+	"\n"
+	"\t*res = strtod(number, NULL);\n"
+	"\n"
+	"\treturn $_NO_ERROR;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"parse_boolean__@(struct @ *self, bool *res)\n"
+	"{\n"
+	"\tif (self->len - self->count >= 4 && !memcmp(self->content + self->count, \"true\", 4)) {\n"
+	"\t\tself->count += 4;\n"
+	"\t\t*res = true;\n"
+	"\t} else if (self->len - self->count >= 5 && !memcmp(self->content + self->count, \"false\", 5)) {\n"
+	"\t\tself->count += 5;\n"
+	"\t\t*res = false;\n"
+	"\t} else {\n"
+	"\t\treturn $_EXPECTED_BOOLEAN;\n"
+	"\t}\n"
+	"\n"
+	"\treturn $_NO_ERROR;\n"
+	"}\n"
+	"\n"
+	"static uint32_t\n"
+	"parse_string__@(struct @ *self, JSONStringSlice *res)\n"
+	"{\n"
+	"\tif (peek__@(self) != '\"') {\n"
+	"\t\treturn $_EXPECTED_STRING;\n"
+	"\t}\n"
+	"\n"
+	"\tsize_t start = self->count + 1;\n"
+	"\tbool has_escapes = false;\n"
+	"\n"
+	"\tif (skip_string__@(self, &has_escapes)) {\n"
+	"\t\treturn $_INVALID_VALUE;\n"
+	"\t}\n"
+	"\n"
+	"\t*res = (JSONStringSlice){\n"
+	"\t\t.buffer = self->content + start,\n"
+	"\t\t.len = self->count - 1 - start,\n"
+	"\t\t.has_escapes = has_escapes\n"
+	"\t};\n"
+	"\n"
+	"\treturn $_NO_ERROR;\n"
+	"}\n"
+	"\n";
+
+static const char *codegen_entry_point =
+	"JSONStatus\n"
+	"parse__#(const char *content, size_t content_len, # *out)\n"
+	"{\n"
+	"\tstruct @ self = {\n"
+	"\t\t.content = content,\n"
+	"\t\t.len = content_len,\n"
+	"\t\t.count = 0\n"
+	"\t};\n"
+	"\tconst char *msg;\n"
+	"\n"
+	"\tskip_whitespace__@(&self);\n"
+	"\n"
+	"\tuint32_t status = parse_#__@(&self, out);\n"
+	"\n"
+	"\tif (status == $_NO_ERROR && (skip_whitespace__@(&self), self.count < self.len)) {\n"
+	"\t\tstatus = $_TRAILING_CONTENT;\n"
+	"\t}\n"
+	"\n"
+	"\tswitch (status) {\n"
+	"\t\tcase $_NO_ERROR:\n"
+	"\t\t\treturn (JSONStatus){ .kind = JSON_VALUE_RESULT_KIND_OK };\n"
+	"\t\tcase $_EXPECTED_OBJECT:\n"
+	"\t\t\tmsg = \"Expected to have `{`\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_ARRAY:\n"
+	"\t\t\tmsg = \"Expected to have `[`\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_MEMBER:\n"
+	"\t\t\tmsg = \"Expected member\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_NAME_SEPARATOR:\n"
+	"\t\t\tmsg = \"Expected name separator\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_VALUE_SEPARATOR:\n"
+	"\t\t\tmsg = \"Expected `,`\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_INTEGER:\n"
+	"\t\t\tmsg = \"Expected integer\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_NUMBER:\n"
+	"\t\t\tmsg = \"Expected number\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_BOOLEAN:\n"
+	"\t\t\tmsg = \"Expected boolean\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_EXPECTED_STRING:\n"
+	"\t\t\tmsg = \"Expected string\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_INTEGER_OVERFLOW:\n"
+	"\t\t\tmsg = \"Integer overflow\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_ARRAY_CAPACITY_EXCEEDED:\n"
+	"\t\t\tmsg = \"Array capacity exceeded\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_MISSING_REQUIRED_MEMBER:\n"
+	"\t\t\tmsg = \"Missing required member\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tcase $_TRAILING_CONTENT:\n"
+	"\t\t\tmsg = \"Unexpected content after the value\";\n"
+	"\n"
+	"\t\t\tbreak;\n"
+	"\t\tdefault:\n"
+	"\t\t\tmsg = \"Invalid value\";\n"
+	"\t}\n"
+	"\n"
+	"\treturn (JSONStatus){\n"
+	"\t\t.kind = JSON_VALUE_RESULT_KIND_ERR,\n"
+	"\t\t.err = {\n"
+	"\t\t\t.kind = JSON_VALUE_RESULT_ERROR_PARSE_FAILED,\n"
+	"\t\t\t.msg = msg,\n"
+	"\t\t\t.offset = self.count\n"
+	"\t\t}\n"
+	"\t};\n"
+	"}\n";
+
+char *
+read_file__Codegen(const char *path, size_t *len)
+{
+	FILE *file = fopen(path, "rb");
+
+	if (!file) {
+		FATAL("Cannot open %s", path);
+	}
+
+	struct CodegenBuffer buffer = { 0 };
+	char chunk[4096];
+	size_t n;
+
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		push__CodegenBuffer(&buffer, "%.*s", (int)n, chunk);
+	}
+
+	fclose(file);
+
+	*len = buffer.len;
+
+	return buffer.buffer;
+}
+
+void
+write_file__Codegen(const char *path, const struct CodegenBuffer *buffer)
+{
+	FILE *file = fopen(path, "wb");
+
+	if (!file || fwrite(buffer->buffer, 1, buffer->len, file) != buffer->len) {
+		FATAL("Cannot write %s", path);
+	}
+
+	fclose(file);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc != 4) {
+		fprintf(stderr, "Usage: %s <schema.json> <output.c> <output.h>\n", argv[0]);
+
+		return 1;
+	}
+
+	size_t schema_len;
+	char *schema_s = read_file__Codegen(argv[1], &schema_len);
+
+	if (!schema_s) {
+		FATAL("%s: empty schema", argv[1]);
+	}
+
+	JSONValueResult schema_result = parse__JSON(schema_s, schema_len);
+
+	if (is_err__JSONValueResult(&schema_result)) {
+		FATAL("%s: %s", argv[1], schema_result.err.msg);
+	}
+
+	struct CodegenNames names = { 0 };
+	struct CodegenType root;
+
+	init__CodegenType(&root, unwrap__JSONValueResult(&schema_result), "Root", &names);
+
+	if (root.kind != CODEGEN_TYPE_KIND_STRUCT) {
+		FATAL("%s: the root schema must be an object", argv[1]);
+	}
+
+	struct Codegen self = {
+		.name = root.c_name,
+		.parser_name = format__Codegen("%sParser", root.c_name),
+		.header = { 0 },
+		.source = { 0 }
+	};
+
+	self.upper_name = upper_snake_case__Codegen(self.parser_name);
+
+	// The header is included by its file name, relatively to the source.
+	const char *header_name = strrchr(argv[3], '/') ? strrchr(argv[3], '/') + 1 : argv[3];
+
+	push__CodegenBuffer(&self.header,
+		"// Generated by json_codegen from %s, do not edit.\n"
+		"\n"
+		"#ifndef %s_H\n"
+		"#define %s_H\n"
+		"\n"
+		"#include <stddef.h>\n"
+		"#include <stdbool.h>\n"
+		"#include <stdint.h>\n"
+		"\n"
+		"#include \"json.h\"\n"
+		"\n",
+		argv[1], self.upper_name, self.upper_name);
+
+	generate_struct__Codegen(&self, &root);
+
+	push__CodegenBuffer(&self.header,
+		"// Strings are borrowed from `content`. Members set to `null` are left\n"
+		"// untouched, unknown members are skipped.\n"
+		"JSONStatus\n"
+		"parse__%s(const char *content, size_t content_len, %s *out);\n"
+		"\n"
+		"#endif // %s_H\n",
+		self.name, self.name, self.upper_name);
+
+	push__CodegenBuffer(&self.source,
+		"// Generated by json_codegen from %s, do not edit.\n"
+		"\n"
+		"#include <stdlib.h>\n"
+		"#include <string.h>\n"
+		"\n"
+		"#include \"%s\"\n"
+		"\n",
+		argv[1], header_name);
+	push_template__CodegenBuffer(&self.source, codegen_prelude, self.parser_name, self.upper_name);
+
+	// The struct parsers are emitted depth first, callees before callers.
+	generate_parse__Codegen(&self, &root);
+
+	// `#` stands for the root struct name in the entry point.
+	for (const char *c = codegen_entry_point; *c; ++c) {
+		if (*c == '#') {
+			push__CodegenBuffer(&self.source, "%s", self.name);
+		} else {
+			char s[2] = { *c, 0 };
+
+			push_template__CodegenBuffer(&self.source, s, self.parser_name, self.upper_name);
+		}
+	}
+
+	write_file__Codegen(argv[2], &self.source);
+	write_file__Codegen(argv[3], &self.header);
+
+	deinit__CodegenBuffer(&self.header);
+	deinit__CodegenBuffer(&self.source);
+	free(self.parser_name);
+	free(self.upper_name);
+	deinit__CodegenType(&root);
+	deinit__CodegenNames(&names);
+	deinit__JSONValueResult(&schema_result);
+	free(schema_s);
+
+	return 0;
+}
@@ -22,15 +22,46 @@
 * SOFTWARE.
 */
 
+#if defined(JSON_STATS) || defined(JSON_THREADS)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+
+#if defined(JSON_STATS) || defined(JSON_THREADS)
+#include <time.h>
+#endif
+
+#ifdef JSON_THREADS
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(JSON_NO_SIMD) && defined(__SSE2__)
+#define JSON_SIMD_SSE2
+#include <emmintrin.h>
+#elif !defined(JSON_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define JSON_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 #include "json.h"
 
+#if defined(__GNUC__)
+#define JSON_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define JSON_PREFETCH(ptr)
+#endif
+
 #define FATAL(msg, ...) \
 	fprintf(stderr, "FATAL(%d): "msg"\n", __LINE__, ##__VA_ARGS__); \
 	exit(1);
@@ -39,10 +70,77 @@
 	fprintf(stderr, "UNREACHABLE(%d): "msg"\n", __LINE__, ##__VA_ARGS__); \
 	exit(1);
 
+#ifdef JSON_STATS
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define JSON_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define JSON_THREAD_LOCAL __declspec(thread)
+#else
+#define JSON_THREAD_LOCAL __thread
+#endif
+
+// Stats of the parse running on the current thread, NULL unless its options
+// have `stats`.
+static JSON_THREAD_LOCAL JSONParseStats *json_stats = NULL;
+static JSON_THREAD_LOCAL size_t json_stats_depth = 0;
+
+static inline uint64_t
+now_ns__JSONParseStats(void);
+
+// NOTE: Each macro expands to a single statement, except
+// JSON_STATS_TIME_START which declares `name`.
+#define JSON_STATS_ADD(field, n) \
+	do { \
+		if (json_stats) { \
+			json_stats->field += (n); \
+		} \
+	} while (0)
+#define JSON_STATS_MAX(field, n) \
+	do { \
+		if (json_stats && json_stats->field < (n)) { \
+			json_stats->field = (n); \
+		} \
+	} while (0)
+#define JSON_STATS_TIME_START(name) \
+	uint64_t name = json_stats ? now_ns__JSONParseStats() : 0
+#define JSON_STATS_TIME_END(field, name) \
+	JSON_STATS_ADD(field, now_ns__JSONParseStats() - (name))
+#define JSON_STATS_ENTER() \
+	do { \
+		++json_stats_depth; \
+		JSON_STATS_MAX(max_depth, json_stats_depth); \
+	} while (0)
+#define JSON_STATS_LEAVE() \
+	do { \
+		--json_stats_depth; \
+	} while (0)
+#else
+#define JSON_STATS_ADD(field, n) do { } while (0)
+#define JSON_STATS_MAX(field, n) do { } while (0)
+#define JSON_STATS_TIME_START(name) do { } while (0)
+#define JSON_STATS_TIME_END(field, name) do { } while (0)
+#define JSON_STATS_ENTER() do { } while (0)
+#define JSON_STATS_LEAVE() do { } while (0)
+#endif
+
 struct JSONContentIterator {
 	const char *content;
 	size_t len;
 	size_t count;
+	const JSONParseOptions *options; // NULL for the defaults
+	// Shape expected for the next object, see `parse_array_value__JSON`
+	struct JSONObjectShape *shape;
+};
+
+// The member names and the index shared by objects with the same members in
+// the same order.
+struct JSONObjectShape {
+	JSONValueString *keys;
+	size_t len;
+	uint32_t *index;
+	size_t capacity;
+	bool is_raw; // No name needs escaping, so they can be compared to the content
+	size_t ref_count;
 };
 
 static inline struct JSONContentIterator
@@ -72,6 +170,265 @@ expect_character__JSONContentIterator(struct JSONContentIterator *self, char exp
 static bool
 expect_characters__JSONContentIterator(struct JSONContentIterator *self, char *expected, size_t expected_len);
 
+// NOTE: The following functions work on bytes rather than on codepoints, they
+// never decode UTF-8 and return 0 at the end of the content.
+
+static inline unsigned char
+peek__JSONContentIterator(const struct JSONContentIterator *self);
+
+static inline unsigned char
+skip_whitespace__JSONContentIterator(struct JSONContentIterator *self);
+
+#define JSON_SKIP_MAX_DEPTH 1024
+
+#define SKIP_NO_ERROR 0
+#define SKIP_UNEXPECTED_END 1
+#define SKIP_UNEXPECTED_CHARACTER 2
+#define SKIP_MISMATCHED_BRACKET 3
+#define SKIP_TOO_DEEP 4
+#define SKIP_INVALID_STRING 5
+#define SKIP_INVALID_LITERAL 6
+#define SKIP_INVALID_NUMBER 7
+#define SKIP_OUT_OF_MEMORY 8
+
+// Bitmasks of the characters of a 64 bytes block, bit N for byte N.
+struct JSONBlockMasks {
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t open; // `{` and `[`
+	uint64_t close; // `}` and `]`
+	uint64_t control; // 0x00 to 0x1F
+};
+
+static inline struct JSONBlockMasks
+init__JSONBlockMasks(const unsigned char *block);
+
+// Bitmask of the `"`, `\`, control characters and, if `stop_at_non_ascii`,
+// non-ASCII bytes among the 16 bytes at `chunk`.
+static inline uint32_t
+string_mask__JSONBlockMasks(const unsigned char *chunk, bool stop_at_non_ascii);
+
+// Bitmask of the whitespace among the 16 bytes at `chunk`.
+static inline uint32_t
+whitespace_mask__JSONBlockMasks(const unsigned char *chunk);
+
+static inline uint64_t
+find_escaped__JSONBlockMasks(uint64_t backslash, uint64_t *escaped_carry);
+
+static inline uint64_t
+prefix_xor__JSONBlockMasks(uint64_t bits);
+
+static inline uint32_t
+trailing_zeros__JSONBlockMasks(uint64_t bits);
+
+static uint32_t
+skip_string__JSONContentIterator(struct JSONContentIterator *self, bool *has_escapes);
+
+static uint32_t
+skip_container__JSONContentIterator(struct JSONContentIterator *self);
+
+static uint32_t
+skip_literal__JSONContentIterator(struct JSONContentIterator *self, const char *literal, size_t literal_len);
+
+static uint32_t
+skip_value__JSONContentIterator(struct JSONContentIterator *self);
+
+static JSONStatus
+skip_status__JSON(const struct JSONContentIterator *iter, uint32_t res);
+
+#define VALIDATE_NO_ERROR 0
+#define VALIDATE_UNEXPECTED_END 1
+#define VALIDATE_UNEXPECTED_CHARACTER 2
+#define VALIDATE_EXPECTED_MEMBER 3
+#define VALIDATE_EXPECTED_NAME_SEPARATOR 4
+#define VALIDATE_EXPECTED_VALUE_SEPARATOR 5
+#define VALIDATE_INVALID_NUMBER 6
+#define VALIDATE_INVALID_LITERAL 7
+#define VALIDATE_INVALID_ESCAPE 8
+#define VALIDATE_INVALID_UTF8 9
+#define VALIDATE_CONTROL_CHARACTER 10
+#define VALIDATE_TOO_DEEP 11
+#define VALIDATE_TRAILING_CONTENT 12
+
+static uint32_t
+validate_utf8__JSONContentIterator(struct JSONContentIterator *self);
+
+static uint32_t
+validate_string__JSONContentIterator(struct JSONContentIterator *self);
+
+static uint32_t
+validate_member_name__JSONContentIterator(struct JSONContentIterator *self);
+
+static uint32_t
+validate_literal__JSONContentIterator(struct JSONContentIterator *self, const char *literal, size_t literal_len);
+
+static uint32_t
+validate_value__JSONContentIterator(struct JSONContentIterator *self);
+
+static JSONStatus
+validate_status__JSON(const struct JSONContentIterator *iter, uint32_t res);
+
+#define JSON_WRITER_BUFFER_LEN 4096
+
+// Buffers the output of a transform before handing it to the callback.
+struct JSONWriter {
+	JSONWriteCallback write;
+	void *user_data;
+	char buffer[JSON_WRITER_BUFFER_LEN];
+	size_t len;
+};
+
+static inline struct JSONWriter
+init__JSONWriter(JSONWriteCallback write, void *user_data);
+
+static bool
+flush__JSONWriter(struct JSONWriter *self);
+
+static bool
+push__JSONWriter(struct JSONWriter *self, const char *s, size_t s_len);
+
+static bool
+push_newline__JSONWriter(struct JSONWriter *self, size_t indent, size_t depth);
+
+#define FORMAT_NO_ERROR 0
+#define FORMAT_UNEXPECTED_END 1
+#define FORMAT_UNEXPECTED_CHARACTER 2
+#define FORMAT_MISMATCHED_BRACKET 3
+#define FORMAT_TOO_DEEP 4
+#define FORMAT_INVALID_STRING 5
+#define FORMAT_TRAILING_CONTENT 6
+#define FORMAT_WRITE_FAILED 7
+#define FORMAT_EXPECTED_VALUE 8
+#define FORMAT_EXPECTED_MEMBER 9
+#define FORMAT_EXPECTED_NAME_SEPARATOR 10
+#define FORMAT_EXPECTED_VALUE_SEPARATOR 11
+#define FORMAT_INVALID_NUMBER 12
+#define FORMAT_INVALID_LITERAL 13
+
+// What format__JSON accepts next
+#define FORMAT_EXPECT_VALUE 0
+#define FORMAT_EXPECT_MEMBER 1
+#define FORMAT_EXPECT_NAME_SEPARATOR 2
+#define FORMAT_EXPECT_VALUE_SEPARATOR 3
+
+static uint32_t
+format__JSON(struct JSONContentIterator *iter, struct JSONWriter *writer, size_t indent);
+
+static uint32_t
+format_unexpected__JSON(uint32_t state);
+
+static JSONStatus
+format_status__JSON(const struct JSONContentIterator *iter, uint32_t res);
+
+#define JSON_SEQUENCE_RS 0x1E
+#define JSON_SEQUENCE_READ_LEN 65536
+
+static unsigned char
+skip_separators__JSONSequenceIterator(struct JSONContentIterator *iter);
+
+static bool
+fill__JSONSequenceIterator(JSONSequenceIterator *self);
+
+static bool
+find_end__JSONSequenceIterator(JSONSequenceIterator *self);
+
+#ifdef JSON_THREADS
+static size_t
+get_threads__JSON(size_t threads);
+
+static void
+run_workers__JSON(void *(*run)(void *), void *arg, size_t threads);
+
+#define JSON_BATCH_PREFETCH_PER_THREAD 4
+#define JSON_BATCH_MIN_BUFFER_LEN 4096
+#define JSON_BATCH_FD_PENDING -2 // Not opened yet
+#define JSON_BATCH_FD_TAKEN -3 // Claimed by the thread parsing the file
+
+struct JSONBatch {
+	const char *const *paths;
+	size_t paths_len;
+	JSONValueResult *results; // NULL when the results go to `callback`
+	JSONBatchCallback callback;
+	void *user_data;
+	pthread_mutex_t mutex;
+	size_t next; // Next file to parse
+	size_t prefetched; // Files claimed for prefetching so far
+	size_t prefetch_len; // How far ahead of `next` the files are prefetched
+	int *fds; // -1 when the file could not be opened, accessed atomically
+};
+
+static size_t
+claim__JSONBatch(struct JSONBatch *self, int *fd);
+
+static JSONValueResult
+parse_file__JSONBatch(const char *path, int fd, char **buffer, size_t *buffer_capacity);
+
+static void *
+run__JSONBatch(void *self);
+
+static void
+parse_files_base__JSON(struct JSONBatch *batch, size_t threads);
+
+#define JSON_PARALLEL_MIN_SPLIT_LEN 64 // Containers with fewer elements are not split
+#define JSON_PARALLEL_RANGES_PER_THREAD 4
+#define JSON_PARALLEL_MAX_DEPTH 8
+
+struct JSONParallelElement {
+	const JSONValueString *key; // NULL in arrays
+	const JSONValue *value;
+};
+
+// A piece of the output: text written while planning, a whole value, or a
+// range of the elements of a split container.
+struct JSONParallelPiece {
+	const JSONValue *value;
+	const struct JSONParallelElement *elements;
+	size_t elements_len;
+	bool is_first; // No `,` before the first element
+	bool owns_elements;
+	JSONValueString res;
+};
+
+struct JSONParallelPlan {
+	struct JSONParallelPiece *pieces;
+	size_t len;
+	size_t capacity;
+	size_t threads;
+	size_t next; // Next piece to serialize, claimed atomically
+	bool has_failed;
+};
+
+static struct JSONParallelPiece *
+push_piece__JSONParallelPlan(struct JSONParallelPlan *self);
+
+static bool
+push_text__JSONParallelPlan(struct JSONParallelPlan *self, const char *s, size_t s_len);
+
+static bool
+split__JSONParallelPlan(struct JSONParallelPlan *self, const JSONValue *value, size_t depth);
+
+static bool
+serialize__JSONParallelPiece(struct JSONParallelPiece *self);
+
+static void *
+run__JSONParallelPlan(void *self);
+
+static void
+deinit__JSONParallelPlan(const struct JSONParallelPlan *self);
+
+static bool
+serialize_parallel__JSONValue(const JSONValue *self, size_t threads, struct JSONParallelPlan *plan);
+
+static uint64_t
+now_ns__JSONReclaimer(void);
+
+static void *
+run__JSONReclaimer(void *self);
+#endif
+
+static uint8_t
+encode_utf8__JSON(uint32_t c, char *res);
+
 struct SipHashState {
 	uint64_t v0;
 	uint64_t v1;
@@ -109,48 +466,190 @@ is_empty__JSONValueString(const JSONValueString *self);
 static inline void
 deinit__JSONValueString(const JSONValueString *self);
 
+// Precedes the elements of an array in their allocation, so that an array
+// without elements has no header.
+struct JSONValueArrayHeader {
+	JSONValueShared shared;
+	enum JSONValueArrayKind kind;
+};
+
 static inline JSONValueArray
 init__JSONValueArray(void);
 
+static inline struct JSONValueArrayHeader *
+get_header__JSONValueArray(const JSONValueArray *self);
+
+static bool
+resize__JSONValueArray(JSONValueArray *self, enum JSONValueArrayKind kind, size_t capacity);
+
 static bool 
 push__JSONValueArray(JSONValueArray *self, JSONValue value);
 
 static void
 deinit__JSONValueArray(const JSONValueArray *self);
 
+static size_t
+format_number__JSONValueArray(const JSONValueArray *self, size_t index, char *res);
+
 static inline JSONValueObjectKeyValue
 init__JSONValueObjectKeyValue(JSONValueString key, JSONValue value);
 
 static void
 deinit__JSONValueObjectKeyValue(const JSONValueObjectKeyValue *self);
 
-static inline JSONValueObjectBucket
-init__JSONValueObjectBucket(JSONValueObjectKeyValue pair);
-
-static inline void
-deinit__JSONValueObjectBucket(const JSONValueObjectBucket *self);
-
 #define JSON_VALUE_OBJECT_KEY_VALUE_MAP_LOAD_FACTOR 0.75
 
 static inline JSONValueObjectKeyValueMap
 init__JSONValueObjectKeyValueMap(void);
 
 static inline size_t
-index__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, const JSONValueString *key);
+hash__JSONValueObjectKeyValueMap(const char *key, size_t key_len);
+
+static inline size_t
+index__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const JSONValueString *key);
 
 #define OBJECT_KEY_VALUE_MAP_NO_ERROR 0
 #define OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY 1
 #define OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY 2
 
-static uint32_t
-push_bucket__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, size_t index, JSONValueObjectBucket *new_bucket);
+static bool
+grow_index__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self);
 
 static uint32_t
 push__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, JSONValueObjectKeyValue value);
 
+static const JSONValue *
+get__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const JSONValueString *key);
+
+static const JSONValue *
+get_hashed__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const char *key, size_t key_len, size_t hash);
+
+static size_t
+find__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const char *key, size_t key_len, size_t hash);
+
 static void
 deinit__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self);
 
+static struct JSONObjectShape *
+share__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self);
+
+static void
+use_shape__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, struct JSONObjectShape *shape);
+
+static uint32_t
+push_shared__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, JSONValue value);
+
+static bool
+unshare__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self);
+
+static void
+release__JSONObjectShape(struct JSONObjectShape *self);
+
+static void
+remove__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, size_t index);
+
+static inline void
+retain_shared__JSONValue(JSONValueShared *shared);
+
+static bool
+release_shared__JSONValue(JSONValueShared *shared);
+
+static bool
+own_shared__JSONValue(JSONValueShared *shared);
+
+static bool
+clone__JSONValueString(const JSONValueString *self, JSONValueString *res);
+
+static bool
+clone_base__JSONValue(const JSONValue *self, JSONValue *res);
+
+static bool
+detach__JSONValueArray(JSONValueArray *self);
+
+static bool
+unpack__JSONValueArray(JSONValueArray *self);
+
+static bool
+detach__JSONValueObject(JSONValueObject *self);
+
+static bool
+detach__JSONValue(JSONValue *self);
+
+static JSONValue *
+detach_parent__JSONPointer(const JSONPointer *self, JSONValue *root);
+
+// A number in the form it is hashed and compared in: integers which fit in an
+// int64_t, including integral doubles, are `is_int`.
+// The numbers which fit an int64_t are held in `i`. The others are held as
+// their decimal value, (-1)^is_negative * 0.d1d2...dn * 10^exponent, where
+// d1...dn are the `digits_len` significant digits starting at `digits` (a `.`
+// among them is skipped), so that they are equal only if their values are.
+// `d` approximates them for the ordering of the JSONPath filters.
+struct JSONCanonicalNumber {
+	bool is_int;
+	int64_t i;
+	bool is_negative;
+	const char *digits;
+	size_t digits_len;
+	int64_t exponent;
+	double d;
+};
+
+static inline uint64_t
+mix_hash__JSONValue(uint64_t hash);
+
+static struct JSONCanonicalNumber
+canonical_number__JSONValue(const char *number, size_t number_len);
+
+static struct JSONCanonicalNumber
+canonical_element__JSONValue(const JSONValueArray *array, size_t index, char *buffer);
+
+static bool
+eq_number__JSONValue(struct JSONCanonicalNumber a, struct JSONCanonicalNumber b);
+
+static uint64_t
+hash_number__JSONValue(struct JSONCanonicalNumber number);
+
+static uint64_t
+get_hash_key__JSONValue(void);
+
+static uint64_t
+hash_string__JSONValue(const char *s, size_t s_len);
+
+static uint64_t
+hash_array__JSONValue(const JSONValueArray *self);
+
+static uint64_t
+hash_object__JSONValue(const JSONValueObjectKeyValueMap *self);
+
+static bool
+eq_element__JSONValue(const JSONValue *self, size_t self_index, const JSONValue *other, size_t other_index);
+
+static bool
+eq_members__JSONValue(const JSONValueObjectKeyValueMap *self, const JSONValueObjectKeyValueMap *other);
+
+#define DIFF_NO_ERROR 0
+#define DIFF_STOPPED 1
+#define DIFF_OUT_OF_MEMORY 2
+
+static uint32_t
+report__JSONDiff(enum JSONDiffKind kind, JSONValueString *pointer, const JSONValue *before, const JSONValue *after, JSONDiffCallback callback, void *user_data);
+
+static bool
+push_key__JSONDiff(JSONValueString *pointer, const JSONValueString *key);
+
+static bool
+push_index__JSONDiff(JSONValueString *pointer, size_t index);
+
+static uint32_t
+diff_base__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data);
+
+static uint32_t
+diff_object__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data);
+
+static uint32_t
+diff_array__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data);
+
 static inline JSONValueObject
 init__JSONValueObject(void);
 
@@ -208,6 +707,13 @@ init_ok__JSONValueResult(JSONValue value);
 static inline JSONValueResult
 init_err__JSONValueResult(enum JSONValueResultError kind, const char *msg);
 
+// 2^53, every integer up to it in absolute value is exact as a double. A
+// parsed double equal to it may come from 2^53 + 1.
+#define JSON_PACKED_MAX_EXACT_INT ((int64_t)1 << 53)
+
+static bool
+parse_packed_array_value__JSON(struct JSONContentIterator *iter, JSONValueArray *res);
+
 static JSONValueResult
 parse_array_value__JSON(struct JSONContentIterator *iter);
 
@@ -225,6 +731,16 @@ parse_object_member_value__JSON(struct JSONContentIterator *iter, JSONValueObjec
 static JSONValueResult
 parse_object_value__JSON(struct JSONContentIterator *iter);
 
+#ifdef JSON_STATS
+static JSONValueResult
+parse_object_value_with_stats__JSON(struct JSONContentIterator *iter, JSONParseStats *stats);
+#endif
+
+// NOTE: The parser does not recover from invalid UTF-8, so the content is
+// validated first where a failed parse must not end the process.
+static JSONValueResult
+parse_validated__JSON(const char *content, size_t content_len, const JSONParseOptions *options);
+
 #define PARSE_STRING_NO_ERROR 0
 #define PARSE_STRING_UNKNOWN_ESCAPE 1
 #define PARSE_STRING_OUT_OF_MEMORY 2
@@ -239,6 +755,35 @@ parse_string_escape_value__JSON(struct JSONContentIterator *iter, JSONValueStrin
 static JSONValueResult
 parse_string_value__JSON(struct JSONContentIterator *iter);
 
+static JSONValueResult
+parse_interned_string_value__JSON(struct JSONContentIterator *iter, JSONInternTable *table);
+
+#define JSON_INTERN_TABLE_LOAD_FACTOR 0.75
+
+static const char *
+intern_locked__JSONInternTable(JSONInternTable *self, const char *s, size_t s_len);
+
+static bool
+grow_index__JSONInternTable(JSONInternTable *self);
+
+static uint64_t
+hash__JSONParseCache(const char *content, size_t content_len);
+
+static void
+unlink__JSONParseCache(JSONParseCache *self, JSONParseCacheEntry *entry);
+
+static void
+push_front__JSONParseCache(JSONParseCache *self, JSONParseCacheEntry *entry);
+
+static JSONParseCacheEntry *
+find__JSONParseCache(JSONParseCache *self, const char *content, size_t content_len, uint64_t hash);
+
+static bool
+unref_locked__JSONParseCache(JSONParseCacheEntry *entry);
+
+static void
+free__JSONParseCacheEntry(JSONParseCacheEntry *entry);
+
 #define PARSE_NUMBER_NO_ERROR 0
 #define PARSE_NUMBER_OUT_OF_MEMORY 1
 #define PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS 2
@@ -273,68 +818,261 @@ parse_null_value__JSON(struct JSONContentIterator *iter);
 static JSONValueResult
 parse_value__JSON(struct JSONContentIterator *iter);
 
-struct JSONContentIterator
-init__JSONContentIterator(const char *content, size_t len)
-{
-	return (struct JSONContentIterator){
-		.content = content,
-		.len = len,
-		.count = 0
-	};
-}
+#define JSON_STRUCT_DESCRIPTOR_MAX_SEEDS 256
+#define JSON_STRUCT_DESCRIPTOR_MAX_TABLE_LEN (1 << 20)
+#define JSON_STRUCT_DESCRIPTOR_MAX_KEY_LEN 256
+#define JSON_DECODE_MAX_NUMBER_LEN 64
 
-unsigned char
-current_character__JSONContentIterator(struct JSONContentIterator *self, uint8_t byte_count)
-{
-	if (self->count + byte_count >= self->len) {
-		if (byte_count == 0) {
-			return '\0';
-		} else {
-			FATAL("Malformed character");
-		}
-	}
+static inline uint32_t
+hash__JSONStructDescriptor(const char *key, size_t key_len, uint32_t seed);
 
-	return self->content[self->count + byte_count] & 0xFF;
-}
+static bool
+is_valid__JSONFieldDescriptor(const JSONFieldDescriptor *self);
 
-uint8_t
-get_codepoint_len_from_first_byte__JSONContentIterator(struct JSONContentIterator *self, unsigned char *c1p)
-{
-	// See RFC 3629:
-	//
-	// 3.  UTF-8 definition
-	//
-	// [...]
-	//
-	// Char. number range  |        UTF-8 octet sequence
-	//    (hexadecimal)    |              (binary)
-	// --------------------+---------------------------------------------
-	// 0000 0000-0000 007F | 0xxxxxxx
-	// 0000 0080-0000 07FF | 110xxxxx 10xxxxxx
-	// 0000 0800-0000 FFFF | 1110xxxx 10xxxxxx 10xxxxxx
-	// 0001 0000-0010 FFFF | 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
-	//
-	// [...]
-	unsigned char c1 = current_character__JSONContentIterator(self, 0);
+static bool
+fill_table__JSONStructDescriptor(JSONStructDescriptor *self, uint32_t *table, size_t table_len, uint32_t seed);
+
+static const JSONFieldDescriptor *
+get_field__JSONStructDescriptor(const JSONStructDescriptor *self, const char *key, size_t key_len);
+
+static inline JSONStatus
+init_ok__JSONStatus(void);
+
+static inline JSONStatus
+init_err__JSONStatus(enum JSONValueResultError kind, const char *msg, size_t offset);
+
+#define DECODE_NO_ERROR 0
+#define DECODE_EXPECTED_OBJECT 1
+#define DECODE_EXPECTED_ARRAY 2
+#define DECODE_EXPECTED_MEMBER 3
+#define DECODE_EXPECTED_NAME_SEPARATOR 4
+#define DECODE_EXPECTED_VALUE_SEPARATOR 5
+#define DECODE_EXPECTED_INTEGER 6
+#define DECODE_EXPECTED_NUMBER 7
+#define DECODE_EXPECTED_BOOLEAN 8
+#define DECODE_EXPECTED_STRING 9
+#define DECODE_INTEGER_OVERFLOW 10
+#define DECODE_NUMBER_TOO_LONG 11
+#define DECODE_ARRAY_CAPACITY_EXCEEDED 12
+#define DECODE_INVALID_VALUE 13
+#define DECODE_TRAILING_CONTENT 14
+#define DECODE_INVALID_DESCRIPTOR 15
 
-	if (c1p) {
-		*c1p = c1;
-	}
+static uint32_t
+scan_number__JSONContentIterator(struct JSONContentIterator *self, bool *is_integer);
 
-	if ((c1 & 0x80) == 0) {
-		return 1;
-	} else if ((c1 & 0xE0) == 0xC0) {
-		return 2;
-	} else if ((c1 & 0xF0) == 0xE0) {
-		return 3;
-	} else if ((c1 & 0xF8) == 0xF0) {
-		return 4;
-	} else {
-		FATAL("Invalid character: %d", c1);
-	}
-}
+static uint32_t
+decode_int__JSON(struct JSONContentIterator *iter, int64_t *res);
 
-uint32_t
+static uint32_t
+decode_double__JSON(struct JSONContentIterator *iter, double *res);
+
+static uint32_t
+decode_boolean__JSON(struct JSONContentIterator *iter, bool *res);
+
+static uint32_t
+decode_string__JSON(struct JSONContentIterator *iter, JSONStringSlice *res);
+
+static uint32_t
+decode_scalar__JSON(struct JSONContentIterator *iter, enum JSONFieldKind kind, JSONStructDescriptor *descriptor, char *res);
+
+static uint32_t
+decode_array__JSON(struct JSONContentIterator *iter, const JSONFieldDescriptor *field, char *res);
+
+static uint32_t
+decode_object__JSON(struct JSONContentIterator *iter, const JSONStructDescriptor *descriptor, char *res);
+
+static JSONStatus
+decode_status__JSON(const struct JSONContentIterator *iter, uint32_t res);
+
+#define JSON_PROJECTION_MAX_KEY_LEN 256
+
+static JSONPathInstruction *
+push__JSONPath(JSONPath *self, enum JSONPathOpcode opcode);
+
+static bool
+compile_name__JSONPath(JSONPath *self, const char **path, const char *end);
+
+static bool
+compile_quoted__JSONPath(const char **path, const char *end, char **res, size_t *res_len);
+
+static bool
+compile_member__JSONPath(JSONPath *self, char *key, size_t key_len);
+
+static bool
+compile_index__JSONPath(JSONPath *self, const char **path, const char *end);
+
+static bool
+compile_filter__JSONPath(JSONPath *self, const char **path, const char *end);
+
+static bool
+compile_bracket__JSONPath(JSONPath *self, const char **path, const char *end);
+
+static int
+compare_number__JSONPath(const JSONPathInstruction *filter, struct JSONCanonicalNumber number);
+
+static bool
+match__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value);
+
+static bool
+eval_at__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value, JSONPathCallback callback, void *user_data);
+
+static bool
+descend__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value, JSONPathCallback callback, void *user_data);
+
+#define JSON_PATH_SCAN_MAX_LEN 63 // The states are a 64-bit set
+#define JSON_PATH_SCAN_MAX_KEY_LEN 256
+
+static uint64_t
+closure__JSONPath(const JSONPath *self, uint64_t states);
+
+static uint64_t
+child_states__JSONPath(const JSONPath *self, uint64_t states, const char *key, size_t key_len, size_t index);
+
+struct JSONPathScanMatch {
+	size_t start;
+	size_t end;
+};
+
+struct JSONPathScan {
+	JSONPathMatchCallback callback;
+	void *user_data;
+	bool is_stopped;
+	// Matches waiting for the end of the `pending` matched containers they
+	// are in, in document order.
+	struct JSONPathScanMatch *matches;
+	size_t len;
+	size_t capacity;
+	size_t pending;
+};
+
+static bool
+push__JSONPathScan(struct JSONPathScan *self, size_t start, size_t end);
+
+static void
+flush__JSONPathScan(struct JSONPathScan *self);
+
+static uint32_t
+scan_value__JSONPath(const JSONPath *self, struct JSONContentIterator *iter, uint64_t states, size_t depth, struct JSONPathScan *scan);
+
+static enum JSONColumnKind
+get_kind__JSONColumn(const JSONValue *value);
+
+static enum JSONColumnKind
+widen_kind__JSONColumn(enum JSONColumnKind kind, enum JSONColumnKind other);
+
+static JSONColumnShape *
+get_column__JSONColumnSchema(JSONColumnSchema *self, const char *name, size_t name_len, size_t hint);
+
+static bool
+grow_index__JSONColumnSchema(JSONColumnSchema *self);
+
+static bool
+init__JSONColumn(JSONColumn *self, const JSONColumnShape *shape, size_t rows);
+
+static bool
+push__JSONColumn(JSONColumn *self, size_t row, const JSONValue *value, size_t *data_capacity);
+
+static void
+deinit__JSONColumn(const JSONColumn *self);
+
+static size_t
+parse_index__JSONPointer(const char *token, size_t token_len);
+
+static bool
+parse_segment__JSONProjection(const char **path, bool is_first, char *key, size_t *key_len, bool *is_elements);
+
+static void
+deinit__JSONProjectionNode(const JSONProjectionNode *self);
+
+static const JSONProjectionNode *
+get_member__JSONProjectionNode(const JSONProjectionNode *self, const char *key, size_t key_len);
+
+static JSONValueResult
+project_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *node, bool *is_present);
+
+static JSONValueResult
+project_array_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *elements);
+
+static JSONValueResult
+project_object_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *node);
+
+#ifdef JSON_STATS
+uint64_t
+now_ns__JSONParseStats(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+struct JSONContentIterator
+init__JSONContentIterator(const char *content, size_t len)
+{
+	return (struct JSONContentIterator){
+		.content = content,
+		.len = len,
+		.count = 0,
+		.options = NULL,
+		.shape = NULL
+	};
+}
+
+unsigned char
+current_character__JSONContentIterator(struct JSONContentIterator *self, uint8_t byte_count)
+{
+	if (self->count + byte_count >= self->len) {
+		if (byte_count == 0) {
+			return '\0';
+		} else {
+			FATAL("Malformed character");
+		}
+	}
+
+	return self->content[self->count + byte_count] & 0xFF;
+}
+
+uint8_t
+get_codepoint_len_from_first_byte__JSONContentIterator(struct JSONContentIterator *self, unsigned char *c1p)
+{
+	// See RFC 3629:
+	//
+	// 3.  UTF-8 definition
+	//
+	// [...]
+	//
+	// Char. number range  |        UTF-8 octet sequence
+	//    (hexadecimal)    |              (binary)
+	// --------------------+---------------------------------------------
+	// 0000 0000-0000 007F | 0xxxxxxx
+	// 0000 0080-0000 07FF | 110xxxxx 10xxxxxx
+	// 0000 0800-0000 FFFF | 1110xxxx 10xxxxxx 10xxxxxx
+	// 0001 0000-0010 FFFF | 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
+	//
+	// [...]
+	unsigned char c1 = current_character__JSONContentIterator(self, 0);
+
+	if (c1p) {
+		*c1p = c1;
+	}
+
+	if ((c1 & 0x80) == 0) {
+		return 1;
+	} else if ((c1 & 0xE0) == 0xC0) {
+		return 2;
+	} else if ((c1 & 0xF0) == 0xE0) {
+		return 3;
+	} else if ((c1 & 0xF8) == 0xF0) {
+		return 4;
+	} else {
+		FATAL("Invalid character: %d", c1);
+	}
+}
+
+uint32_t
 read_bytes__JSONContentIterator(struct JSONContentIterator *self)
 {
 	unsigned char c1; 
@@ -450,1301 +1188,8139 @@ expect_characters__JSONContentIterator(struct JSONContentIterator *self, char *e
 	return true;
 }
 
-static void
-mix__SipHashState(struct SipHashState *self)
+unsigned char
+peek__JSONContentIterator(const struct JSONContentIterator *self)
 {
-#define JSON_HASH_ROTATE_LEFT(value, bits) \
-	(((value) << (bits)) | ((value) >> (64 - (bits))))
-
-	self->v0 += self->v1;
-	self->v2 += self->v3;
-	self->v1 = JSON_HASH_ROTATE_LEFT(self->v1, 13);
-	self->v3 = JSON_HASH_ROTATE_LEFT(self->v3, 16);
-	self->v1 ^= self->v0;
-	self->v3 ^= self->v2;
-	self->v0 = JSON_HASH_ROTATE_LEFT(self->v0, 32);
-	self->v2 += self->v1;
-	self->v0 += self->v3;
-	self->v1 = JSON_HASH_ROTATE_LEFT(self->v1, 17);
-	self->v3 = JSON_HASH_ROTATE_LEFT(self->v3, 21);
-	self->v1 ^= self->v2;
-	self->v3 ^= self->v0;
-	self->v2 = JSON_HASH_ROTATE_LEFT(self->v2, 32);
-
-#undef JSON_HASH_ROTATE_LEFT
+	return self->count < self->len ? self->content[self->count] : 0;
 }
 
-void
-final__SipHashState(struct SipHashState *self, size_t len)
+unsigned char
+skip_whitespace__JSONContentIterator(struct JSONContentIterator *self)
 {
-	self->v2 ^= 0xFF;
+	// See RFC 8259:
+	//
+	// 2.  JSON Grammar
+	//
+	// [...]
+	//
+	// ws = *(
+	//         %x20 /              ; Space
+	//         %x09 /              ; Horizontal tab
+	//         %x0A /              ; Line feed or New line
+	//         %x0D )              ; Carriage return
+	//
+	// [...]
+	while (self->count < self->len) {
+		switch (self->content[self->count]) {
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r':
+				++self->count;
 
-	for (int i = 0; i < 4; ++i) {
-		mix__SipHashState(self);
-	}
+				break;
+			default:
+				return self->content[self->count];
+		}
 
-	self->v0 ^= len;
+		// Indentation comes in runs, they are jumped over 16 bytes at a time.
+		while (self->len - self->count >= 16) {
+			uint32_t whitespace = whitespace_mask__JSONBlockMasks((const unsigned char *)self->content + self->count);
 
-	for (int i = 0; i < 4; ++i) {
-		mix__SipHashState(self);
+			if (whitespace != 0xFFFF) {
+				self->count += trailing_zeros__JSONBlockMasks(~whitespace);
+
+				return self->content[self->count];
+			}
+
+			self->count += 16;
+		}
 	}
+
+	return 0;
 }
 
-uint64_t
-hash__SipHashState(const void *key, size_t key_len, const size_t k0, const size_t k1)
+struct JSONBlockMasks
+init__JSONBlockMasks(const unsigned char *block)
 {
-	struct SipHashState state = {
-		.v0 = k0 ^ (sizeof(size_t) == 8 ? 0x736f6d6570736575ULL : 0x736f6d65),
-		.v1 = k1 ^ (sizeof(size_t) == 8 ? 0x646f72616e646f6dULL : 0x646f7261),
-		.v2 = k0 ^ (sizeof(size_t) == 8 ? 0x6c7967656e657261ULL : 0x6e657261),
-		.v3 = k1 ^ (sizeof(size_t) == 8 ? 0x7465646279746573ULL : 0x79746573)
-	};
+	struct JSONBlockMasks res = { 0 };
+
+#if defined(JSON_SIMD_SSE2)
+	for (size_t i = 0; i < 64; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *)(block + i));
+		// `[` and `{`, `]` and `}` only differ by 0x20
+		__m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+		res.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+		res.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+		res.open |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{'))) << i;
+		res.close |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))) << i;
+		res.control |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F))) << i;
+	}
+#elif defined(JSON_SIMD_NEON)
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t weight = vld1q_u8(weights);
+
+#define JSON_NEON_MOVEMASK(v) \
+	((uint64_t)vaddv_u8(vget_low_u8(vandq_u8(v, weight))) | (uint64_t)vaddv_u8(vget_high_u8(vandq_u8(v, weight))) << 8)
+
+	for (size_t i = 0; i < 64; i += 16) {
+		uint8x16_t chunk = vld1q_u8(block + i);
+		uint8x16_t lower = vorrq_u8(chunk, vdupq_n_u8(0x20));
+
+		res.quote |= JSON_NEON_MOVEMASK(vceqq_u8(chunk, vdupq_n_u8('"'))) << i;
+		res.backslash |= JSON_NEON_MOVEMASK(vceqq_u8(chunk, vdupq_n_u8('\\'))) << i;
+		res.open |= JSON_NEON_MOVEMASK(vceqq_u8(lower, vdupq_n_u8('{'))) << i;
+		res.close |= JSON_NEON_MOVEMASK(vceqq_u8(lower, vdupq_n_u8('}'))) << i;
+		res.control |= JSON_NEON_MOVEMASK(vcleq_u8(chunk, vdupq_n_u8(0x1F))) << i;
+	}
 
-	const uint8_t *key_bytes = (const uint8_t*)key;
-	const uint8_t *end = key_bytes + key_len - (key_len % sizeof(uint64_t));
-	const uint64_t *blocks = (const uint64_t *)key_bytes;
+#undef JSON_NEON_MOVEMASK
+#else
+	for (size_t i = 0; i < 64; ++i) {
+		uint64_t bit = (uint64_t)1 << i;
 
-	while (key_bytes < end) {
-		state.v3 ^= *blocks;
+		switch (block[i]) {
+			case '"':
+				res.quote |= bit;
 
-		for (int i = 0; i < 2; ++i) {
-			mix__SipHashState(&state);
-		}
+				break;
+			case '\\':
+				res.backslash |= bit;
 
-		state.v0 ^= *blocks;
-		++blocks;
-		key_bytes += sizeof(uint64_t);
-	}
+				break;
+			case '{':
+			case '[':
+				res.open |= bit;
 
-	uint64_t last_block = 0;
+				break;
+			case '}':
+			case ']':
+				res.close |= bit;
 
-	memcpy(&last_block, key_bytes, key_len % sizeof(uint64_t));
+				break;
+			default:
+				if (block[i] < 0x20) {
+					res.control |= bit;
+				}
+		}
+	}
+#endif
 
-	state.v3 ^= last_block;
+	return res;
+}
 
-	for (int i = 0; i < 2; ++i) {
-		mix__SipHashState(&state);
+uint32_t
+string_mask__JSONBlockMasks(const unsigned char *chunk, bool stop_at_non_ascii)
+{
+#if defined(JSON_SIMD_SSE2)
+	__m128i v = _mm_loadu_si128((const __m128i *)chunk);
+	__m128i special = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+		_mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)));
+
+	if (stop_at_non_ascii) {
+		special = _mm_or_si128(special, v);
 	}
 
-	state.v0 ^= last_block;
+	return (uint16_t)_mm_movemask_epi8(special);
+#elif defined(JSON_SIMD_NEON)
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t v = vld1q_u8(chunk);
+	uint8x16_t special = vorrq_u8(
+		vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+		vcleq_u8(v, vdupq_n_u8(0x1F)));
 
-	final__SipHashState(&state, key_len);
+	if (stop_at_non_ascii) {
+		special = vorrq_u8(special, vcgeq_u8(v, vdupq_n_u8(0x80)));
+	}
 
-	return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
-}
+	if (!vmaxvq_u8(special)) {
+		return 0;
+	}
 
-JSONValueString
-init__JSONValueString(void)
-{
-	return (JSONValueString){
-		.buffer = NULL,
-		.len = 0,
-		.capacity = 8,
-	};
-}
+	special = vandq_u8(special, vld1q_u8(weights));
 
-bool
-eq__JSONValueString(const JSONValueString *self, const JSONValueString *other)
-{
-	if (is_empty__JSONValueString(self) && is_empty__JSONValueString(other)) {
-		return true;
-	} else if (self->len != other->len) {
-		return false;
-	}
+	return vaddv_u8(vget_low_u8(special)) | (uint32_t)vaddv_u8(vget_high_u8(special)) << 8;
+#else
+	uint32_t res = 0;
 
-	for (size_t i = 0; i < self->len; ++i) {
-		if (self->buffer[i] != other->buffer[i]) {
-			return false;
+	for (size_t i = 0; i < 16; ++i) {
+		if (chunk[i] == '"' || chunk[i] == '\\' || chunk[i] < 0x20 || (stop_at_non_ascii && chunk[i] >= 0x80)) {
+			res |= (uint32_t)1 << i;
 		}
 	}
 
-	return true;
+	return res;
+#endif
 }
 
-bool
-push__JSONValueString(JSONValueString *self, uint32_t c)
+uint32_t
+whitespace_mask__JSONBlockMasks(const unsigned char *chunk)
 {
-	// See RFC 3629:
-	//
-	// 3.  UTF-8 definition
-	//
-	// [...]
-	//
-	// Char. number range  |        UTF-8 octet sequence
-	//    (hexadecimal)    |              (binary)
-	// --------------------+---------------------------------------------
-	// 0000 0000-0000 007F | 0xxxxxxx
-	// 0000 0080-0000 07FF | 110xxxxx 10xxxxxx
-	// 0000 0800-0000 FFFF | 1110xxxx 10xxxxxx 10xxxxxx
-	// 0001 0000-0010 FFFF | 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
-	//
-	// [...]
-	uint8_t byte_count;
-
-	if (c <= 0x7F) {
-		byte_count = 1;
-	} else if (c <= 0x7FF) {
-		byte_count = 2;
-	} else if (c <= 0xFFFF) {
-		byte_count = 3;
-	} else if (c <= 0x10FFFF) {
-		byte_count = 4;
-	} else {
-		UNREACHABLE("invalid codepoint");
-	}
-
-	if (!self->buffer) {
-		self->buffer = malloc(self->capacity);	
-	} else if (self->len + byte_count + 1 >= self->capacity) {
-		self->capacity *= 2;
-		self->buffer = realloc(self->buffer, self->capacity);
-	}
-
-	if (!self->buffer) {
-		return false;
+#if defined(JSON_SIMD_SSE2)
+	__m128i v = _mm_loadu_si128((const __m128i *)chunk);
+	__m128i whitespace = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+	return (uint16_t)_mm_movemask_epi8(whitespace);
+#elif defined(JSON_SIMD_NEON)
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t v = vld1q_u8(chunk);
+	uint8x16_t whitespace = vorrq_u8(
+		vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+		vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+
+	whitespace = vandq_u8(whitespace, vld1q_u8(weights));
+
+	return vaddv_u8(vget_low_u8(whitespace)) | (uint32_t)vaddv_u8(vget_high_u8(whitespace)) << 8;
+#else
+	uint32_t res = 0;
+
+	for (size_t i = 0; i < 16; ++i) {
+		if (chunk[i] == ' ' || chunk[i] == '\t' || chunk[i] == '\n' || chunk[i] == '\r') {
+			res |= (uint32_t)1 << i;
+		}
 	}
 
-	switch (byte_count) {
-		case 1:
-			self->buffer[self->len++] = c;
-
-			break;
-		case 2:
-			self->buffer[self->len++] = ((c >> 6 ) & 0x1F) | 0xC0;
-			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+	return res;
+#endif
+}
 
-			break;
-		case 3:
-			self->buffer[self->len++] = ((c >> 12) & 0xF) | 0xE0;
-			self->buffer[self->len++] = ((c >> 6) & 0x3F) | 0x80;
-			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+uint64_t
+find_escaped__JSONBlockMasks(uint64_t backslash, uint64_t *escaped_carry)
+{
+	// A character is escaped when it follows an odd-length run of
+	// backslashes. The runs are told apart by the parity of the position
+	// they start at, adding the run starts to the runs carries each run
+	// into the character following it.
+	//
+	// See Langdale and Lemire, Parsing Gigabytes of JSON per Second, 3.1.1.
+	static const uint64_t even_bits = 0x5555555555555555ULL;
 
-			break;
-		case 4:
-			self->buffer[self->len++] = ((c >> 18) & 0x7) | 0xF0;
-			self->buffer[self->len++] = ((c >> 12) & 0x3F) | 0x80;
-			self->buffer[self->len++] = ((c >> 6) & 0x3F) | 0x80;
-			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+	backslash &= ~*escaped_carry;
 
-			break;
-		default:
-			UNREACHABLE("Impossible byte count");
-	}
+	uint64_t follows_escape = backslash << 1 | *escaped_carry;
+	uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+	uint64_t even_runs = odd_starts + backslash;
 
-	self->buffer[self->len] = 0;
+	*escaped_carry = even_runs < odd_starts; // Overflow
 
-	return true;
+	return (even_bits ^ even_runs << 1) & follows_escape;
 }
 
-bool
-push_character__JSONValueString(JSONValueString *self, unsigned char c)
+uint64_t
+prefix_xor__JSONBlockMasks(uint64_t bits)
 {
-	if (!self->buffer) {
-		self->buffer = malloc(self->capacity);
-	} else if (self->len + 1 >= self->capacity) {
-		self->capacity *= 2;
-		self->buffer = realloc(self->buffer, self->capacity);
-	}
+	// Bit N of the result is the XOR of the bits 0 to N, i.e. set between an
+	// opening quote (included) and a closing quote (excluded).
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+
+	return bits;
+}
 
-	if (!self->buffer) {
-		return false;
+uint32_t
+trailing_zeros__JSONBlockMasks(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(bits);
+#else
+	uint32_t res = 0;
+
+	while (!(bits & 1)) {
+		bits >>= 1;
+		++res;
 	}
 
-	self->buffer[self->len++] = c;
-	self->buffer[self->len] = 0;
-
-	return true;
+	return res;
+#endif
 }
 
-bool
-push_characters__JSONValueString(JSONValueString *self, char *s, size_t s_len)
+uint32_t
+skip_string__JSONContentIterator(struct JSONContentIterator *self, bool *has_escapes)
 {
-	size_t new_size = self->len + s_len + 1;
+	// NOTE: The iterator must be on the opening `"`. The escapes are only
+	// stepped over, they are not decoded.
+	++self->count;
 
-	if (new_size >= self->capacity) {
-		self->capacity <<= (new_size / self->capacity + 1);
-		self->buffer = realloc(self->buffer, self->capacity);
+	while (self->count < self->len) {
+		// Jumps to the next `"`, `\` or control character 16 bytes at a time.
+		if (self->len - self->count >= 16) {
+			uint32_t special = string_mask__JSONBlockMasks((const unsigned char *)self->content + self->count, false);
 
-		assert(self->capacity > new_size);
-	}
+			if (!special) {
+				self->count += 16;
 
-	if (!self->buffer) {
-		return false;
-	}
+				continue;
+			}
 
-	char *start_buffer = self->buffer + self->len;
+			self->count += trailing_zeros__JSONBlockMasks(special);
+		}
 
-	memcpy(start_buffer, s, s_len);
+		unsigned char c = self->content[self->count++];
 
-	self->len = new_size - 1;
+		switch (c) {
+			case '"':
+				return SKIP_NO_ERROR;
+			case '\\':
+				if (self->count == self->len) {
+					return SKIP_UNEXPECTED_END;
+				}
 
-	self->buffer[self->len] = 0;
+				if (has_escapes) {
+					*has_escapes = true;
+				}
 
-	return true;
-}
+				++self->count;
 
-bool
-is_empty__JSONValueString(const JSONValueString *self)
-{
-	return self->len == 0;
-}
+				break;
+			default:
+				if (c < 0x20) {
+					return SKIP_INVALID_STRING;
+				}
+		}
+	}
 
-void
-deinit__JSONValueString(const JSONValueString *self)
-{
-	free(self->buffer);
+	return SKIP_UNEXPECTED_END;
 }
 
-JSONValueArray
-init__JSONValueArray(void)
+uint32_t
+skip_container__JSONContentIterator(struct JSONContentIterator *self)
 {
-	return (JSONValueArray){
-		.buffer = NULL,
-		.len = 0,
-		.capacity = 8
-	};
-}
+	// NOTE: The iterator must be on the opening `{` or `[`. Only the
+	// structure is checked: brackets, strings and control characters in
+	// strings.
+	//
+	// Each 64 bytes block is turned into bitmasks, the escaped quotes and
+	// the brackets inside strings are masked out, and only the remaining
+	// brackets are visited one by one.
+	uint64_t stack[JSON_SKIP_MAX_DEPTH / 64]; // Bit N is set when the container at depth N is an object
+	size_t depth = 0;
+	uint64_t escaped_carry = 0;
+	uint64_t in_string_carry = 0;
+	unsigned char padded[64];
+
+	for (size_t start = self->count; start < self->len; start += 64) {
+		const unsigned char *block = (const unsigned char *)self->content + start;
+
+		if (self->len - start < 64) {
+			memset(padded, ' ', sizeof(padded));
+			memcpy(padded, block, self->len - start);
+			block = padded;
+		}
 
-bool
-push__JSONValueArray(JSONValueArray *self, JSONValue value)
-{
-	if (!self->buffer) {
-		self->buffer = malloc(sizeof(JSONValue) * self->capacity);
-	} else if (self->len + 1 >= self->capacity) {
-		self->capacity *= 2;
-		self->buffer = realloc(self->buffer, sizeof(JSONValue) * self->capacity);
-	}
+		struct JSONBlockMasks masks = init__JSONBlockMasks(block);
+		uint64_t escaped = find_escaped__JSONBlockMasks(masks.backslash, &escaped_carry);
+		uint64_t in_string = prefix_xor__JSONBlockMasks(masks.quote & ~escaped) ^ in_string_carry;
+		uint64_t brackets = (masks.open | masks.close) & ~in_string;
+		uint64_t control = masks.control & in_string;
 
-	if (!self->buffer) {
-		return false;
-	}
+		in_string_carry = 0 - (in_string >> 63);
 
-	self->buffer[self->len++] = value;
+		while (brackets) {
+			uint32_t i = trailing_zeros__JSONBlockMasks(brackets);
 
-	return true;
-}
+			if (control & (((uint64_t)1 << i) - 1)) {
+				break;
+			}
 
-void
-deinit__JSONValueArray(const JSONValueArray *self)
-{
-	for (size_t i = 0; i < self->len; ++i) {
-		deinit__JSONValue(&self->buffer[i]);
-	}
+			self->count = start + i;
 
-	free(self->buffer);
-}
+			if (masks.open >> i & 1) {
+				if (depth == JSON_SKIP_MAX_DEPTH) {
+					return SKIP_TOO_DEEP;
+				}
 
-JSONValueObjectKeyValue
-init__JSONValueObjectKeyValue(JSONValueString key, JSONValue value)
-{
-	JSONValue *value_ptr = malloc(sizeof(JSONValue));
+				if (block[i] == '{') {
+					stack[depth / 64] |= (uint64_t)1 << (depth % 64);
+				} else {
+					stack[depth / 64] &= ~((uint64_t)1 << (depth % 64));
+				}
 
-	if (!value_ptr) {
-		FATAL("Out of memory");
-	}
+				++depth;
+			} else {
+				--depth;
 
-	*value_ptr = value;
+				bool is_object = stack[depth / 64] >> (depth % 64) & 1;
 
-	return (JSONValueObjectKeyValue){
-		.key = key,
-		.value = value_ptr
-	};
-}
+				if (is_object != (block[i] == '}')) {
+					return SKIP_MISMATCHED_BRACKET;
+				}
 
-void
-deinit__JSONValueObjectKeyValue(const JSONValueObjectKeyValue *self)
-{
-	deinit__JSONValueString(&self->key);
-	deinit__JSONValue(self->value);
-	free(self->value);
-}
+				if (depth == 0) {
+					++self->count;
 
-JSONValueObjectBucket
-init__JSONValueObjectBucket(JSONValueObjectKeyValue pair)
-{
-	return (JSONValueObjectBucket){
-		.pair = pair,
-		.next = NULL
-	};
-}
+					return SKIP_NO_ERROR;
+				}
+			}
 
-void
-deinit__JSONValueObjectBucket(const JSONValueObjectBucket *self)
-{
-	deinit__JSONValueObjectKeyValue(&self->pair);
-}
+			brackets &= brackets - 1;
+		}
 
-JSONValueObjectKeyValueMap
-init__JSONValueObjectKeyValueMap(void)
-{
-	return (JSONValueObjectKeyValueMap){
-		.buckets = NULL,
-		.len = 0,
-		.capacity = 8
-	};
+		if (control) {
+			self->count = start + trailing_zeros__JSONBlockMasks(control);
+
+			return SKIP_INVALID_STRING;
+		}
+	}
+
+	self->count = self->len;
+
+	return SKIP_UNEXPECTED_END;
 }
 
-size_t
-index__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, const JSONValueString *key)
+uint32_t
+skip_literal__JSONContentIterator(struct JSONContentIterator *self, const char *literal, size_t literal_len)
 {
-	const size_t k0 = sizeof(size_t) == 8 ? 0x0123456789abcdefULL : 0x01234567;
-	const size_t k1 = sizeof(size_t) == 8 ? 0xfedcba9876543210ULL : 0x89abcdef;
+	// NOTE: A literal cut by the end of the content is reported as such, the
+	// sequence iterator then waits for more content.
+	size_t remaining = self->len - self->count;
+
+	if (memcmp(self->content + self->count, literal, remaining < literal_len ? remaining : literal_len)) {
+		return SKIP_INVALID_LITERAL;
+	} else if (remaining < literal_len) {
+		self->count = self->len;
+
+		return SKIP_UNEXPECTED_END;
+	}
 
-	return hash__SipHashState(key->buffer, key->len, k0, k1) % self->capacity;
+	self->count += literal_len;
+
+	return SKIP_NO_ERROR;
 }
 
 uint32_t
-push_bucket__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, size_t index, JSONValueObjectBucket *new_bucket)
+skip_value__JSONContentIterator(struct JSONContentIterator *self)
 {
-	JSONValueObjectBucket *head = self->buckets[index];
-
-	if (head) {
-		JSONValueObjectBucket *previous_bucket = NULL;
-		JSONValueObjectBucket *current_bucket = head;
-		bool is_exist = false;
+	unsigned char c = skip_whitespace__JSONContentIterator(self);
 
-		while (current_bucket) {
-			if (eq__JSONValueString(&current_bucket->pair.key, &new_bucket->pair.key)) {
-				is_exist = true;
+	switch (c) {
+		case 0:
+			return SKIP_UNEXPECTED_END;
+		case '"':
+			return skip_string__JSONContentIterator(self, NULL);
+		case '{':
+		case '[':
+			return skip_container__JSONContentIterator(self);
+		case '}':
+		case ']':
+		case ',':
+		case ':':
+			return SKIP_UNEXPECTED_CHARACTER;
+		case 't':
+			return skip_literal__JSONContentIterator(self, "true", 4);
+		case 'f':
+			return skip_literal__JSONContentIterator(self, "false", 5);
+		case 'n':
+			return skip_literal__JSONContentIterator(self, "null", 4);
+		default: {
+			bool is_integer;
+
+			if (c != '-' && !isdigit(c)) {
+				return SKIP_UNEXPECTED_CHARACTER;
+			} else if (scan_number__JSONContentIterator(self, &is_integer)) {
+				return self->count == self->len ? SKIP_UNEXPECTED_END : SKIP_INVALID_NUMBER;
 			}
 
-			previous_bucket = current_bucket;
-			current_bucket = current_bucket->next;
+			return SKIP_NO_ERROR;
 		}
-
-		if (is_exist) {
-			return OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY;
-		}
-
-		previous_bucket->next = new_bucket;
-	} else {
-		self->buckets[index] = new_bucket;
 	}
-
-	return OBJECT_KEY_VALUE_MAP_NO_ERROR;
 }
 
 uint32_t
-push__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, JSONValueObjectKeyValue value)
+validate_utf8__JSONContentIterator(struct JSONContentIterator *self)
 {
-	size_t index = index__JSONValueObjectKeyValueMap(self, &value.key);
-
-	if (!self->buckets) {
-		self->buckets = calloc(self->capacity, sizeof(void*));
-		
-		if (!self->buckets) {
-			return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
-		}
-	} else if (self->len + 1 >= self->capacity * JSON_VALUE_OBJECT_KEY_VALUE_MAP_LOAD_FACTOR) {
-		size_t old_capacity = self->capacity;
+	// See RFC 3629:
+	//
+	// 4.  Syntax of UTF-8 Byte Sequences
+	//
+	// [...]
+	//
+	// UTF8-2      = %xC2-DF UTF8-tail
+	// UTF8-3      = %xE0 %xA0-BF UTF8-tail / %xE1-EC 2( UTF8-tail ) /
+	//               %xED %x80-9F UTF8-tail / %xEE-EF 2( UTF8-tail )
+	// UTF8-4      = %xF0 %x90-BF 2( UTF8-tail ) / %xF1-F3 3( UTF8-tail ) /
+	//               %xF4 %x80-8F 2( UTF8-tail )
+	// UTF8-tail   = %x80-BF
+	//
+	// [...]
+	const unsigned char *s = (const unsigned char *)self->content + self->count;
+	size_t remaining = self->len - self->count;
+	unsigned char c = s[0];
+	unsigned char second_min = 0x80;
+	unsigned char second_max = 0xBF;
+	size_t len;
 
-		self->capacity *= 2;
+	if (c >= 0xC2 && c <= 0xDF) {
+		len = 2;
+	} else if (c >= 0xE0 && c <= 0xEF) {
+		len = 3;
+		second_min = c == 0xE0 ? 0xA0 : 0x80; // Overlong
+		second_max = c == 0xED ? 0x9F : 0xBF; // Surrogates
+	} else if (c >= 0xF0 && c <= 0xF4) {
+		len = 4;
+		second_min = c == 0xF0 ? 0x90 : 0x80; // Overlong
+		second_max = c == 0xF4 ? 0x8F : 0xBF; // Above U+10FFFF
+	} else {
+		return VALIDATE_INVALID_UTF8;
+	}
 
-		JSONValueObjectBucket **new_buckets = calloc(self->capacity, sizeof(void*));
+	if (remaining < len || s[1] < second_min || s[1] > second_max) {
+		return VALIDATE_INVALID_UTF8;
+	}
 
-		if (!new_buckets) {
-			return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
+	for (size_t i = 2; i < len; ++i) {
+		if ((s[i] & 0xC0) != 0x80) {
+			return VALIDATE_INVALID_UTF8;
 		}
+	}
 
-		JSONValueObjectBucket **old_buckets = self->buckets;
+	self->count += len;
+
+	return VALIDATE_NO_ERROR;
+}
 
-		self->buckets = new_buckets;
+uint32_t
+validate_string__JSONContentIterator(struct JSONContentIterator *self)
+{
+	// See RFC 8259, 7.  Strings
+	++self->count; // Skip `"`
 
-		for (size_t i = 0; i < old_capacity; ++i) {
-			JSONValueObjectBucket *current = old_buckets[i];
+	while (self->count < self->len) {
+		// Jumps over the plain ASCII characters 16 bytes at a time.
+		if (self->len - self->count >= 16) {
+			uint32_t special = string_mask__JSONBlockMasks((const unsigned char *)self->content + self->count, true);
 
-			while (current) {
-				JSONValueObjectBucket *next = current->next;
-				size_t new_index = index__JSONValueObjectKeyValueMap(self, &current->pair.key);
+			if (!special) {
+				self->count += 16;
 
-				current->next = new_buckets[new_index];
-				new_buckets[new_index] = current;
-				current = next;
+				continue;
 			}
+
+			self->count += trailing_zeros__JSONBlockMasks(special);
 		}
 
-		free(old_buckets);
+		unsigned char c = self->content[self->count];
+		uint32_t res;
 
-		// Reload index
-		index = index__JSONValueObjectKeyValueMap(self, &value.key);
-	}
+		switch (c) {
+			case '"':
+				++self->count;
 
-	JSONValueObjectBucket *bucket_ptr = malloc(sizeof(JSONValueObjectBucket));
+				return VALIDATE_NO_ERROR;
+			case '\\':
+				if (self->count + 1 == self->len) {
+					return VALIDATE_UNEXPECTED_END;
+				}
 
-	if (!bucket_ptr) {
-		return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
-	}
+				switch (self->content[self->count + 1]) {
+					case '"':
+					case '\\':
+					case '/':
+					case 'b':
+					case 'f':
+					case 'n':
+					case 'r':
+					case 't':
+						self->count += 2;
+
+						break;
+					case 'u':
+						if (self->len - self->count < 6) {
+							return VALIDATE_UNEXPECTED_END;
+						}
+
+						for (size_t i = 2; i < 6; ++i) {
+							if (!is_hex_character__JSON((unsigned char)self->content[self->count + i])) {
+								return VALIDATE_INVALID_ESCAPE;
+							}
+						}
+
+						self->count += 6;
+
+						break;
+					default:
+						return VALIDATE_INVALID_ESCAPE;
+				}
 
-	*bucket_ptr = init__JSONValueObjectBucket(value);
+				break;
+			default:
+				if (c < 0x20) {
+					return VALIDATE_CONTROL_CHARACTER;
+				} else if (c < 0x80) {
+					++self->count;
+				} else if ((res = validate_utf8__JSONContentIterator(self))) {
+					return res;
+				}
+		}
+	}
+
+	return VALIDATE_UNEXPECTED_END;
+}
 
-	uint32_t res = push_bucket__JSONValueObjectKeyValueMap(self, index, bucket_ptr);
+uint32_t
+validate_member_name__JSONContentIterator(struct JSONContentIterator *self)
+{
+	uint32_t res;
 
-	if (res == OBJECT_KEY_VALUE_MAP_NO_ERROR) {
-		++self->len;
+	if (skip_whitespace__JSONContentIterator(self) != '"') {
+		return self->count == self->len ? VALIDATE_UNEXPECTED_END : VALIDATE_EXPECTED_MEMBER;
+	} else if ((res = validate_string__JSONContentIterator(self))) {
+		return res;
+	} else if (skip_whitespace__JSONContentIterator(self) != ':') {
+		return self->count == self->len ? VALIDATE_UNEXPECTED_END : VALIDATE_EXPECTED_NAME_SEPARATOR;
 	}
 
-	return res;
+	++self->count;
+
+	return VALIDATE_NO_ERROR;
 }
 
-void
-deinit__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self)
+uint32_t
+validate_literal__JSONContentIterator(struct JSONContentIterator *self, const char *literal, size_t literal_len)
+{
+	if (self->len - self->count < literal_len || memcmp(self->content + self->count, literal, literal_len)) {
+		return VALIDATE_INVALID_LITERAL;
+	}
+
+	self->count += literal_len;
+
+	return VALIDATE_NO_ERROR;
+}
+
+uint32_t
+validate_value__JSONContentIterator(struct JSONContentIterator *self)
 {
-	if (self->buckets) {
-		for (size_t i = 0; i < self->capacity; ++i) {
-			JSONValueObjectBucket *current_bucket = self->buckets[i];
+	// See RFC 8259, 2.  JSON Grammar
+	//
+	// The containers are tracked on a bit stack instead of recursing, bit N
+	// is set when the container at depth N is an object.
+	uint64_t stack[JSON_SKIP_MAX_DEPTH / 64];
+	size_t depth = 0;
+	unsigned char c = skip_whitespace__JSONContentIterator(self);
+	uint32_t res;
+
+	while (true) {
+		// A value starts at `c`
+		switch (c) {
+			case '{':
+			case '[': {
+				bool is_object = c == '{';
+
+				if (depth == JSON_SKIP_MAX_DEPTH) {
+					return VALIDATE_TOO_DEEP;
+				}
+
+				if (is_object) {
+					stack[depth / 64] |= (uint64_t)1 << (depth % 64);
+				} else {
+					stack[depth / 64] &= ~((uint64_t)1 << (depth % 64));
+				}
+
+				++depth;
+				++self->count;
+
+				c = skip_whitespace__JSONContentIterator(self);
+
+				if (c == (is_object ? '}' : ']')) {
+					++self->count;
+					--depth;
 
-			while (current_bucket) {
-				JSONValueObjectBucket *next_bucket = current_bucket->next;
+					break;
+				} else if (is_object && (res = validate_member_name__JSONContentIterator(self))) {
+					return res;
+				}
+
+				c = skip_whitespace__JSONContentIterator(self);
+
+				continue;
+			}
+			case '"':
+				if ((res = validate_string__JSONContentIterator(self))) {
+					return res;
+				}
+
+				break;
+			case '-':
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+			case '4':
+			case '5':
+			case '6':
+			case '7':
+			case '8':
+			case '9': {
+				bool is_integer;
+
+				if (scan_number__JSONContentIterator(self, &is_integer)) {
+					return VALIDATE_INVALID_NUMBER;
+				}
+
+				break;
+			}
+			case 't':
+				if ((res = validate_literal__JSONContentIterator(self, "true", 4))) {
+					return res;
+				}
+
+				break;
+			case 'f':
+				if ((res = validate_literal__JSONContentIterator(self, "false", 5))) {
+					return res;
+				}
 
-				deinit__JSONValueObjectBucket(current_bucket);
-				free(current_bucket);
+				break;
+			case 'n':
+				if ((res = validate_literal__JSONContentIterator(self, "null", 4))) {
+					return res;
+				}
+
+				break;
+			default:
+				return self->count == self->len ? VALIDATE_UNEXPECTED_END : VALIDATE_UNEXPECTED_CHARACTER;
+		}
+
+		// A value ends, closes the containers it ends.
+		while (depth > 0) {
+			bool is_object = stack[(depth - 1) / 64] >> ((depth - 1) % 64) & 1;
+
+			c = skip_whitespace__JSONContentIterator(self);
 
-				current_bucket = next_bucket;
+			if (c == ',') {
+				++self->count;
+
+				if (is_object && (res = validate_member_name__JSONContentIterator(self))) {
+					return res;
+				}
+
+				break;
+			} else if (c == (is_object ? '}' : ']')) {
+				++self->count;
+				--depth;
+			} else {
+				return self->count == self->len ? VALIDATE_UNEXPECTED_END : VALIDATE_EXPECTED_VALUE_SEPARATOR;
 			}
 		}
 
-		free(self->buckets);
+		if (depth == 0) {
+			return VALIDATE_NO_ERROR;
+		}
+
+		c = skip_whitespace__JSONContentIterator(self);
 	}
 }
 
-JSONValueObject
-init__JSONValueObject(void)
+struct JSONWriter
+init__JSONWriter(JSONWriteCallback write, void *user_data)
 {
-	return (JSONValueObject){
-		.map = init__JSONValueObjectKeyValueMap(),
+	return (struct JSONWriter){
+		.write = write,
+		.user_data = user_data,
+		.len = 0
 	};
 }
 
-uint32_t
-add_member__JSONValueObject(JSONValueObject *self, JSONValueString key, JSONValue value)
+bool
+flush__JSONWriter(struct JSONWriter *self)
 {
-	return push__JSONValueObjectKeyValueMap(&self->map, init__JSONValueObjectKeyValue(key, value));
-}
+	bool res = self->len == 0 || self->write(self->buffer, self->len, self->user_data);
 
-void
-deinit__JSONValueObject(const JSONValueObject *self)
-{
-	deinit__JSONValueObjectKeyValueMap(&self->map);
-}
+	self->len = 0;
 
-JSONValue
-init_number__JSONValue(JSONValueString number)
-{
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_NUMBER,
-		.number = number
-	};
+	return res;
 }
 
-JSONValue
-init_string__JSONValue(JSONValueString string)
+bool
+push__JSONWriter(struct JSONWriter *self, const char *s, size_t s_len)
 {
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_STRING,
-		.string = string
-	};
-}
+	if (self->len + s_len > JSON_WRITER_BUFFER_LEN) {
+		if (!flush__JSONWriter(self)) {
+			return false;
+		}
 
-JSONValue
-init_boolean__JSONValue(bool boolean)
-{
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_BOOLEAN,
-		.boolean = boolean
-	};
-}
+		// Long strings go straight to the callback
+		if (s_len >= JSON_WRITER_BUFFER_LEN) {
+			return self->write(s, s_len, self->user_data);
+		}
+	}
 
-JSONValue
-init_array__JSONValue(JSONValueArray array)
-{
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_ARRAY,
-		.array = array
-	};
-}
+	memcpy(self->buffer + self->len, s, s_len);
+	self->len += s_len;
 
-JSONValue
-init_object__JSONValue(JSONValueObject object)
-{
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_OBJECT,
-		.object = object
-	};
+	return true;
 }
 
-JSONValue
-init_null__JSONValue()
+bool
+push_newline__JSONWriter(struct JSONWriter *self, size_t indent, size_t depth)
 {
-	return (JSONValue){
-		.kind = JSON_VALUE_KIND_NULL
-	};
-}
+	static const char spaces[] = "                                                                ";
+	size_t spaces_len = indent * depth;
 
-#define JSON_TO_STRING_HANDLE_ERROR(fncall) if (!(fncall)) { return false; }
+	if (!push__JSONWriter(self, "\n", 1)) {
+		return false;
+	}
 
-bool
-convert_number_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
-{
-	return push_characters__JSONValueString(res, self->number.buffer, self->number.len);
+	while (spaces_len > 0) {
+		size_t n = spaces_len < sizeof(spaces) - 1 ? spaces_len : sizeof(spaces) - 1;
+
+		if (!push__JSONWriter(self, spaces, n)) {
+			return false;
+		}
+
+		spaces_len -= n;
+	}
+
+	return true;
 }
 
-bool
-convert_string_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+uint32_t
+format__JSON(struct JSONContentIterator *iter, struct JSONWriter *writer, size_t indent)
 {
-	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+	// NOTE: The tokens are copied as they are, `indent` is 0 to minify. The
+	// grammar is checked as the tokens go by, a missing or doubled separator
+	// would otherwise glue two values together.
+	uint64_t stack[JSON_SKIP_MAX_DEPTH / 64]; // Bit N is set when the container at depth N is an object
+	size_t depth = 0;
+	uint32_t state = FORMAT_EXPECT_VALUE;
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+
+	do {
+		size_t start = iter->count;
+		bool is_value_end = false;
+		bool is_written;
+
+		switch (c) {
+			case 0:
+				return iter->count == iter->len ? FORMAT_UNEXPECTED_END : FORMAT_UNEXPECTED_CHARACTER;
+			case '"':
+				if (state != FORMAT_EXPECT_VALUE && state != FORMAT_EXPECT_MEMBER) {
+					return format_unexpected__JSON(state);
+				} else if (skip_string__JSONContentIterator(iter, NULL)) {
+					return FORMAT_INVALID_STRING;
+				}
 
-	if (self->string.buffer) {
-		for (size_t i = 0; i < self->string.len; ++i) {
-			unsigned char current = self->string.buffer[i] & 0xFF;
+				is_value_end = state == FORMAT_EXPECT_VALUE;
+				state = FORMAT_EXPECT_NAME_SEPARATOR;
+				is_written = push__JSONWriter(writer, iter->content + start, iter->count - start);
 
-			switch (current) {
-				case '\"':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+				break;
+			case '{':
+			case '[': {
+				unsigned char close = c == '{' ? '}' : ']';
+
+				if (state != FORMAT_EXPECT_VALUE) {
+					return format_unexpected__JSON(state);
+				} else if (depth == JSON_SKIP_MAX_DEPTH) {
+					return FORMAT_TOO_DEEP;
+				}
 
-					break;
-				case '\\':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+				if (c == '{') {
+					stack[depth / 64] |= (uint64_t)1 << (depth % 64);
+				} else {
+					stack[depth / 64] &= ~((uint64_t)1 << (depth % 64));
+				}
 
-					break;
-				case '/':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '/'));
+				++depth;
+				++iter->count;
+				is_written = push__JSONWriter(writer, iter->content + start, 1);
+
+				// Empty containers stay on one line
+				if (skip_whitespace__JSONContentIterator(iter) == close) {
+					--depth;
+					++iter->count;
+					is_value_end = true;
+					is_written = is_written && push__JSONWriter(writer, (const char *)&close, 1);
+				} else {
+					state = c == '{' ? FORMAT_EXPECT_MEMBER : FORMAT_EXPECT_VALUE;
+					is_written = is_written && (!indent || push_newline__JSONWriter(writer, indent, depth));
+				}
 
-					break;
-				case '\b':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'b'));
+				break;
+			}
+			case '}':
+			case ']': {
+				if (depth == 0 || state != FORMAT_EXPECT_VALUE_SEPARATOR) {
+					return format_unexpected__JSON(state);
+				}
 
-					break;
-				case '\f':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'f'));
+				--depth;
 
-					break;
-				case '\n':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'n'));
+				bool is_object = stack[depth / 64] >> (depth % 64) & 1;
 
-					break;
-				case '\r':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'r'));
+				if (is_object != (c == '}')) {
+					return FORMAT_MISMATCHED_BRACKET;
+				}
 
-					break;
-				case '\t':
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 't'));
+				++iter->count;
+				is_value_end = true;
+				is_written = (!indent || push_newline__JSONWriter(writer, indent, depth)) && push__JSONWriter(writer, iter->content + start, 1);
 
-					break;
-				default:
-					JSON_TO_STRING_HANDLE_ERROR(push_character__JSONValueString(res, current));
+				break;
 			}
+			case ',':
+				if (depth == 0 || state != FORMAT_EXPECT_VALUE_SEPARATOR) {
+					return format_unexpected__JSON(state);
+				}
+
+				++iter->count;
+				state = stack[(depth - 1) / 64] >> ((depth - 1) % 64) & 1 ? FORMAT_EXPECT_MEMBER : FORMAT_EXPECT_VALUE;
+				is_written = push__JSONWriter(writer, ",", 1) && (!indent || push_newline__JSONWriter(writer, indent, depth));
+
+				break;
+			case ':':
+				if (state != FORMAT_EXPECT_NAME_SEPARATOR) {
+					return format_unexpected__JSON(state);
+				}
+
+				++iter->count;
+				state = FORMAT_EXPECT_VALUE;
+				is_written = push__JSONWriter(writer, ": ", indent ? 2 : 1);
+
+				break;
+			case 't':
+			case 'f':
+			case 'n':
+				if (state != FORMAT_EXPECT_VALUE) {
+					return format_unexpected__JSON(state);
+				} else if (validate_literal__JSONContentIterator(iter, c == 't' ? "true" : c == 'f' ? "false" : "null", c == 'f' ? 5 : 4)) {
+					return FORMAT_INVALID_LITERAL;
+				}
+
+				is_value_end = true;
+				is_written = push__JSONWriter(writer, iter->content + start, iter->count - start);
+
+				break;
+			default: {
+				bool is_integer;
+
+				if (c != '-' && !isdigit(c)) {
+					return FORMAT_UNEXPECTED_CHARACTER;
+				} else if (state != FORMAT_EXPECT_VALUE) {
+					return format_unexpected__JSON(state);
+				} else if (scan_number__JSONContentIterator(iter, &is_integer)) {
+					return FORMAT_INVALID_NUMBER;
+				}
+
+				is_value_end = true;
+				is_written = push__JSONWriter(writer, iter->content + start, iter->count - start);
+			}
+		}
+
+		if (!is_written) {
+			return FORMAT_WRITE_FAILED;
+		} else if (is_value_end) {
+			state = FORMAT_EXPECT_VALUE_SEPARATOR;
 		}
+
+		c = skip_whitespace__JSONContentIterator(iter);
+	} while (depth > 0);
+
+	if (iter->count < iter->len) {
+		return FORMAT_TRAILING_CONTENT;
 	}
 
-	return push__JSONValueString(res, '"');
+	return flush__JSONWriter(writer) ? FORMAT_NO_ERROR : FORMAT_WRITE_FAILED;
 }
 
-bool
-convert_boolean_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+uint32_t
+format_unexpected__JSON(uint32_t state)
 {
-	if (self->boolean) {
-		return push_characters__JSONValueString(res, "true", 4);
+	switch (state) {
+		case FORMAT_EXPECT_VALUE:
+			return FORMAT_EXPECTED_VALUE;
+		case FORMAT_EXPECT_MEMBER:
+			return FORMAT_EXPECTED_MEMBER;
+		case FORMAT_EXPECT_NAME_SEPARATOR:
+			return FORMAT_EXPECTED_NAME_SEPARATOR;
+		case FORMAT_EXPECT_VALUE_SEPARATOR:
+			return FORMAT_EXPECTED_VALUE_SEPARATOR;
+		default:
+			UNREACHABLE("Unknown state");
 	}
-	
-	return push_characters__JSONValueString(res, "false", 5);
 }
 
-bool
-convert_array_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+JSONStatus
+format_status__JSON(const struct JSONContentIterator *iter, uint32_t res)
 {
-	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '['));
-
-	size_t array_len = self->array.len;
+	switch (res) {
+		case FORMAT_NO_ERROR:
+			return init_ok__JSONStatus();
+		case FORMAT_UNEXPECTED_END:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected end", iter->count);
+		case FORMAT_UNEXPECTED_CHARACTER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character", iter->count);
+		case FORMAT_MISMATCHED_BRACKET:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Mismatched bracket", iter->count);
+		case FORMAT_TOO_DEEP:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Too deep", iter->count);
+		case FORMAT_INVALID_STRING:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid string", iter->count);
+		case FORMAT_TRAILING_CONTENT:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected content after the value", iter->count);
+		case FORMAT_EXPECTED_VALUE:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected value", iter->count);
+		case FORMAT_EXPECTED_MEMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member", iter->count);
+		case FORMAT_EXPECTED_NAME_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected name separator", iter->count);
+		case FORMAT_EXPECTED_VALUE_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,` or the end of the container", iter->count);
+		case FORMAT_INVALID_NUMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid number", iter->count);
+		case FORMAT_INVALID_LITERAL:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `true`, `false` or `null`", iter->count);
+		case FORMAT_WRITE_FAILED:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_WRITE_FAILED, "Write failed", iter->count);
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
 
-	if (self->array.buffer) {
-		for (size_t i = 0; i < self->array.len; ++i) {
-			JSON_TO_STRING_HANDLE_ERROR(to_string_base__JSONValue(&self->array.buffer[i], res));
+unsigned char
+skip_separators__JSONSequenceIterator(struct JSONContentIterator *iter)
+{
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
 
-			if (i + 1 != array_len) {
-				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ','));
-			}
-		}
+	while (c == JSON_SEQUENCE_RS) {
+		++iter->count;
+		c = skip_whitespace__JSONContentIterator(iter);
 	}
 
-	return push__JSONValueString(res, ']');
+	return c;
 }
 
 bool
-convert_object_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+fill__JSONSequenceIterator(JSONSequenceIterator *self)
 {
-	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '{'));
+	// Drops the bytes already consumed, then grows the buffer when the value
+	// being read leaves too little room for the next read.
+	size_t len = self->content_len - self->offset;
+
+	if (self->offset > 0) {
+		memmove(self->buffer, self->buffer + self->offset, len);
+	}
 
-	bool need_comma = false;
+	self->offset = 0;
+	self->content_len = len;
 
-	if (self->object.map.buckets) {
-		for (size_t i = 0; i < self->object.map.capacity; ++i) {
-			const JSONValueObjectBucket *current_bucket = self->object.map.buckets[i];
+	if (self->buffer_capacity - len < JSON_SEQUENCE_READ_LEN) {
+		size_t capacity = self->buffer_capacity * 2;
 
-			while (current_bucket) {
-				if (need_comma) {
-					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ','));
-				}
+		if (capacity < len + JSON_SEQUENCE_READ_LEN) {
+			capacity = len + JSON_SEQUENCE_READ_LEN;
+		}
 
-				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
-				JSON_TO_STRING_HANDLE_ERROR(push_characters__JSONValueString(res, current_bucket->pair.key.buffer, current_bucket->pair.key.len));
-				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
-				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ':'));
-				JSON_TO_STRING_HANDLE_ERROR(to_string_base__JSONValue(current_bucket->pair.value, res));
+		char *buffer = realloc(self->buffer, capacity);
 
-				current_bucket = current_bucket->next;
-				need_comma = true;
-			}
+		if (!buffer) {
+			return false;
 		}
+
+		self->buffer = buffer;
+		self->buffer_capacity = capacity;
+		self->content = buffer;
 	}
 
-	return push__JSONValueString(res, '}');
+	size_t read_len = self->read(self->buffer + len, self->buffer_capacity - len, self->user_data);
+
+	self->content_len += read_len;
+	self->is_eof = read_len == 0;
+
+	return true;
 }
 
 bool
-convert_null_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+find_end__JSONSequenceIterator(JSONSequenceIterator *self)
 {
-	return push_characters__JSONValueString(res, "null", 4);
-}
-
-#undef JSON_TO_STRING_HANDLE_ERROR
+	// NOTE: Only the strings and the brackets are followed, the value is
+	// validated once complete. `self->scan` keeps the state between reads,
+	// so a value spanning many reads is still scanned once.
+	const char *s = self->content + self->offset;
+	size_t len = self->content_len - self->offset;
+	size_t i = self->scan.len;
+
+	for (; i < len; ++i) {
+		unsigned char c = s[i];
+
+		if (c == JSON_SEQUENCE_RS) {
+			return true;
+		} else if (self->scan.is_in_string) {
+			if (self->scan.is_escaped) {
+				self->scan.is_escaped = false;
+			} else if (c == '\\') {
+				self->scan.is_escaped = true;
+			} else if (c == '"') {
+				self->scan.is_in_string = false;
+
+				if (self->scan.depth == 0) {
+					return true;
+				}
+			}
 
-bool
-to_string_base__JSONValue(const JSONValue *self, JSONValueString *res)
-{
-	switch (self->kind) {
-		case JSON_VALUE_KIND_NUMBER:
-			return convert_number_value_to_string__JSONValue(self, res);
-		case JSON_VALUE_KIND_STRING:
-			return convert_string_value_to_string__JSONValue(self, res);
-		case JSON_VALUE_KIND_BOOLEAN:
-			return convert_boolean_value_to_string__JSONValue(self, res);
-		case JSON_VALUE_KIND_ARRAY:
-			return convert_array_value_to_string__JSONValue(self, res);
-		case JSON_VALUE_KIND_OBJECT:
-			return convert_object_value_to_string__JSONValue(self, res);
-		case JSON_VALUE_KIND_NULL:
-			return convert_null_value_to_string__JSONValue(self, res);
-		default:
-			UNREACHABLE("Unknown value");
+			continue;
+		}
+
+		switch (c) {
+			case '"':
+				self->scan.is_in_string = true;
+
+				break;
+			case '{':
+			case '[':
+				++self->scan.depth;
+
+				break;
+			case '}':
+			case ']':
+				// A closing bracket at the top level is reported by the
+				// validation.
+				if (self->scan.depth <= 1) {
+					return true;
+				}
+
+				--self->scan.depth;
+
+				break;
+			default:
+				// A top-level literal or number ends at the first other
+				// character.
+				if (self->scan.depth == 0 && !(isalnum(c) || c == '-' || c == '+' || c == '.')) {
+					return true;
+				}
+		}
 	}
+
+	self->scan.len = i;
+
+	return false;
 }
 
-char *
-to_string__JSONValue(const JSONValue *self)
+#ifdef JSON_THREADS
+size_t
+get_threads__JSON(size_t threads)
 {
-	JSONValueString res = init__JSONValueString();
-
-	if (!to_string_base__JSONValue(self, &res)) {
-		deinit__JSONValueString(&res);
+	if (threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
 
-		return NULL;
+		threads = cpus > 0 ? (size_t)cpus : 1;
 	}
 
-	return res.buffer;
+	return threads;
 }
 
 void
-deinit__JSONValue(const JSONValue *self)
+run_workers__JSON(void *(*run)(void *), void *arg, size_t threads)
 {
-	switch (self->kind) {
-		case JSON_VALUE_KIND_NUMBER:
-			deinit__JSONValueString(&self->number);
-
-			break;
-		case JSON_VALUE_KIND_BOOLEAN:
-		case JSON_VALUE_KIND_NULL:
-			break;
-		case JSON_VALUE_KIND_STRING:
-			deinit__JSONValueString(&self->string);
+	// The calling thread is one of the workers. If some threads cannot be
+	// created, the others do their share.
+	pthread_t *workers = threads > 1 ? malloc(sizeof(pthread_t) * (threads - 1)) : NULL;
+	size_t workers_len = 0;
 
-			break;
-		case JSON_VALUE_KIND_ARRAY:
-			deinit__JSONValueArray(&self->array);
+	while (workers && workers_len < threads - 1 && pthread_create(&workers[workers_len], NULL, run, arg) == 0) {
+		++workers_len;
+	}
 
-			break;
-		case JSON_VALUE_KIND_OBJECT:
-			deinit__JSONValueObject(&self->object);
+	run(arg);
 
-			break;
-		default:
-			UNREACHABLE("unknown JSON value");
+	for (size_t i = 0; i < workers_len; ++i) {
+		pthread_join(workers[i], NULL);
 	}
-}
 
-JSONValueResult
-init_ok__JSONValueResult(JSONValue value)
-{
-	return (JSONValueResult){
-		.kind = JSON_VALUE_RESULT_KIND_OK,
-		.ok = value,
-	};
+	free(workers);
 }
 
-JSONValueResult
-init_err__JSONValueResult(enum JSONValueResultError kind, const char *msg)
+size_t
+claim__JSONBatch(struct JSONBatch *self, int *fd)
 {
-	return (JSONValueResult){
-		.kind = JSON_VALUE_RESULT_KIND_ERR,
-		.err = {
-			.kind = kind,
-			.msg = msg
-		},
-	};
-}
+	// Only the indexes are claimed under the lock, the files are opened once
+	// it is released.
+	pthread_mutex_lock(&self->mutex);
 
-bool
-is_err__JSONValueResult(const JSONValueResult *self)
-{
-	return self->kind == JSON_VALUE_RESULT_KIND_ERR;
-}
+	size_t index = self->next;
+	size_t prefetch_begin = self->prefetched;
+	size_t prefetch_end = prefetch_begin;
 
-const JSONValue *
-unwrap__JSONValueResult(const JSONValueResult *self)
-{
-	assert(self->kind == JSON_VALUE_RESULT_KIND_OK && "expected ok");
+	if (index < self->paths_len) {
+		++self->next;
+		prefetch_end = index + self->prefetch_len + 1;
 
-	return &self->ok;
-}
+		if (prefetch_end > self->paths_len) {
+			prefetch_end = self->paths_len;
+		}
 
-void
-deinit__JSONValueResult(const JSONValueResult *self)
-{
-	switch (self->kind) {
-		case JSON_VALUE_RESULT_KIND_OK:
-			deinit__JSONValue(&self->ok);
+		if (prefetch_end > prefetch_begin) {
+			self->prefetched = prefetch_end;
+		} else {
+			prefetch_end = prefetch_begin;
+		}
+	}
 
-			break;
-		case JSON_VALUE_RESULT_KIND_ERR:
-			break;
-		default:
-			UNREACHABLE("Unknown result");
+	pthread_mutex_unlock(&self->mutex);
+
+	if (index >= self->paths_len) {
+		return index;
+	}
+
+	// Lets the kernel read the next files while this one is parsed
+	for (size_t i = prefetch_begin; i < prefetch_end; ++i) {
+		int prefetched_fd = open(self->paths[i], O_RDONLY);
+		int expected = JSON_BATCH_FD_PENDING;
+
+		if (prefetched_fd >= 0) {
+			posix_fadvise(prefetched_fd, 0, 0, POSIX_FADV_WILLNEED);
+		}
+
+		// The thread parsing this file may have gone ahead without waiting
+		// for the prefetch, in which case it opened the file itself.
+		if (!__atomic_compare_exchange_n(&self->fds[i], &expected, prefetched_fd, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED) && prefetched_fd >= 0) {
+			close(prefetched_fd);
+		}
 	}
+
+	*fd = __atomic_exchange_n(&self->fds[index], JSON_BATCH_FD_TAKEN, __ATOMIC_ACQUIRE);
+
+	return index;
 }
 
 JSONValueResult
-parse_array_value__JSON(struct JSONContentIterator *iter)
+parse_file__JSONBatch(const char *path, int fd, char **buffer, size_t *buffer_capacity)
 {
-	// See RFC 8259:
-	//
-	// 5.  Arrays
-	//
-	// [...]
-	//
-	// array = begin-array [ value *( value-separator value ) ] end-array
-	//
-	// [...]
-	if (!expect_character__JSONContentIterator(iter, '[',  true)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `[`");
+	if (fd < 0) {
+		// Either the file is not prefetched yet, or the error is reported
+		// again in case it was transient
+		fd = open(path, O_RDONLY);
+
+		if (fd < 0) {
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_READ_FAILED, "Cannot open the file");
+		}
 	}
 
-	uint32_t current = current__JSONContentIterator(iter);
-	JSONValueArray array = init__JSONValueArray();
+	struct stat st;
+	size_t len = 0;
 
-	while (current && current != ']') {
-		JSONValueResult value_result = parse_value__JSON(iter);
+	// The size is only a hint, the file is read until its end
+	if (fstat(fd, &st) == 0 && st.st_size > 0 && (size_t)st.st_size >= *buffer_capacity) {
+		size_t capacity = (size_t)st.st_size + 1;
+		char *new_buffer = realloc(*buffer, capacity);
 
-		if (is_err__JSONValueResult(&value_result)) {
-			return value_result;
+		if (!new_buffer) {
+			close(fd);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
 		}
 
-		const JSONValue *value = unwrap__JSONValueResult(&value_result);
+		*buffer = new_buffer;
+		*buffer_capacity = capacity;
+	}
+
+	for (;;) {
+		if (len == *buffer_capacity) {
+			size_t capacity = *buffer_capacity ? *buffer_capacity * 2 : JSON_BATCH_MIN_BUFFER_LEN;
+			char *new_buffer = realloc(*buffer, capacity);
 
-		if (!push__JSONValueArray(&array, *value)) {
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+			if (!new_buffer) {
+				close(fd);
+
+				return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+			}
+
+			*buffer = new_buffer;
+			*buffer_capacity = capacity;
 		}
 
-		skip_spaces__JSONContentIterator(iter);
+		ssize_t read_len = read(fd, *buffer + len, *buffer_capacity - len);
 
-		if (!(current__JSONContentIterator(iter) == ']' || expect_character__JSONContentIterator(iter, ',', true))) {
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+		if (read_len < 0) {
+			close(fd);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_READ_FAILED, "Cannot read the file");
+		} else if (read_len == 0) {
+			break;
 		}
 
-		current = current__JSONContentIterator(iter);
+		len += read_len;
 	}
 
-	next__JSONContentIterator(iter); // Skip `]`
+	close(fd);
 
-	return init_ok__JSONValueResult(init_array__JSONValue(array));
+	return parse_validated__JSON(*buffer, len, NULL);
 }
 
-uint32_t 
-parse_object_member_value__JSON(struct JSONContentIterator *iter, JSONValueObject *object)
+void *
+run__JSONBatch(void *self)
 {
-	skip_spaces__JSONContentIterator(iter);
-
-	if (current__JSONContentIterator(iter) != '"') {
-		return PARSE_OBJECT_EXPECTED_MEMBER;
+	struct JSONBatch *batch = self;
+	// Reused for all the files parsed by this thread
+	char *buffer = NULL;
+	size_t buffer_capacity = 0;
+	int fd;
+	size_t index;
+
+	while ((index = claim__JSONBatch(batch, &fd)) < batch->paths_len) {
+		JSONValueResult res = parse_file__JSONBatch(batch->paths[index], fd, &buffer, &buffer_capacity);
+
+		if (batch->callback) {
+			batch->callback(index, res, batch->user_data);
+		} else {
+			batch->results[index] = res;
+		}
 	}
 
-	JSONValueResult name_result = parse_string_value__JSON(iter);
+	free(buffer);
+
+	return NULL;
+}
+
+void
+parse_files_base__JSON(struct JSONBatch *batch, size_t threads)
+{
+	threads = get_threads__JSON(threads);
 
-	if (is_err__JSONValueResult(&name_result)) {
-		return PARSE_OBJECT_INVALID_MEMBER_NAME;
+	if (threads > batch->paths_len) {
+		threads = batch->paths_len;
 	}
 
-	if (!expect_character__JSONContentIterator(iter, ':', true)) {
-		return PARSE_OBJECT_EXPECTED_VALUE_SEPARATOR;
+	if (threads == 0) {
+		return;
 	}
 
-	JSONValueResult value_result = parse_value__JSON(iter);
+	batch->next = 0;
+	batch->prefetched = 0;
+	batch->prefetch_len = threads * JSON_BATCH_PREFETCH_PER_THREAD;
+	batch->fds = malloc(sizeof(int) * batch->paths_len);
 
-	if (is_err__JSONValueResult(&value_result)) {
-		return PARSE_OBJECT_INVALID_MEMBER_VALUE;
-	}
-	
-	const JSONValue *name = unwrap__JSONValueResult(&name_result);
-	const JSONValue *value = unwrap__JSONValueResult(&value_result);
+	if (!batch->fds) {
+		for (size_t i = 0; i < batch->paths_len; ++i) {
+			JSONValueResult res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
 
-	switch (add_member__JSONValueObject(object, name->string, *value)) {
-		case OBJECT_KEY_VALUE_MAP_NO_ERROR:
-			return PARSE_OBJECT_NO_ERROR;
-		case OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY:
-			return PARSE_OBJECT_OUT_OF_MEMORY;
-		case OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY:
-			return PARSE_OBJECT_DUPLICATE_KEY;
-		default:
-			UNREACHABLE("Unknown status");
-	}
-}
+			if (batch->callback) {
+				batch->callback(i, res, batch->user_data);
+			} else {
+				batch->results[i] = res;
+			}
+		}
 
-JSONValueResult
-parse_object_value__JSON(struct JSONContentIterator *iter)
-{
-	// See RFC 8259:
-	//
-	// 4.  Objects
-	//
-	// [...]
-	//
-	// object = begin-object [ member *( value-separator member ) ]
-    //          end-object
-	// member = string name-separator value
-	//
-	// [...]
-	if (!expect_character__JSONContentIterator(iter, '{', true)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `{`");
+		return;
 	}
 
-	uint32_t current = current__JSONContentIterator(iter);
-	JSONValueObject object = init__JSONValueObject();
-	uint32_t res;
+	for (size_t i = 0; i < batch->paths_len; ++i) {
+		batch->fds[i] = JSON_BATCH_FD_PENDING;
+	}
 
-	while (current && current != '}') {
-		if ((res = parse_object_member_value__JSON(iter, &object))) {
-			goto handle_err;
-		}
+	pthread_mutex_init(&batch->mutex, NULL);
+	run_workers__JSON(&run__JSONBatch, batch, threads);
+	pthread_mutex_destroy(&batch->mutex);
+	free(batch->fds);
+}
 
-		skip_spaces__JSONContentIterator(iter);
+struct JSONParallelPiece *
+push_piece__JSONParallelPlan(struct JSONParallelPlan *self)
+{
+	if (self->len == self->capacity) {
+		size_t capacity = self->capacity ? self->capacity * 2 : 16;
+		struct JSONParallelPiece *pieces = realloc(self->pieces, sizeof(struct JSONParallelPiece) * capacity);
 
-		if (!(current__JSONContentIterator(iter) == '}' || expect_character__JSONContentIterator(iter, ',', true))) {
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+		if (!pieces) {
+			return NULL;
 		}
 
-		current = current__JSONContentIterator(iter);
+		self->pieces = pieces;
+		self->capacity = capacity;
 	}
 
-	next__JSONContentIterator(iter); // Skip `}`
+	struct JSONParallelPiece *piece = &self->pieces[self->len++];
 
-	return init_ok__JSONValueResult(init_object__JSONValue(object));
+	*piece = (struct JSONParallelPiece){
+		.value = NULL,
+		.elements = NULL,
+		.elements_len = 0,
+		.is_first = true,
+		.owns_elements = false,
+		.res = init__JSONValueString()
+	};
 
-handle_err:
-	switch (res) {
-		case PARSE_OBJECT_EXPECTED_MEMBER:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member");
-		case PARSE_OBJECT_EXPECTED_VALUE_SEPARATOR:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected value separator");
-		case PARSE_OBJECT_INVALID_MEMBER_NAME:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member name");
-		case PARSE_OBJECT_INVALID_MEMBER_VALUE:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member value");
-		case PARSE_OBJECT_OUT_OF_MEMORY:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
-		case PARSE_OBJECT_DUPLICATE_KEY:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Duplicated key");
-		default:
-			UNREACHABLE("Unknown error");
-	}
+	return piece;
 }
 
 bool
-is_hex_character__JSON(uint32_t c)
+push_text__JSONParallelPlan(struct JSONParallelPlan *self, const char *s, size_t s_len)
 {
-	return isdigit(c) || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+	struct JSONParallelPiece *last = self->len > 0 ? &self->pieces[self->len - 1] : NULL;
+
+	// Consecutive texts share a piece
+	if (!last || last->value || last->elements) {
+		last = push_piece__JSONParallelPlan(self);
+
+		if (!last) {
+			return false;
+		}
+	}
+
+	return push_characters__JSONValueString(&last->res, (char *)s, s_len);
 }
 
-uint32_t
-parse_string_escape_value__JSON(struct JSONContentIterator *iter, JSONValueString *string)
+bool
+split__JSONParallelPlan(struct JSONParallelPlan *self, const JSONValue *value, size_t depth)
 {
-	uint32_t current = next__JSONContentIterator(iter);
-	uint32_t character_to_add;
+	// NOTE: Containers with many elements are split into ranges of
+	// elements, the other ones are walked down to find larger containers.
+	size_t len;
 
-	switch (current) {
-		case '"':
-			character_to_add = '\"';
+	switch (value->kind) {
+		case JSON_VALUE_KIND_ARRAY:
+			// Packed arrays are serialized as a single piece
+			len = get_kind__JSONValueArray(&value->array) == JSON_VALUE_ARRAY_KIND_VALUES ? value->array.len : 0;
 
 			break;
-		case '\\':
-			character_to_add = '\\';
+		case JSON_VALUE_KIND_OBJECT:
+			len = value->object.map->len;
 
 			break;
-		case '/':
-			character_to_add = '/';
+		default:
+			len = 0;
+	}
 
-			break;
-		case 'b':
-			character_to_add = '\b';
+	if (len == 0 || (len < JSON_PARALLEL_MIN_SPLIT_LEN && depth == JSON_PARALLEL_MAX_DEPTH)) {
+		struct JSONParallelPiece *piece = push_piece__JSONParallelPlan(self);
 
-			break;
-		case 'f':
-			character_to_add = '\f';
+		if (!piece) {
+			return false;
+		}
 
-			break;
-		case 'n':
-			character_to_add = '\n';
+		piece->value = value;
 
-			break;
-		case 'r':
-			character_to_add = '\r';
+		return true;
+	}
 
-			break;
-		case 't':
-			character_to_add = '\t';
+	struct JSONParallelElement *elements = malloc(sizeof(struct JSONParallelElement) * len);
 
-			break;
-		case 'u': {
-			uint32_t u1 = next__JSONContentIterator(iter);
-			uint32_t u2 = next__JSONContentIterator(iter);
-			uint32_t u3 = next__JSONContentIterator(iter);
-			uint32_t u4 = next__JSONContentIterator(iter);
+	if (!elements) {
+		return false;
+	}
 
-			if (is_hex_character__JSON(u1) &&
-				is_hex_character__JSON(u2) &&
-				is_hex_character__JSON(u3) &&
-				is_hex_character__JSON(u4)) {
-				char unicode_escape_value_s[] = {
-					'0', 'x', (char)u1, (char)u2, (char)u3, (char)u4, 0
-				};
+	if (value->kind == JSON_VALUE_KIND_ARRAY) {
+		for (size_t i = 0; i < len; ++i) {
+			elements[i] = (struct JSONParallelElement){ .key = NULL, .value = &value->array.buffer[i] };
+		}
+	} else {
+		for (size_t i = 0; i < len; ++i) {
+			elements[i] = (struct JSONParallelElement){ .key = &value->object.map->members[i].key, .value = value->object.map->members[i].value };
+		}
+	}
 
-				character_to_add = strtol(&unicode_escape_value_s[0], NULL, 0);	
-			} else {
-				return PARSE_STRING_INVALID_UNICODE_ESCAPE;
+	bool is_array = value->kind == JSON_VALUE_KIND_ARRAY;
+
+	if (!push_text__JSONParallelPlan(self, is_array ? "[" : "{", 1)) {
+		free(elements);
+
+		return false;
+	}
+
+	if (len >= JSON_PARALLEL_MIN_SPLIT_LEN) {
+		size_t ranges_len = self->threads * JSON_PARALLEL_RANGES_PER_THREAD;
+
+		if (ranges_len > len) {
+			ranges_len = len;
+		}
+
+		for (size_t i = 0; i < ranges_len; ++i) {
+			size_t begin = len * i / ranges_len;
+			size_t end = len * (i + 1) / ranges_len;
+			struct JSONParallelPiece *piece = push_piece__JSONParallelPlan(self);
+
+			if (!piece) {
+				if (i == 0) {
+					free(elements);
+				}
+
+				return false;
 			}
 
-			break;
+			piece->elements = elements + begin;
+			piece->elements_len = end - begin;
+			piece->is_first = i == 0;
+			piece->owns_elements = i == 0;
+		}
+	} else {
+		bool is_split = true;
+
+		for (size_t i = 0; i < len && is_split; ++i) {
+			if (i > 0) {
+				is_split = push_text__JSONParallelPlan(self, ",", 1);
+			}
+
+			if (is_split && elements[i].key) {
+				is_split = push_text__JSONParallelPlan(self, "\"", 1) &&
+					push_text__JSONParallelPlan(self, elements[i].key->buffer, elements[i].key->len) &&
+					push_text__JSONParallelPlan(self, "\":", 2);
+			}
+
+			is_split = is_split && split__JSONParallelPlan(self, elements[i].value, depth + 1);
+		}
+
+		free(elements);
+
+		if (!is_split) {
+			return false;
 		}
-		default:
-			return PARSE_STRING_UNKNOWN_ESCAPE;
 	}
 
-	if (!push__JSONValueString(string, character_to_add)) {
-		return PARSE_STRING_OUT_OF_MEMORY;
+	return push_text__JSONParallelPlan(self, is_array ? "]" : "}", 1);
+}
+
+bool
+serialize__JSONParallelPiece(struct JSONParallelPiece *self)
+{
+	if (self->value) {
+		return to_string_base__JSONValue(self->value, &self->res);
 	}
 
-	return PARSE_STRING_NO_ERROR;
+	// The same output as `convert_array_value_to_string__JSONValue` and
+	// `convert_object_value_to_string__JSONValue`
+	for (size_t i = 0; i < self->elements_len; ++i) {
+		const struct JSONParallelElement *element = &self->elements[i];
+
+		if ((i > 0 || !self->is_first) && !push__JSONValueString(&self->res, ',')) {
+			return false;
+		}
+
+		if (element->key) {
+			if (!push__JSONValueString(&self->res, '"') ||
+				!push_characters__JSONValueString(&self->res, element->key->buffer, element->key->len) ||
+				!push__JSONValueString(&self->res, '"') ||
+				!push__JSONValueString(&self->res, ':')) {
+				return false;
+			}
+		}
+
+		if (!to_string_base__JSONValue(element->value, &self->res)) {
+			return false;
+		}
+	}
+
+	return true;
 }
 
-JSONValueResult
-parse_string_value__JSON(struct JSONContentIterator *iter)
+void *
+run__JSONParallelPlan(void *self)
 {
-	// See RFC 8259:
-	//
-	// 7.  Strings
-	//
-	// [...]
-	//
-	// string = quotation-mark *char quotation-mark
-    // char = unescaped /
-    //     escape (
-    //         %x22 /          ; "    quotation mark  U+0022
-    //         %x5C /          ; \    reverse solidus U+005C
-    //         %x2F /          ; /    solidus         U+002F
-    //         %x62 /          ; b    backspace       U+0008
-    //         %x66 /          ; f    form feed       U+000C
-    //         %x6E /          ; n    line feed       U+000A
-    //         %x72 /          ; r    carriage return U+000D
-    //         %x74 /          ; t    tab             U+0009
-    //         %x75 4HEXDIG )  ; uXXXX                U+XXXX
-    // escape = %x5C              ; \
-    // quotation-mark = %x22      ; "
-    // unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
-	//
-	// [...]
-	if (!expect_character__JSONContentIterator(iter, '"', true)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `\"`");
+	struct JSONParallelPlan *plan = self;
+	size_t i;
+
+	while ((i = __atomic_fetch_add(&plan->next, 1, __ATOMIC_RELAXED)) < plan->len) {
+		struct JSONParallelPiece *piece = &plan->pieces[i];
+
+		// Texts are already written
+		if ((piece->value || piece->elements) && !serialize__JSONParallelPiece(piece)) {
+			__atomic_store_n(&plan->has_failed, true, __ATOMIC_RELAXED);
+		}
 	}
 
-	uint32_t res = PARSE_STRING_NO_ERROR;
-	uint32_t current = current__JSONContentIterator(iter);
-	JSONValueString string = init__JSONValueString();
+	return NULL;
+}
 
-	while (current && current != '"') {
-		switch (current) {
-			case '\\':
-				if ((res = parse_string_escape_value__JSON(iter, &string))) {
-					goto handle_err;
-				}
+void
+deinit__JSONParallelPlan(const struct JSONParallelPlan *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		if (self->pieces[i].owns_elements) {
+			free((struct JSONParallelElement *)self->pieces[i].elements);
+		}
 
-				break;
-			default:
-				if (current < 0x20) {
-					return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Characters greater than 0x0 and less than 0x20 are invalid");
-				} else if (!push__JSONValueString(&string, current)) {
-					return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
-				}
+		deinit__JSONValueString(&self->pieces[i].res);
+	}
+
+	free(self->pieces);
+}
+
+bool
+serialize_parallel__JSONValue(const JSONValue *self, size_t threads, struct JSONParallelPlan *plan)
+{
+	*plan = (struct JSONParallelPlan){
+		.pieces = NULL,
+		.len = 0,
+		.capacity = 0,
+		.threads = get_threads__JSON(threads),
+		.next = 0,
+		.has_failed = false
+	};
+
+	if (!split__JSONParallelPlan(plan, self, 0)) {
+		deinit__JSONParallelPlan(plan);
+
+		return false;
+	}
+
+	size_t tasks_len = 0;
+
+	for (size_t i = 0; i < plan->len; ++i) {
+		tasks_len += plan->pieces[i].value || plan->pieces[i].elements;
+	}
+
+	run_workers__JSON(&run__JSONParallelPlan, plan, tasks_len < plan->threads ? tasks_len : plan->threads);
+
+	if (plan->has_failed) {
+		deinit__JSONParallelPlan(plan);
+
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t
+now_ns__JSONReclaimer(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void *
+run__JSONReclaimer(void *self)
+{
+	JSONReclaimer *reclaimer = self;
+
+	pthread_mutex_lock(&reclaimer->mutex);
+
+	for (;;) {
+		while (reclaimer->len == 0 && !reclaimer->is_stopping) {
+			pthread_cond_wait(&reclaimer->not_empty, &reclaimer->mutex);
 		}
 
-		current = next__JSONContentIterator(iter);
+		if (reclaimer->len == 0) {
+			break;
+		}
+
+		JSONValue value = reclaimer->queue[reclaimer->head];
+
+		reclaimer->head = (reclaimer->head + 1) % reclaimer->capacity;
+		--reclaimer->len;
+		reclaimer->is_busy = true;
+
+		pthread_mutex_unlock(&reclaimer->mutex);
+
+		uint64_t start = now_ns__JSONReclaimer();
+
+		deinit__JSONValue(&value);
+
+		uint64_t reclaim_ns = now_ns__JSONReclaimer() - start;
+
+		pthread_mutex_lock(&reclaimer->mutex);
+
+		reclaimer->is_busy = false;
+		++reclaimer->stats.reclaimed;
+		reclaimer->stats.reclaim_ns += reclaim_ns;
+
+		if (reclaimer->len == 0) {
+			pthread_cond_broadcast(&reclaimer->drained);
+		}
 	}
 
-	next__JSONContentIterator(iter); // Skip `"`
+	pthread_mutex_unlock(&reclaimer->mutex);
 
-	return init_ok__JSONValueResult(init_string__JSONValue(string));
+	return NULL;
+}
+#endif
 
-handle_err:
-	switch (res) {
-		case PARSE_STRING_UNKNOWN_ESCAPE:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unknown escape");
-		case PARSE_STRING_OUT_OF_MEMORY:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
-		case PARSE_STRING_INVALID_UNICODE_ESCAPE:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid unicode escape");
-		default:
-			UNREACHABLE("Unknown error");
+uint8_t
+encode_utf8__JSON(uint32_t c, char *res)
+{
+	// See RFC 3629, 3.  UTF-8 definition
+	if (c <= 0x7F) {
+		res[0] = c;
+
+		return 1;
+	} else if (c <= 0x7FF) {
+		res[0] = ((c >> 6) & 0x1F) | 0xC0;
+		res[1] = (c & 0x3F) | 0x80;
+
+		return 2;
+	} else if (c <= 0xFFFF) {
+		res[0] = ((c >> 12) & 0xF) | 0xE0;
+		res[1] = ((c >> 6) & 0x3F) | 0x80;
+		res[2] = (c & 0x3F) | 0x80;
+
+		return 3;
 	}
+
+	res[0] = ((c >> 18) & 0x7) | 0xF0;
+	res[1] = ((c >> 12) & 0x3F) | 0x80;
+	res[2] = ((c >> 6) & 0x3F) | 0x80;
+	res[3] = (c & 0x3F) | 0x80;
+
+	return 4;
 }
 
-uint32_t
-parse_number_minus_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+size_t
+unescape__JSON(const char *s, size_t s_len, char *res, size_t res_capacity)
 {
-	uint32_t current = current__JSONContentIterator(iter);
+	size_t len = 0;
+
+	for (size_t i = 0; i < s_len; ++i) {
+		char escaped[4];
+		uint8_t escaped_len = 1;
+
+		if (s[i] != '\\') {
+			escaped[0] = s[i];
+		} else if (++i == s_len) {
+			return SIZE_MAX;
+		} else {
+			switch (s[i]) {
+				case '"':
+				case '\\':
+				case '/':
+					escaped[0] = s[i];
+
+					break;
+				case 'b':
+					escaped[0] = '\b';
+
+					break;
+				case 'f':
+					escaped[0] = '\f';
+
+					break;
+				case 'n':
+					escaped[0] = '\n';
+
+					break;
+				case 'r':
+					escaped[0] = '\r';
+
+					break;
+				case 't':
+					escaped[0] = '\t';
+
+					break;
+				case 'u': {
+					uint32_t c = 0;
+
+					for (int j = 0; j < 4; ++j) {
+						if (++i == s_len || !is_hex_character__JSON((unsigned char)s[i])) {
+							return SIZE_MAX;
+						}
+
+						c = c << 4 | (isdigit((unsigned char)s[i]) ? s[i] - '0' : (s[i] | 0x20) - 'a' + 10);
+					}
+
+					// Surrogate pair
+					if (c >= 0xD800 && c <= 0xDBFF && i + 6 < s_len && s[i + 1] == '\\' && s[i + 2] == 'u') {
+						uint32_t low = 0;
+
+						for (int j = 3; j < 7; ++j) {
+							if (!is_hex_character__JSON((unsigned char)s[i + j])) {
+								return SIZE_MAX;
+							}
+
+							low = low << 4 | (isdigit((unsigned char)s[i + j]) ? s[i + j] - '0' : (s[i + j] | 0x20) - 'a' + 10);
+						}
+
+						if (low >= 0xDC00 && low <= 0xDFFF) {
+							c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+							i += 6;
+						}
+					}
+
+					escaped_len = encode_utf8__JSON(c, escaped);
+
+					break;
+				}
+				default:
+					return SIZE_MAX;
+			}
+		}
+
+		if (len + escaped_len > res_capacity) {
+			return SIZE_MAX;
+		}
+
+		memcpy(res + len, escaped, escaped_len);
+		len += escaped_len;
+	}
+
+	return len;
+}
+
+static void
+mix__SipHashState(struct SipHashState *self)
+{
+#define JSON_HASH_ROTATE_LEFT(value, bits) \
+	(((value) << (bits)) | ((value) >> (64 - (bits))))
+
+	self->v0 += self->v1;
+	self->v2 += self->v3;
+	self->v1 = JSON_HASH_ROTATE_LEFT(self->v1, 13);
+	self->v3 = JSON_HASH_ROTATE_LEFT(self->v3, 16);
+	self->v1 ^= self->v0;
+	self->v3 ^= self->v2;
+	self->v0 = JSON_HASH_ROTATE_LEFT(self->v0, 32);
+	self->v2 += self->v1;
+	self->v0 += self->v3;
+	self->v1 = JSON_HASH_ROTATE_LEFT(self->v1, 17);
+	self->v3 = JSON_HASH_ROTATE_LEFT(self->v3, 21);
+	self->v1 ^= self->v2;
+	self->v3 ^= self->v0;
+	self->v2 = JSON_HASH_ROTATE_LEFT(self->v2, 32);
+
+#undef JSON_HASH_ROTATE_LEFT
+}
+
+void
+final__SipHashState(struct SipHashState *self, size_t len)
+{
+	self->v2 ^= 0xFF;
+
+	for (int i = 0; i < 4; ++i) {
+		mix__SipHashState(self);
+	}
+
+	self->v0 ^= len;
+
+	for (int i = 0; i < 4; ++i) {
+		mix__SipHashState(self);
+	}
+}
+
+uint64_t
+hash__SipHashState(const void *key, size_t key_len, const size_t k0, const size_t k1)
+{
+	struct SipHashState state = {
+		.v0 = k0 ^ (sizeof(size_t) == 8 ? 0x736f6d6570736575ULL : 0x736f6d65),
+		.v1 = k1 ^ (sizeof(size_t) == 8 ? 0x646f72616e646f6dULL : 0x646f7261),
+		.v2 = k0 ^ (sizeof(size_t) == 8 ? 0x6c7967656e657261ULL : 0x6e657261),
+		.v3 = k1 ^ (sizeof(size_t) == 8 ? 0x7465646279746573ULL : 0x79746573)
+	};
+
+	const uint8_t *key_bytes = (const uint8_t*)key;
+	const uint8_t *end = key_bytes + key_len - (key_len % sizeof(uint64_t));
+	const uint64_t *blocks = (const uint64_t *)key_bytes;
+
+	while (key_bytes < end) {
+		state.v3 ^= *blocks;
+
+		for (int i = 0; i < 2; ++i) {
+			mix__SipHashState(&state);
+		}
+
+		state.v0 ^= *blocks;
+		++blocks;
+		key_bytes += sizeof(uint64_t);
+	}
+
+	uint64_t last_block = 0;
+
+	memcpy(&last_block, key_bytes, key_len % sizeof(uint64_t));
+
+	state.v3 ^= last_block;
+
+	for (int i = 0; i < 2; ++i) {
+		mix__SipHashState(&state);
+	}
+
+	state.v0 ^= last_block;
+
+	final__SipHashState(&state, key_len);
+
+	return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
+}
+
+JSONValueString
+init__JSONValueString(void)
+{
+	return (JSONValueString){
+		.buffer = NULL,
+		.len = 0,
+		.capacity = 8,
+	};
+}
+
+bool
+eq__JSONValueString(const JSONValueString *self, const JSONValueString *other)
+{
+	if (is_empty__JSONValueString(self) && is_empty__JSONValueString(other)) {
+		return true;
+	} else if (self->len != other->len) {
+		return false;
+	} else if (self->buffer == other->buffer) {
+		// e.g. interned in the same table
+		return true;
+	}
+
+	for (size_t i = 0; i < self->len; ++i) {
+		if (self->buffer[i] != other->buffer[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+push__JSONValueString(JSONValueString *self, uint32_t c)
+{
+	// See RFC 3629:
+	//
+	// 3.  UTF-8 definition
+	//
+	// [...]
+	//
+	// Char. number range  |        UTF-8 octet sequence
+	//    (hexadecimal)    |              (binary)
+	// --------------------+---------------------------------------------
+	// 0000 0000-0000 007F | 0xxxxxxx
+	// 0000 0080-0000 07FF | 110xxxxx 10xxxxxx
+	// 0000 0800-0000 FFFF | 1110xxxx 10xxxxxx 10xxxxxx
+	// 0001 0000-0010 FFFF | 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
+	//
+	// [...]
+	uint8_t byte_count;
+
+	if (c <= 0x7F) {
+		byte_count = 1;
+	} else if (c <= 0x7FF) {
+		byte_count = 2;
+	} else if (c <= 0xFFFF) {
+		byte_count = 3;
+	} else if (c <= 0x10FFFF) {
+		byte_count = 4;
+	} else {
+		UNREACHABLE("invalid codepoint");
+	}
+
+	if (!self->buffer) {
+		self->buffer = malloc(self->capacity);	
+		JSON_STATS_ADD(allocations, 1);
+	} else if (self->len + byte_count + 1 >= self->capacity) {
+		self->capacity *= 2;
+		self->buffer = realloc(self->buffer, self->capacity);
+		JSON_STATS_ADD(allocations, 1);
+	}
+
+	if (!self->buffer) {
+		return false;
+	}
+
+	switch (byte_count) {
+		case 1:
+			self->buffer[self->len++] = c;
+
+			break;
+		case 2:
+			self->buffer[self->len++] = ((c >> 6 ) & 0x1F) | 0xC0;
+			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+
+			break;
+		case 3:
+			self->buffer[self->len++] = ((c >> 12) & 0xF) | 0xE0;
+			self->buffer[self->len++] = ((c >> 6) & 0x3F) | 0x80;
+			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+
+			break;
+		case 4:
+			self->buffer[self->len++] = ((c >> 18) & 0x7) | 0xF0;
+			self->buffer[self->len++] = ((c >> 12) & 0x3F) | 0x80;
+			self->buffer[self->len++] = ((c >> 6) & 0x3F) | 0x80;
+			self->buffer[self->len++] = (c & 0x3F) | 0x80;
+
+			break;
+		default:
+			UNREACHABLE("Impossible byte count");
+	}
+
+	self->buffer[self->len] = 0;
+
+	return true;
+}
+
+bool
+push_character__JSONValueString(JSONValueString *self, unsigned char c)
+{
+	if (!self->buffer) {
+		self->buffer = malloc(self->capacity);
+		JSON_STATS_ADD(allocations, 1);
+	} else if (self->len + 1 >= self->capacity) {
+		self->capacity *= 2;
+		self->buffer = realloc(self->buffer, self->capacity);
+		JSON_STATS_ADD(allocations, 1);
+	}
+
+	if (!self->buffer) {
+		return false;
+	}
+
+	self->buffer[self->len++] = c;
+	self->buffer[self->len] = 0;
+
+	return true;
+}
+
+bool
+push_characters__JSONValueString(JSONValueString *self, char *s, size_t s_len)
+{
+	size_t new_size = self->len + s_len + 1;
+
+	if (new_size >= self->capacity) {
+		self->capacity <<= (new_size / self->capacity + 1);
+		self->buffer = realloc(self->buffer, self->capacity);
+		JSON_STATS_ADD(allocations, 1);
+
+		assert(self->capacity > new_size);
+	} else if (!self->buffer) {
+		self->buffer = malloc(self->capacity);
+		JSON_STATS_ADD(allocations, 1);
+	}
+
+	if (!self->buffer) {
+		return false;
+	}
+
+	char *start_buffer = self->buffer + self->len;
+
+	memcpy(start_buffer, s, s_len);
+
+	self->len = new_size - 1;
+
+	self->buffer[self->len] = 0;
+
+	return true;
+}
+
+bool
+is_empty__JSONValueString(const JSONValueString *self)
+{
+	return self->len == 0;
+}
+
+void
+deinit__JSONValueString(const JSONValueString *self)
+{
+	// A borrowed buffer, such as an interned string
+	if (self->capacity) {
+		free(self->buffer);
+	}
+}
+
+JSONValueArray
+init__JSONValueArray(void)
+{
+	return (JSONValueArray){
+		.buffer = NULL,
+		.len = 0,
+		.capacity = 8
+	};
+}
+
+struct JSONValueArrayHeader *
+get_header__JSONValueArray(const JSONValueArray *self)
+{
+	// NOTE: `self` must have a buffer.
+	return (struct JSONValueArrayHeader *)(void *)self->buffer - 1;
+}
+
+enum JSONValueArrayKind
+get_kind__JSONValueArray(const JSONValueArray *self)
+{
+	return self->buffer ? get_header__JSONValueArray(self)->kind : JSON_VALUE_ARRAY_KIND_VALUES;
+}
+
+bool
+resize__JSONValueArray(JSONValueArray *self, enum JSONValueArrayKind kind, size_t capacity)
+{
+	// NOTE: Allocates or grows the buffer of `self` and its header, for
+	// `capacity` elements of `kind`. The buffer must not be shared with
+	// clones. Returns false on allocation failure, `self` is then left as it
+	// was.
+	size_t element_size;
+
+	switch (kind) {
+		case JSON_VALUE_ARRAY_KIND_VALUES:
+			element_size = sizeof(JSONValue);
+
+			break;
+		case JSON_VALUE_ARRAY_KIND_INT:
+		case JSON_VALUE_ARRAY_KIND_DOUBLE:
+			element_size = sizeof(int64_t);
+
+			break;
+		case JSON_VALUE_ARRAY_KIND_BOOLEAN:
+			element_size = sizeof(bool);
+
+			break;
+		default:
+			UNREACHABLE("Unknown array kind");
+	}
+
+	struct JSONValueArrayHeader *header = realloc(self->buffer ? get_header__JSONValueArray(self) : NULL, sizeof(struct JSONValueArrayHeader) + element_size * capacity);
+
+	JSON_STATS_ADD(allocations, 1);
+
+	if (!header) {
+		return false;
+	}
+
+	if (!self->buffer) {
+		header->shared = (JSONValueShared){
+			.ref_count = 1,
+			.hash = 0
+		};
+	}
+
+	header->kind = kind;
+	self->buffer = (JSONValue *)(void *)(header + 1);
+	self->capacity = capacity;
+
+	return true;
+}
+
+bool
+push__JSONValueArray(JSONValueArray *self, JSONValue value)
+{
+	// The elements are kept on failure, so that they can be released
+	if (!self->buffer && !resize__JSONValueArray(self, JSON_VALUE_ARRAY_KIND_VALUES, self->capacity)) {
+		return false;
+	} else if (self->len + 1 >= self->capacity && !resize__JSONValueArray(self, JSON_VALUE_ARRAY_KIND_VALUES, self->capacity * 2)) {
+		return false;
+	}
+
+	self->buffer[self->len++] = value;
+
+	return true;
+}
+
+void
+deinit__JSONValueArray(const JSONValueArray *self)
+{
+	if (!self->buffer) {
+		return;
+	}
+
+	// A buffer shared with clones is freed by its last holder
+	struct JSONValueArrayHeader *header = get_header__JSONValueArray(self);
+
+	if (!release_shared__JSONValue(&header->shared)) {
+		return;
+	}
+
+	if (header->kind == JSON_VALUE_ARRAY_KIND_VALUES) {
+		for (size_t i = 0; i < self->len; ++i) {
+			deinit__JSONValue(&self->buffer[i]);
+		}
+	}
+
+	free(header);
+}
+
+size_t
+format_number__JSONValueArray(const JSONValueArray *self, size_t index, char *res)
+{
+	// NOTE: `res` has room for JSON_PACKED_NUMBER_MAX_LEN bytes.
+	if (get_kind__JSONValueArray(self) == JSON_VALUE_ARRAY_KIND_INT) {
+		return snprintf(res, JSON_PACKED_NUMBER_MAX_LEN, "%" PRId64, self->ints[index]);
+	}
+
+	double number = self->doubles[index];
+	int len;
+
+	// The shortest precision which reads back as the same double
+	for (int precision = 15;; ++precision) {
+		len = snprintf(res, JSON_PACKED_NUMBER_MAX_LEN, "%.*g", precision, number);
+
+		if (precision == 17 || strtod(res, NULL) == number) {
+			return len;
+		}
+	}
+}
+
+JSONValueObjectKeyValue
+init__JSONValueObjectKeyValue(JSONValueString key, JSONValue value)
+{
+	JSONValue *value_ptr = malloc(sizeof(JSONValue));
+
+	JSON_STATS_ADD(allocations, 1);
+
+	if (!value_ptr) {
+		FATAL("Out of memory");
+	}
+
+	*value_ptr = value;
+
+	return (JSONValueObjectKeyValue){
+		.key = key,
+		.value = value_ptr
+	};
+}
+
+void
+deinit__JSONValueObjectKeyValue(const JSONValueObjectKeyValue *self)
+{
+	deinit__JSONValueString(&self->key);
+	deinit__JSONValue(self->value);
+	free(self->value);
+}
+
+JSONValueObjectKeyValueMap
+init__JSONValueObjectKeyValueMap(void)
+{
+	return (JSONValueObjectKeyValueMap){
+		.members = NULL,
+		.len = 0,
+		.members_capacity = 0,
+		.index = NULL,
+		.capacity = 8,
+		.shape = NULL,
+		.shared = {
+			.ref_count = 1,
+			.hash = 0
+		}
+	};
+}
+
+size_t
+hash__JSONValueObjectKeyValueMap(const char *key, size_t key_len)
+{
+	const size_t k0 = sizeof(size_t) == 8 ? 0x0123456789abcdefULL : 0x01234567;
+	const size_t k1 = sizeof(size_t) == 8 ? 0xfedcba9876543210ULL : 0x89abcdef;
+
+	return hash__SipHashState(key, key_len, k0, k1);
+}
+
+size_t
+index__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const JSONValueString *key)
+{
+	// NOTE: The capacity is a power of two.
+	return hash__JSONValueObjectKeyValueMap(key->buffer, key->len) & (self->capacity - 1);
+}
+
+bool
+grow_index__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self)
+{
+	size_t capacity = self->index ? self->capacity * 2 : self->capacity;
+	uint32_t *index = calloc(capacity, sizeof(uint32_t));
+
+	JSON_STATS_ADD(allocations, 1);
+
+	if (!index) {
+		return false;
+	}
+
+	if (self->index) {
+		JSON_STATS_ADD(object_resizes, 1);
+	}
+
+	free(self->index);
+
+	self->index = index;
+	self->capacity = capacity;
+
+	// Only the slots are moved, the members stay where they are
+	for (size_t i = 0; i < self->len; ++i) {
+		size_t slot = index__JSONValueObjectKeyValueMap(self, &self->members[i].key);
+
+		while (self->index[slot]) {
+			slot = (slot + 1) & (self->capacity - 1);
+		}
+
+		self->index[slot] = i + 1;
+	}
+
+	return true;
+}
+
+uint32_t
+push__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, JSONValueObjectKeyValue value)
+{
+	// NOTE: The map takes the ownership of `value`, even on failure.
+	if (!self->index || self->len + 1 >= self->capacity * JSON_VALUE_OBJECT_KEY_VALUE_MAP_LOAD_FACTOR) {
+		if (!grow_index__JSONValueObjectKeyValueMap(self)) {
+			deinit__JSONValueObjectKeyValue(&value);
+
+			return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
+		}
+	}
+
+	size_t slot = index__JSONValueObjectKeyValueMap(self, &value.key);
+#ifdef JSON_STATS
+	size_t probe_len = 0;
+#endif
+
+	while (self->index[slot]) {
+		if (eq__JSONValueString(&self->members[self->index[slot] - 1].key, &value.key)) {
+			deinit__JSONValueObjectKeyValue(&value);
+
+			return OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY;
+		}
+
+		slot = (slot + 1) & (self->capacity - 1);
+#ifdef JSON_STATS
+		++probe_len;
+#endif
+	}
+
+	JSON_STATS_ADD(object_probes, probe_len);
+	JSON_STATS_MAX(object_max_probe_len, probe_len);
+
+	if (self->len == self->members_capacity) {
+		size_t members_capacity = self->members_capacity ? self->members_capacity * 2 : 4;
+		JSONValueObjectKeyValue *members = realloc(self->members, sizeof(JSONValueObjectKeyValue) * members_capacity);
+
+		JSON_STATS_ADD(allocations, 1);
+
+		if (!members) {
+			deinit__JSONValueObjectKeyValue(&value);
+
+			return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
+		}
+
+		self->members = members;
+		self->members_capacity = members_capacity;
+	}
+
+	self->members[self->len++] = value;
+	self->index[slot] = self->len;
+
+	return OBJECT_KEY_VALUE_MAP_NO_ERROR;
+}
+
+const JSONValue *
+get__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const JSONValueString *key)
+{
+	return get_hashed__JSONValueObjectKeyValueMap(self, key->buffer, key->len, hash__JSONValueObjectKeyValueMap(key->buffer, key->len));
+}
+
+const JSONValue *
+get_hashed__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const char *key, size_t key_len, size_t hash)
+{
+	size_t i = find__JSONValueObjectKeyValueMap(self, key, key_len, hash);
+
+	return i != SIZE_MAX ? self->members[i].value : NULL;
+}
+
+size_t
+find__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self, const char *key, size_t key_len, size_t hash)
+{
+	// NOTE: Returns the index of the member named `key`, or SIZE_MAX.
+	if (!self->index) {
+		return SIZE_MAX;
+	}
+
+	size_t slot = hash & (self->capacity - 1);
+
+	while (self->index[slot]) {
+		const JSONValueObjectKeyValue *member = &self->members[self->index[slot] - 1];
+
+		if (member->key.len == key_len && (key_len == 0 || !memcmp(member->key.buffer, key, key_len))) {
+			return self->index[slot] - 1;
+		}
+
+		slot = (slot + 1) & (self->capacity - 1);
+	}
+
+	return SIZE_MAX;
+}
+
+void
+deinit__JSONValueObjectKeyValueMap(const JSONValueObjectKeyValueMap *self)
+{
+	// NOTE: Frees the members of `self`, see `deinit__JSONValueObject` for
+	// the holders of the map.
+	if (self->shape) {
+		for (size_t i = 0; i < self->len; ++i) {
+			deinit__JSONValue(self->members[i].value);
+			free(self->members[i].value);
+		}
+
+		free(self->members);
+		release__JSONObjectShape(self->shape);
+
+		return;
+	}
+
+	for (size_t i = 0; i < self->len; ++i) {
+		deinit__JSONValueObjectKeyValue(&self->members[i]);
+	}
+
+	free(self->members);
+	free(self->index);
+}
+
+struct JSONObjectShape *
+share__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self)
+{
+	// NOTE: Moves the names and the index of `self` to a new shape. Returns
+	// NULL on allocation failure, `self` is then left as it was.
+	struct JSONObjectShape *shape = malloc(sizeof(struct JSONObjectShape));
+	JSONValueString *keys = malloc(sizeof(JSONValueString) * self->len);
+
+	JSON_STATS_ADD(allocations, 2);
+
+	if (!shape || !keys) {
+		free(shape);
+		free(keys);
+
+		return NULL;
+	}
+
+	bool is_raw = true;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		keys[i] = self->members[i].key;
+
+		for (size_t j = 0; j < keys[i].len && is_raw; ++j) {
+			unsigned char c = keys[i].buffer[j];
+
+			is_raw = c >= 0x20 && c != '"' && c != '\\';
+		}
+	}
+
+	*shape = (struct JSONObjectShape){
+		.keys = keys,
+		.len = self->len,
+		.index = self->index,
+		.capacity = self->capacity,
+		.is_raw = is_raw,
+		.ref_count = 1
+	};
+
+	self->shape = shape;
+
+	return shape;
+}
+
+void
+use_shape__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, struct JSONObjectShape *shape)
+{
+	// NOTE: `self` must be empty. The objects of a shape may be released by
+	// different threads once they are shared with clones.
+	__atomic_fetch_add(&shape->ref_count, 1, __ATOMIC_RELAXED);
+
+	self->shape = shape;
+	self->index = shape->index;
+	self->capacity = shape->capacity;
+}
+
+uint32_t
+push_shared__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, JSONValue value)
+{
+	// NOTE: Adds the next member of the shape, whose name was matched by the
+	// caller. The index already has its slot.
+	if (!self->members) {
+		self->members = malloc(sizeof(JSONValueObjectKeyValue) * self->shape->len);
+		self->members_capacity = self->shape->len;
+
+		JSON_STATS_ADD(allocations, 1);
+
+		if (!self->members) {
+			deinit__JSONValue(&value);
+
+			return OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY;
+		}
+	}
+
+	self->members[self->len] = init__JSONValueObjectKeyValue(self->shape->keys[self->len], value);
+	++self->len;
+
+	return OBJECT_KEY_VALUE_MAP_NO_ERROR;
+}
+
+bool
+unshare__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self)
+{
+	// NOTE: Copies the names of the members from the shape and indexes them
+	// again, e.g. when a member does not follow the shape.
+	struct JSONObjectShape *shape = self->shape;
+	size_t capacity = 8;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		JSONValueString key = init__JSONValueString();
+
+		if (!push_characters__JSONValueString(&key, self->members[i].key.buffer ? self->members[i].key.buffer : "", self->members[i].key.len)) {
+			for (size_t j = 0; j < i; ++j) {
+				deinit__JSONValueString(&self->members[j].key);
+				self->members[j].key = shape->keys[j];
+			}
+
+			return false;
+		}
+
+		self->members[i].key = key;
+	}
+
+	while (self->len + 1 >= capacity * JSON_VALUE_OBJECT_KEY_VALUE_MAP_LOAD_FACTOR) {
+		capacity *= 2;
+	}
+
+	self->shape = NULL;
+	self->index = NULL;
+	self->capacity = capacity;
+
+	release__JSONObjectShape(shape);
+
+	return grow_index__JSONValueObjectKeyValueMap(self);
+}
+
+void
+remove__JSONValueObjectKeyValueMap(JSONValueObjectKeyValueMap *self, size_t index)
+{
+	// NOTE: `self` must not use a shape. The members stay in insertion order
+	// and are indexed again in place.
+	deinit__JSONValueObjectKeyValue(&self->members[index]);
+
+	memmove(&self->members[index], &self->members[index + 1], sizeof(JSONValueObjectKeyValue) * (self->len - index - 1));
+	memset(self->index, 0, sizeof(uint32_t) * self->capacity);
+
+	--self->len;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		size_t slot = index__JSONValueObjectKeyValueMap(self, &self->members[i].key);
+
+		while (self->index[slot]) {
+			slot = (slot + 1) & (self->capacity - 1);
+		}
+
+		self->index[slot] = i + 1;
+	}
+}
+
+void
+release__JSONObjectShape(struct JSONObjectShape *self)
+{
+	if (__atomic_sub_fetch(&self->ref_count, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < self->len; ++i) {
+		deinit__JSONValueString(&self->keys[i]);
+	}
+
+	free(self->keys);
+	free(self->index);
+	free(self);
+}
+
+JSONValueObject
+init__JSONValueObject(void)
+{
+	// NOTE: `map` is NULL on allocation failure.
+	JSONValueObjectKeyValueMap *map = malloc(sizeof(JSONValueObjectKeyValueMap));
+
+	JSON_STATS_ADD(allocations, 1);
+
+	if (map) {
+		*map = init__JSONValueObjectKeyValueMap();
+	}
+
+	return (JSONValueObject){
+		.map = map
+	};
+}
+
+uint32_t
+add_member__JSONValueObject(JSONValueObject *self, JSONValueString key, JSONValue value)
+{
+	return push__JSONValueObjectKeyValueMap(self->map, init__JSONValueObjectKeyValue(key, value));
+}
+
+void
+deinit__JSONValueObject(const JSONValueObject *self)
+{
+	// A map shared with clones is freed by its last holder
+	if (!release_shared__JSONValue(&self->map->shared)) {
+		return;
+	}
+
+	deinit__JSONValueObjectKeyValueMap(self->map);
+	free(self->map);
+}
+
+JSONValue
+init_number__JSONValue(JSONValueString number)
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_NUMBER,
+		.number = number
+	};
+}
+
+JSONValue
+init_string__JSONValue(JSONValueString string)
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_STRING,
+		.string = string
+	};
+}
+
+JSONValue
+init_boolean__JSONValue(bool boolean)
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_BOOLEAN,
+		.boolean = boolean
+	};
+}
+
+JSONValue
+init_array__JSONValue(JSONValueArray array)
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_ARRAY,
+		.array = array
+	};
+}
+
+JSONValue
+init_object__JSONValue(JSONValueObject object)
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_OBJECT,
+		.object = object
+	};
+}
+
+JSONValue
+init_null__JSONValue()
+{
+	return (JSONValue){
+		.kind = JSON_VALUE_KIND_NULL
+	};
+}
+
+void
+retain_shared__JSONValue(JSONValueShared *shared)
+{
+	// NOTE: The holder already keeps the buffer alive. Several threads may
+	// clone a frozen document at once.
+	__atomic_fetch_add(&shared->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+bool
+release_shared__JSONValue(JSONValueShared *shared)
+{
+	// NOTE: Returns true if the caller was the last holder of the buffer,
+	// which it then frees.
+	return __atomic_sub_fetch(&shared->ref_count, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+bool
+own_shared__JSONValue(JSONValueShared *shared)
+{
+	// NOTE: Returns true if the caller is the only holder of the buffer, which
+	// it is about to edit, so the hash of the buffer is forgotten.
+	if (__atomic_load_n(&shared->ref_count, __ATOMIC_ACQUIRE) > 1) {
+		return false;
+	}
+
+	__atomic_store_n(&shared->hash, 0, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+bool
+clone__JSONValueString(const JSONValueString *self, JSONValueString *res)
+{
+	// A borrowed buffer outlives both strings
+	if (!self->capacity) {
+		*res = *self;
+
+		return true;
+	}
+
+	*res = init__JSONValueString();
+
+	return push_characters__JSONValueString(res, self->buffer ? self->buffer : "", self->len);
+}
+
+bool
+clone_base__JSONValue(const JSONValue *self, JSONValue *res)
+{
+	switch (self->kind) {
+		case JSON_VALUE_KIND_NUMBER: {
+			JSONValueString number;
+
+			if (!clone__JSONValueString(&self->number, &number)) {
+				return false;
+			}
+
+			*res = init_number__JSONValue(number);
+
+			return true;
+		}
+		case JSON_VALUE_KIND_STRING: {
+			JSONValueString string;
+
+			if (!clone__JSONValueString(&self->string, &string)) {
+				return false;
+			}
+
+			*res = init_string__JSONValue(string);
+
+			return true;
+		}
+		case JSON_VALUE_KIND_BOOLEAN:
+		case JSON_VALUE_KIND_NULL:
+			*res = *self;
+
+			return true;
+		case JSON_VALUE_KIND_ARRAY: {
+			if (self->array.buffer) {
+				retain_shared__JSONValue(&get_header__JSONValueArray(&self->array)->shared);
+			}
+
+			*res = *self;
+
+			return true;
+		}
+		case JSON_VALUE_KIND_OBJECT: {
+			retain_shared__JSONValue(&self->object.map->shared);
+
+			*res = *self;
+
+			return true;
+		}
+		default:
+			UNREACHABLE("Unknown value");
+	}
+}
+
+JSONValueResult
+clone__JSONValue(const JSONValue *self)
+{
+	JSONValue res;
+
+	if (!clone_base__JSONValue(self, &res)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+	}
+
+	return init_ok__JSONValueResult(res);
+}
+
+bool
+detach__JSONValueArray(JSONValueArray *self)
+{
+	// NOTE: Gives `self` its own copy of a buffer shared with clones. The
+	// elements are cloned, so only their own buffers get shared. `self` is
+	// not packed, see `unpack__JSONValueArray`.
+	if (!self->buffer || own_shared__JSONValue(&get_header__JSONValueArray(self)->shared)) {
+		return true;
+	}
+
+	JSONValueArray res = init__JSONValueArray();
+
+	if (!resize__JSONValueArray(&res, JSON_VALUE_ARRAY_KIND_VALUES, self->capacity)) {
+		return false;
+	}
+
+	for (; res.len < self->len; ++res.len) {
+		if (!clone_base__JSONValue(&self->buffer[res.len], &res.buffer[res.len])) {
+			deinit__JSONValueArray(&res);
+
+			return false;
+		}
+	}
+
+	// Drops the hold of `self` on the shared buffer
+	deinit__JSONValueArray(self);
+
+	*self = res;
+
+	return true;
+}
+
+bool
+unpack__JSONValueArray(JSONValueArray *self)
+{
+	// NOTE: Gives a packed array a buffer of values, so that its elements can
+	// be edited. The packed buffer stays with the clones which share it.
+	enum JSONValueArrayKind kind = get_kind__JSONValueArray(self);
+
+	if (kind == JSON_VALUE_ARRAY_KIND_VALUES) {
+		return true;
+	}
+
+	JSONValueArray res = init__JSONValueArray();
+
+	res.capacity = self->len + 1 > res.capacity ? self->len + 1 : res.capacity;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		JSONValue element;
+
+		if (kind == JSON_VALUE_ARRAY_KIND_BOOLEAN) {
+			element = init_boolean__JSONValue(self->booleans[i]);
+		} else {
+			char buffer[JSON_PACKED_NUMBER_MAX_LEN];
+			JSONValueString number = init__JSONValueString();
+
+			if (!push_characters__JSONValueString(&number, buffer, format_number__JSONValueArray(self, i, buffer))) {
+				deinit__JSONValueString(&number);
+				deinit__JSONValueArray(&res);
+
+				return false;
+			}
+
+			element = init_number__JSONValue(number);
+		}
+
+		if (!push__JSONValueArray(&res, element)) {
+			deinit__JSONValue(&element);
+			deinit__JSONValueArray(&res);
+
+			return false;
+		}
+	}
+
+	// Drops the hold of `self` on the packed buffer
+	deinit__JSONValueArray(self);
+
+	*self = res;
+
+	return true;
+}
+
+bool
+detach__JSONValueObject(JSONValueObject *self)
+{
+	// NOTE: Same as `detach__JSONValueArray`, for the map. The copy has its own
+	// names and index, even if `self` uses a shape.
+	if (own_shared__JSONValue(&self->map->shared)) {
+		return true;
+	}
+
+	const JSONValueObjectKeyValueMap *map = self->map;
+	JSONValueObjectKeyValueMap res = init__JSONValueObjectKeyValueMap();
+
+	res.capacity = map->capacity;
+
+	if (map->len > 0) {
+		res.members = malloc(sizeof(JSONValueObjectKeyValue) * map->len);
+		res.members_capacity = map->len;
+
+		JSON_STATS_ADD(allocations, 1);
+
+		if (!res.members) {
+			return false;
+		}
+	}
+
+	if (map->index) {
+		res.index = malloc(sizeof(uint32_t) * map->capacity);
+
+		JSON_STATS_ADD(allocations, 1);
+
+		if (!res.index) {
+			free(res.members);
+
+			return false;
+		}
+
+		// The names are in the same order, so are their slots
+		memcpy(res.index, map->index, sizeof(uint32_t) * map->capacity);
+	}
+
+	for (; res.len < map->len; ++res.len) {
+		const JSONValueObjectKeyValue *member = &map->members[res.len];
+		JSONValueString key;
+		JSONValue value;
+
+		if (!clone__JSONValueString(&member->key, &key)) {
+			deinit__JSONValueObjectKeyValueMap(&res);
+
+			return false;
+		}
+
+		if (!clone_base__JSONValue(member->value, &value)) {
+			deinit__JSONValueString(&key);
+			deinit__JSONValueObjectKeyValueMap(&res);
+
+			return false;
+		}
+
+		res.members[res.len] = init__JSONValueObjectKeyValue(key, value);
+	}
+
+	JSONValueObjectKeyValueMap *res_map = malloc(sizeof(JSONValueObjectKeyValueMap));
+
+	JSON_STATS_ADD(allocations, 1);
+
+	if (!res_map) {
+		deinit__JSONValueObjectKeyValueMap(&res);
+
+		return false;
+	}
+
+	*res_map = res;
+
+	// Drops the hold of `self` on the shared map
+	deinit__JSONValueObject(self);
+
+	self->map = res_map;
+
+	return true;
+}
+
+bool
+detach__JSONValue(JSONValue *self)
+{
+	switch (self->kind) {
+		case JSON_VALUE_KIND_ARRAY:
+			return unpack__JSONValueArray(&self->array) && detach__JSONValueArray(&self->array);
+		case JSON_VALUE_KIND_OBJECT:
+			return detach__JSONValueObject(&self->object);
+		default:
+			return false;
+	}
+}
+
+#define JSON_HASH_NULL 0x6A09E667F3BCC908ULL
+#define JSON_HASH_BOOLEAN 0xBB67AE8584CAA73BULL
+#define JSON_HASH_NUMBER 0x3C6EF372FE94F82BULL
+#define JSON_HASH_STRING 0xA54FF53A5F1D36F1ULL
+#define JSON_HASH_ARRAY 0x510E527FADE682D1ULL
+#define JSON_HASH_OBJECT 0x9B05688C2B3E6C1FULL
+
+uint64_t
+mix_hash__JSONValue(uint64_t hash)
+{
+	// NOTE: The finalizer of SplitMix64.
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+
+	return hash ^ (hash >> 31);
+}
+
+struct JSONCanonicalNumber
+canonical_number__JSONValue(const char *number, size_t number_len)
+{
+	// NOTE: The integers are read exactly, the other numbers are reduced to
+	// their significant digits and exponent (`number` is NUL-terminated).
+	bool is_negative = number_len > 0 && number[0] == '-';
+	uint64_t limit = is_negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+	uint64_t value = 0;
+	size_t i = is_negative;
+
+	for (; i < number_len && isdigit((unsigned char)number[i]); ++i) {
+		uint64_t digit = number[i] - '0';
+
+		if (value > (limit - digit) / 10) {
+			break;
+		}
+
+		value = value * 10 + digit;
+	}
+
+	if (i == number_len && number_len > (size_t)is_negative) {
+		return (struct JSONCanonicalNumber){
+			.is_int = true,
+			.i = is_negative ? (int64_t)(0 - value) : (int64_t)value
+		};
+	}
+
+	struct JSONCanonicalNumber res = {
+		.is_int = false,
+		.is_negative = is_negative,
+		.digits = NULL,
+		.digits_len = 0,
+		.exponent = 0,
+		.d = strtod(number, NULL)
+	};
+	bool is_fraction = false;
+	size_t count = 0;
+
+	// The leading zeros are skipped, the trailing ones are not counted
+	for (i = is_negative; i < number_len && (isdigit((unsigned char)number[i]) || number[i] == '.'); ++i) {
+		if (number[i] == '.') {
+			is_fraction = true;
+
+			continue;
+		} else if (!res.digits && number[i] == '0') {
+			res.exponent -= is_fraction;
+
+			continue;
+		} else if (!res.digits) {
+			res.digits = &number[i];
+		}
+
+		++count;
+		res.exponent += !is_fraction;
+
+		if (number[i] != '0') {
+			res.digits_len = count;
+		}
+	}
+
+	if (i < number_len && (number[i] == 'e' || number[i] == 'E')) {
+		bool is_negative_exponent = number[++i] == '-';
+		int64_t exponent = 0;
+
+		i += number[i] == '-' || number[i] == '+';
+
+		// NOTE: The exponents beyond 10^17 saturate.
+		for (; i < number_len && isdigit((unsigned char)number[i]); ++i) {
+			if (exponent < INT64_MAX / 100) {
+				exponent = exponent * 10 + (number[i] - '0');
+			}
+		}
+
+		res.exponent += is_negative_exponent ? -exponent : exponent;
+	}
+
+	if (!res.digits) {
+		return (struct JSONCanonicalNumber){ .is_int = true, .i = 0 };
+	} else if (res.exponent < (int64_t)res.digits_len || res.exponent > 19) {
+		return res;
+	}
+
+	// An integer written with a fraction or an exponent, or beyond int64_t
+	const char *digit = res.digits;
+
+	value = 0;
+
+	for (int64_t j = 0; j < res.exponent; ++j) {
+		uint64_t d = 0;
+
+		if ((size_t)j < res.digits_len) {
+			digit += *digit == '.';
+			d = *digit++ - '0';
+		}
+
+		if (value > (limit - d) / 10) {
+			return res;
+		}
+
+		value = value * 10 + d;
+	}
+
+	return (struct JSONCanonicalNumber){
+		.is_int = true,
+		.i = is_negative ? (int64_t)(0 - value) : (int64_t)value
+	};
+}
+
+struct JSONCanonicalNumber
+canonical_element__JSONValue(const JSONValueArray *array, size_t index, char *buffer)
+{
+	// NOTE: `array` is a packed array of numbers. The doubles are formatted
+	// into `buffer`, which has room for JSON_PACKED_NUMBER_MAX_LEN bytes and
+	// holds the digits of the result.
+	if (get_kind__JSONValueArray(array) == JSON_VALUE_ARRAY_KIND_INT) {
+		return (struct JSONCanonicalNumber){ .is_int = true, .i = array->ints[index] };
+	}
+
+	return canonical_number__JSONValue(buffer, format_number__JSONValueArray(array, index, buffer));
+}
+
+bool
+eq_number__JSONValue(struct JSONCanonicalNumber a, struct JSONCanonicalNumber b)
+{
+	if (a.is_int || b.is_int) {
+		return a.is_int == b.is_int && a.i == b.i;
+	} else if (a.is_negative != b.is_negative || a.exponent != b.exponent || a.digits_len != b.digits_len) {
+		return false;
+	}
+
+	const char *x = a.digits;
+	const char *y = b.digits;
+
+	for (size_t i = 0; i < a.digits_len; ++i, ++x, ++y) {
+		x += *x == '.';
+		y += *y == '.';
+
+		if (*x != *y) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint64_t
+hash_number__JSONValue(struct JSONCanonicalNumber number)
+{
+	if (number.is_int) {
+		return mix_hash__JSONValue(JSON_HASH_NUMBER ^ (uint64_t)number.i);
+	}
+
+	uint64_t hash = mix_hash__JSONValue(JSON_HASH_NUMBER ^ (uint64_t)number.exponent) ^ number.is_negative;
+	const char *digit = number.digits;
+
+	for (size_t i = 0; i < number.digits_len; ++i, ++digit) {
+		digit += *digit == '.';
+		hash = mix_hash__JSONValue(hash + (unsigned char)*digit);
+	}
+
+	return hash;
+}
+
+uint64_t
+get_hash_key__JSONValue(void)
+{
+	// NOTE: A random key per process, so that colliding contents cannot be
+	// prepared ahead of time. The first thread to need it installs it.
+	static uint64_t key = 0;
+	uint64_t res = __atomic_load_n(&key, __ATOMIC_ACQUIRE);
+
+	if (res) {
+		return res;
+	}
+
+	uint64_t seed = 0;
+	FILE *random = fopen("/dev/urandom", "rb");
+
+	if (random) {
+		if (fread(&seed, sizeof(seed), 1, random) != 1) {
+			seed = 0;
+		}
+
+		fclose(random);
+	}
+
+	// Without /dev/urandom, the randomized address space layout
+	seed ^= ((uint64_t)(uintptr_t)&key << 16) ^ (uint64_t)(uintptr_t)&seed;
+	seed = mix_hash__JSONValue(seed);
+	seed += seed == 0;
+
+	if (__atomic_compare_exchange_n(&key, &res, seed, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		return seed;
+	}
+
+	return res;
+}
+
+uint64_t
+hash_string__JSONValue(const char *s, size_t s_len)
+{
+	uint64_t key = get_hash_key__JSONValue();
+
+	return mix_hash__JSONValue(JSON_HASH_STRING ^ hash__SipHashState(s_len ? s : "", s_len, (size_t)key, (size_t)mix_hash__JSONValue(key)));
+}
+
+uint64_t
+hash_array__JSONValue(const JSONValueArray *self)
+{
+	// NOTE: The elements are hashed in order.
+	uint64_t hash = JSON_HASH_ARRAY ^ self->len;
+	enum JSONValueArrayKind kind = get_kind__JSONValueArray(self);
+
+	for (size_t i = 0; i < self->len; ++i) {
+		uint64_t element_hash;
+
+		switch (kind) {
+			case JSON_VALUE_ARRAY_KIND_VALUES:
+				element_hash = hash__JSONValue(&self->buffer[i]);
+
+				break;
+			case JSON_VALUE_ARRAY_KIND_INT:
+			case JSON_VALUE_ARRAY_KIND_DOUBLE: {
+				char buffer[JSON_PACKED_NUMBER_MAX_LEN];
+
+				element_hash = hash_number__JSONValue(canonical_element__JSONValue(self, i, buffer));
+
+				break;
+			}
+			case JSON_VALUE_ARRAY_KIND_BOOLEAN:
+				element_hash = mix_hash__JSONValue(JSON_HASH_BOOLEAN ^ self->booleans[i]);
+
+				break;
+			default:
+				UNREACHABLE("Unknown array kind");
+		}
+
+		hash = mix_hash__JSONValue(hash + element_hash);
+	}
+
+	return hash;
+}
+
+uint64_t
+hash_object__JSONValue(const JSONValueObjectKeyValueMap *self)
+{
+	// NOTE: The hashes of the members are added, so that their order does not
+	// matter.
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		const JSONValueObjectKeyValue *member = &self->members[i];
+
+		sum += mix_hash__JSONValue(hash_string__JSONValue(member->key.buffer, member->key.len) + 0x9E3779B97F4A7C15ULL * hash__JSONValue(member->value));
+	}
+
+	return mix_hash__JSONValue(JSON_HASH_OBJECT ^ self->len ^ sum);
+}
+
+uint64_t
+hash__JSONValue(const JSONValue *self)
+{
+	JSONValueShared *shared;
+
+	switch (self->kind) {
+		case JSON_VALUE_KIND_NUMBER:
+			return hash_number__JSONValue(canonical_number__JSONValue(self->number.buffer, self->number.len));
+		case JSON_VALUE_KIND_STRING:
+			return hash_string__JSONValue(self->string.buffer, self->string.len);
+		case JSON_VALUE_KIND_BOOLEAN:
+			return mix_hash__JSONValue(JSON_HASH_BOOLEAN ^ self->boolean);
+		case JSON_VALUE_KIND_NULL:
+			return mix_hash__JSONValue(JSON_HASH_NULL);
+		case JSON_VALUE_KIND_ARRAY:
+			// An array without elements has no header
+			shared = self->array.buffer ? &get_header__JSONValueArray(&self->array)->shared : NULL;
+
+			break;
+		case JSON_VALUE_KIND_OBJECT:
+			shared = &self->object.map->shared;
+
+			break;
+		default:
+			UNREACHABLE("Unknown value");
+	}
+
+	// NOTE: Several threads may hash a frozen document at once, they all
+	// compute and store the same hash.
+	uint64_t hash = shared ? __atomic_load_n(&shared->hash, __ATOMIC_RELAXED) : 0;
+
+	if (hash) {
+		return hash;
+	}
+
+	hash = self->kind == JSON_VALUE_KIND_ARRAY ? hash_array__JSONValue(&self->array) : hash_object__JSONValue(self->object.map);
+	// 0 stands for a hash which is not computed yet
+	hash += hash == 0;
+
+	if (shared) {
+		__atomic_store_n(&shared->hash, hash, __ATOMIC_RELAXED);
+	}
+
+	return hash;
+}
+
+bool
+eq__JSONValue(const JSONValue *self, const JSONValue *other)
+{
+	if (self == other) {
+		return true;
+	} else if (self->kind != other->kind) {
+		return false;
+	}
+
+	switch (self->kind) {
+		case JSON_VALUE_KIND_NUMBER: {
+			struct JSONCanonicalNumber a = canonical_number__JSONValue(self->number.buffer, self->number.len);
+			struct JSONCanonicalNumber b = canonical_number__JSONValue(other->number.buffer, other->number.len);
+
+			return eq_number__JSONValue(a, b);
+		}
+		case JSON_VALUE_KIND_STRING:
+			return eq__JSONValueString(&self->string, &other->string);
+		case JSON_VALUE_KIND_BOOLEAN:
+			return self->boolean == other->boolean;
+		case JSON_VALUE_KIND_NULL:
+			return true;
+		case JSON_VALUE_KIND_ARRAY:
+			// The buffer of a clone
+			if (self->array.len != other->array.len) {
+				return false;
+			} else if (self->array.buffer == other->array.buffer) {
+				return true;
+			} else if (hash__JSONValue(self) != hash__JSONValue(other)) {
+				return false;
+			}
+
+			// Equal hashes do not prove equal contents. The hashes of the
+			// nested arrays and objects are cached by now, so they still
+			// reject the differing subtrees at once.
+			for (size_t i = 0; i < self->array.len; ++i) {
+				if (!eq_element__JSONValue(self, i, other, i)) {
+					return false;
+				}
+			}
+
+			return true;
+		case JSON_VALUE_KIND_OBJECT:
+			if (self->object.map->len != other->object.map->len) {
+				return false;
+			} else if (self->object.map->members == other->object.map->members) {
+				return true;
+			} else if (hash__JSONValue(self) != hash__JSONValue(other)) {
+				return false;
+			}
+
+			return eq_members__JSONValue(self->object.map, other->object.map);
+		default:
+			UNREACHABLE("Unknown value");
+	}
+}
+
+bool
+eq_element__JSONValue(const JSONValue *self, size_t self_index, const JSONValue *other, size_t other_index)
+{
+	// NOTE: Compares the elements of two arrays, packed or not. Packed
+	// integers are compared in place; only packed doubles are formatted.
+	const JSONValueArray *a = &self->array;
+	const JSONValueArray *b = &other->array;
+	enum JSONValueArrayKind a_kind = get_kind__JSONValueArray(a);
+	enum JSONValueArrayKind b_kind = get_kind__JSONValueArray(b);
+
+	if (a_kind == JSON_VALUE_ARRAY_KIND_VALUES && b_kind == JSON_VALUE_ARRAY_KIND_VALUES) {
+		return eq__JSONValue(&a->buffer[self_index], &b->buffer[other_index]);
+	}
+
+	bool a_is_number = a_kind == JSON_VALUE_ARRAY_KIND_INT || a_kind == JSON_VALUE_ARRAY_KIND_DOUBLE;
+	bool b_is_number = b_kind == JSON_VALUE_ARRAY_KIND_INT || b_kind == JSON_VALUE_ARRAY_KIND_DOUBLE;
+
+	if (a_is_number || b_is_number) {
+		const JSONValue *a_value = a_kind == JSON_VALUE_ARRAY_KIND_VALUES ? &a->buffer[self_index] : NULL;
+		const JSONValue *b_value = b_kind == JSON_VALUE_ARRAY_KIND_VALUES ? &b->buffer[other_index] : NULL;
+
+		if ((a_value && a_value->kind != JSON_VALUE_KIND_NUMBER) || (b_value && b_value->kind != JSON_VALUE_KIND_NUMBER) || (!a_is_number && !a_value) || (!b_is_number && !b_value)) {
+			return false;
+		}
+
+		char x_buffer[JSON_PACKED_NUMBER_MAX_LEN];
+		char y_buffer[JSON_PACKED_NUMBER_MAX_LEN];
+		struct JSONCanonicalNumber x = a_value ? canonical_number__JSONValue(a_value->number.buffer, a_value->number.len) : canonical_element__JSONValue(a, self_index, x_buffer);
+		struct JSONCanonicalNumber y = b_value ? canonical_number__JSONValue(b_value->number.buffer, b_value->number.len) : canonical_element__JSONValue(b, other_index, y_buffer);
+
+		return eq_number__JSONValue(x, y);
+	}
+
+	// At least one packed array of booleans
+	JSONElement a_element;
+	JSONElement b_element;
+
+	return eq__JSONValue(get_element__JSONValue(self, self_index, &a_element), get_element__JSONValue(other, other_index, &b_element));
+}
+
+bool
+eq_members__JSONValue(const JSONValueObjectKeyValueMap *self, const JSONValueObjectKeyValueMap *other)
+{
+	// NOTE: Both objects have as many members, and their names are unique.
+	for (size_t i = 0; i < self->len; ++i) {
+		const JSONValueString *key = &self->members[i].key;
+		size_t index = i;
+
+		// Most objects compared with each other have their members in the
+		// same order.
+		if (!eq__JSONValueString(&other->members[i].key, key)) {
+			index = find__JSONValueObjectKeyValueMap(other, key->buffer, key->len, hash__JSONValueObjectKeyValueMap(key->buffer, key->len));
+		}
+
+		if (index == SIZE_MAX || !eq__JSONValue(self->members[i].value, other->members[index].value)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t
+report__JSONDiff(enum JSONDiffKind kind, JSONValueString *pointer, const JSONValue *before, const JSONValue *after, JSONDiffCallback callback, void *user_data)
+{
+	return callback(kind, pointer->buffer ? pointer->buffer : "", pointer->len, before, after, user_data) ? DIFF_NO_ERROR : DIFF_STOPPED;
+}
+
+bool
+push_key__JSONDiff(JSONValueString *pointer, const JSONValueString *key)
+{
+	// NOTE: Escapes `~` and `/` as in RFC 6901.
+	if (!push_character__JSONValueString(pointer, '/')) {
+		return false;
+	}
+
+	for (size_t i = 0; i < key->len; ++i) {
+		char c = key->buffer[i];
+		bool is_pushed = c == '~' ? push_characters__JSONValueString(pointer, "~0", 2)
+			: c == '/' ? push_characters__JSONValueString(pointer, "~1", 2)
+			: push_character__JSONValueString(pointer, c);
+
+		if (!is_pushed) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+push_index__JSONDiff(JSONValueString *pointer, size_t index)
+{
+	char buffer[24];
+	int len = snprintf(buffer, sizeof(buffer), "/%zu", index);
+
+	return push_characters__JSONValueString(pointer, buffer, len);
+}
+
+uint32_t
+diff_base__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data)
+{
+	if (eq__JSONValue(before, after)) {
+		return DIFF_NO_ERROR;
+	} else if (before->kind == JSON_VALUE_KIND_OBJECT && after->kind == JSON_VALUE_KIND_OBJECT) {
+		return diff_object__JSONValue(before, after, pointer, callback, user_data);
+	} else if (before->kind == JSON_VALUE_KIND_ARRAY && after->kind == JSON_VALUE_KIND_ARRAY) {
+		return diff_array__JSONValue(before, after, pointer, callback, user_data);
+	}
+
+	return report__JSONDiff(JSON_DIFF_KIND_CHANGED, pointer, before, after, callback, user_data);
+}
+
+uint32_t
+diff_object__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data)
+{
+	const JSONValueObjectKeyValueMap *a = before->object.map;
+	const JSONValueObjectKeyValueMap *b = after->object.map;
+	size_t pointer_len = pointer->len;
+	uint32_t status = DIFF_NO_ERROR;
+
+	// The removed and changed members, then the added ones
+	for (size_t pass = 0; pass < 2 && !status; ++pass) {
+		const JSONValueObjectKeyValueMap *from = pass == 0 ? a : b;
+		const JSONValueObjectKeyValueMap *to = pass == 0 ? b : a;
+
+		for (size_t i = 0; i < from->len && !status; ++i) {
+			const JSONValueString *key = &from->members[i].key;
+			size_t index = i;
+
+			// Most objects compared with each other have their members in the
+			// same order.
+			if (i >= to->len || !eq__JSONValueString(&to->members[i].key, key)) {
+				index = find__JSONValueObjectKeyValueMap(to, key->buffer, key->len, hash__JSONValueObjectKeyValueMap(key->buffer, key->len));
+			}
+
+			if (pass == 1 && index != SIZE_MAX) {
+				continue;
+			} else if (!push_key__JSONDiff(pointer, key)) {
+				return DIFF_OUT_OF_MEMORY;
+			}
+
+			if (index == SIZE_MAX) {
+				status = pass == 0
+					? report__JSONDiff(JSON_DIFF_KIND_REMOVED, pointer, from->members[i].value, NULL, callback, user_data)
+					: report__JSONDiff(JSON_DIFF_KIND_ADDED, pointer, NULL, from->members[i].value, callback, user_data);
+			} else {
+				status = diff_base__JSONValue(from->members[i].value, to->members[index].value, pointer, callback, user_data);
+			}
+
+			pointer->len = pointer_len;
+			pointer->buffer[pointer_len] = 0;
+		}
+	}
+
+	return status;
+}
+
+uint32_t
+diff_array__JSONValue(const JSONValue *before, const JSONValue *after, JSONValueString *pointer, JSONDiffCallback callback, void *user_data)
+{
+	size_t len = before->array.len > after->array.len ? before->array.len : after->array.len;
+	size_t pointer_len = pointer->len;
+	uint32_t status = DIFF_NO_ERROR;
+
+	for (size_t i = 0; i < len && !status; ++i) {
+		if (i < before->array.len && i < after->array.len && eq_element__JSONValue(before, i, after, i)) {
+			continue;
+		} else if (!push_index__JSONDiff(pointer, i)) {
+			return DIFF_OUT_OF_MEMORY;
+		}
+
+		JSONElement before_element;
+		JSONElement after_element;
+		const JSONValue *before_value = get_element__JSONValue(before, i, &before_element);
+		const JSONValue *after_value = get_element__JSONValue(after, i, &after_element);
+
+		if (!after_value) {
+			status = report__JSONDiff(JSON_DIFF_KIND_REMOVED, pointer, before_value, NULL, callback, user_data);
+		} else if (!before_value) {
+			status = report__JSONDiff(JSON_DIFF_KIND_ADDED, pointer, NULL, after_value, callback, user_data);
+		} else {
+			status = diff_base__JSONValue(before_value, after_value, pointer, callback, user_data);
+		}
+
+		pointer->len = pointer_len;
+		pointer->buffer[pointer_len] = 0;
+	}
+
+	return status;
+}
+
+bool
+diff__JSONValue(const JSONValue *before, const JSONValue *after, JSONDiffCallback callback, void *user_data)
+{
+	JSONValueString pointer = init__JSONValueString();
+	uint32_t status = diff_base__JSONValue(before, after, &pointer, callback, user_data);
+
+	deinit__JSONValueString(&pointer);
+
+	return status != DIFF_OUT_OF_MEMORY;
+}
+
+#define JSON_TO_STRING_HANDLE_ERROR(fncall) if (!(fncall)) { return false; }
+
+bool
+convert_number_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	return push_characters__JSONValueString(res, self->number.buffer, self->number.len);
+}
+
+bool
+convert_string_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+
+	if (self->string.buffer) {
+		for (size_t i = 0; i < self->string.len; ++i) {
+			unsigned char current = self->string.buffer[i] & 0xFF;
+
+			switch (current) {
+				case '\"':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+
+					break;
+				case '\\':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+
+					break;
+				case '/':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '/'));
+
+					break;
+				case '\b':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'b'));
+
+					break;
+				case '\f':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'f'));
+
+					break;
+				case '\n':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'n'));
+
+					break;
+				case '\r':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 'r'));
+
+					break;
+				case '\t':
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '\\'));
+					JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, 't'));
+
+					break;
+				default:
+					JSON_TO_STRING_HANDLE_ERROR(push_character__JSONValueString(res, current));
+			}
+		}
+	}
+
+	return push__JSONValueString(res, '"');
+}
+
+bool
+convert_boolean_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	if (self->boolean) {
+		return push_characters__JSONValueString(res, "true", 4);
+	}
+	
+	return push_characters__JSONValueString(res, "false", 5);
+}
+
+bool
+convert_array_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '['));
+
+	size_t array_len = self->array.len;
+
+	if (get_kind__JSONValueArray(&self->array) != JSON_VALUE_ARRAY_KIND_VALUES) {
+		JSONElement element;
+
+		for (size_t i = 0; i < array_len; ++i) {
+			JSON_TO_STRING_HANDLE_ERROR(to_string_base__JSONValue(get_element__JSONValue(self, i, &element), res));
+
+			if (i + 1 != array_len) {
+				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ','));
+			}
+		}
+	} else if (self->array.buffer) {
+		for (size_t i = 0; i < self->array.len; ++i) {
+			JSON_TO_STRING_HANDLE_ERROR(to_string_base__JSONValue(&self->array.buffer[i], res));
+
+			if (i + 1 != array_len) {
+				JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ','));
+			}
+		}
+	}
+
+	return push__JSONValueString(res, ']');
+}
+
+bool
+convert_object_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '{'));
+
+	const JSONValueObjectKeyValueMap *map = self->object.map;
+
+	for (size_t i = 0; i < map->len; ++i) {
+		if (i > 0) {
+			JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ','));
+		}
+
+		JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+		JSON_TO_STRING_HANDLE_ERROR(push_characters__JSONValueString(res, map->members[i].key.buffer, map->members[i].key.len));
+		JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, '"'));
+		JSON_TO_STRING_HANDLE_ERROR(push__JSONValueString(res, ':'));
+		JSON_TO_STRING_HANDLE_ERROR(to_string_base__JSONValue(map->members[i].value, res));
+	}
+
+	return push__JSONValueString(res, '}');
+}
+
+bool
+convert_null_value_to_string__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	return push_characters__JSONValueString(res, "null", 4);
+}
+
+#undef JSON_TO_STRING_HANDLE_ERROR
+
+bool
+to_string_base__JSONValue(const JSONValue *self, JSONValueString *res)
+{
+	switch (self->kind) {
+		case JSON_VALUE_KIND_NUMBER:
+			return convert_number_value_to_string__JSONValue(self, res);
+		case JSON_VALUE_KIND_STRING:
+			return convert_string_value_to_string__JSONValue(self, res);
+		case JSON_VALUE_KIND_BOOLEAN:
+			return convert_boolean_value_to_string__JSONValue(self, res);
+		case JSON_VALUE_KIND_ARRAY:
+			return convert_array_value_to_string__JSONValue(self, res);
+		case JSON_VALUE_KIND_OBJECT:
+			return convert_object_value_to_string__JSONValue(self, res);
+		case JSON_VALUE_KIND_NULL:
+			return convert_null_value_to_string__JSONValue(self, res);
+		default:
+			UNREACHABLE("Unknown value");
+	}
+}
+
+char *
+to_string__JSONValue(const JSONValue *self)
+{
+	JSONValueString res = init__JSONValueString();
+
+	if (!to_string_base__JSONValue(self, &res)) {
+		deinit__JSONValueString(&res);
+
+		return NULL;
+	}
+
+	return res.buffer;
+}
+
+const JSONValue *
+get_member__JSONValue(const JSONValue *self, const char *key, size_t key_len)
+{
+	if (self->kind != JSON_VALUE_KIND_OBJECT) {
+		return NULL;
+	}
+
+	const JSONValueString key_s = {
+		.buffer = (char *)key,
+		.len = key_len,
+		.capacity = key_len
+	};
+
+	return get__JSONValueObjectKeyValueMap(self->object.map, &key_s);
+}
+
+JSONMemberCache
+init__JSONMemberCache(const char *key, size_t key_len)
+{
+	return (JSONMemberCache){
+		.key = key,
+		.key_len = key_len,
+		.hash = hash__JSONValueObjectKeyValueMap(key, key_len),
+		.shape = NULL,
+		.index = 0
+	};
+}
+
+const JSONValue *
+get_cached_member__JSONValue(const JSONValue *self, JSONMemberCache *cache)
+{
+	if (self->kind != JSON_VALUE_KIND_OBJECT) {
+		return NULL;
+	}
+
+	const JSONValueObjectKeyValueMap *map = self->object.map;
+
+	// The objects of a shape have their members at the same index. The name
+	// is still compared, in case the cached shape was freed and its address
+	// reused.
+	if (map->shape && map->shape == cache->shape && cache->index < map->len) {
+		const JSONValueObjectKeyValue *member = &map->members[cache->index];
+
+		if (member->key.len == cache->key_len && (cache->key_len == 0 || !memcmp(member->key.buffer, cache->key, cache->key_len))) {
+			return member->value;
+		}
+	}
+
+	size_t i = find__JSONValueObjectKeyValueMap(map, cache->key, cache->key_len, cache->hash);
+
+	if (i == SIZE_MAX) {
+		return NULL;
+	} else if (map->shape && map->len == map->shape->len) {
+		cache->shape = map->shape;
+		cache->index = i;
+	}
+
+	return map->members[i].value;
+}
+
+JSONObjectIterator
+init__JSONObjectIterator(const JSONValue *self)
+{
+	bool is_object = self->kind == JSON_VALUE_KIND_OBJECT;
+
+	return (JSONObjectIterator){
+		.members = is_object ? self->object.map->members : NULL,
+		.len = is_object ? self->object.map->len : 0,
+		.index = 0
+	};
+}
+
+const JSONValueObjectKeyValue *
+next__JSONObjectIterator(JSONObjectIterator *self)
+{
+	if (self->index == self->len) {
+		return NULL;
+	}
+
+	// The members are contiguous but their values are not
+	if (self->index + 1 < self->len) {
+		JSON_PREFETCH(self->members[self->index + 1].value);
+	}
+
+	return &self->members[self->index++];
+}
+
+const JSONValue *
+get_element__JSONValue(const JSONValue *self, size_t index, JSONElement *element)
+{
+	if (self->kind != JSON_VALUE_KIND_ARRAY || index >= self->array.len) {
+		return NULL;
+	}
+
+	switch (get_kind__JSONValueArray(&self->array)) {
+		case JSON_VALUE_ARRAY_KIND_VALUES:
+			return &self->array.buffer[index];
+		case JSON_VALUE_ARRAY_KIND_INT:
+		case JSON_VALUE_ARRAY_KIND_DOUBLE: {
+			size_t len = format_number__JSONValueArray(&self->array, index, element->number);
+
+			// Borrowed, never released
+			element->value = (JSONValue){
+				.kind = JSON_VALUE_KIND_NUMBER,
+				.number = { .buffer = element->number, .len = len, .capacity = 0 }
+			};
+
+			return &element->value;
+		}
+		case JSON_VALUE_ARRAY_KIND_BOOLEAN:
+			element->value = init_boolean__JSONValue(self->array.booleans[index]);
+
+			return &element->value;
+		default:
+			UNREACHABLE("Unknown array kind");
+	}
+}
+
+JSONArrayIterator
+init__JSONArrayIterator(const JSONValue *self)
+{
+	bool is_array = self->kind == JSON_VALUE_KIND_ARRAY;
+
+	return (JSONArrayIterator){
+		.array = is_array ? self : NULL,
+		.len = is_array ? self->array.len : 0,
+		.index = 0
+	};
+}
+
+const JSONValue *
+next__JSONArrayIterator(JSONArrayIterator *self)
+{
+	if (self->index == self->len) {
+		return NULL;
+	}
+
+	return get_element__JSONValue(self->array, self->index++, &self->element);
+}
+
+size_t
+parse_index__JSONPointer(const char *token, size_t token_len)
+{
+	// See RFC 6901:
+	//
+	// 4.  Evaluation
+	//
+	// [...]
+	//
+	// array-index = %x30 / ( %x31-39 *(%x30-39) )
+	//               ; "0", or digits without a leading "0"
+	if (token_len == 0 || (token[0] == '0' && token_len > 1)) {
+		return SIZE_MAX;
+	}
+
+	size_t index = 0;
+
+	for (size_t i = 0; i < token_len; ++i) {
+		if (!isdigit((unsigned char)token[i]) || index > (SIZE_MAX - 9) / 10) {
+			return SIZE_MAX;
+		}
+
+		index = index * 10 + (token[i] - '0');
+	}
+
+	return index;
+}
+
+bool
+compile__JSONPointer(JSONPointer *self, const char *pointer, size_t pointer_len)
+{
+	// See RFC 6901:
+	//
+	// 3.  Syntax
+	//
+	// json-pointer    = *( "/" reference-token )
+	// reference-token = *( unescaped / escaped )
+	// escaped         = "~" ( "0" / "1" )
+	//                   ; representing '~' and '/', respectively
+	*self = (JSONPointer){ .tokens = NULL, .len = 0 };
+
+	if (pointer_len > 0 && pointer[0] != '/') {
+		return false;
+	}
+
+	for (size_t i = 0; i < pointer_len; ++i) {
+		self->len += pointer[i] == '/';
+	}
+
+	if (self->len == 0) {
+		return true;
+	}
+
+	self->tokens = calloc(self->len, sizeof(JSONPointerToken));
+
+	if (!self->tokens) {
+		self->len = 0;
+
+		return false;
+	}
+
+	const char *current = pointer + 1;
+	const char *end = pointer + pointer_len;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		const char *token_end = memchr(current, '/', end - current);
+		JSONPointerToken *token = &self->tokens[i];
+
+		if (!token_end) {
+			token_end = end;
+		}
+
+		// An unescaped token is never longer than the escaped one
+		token->key = malloc(token_end - current + 1);
+
+		if (!token->key) {
+			deinit__JSONPointer(self);
+
+			return false;
+		}
+
+		for (const char *c = current; c < token_end; ++c) {
+			if (*c != '~') {
+				token->key[token->key_len++] = *c;
+			} else if (c + 1 < token_end && (c[1] == '0' || c[1] == '1')) {
+				token->key[token->key_len++] = *++c == '0' ? '~' : '/';
+			} else {
+				deinit__JSONPointer(self);
+
+				return false;
+			}
+		}
+
+		token->key[token->key_len] = '\0';
+		token->hash = hash__JSONValueObjectKeyValueMap(token->key, token->key_len);
+		token->index = parse_index__JSONPointer(token->key, token->key_len);
+		current = token_end + 1;
+	}
+
+	return true;
+}
+
+const JSONValue *
+get__JSONPointer(const JSONPointer *self, const JSONValue *value, JSONElement *element)
+{
+	for (size_t i = 0; i < self->len && value; ++i) {
+		const JSONPointerToken *token = &self->tokens[i];
+
+		switch (value->kind) {
+			case JSON_VALUE_KIND_OBJECT:
+				value = get_hashed__JSONValueObjectKeyValueMap(value->object.map, token->key, token->key_len, token->hash);
+
+				break;
+			case JSON_VALUE_KIND_ARRAY:
+				value = get_element__JSONValue(value, token->index, element);
+
+				break;
+			default:
+				return NULL;
+		}
+	}
+
+	return value;
+}
+
+JSONValue *
+detach_parent__JSONPointer(const JSONPointer *self, JSONValue *root)
+{
+	// NOTE: Returns the parent of the value `self` points to, after detaching
+	// (and unpacking) every array and object from `root` to it. `self` must
+	// not be empty.
+	JSONValue *value = root;
+
+	for (size_t i = 0;; ++i) {
+		if (!detach__JSONValue(value)) {
+			return NULL;
+		}
+
+		if (i + 1 == self->len) {
+			return value;
+		}
+
+		const JSONPointerToken *token = &self->tokens[i];
+
+		if (value->kind == JSON_VALUE_KIND_OBJECT) {
+			size_t index = find__JSONValueObjectKeyValueMap(value->object.map, token->key, token->key_len, token->hash);
+
+			if (index == SIZE_MAX) {
+				return NULL;
+			}
+
+			value = value->object.map->members[index].value;
+		} else if (token->index < value->array.len) {
+			value = &value->array.buffer[token->index];
+		} else {
+			return NULL;
+		}
+	}
+}
+
+bool
+set__JSONPointer(const JSONPointer *self, JSONValue *root, const JSONValue *value)
+{
+	// NOTE: `value` is cloned first, it may be part of `root`.
+	JSONValue clone;
+
+	if (!clone_base__JSONValue(value, &clone)) {
+		return false;
+	}
+
+	if (self->len == 0) {
+		deinit__JSONValue(root);
+
+		*root = clone;
+
+		return true;
+	}
+
+	JSONValue *parent = detach_parent__JSONPointer(self, root);
+	const JSONPointerToken *token = &self->tokens[self->len - 1];
+
+	if (!parent) {
+		deinit__JSONValue(&clone);
+
+		return false;
+	}
+
+	if (parent->kind == JSON_VALUE_KIND_OBJECT) {
+		JSONValueObjectKeyValueMap *map = parent->object.map;
+		size_t index = find__JSONValueObjectKeyValueMap(map, token->key, token->key_len, token->hash);
+
+		if (index != SIZE_MAX) {
+			deinit__JSONValue(map->members[index].value);
+
+			*map->members[index].value = clone;
+
+			return true;
+		}
+
+		// A new member does not follow the shape
+		JSONValueString key = init__JSONValueString();
+
+		if ((map->shape && !unshare__JSONValueObjectKeyValueMap(map)) || !push_characters__JSONValueString(&key, token->key, token->key_len)) {
+			deinit__JSONValueString(&key);
+			deinit__JSONValue(&clone);
+
+			return false;
+		}
+
+		return push__JSONValueObjectKeyValueMap(map, init__JSONValueObjectKeyValue(key, clone)) == OBJECT_KEY_VALUE_MAP_NO_ERROR;
+	}
+
+	JSONValueArray *array = &parent->array;
+	size_t index = token->key_len == 1 && token->key[0] == '-' ? array->len : token->index;
+
+	if (index < array->len) {
+		deinit__JSONValue(&array->buffer[index]);
+
+		array->buffer[index] = clone;
+
+		return true;
+	}
+
+	if (index == array->len && push__JSONValueArray(array, clone)) {
+		return true;
+	}
+
+	deinit__JSONValue(&clone);
+
+	return false;
+}
+
+bool
+remove__JSONPointer(const JSONPointer *self, JSONValue *root)
+{
+	JSONValue *parent = self->len > 0 ? detach_parent__JSONPointer(self, root) : NULL;
+
+	if (!parent) {
+		return false;
+	}
+
+	const JSONPointerToken *token = &self->tokens[self->len - 1];
+
+	if (parent->kind == JSON_VALUE_KIND_OBJECT) {
+		JSONValueObjectKeyValueMap *map = parent->object.map;
+		size_t index = find__JSONValueObjectKeyValueMap(map, token->key, token->key_len, token->hash);
+
+		if (index == SIZE_MAX || (map->shape && !unshare__JSONValueObjectKeyValueMap(map))) {
+			return false;
+		}
+
+		remove__JSONValueObjectKeyValueMap(map, index);
+
+		return true;
+	}
+
+	JSONValueArray *array = &parent->array;
+
+	if (token->index >= array->len) {
+		return false;
+	}
+
+	deinit__JSONValue(&array->buffer[token->index]);
+
+	memmove(&array->buffer[token->index], &array->buffer[token->index + 1], sizeof(JSONValue) * (array->len - token->index - 1));
+
+	--array->len;
+
+	return true;
+}
+
+void
+deinit__JSONPointer(const JSONPointer *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->tokens[i].key);
+	}
+
+	free(self->tokens);
+}
+
+JSONPathInstruction *
+push__JSONPath(JSONPath *self, enum JSONPathOpcode opcode)
+{
+	if (self->len == self->capacity) {
+		size_t capacity = self->capacity ? self->capacity * 2 : 8;
+		JSONPathInstruction *code = realloc(self->code, sizeof(JSONPathInstruction) * capacity);
+
+		if (!code) {
+			return NULL;
+		}
+
+		self->code = code;
+		self->capacity = capacity;
+	}
+
+	JSONPathInstruction *instruction = &self->code[self->len++];
+
+	*instruction = (JSONPathInstruction){ .opcode = opcode };
+
+	return instruction;
+}
+
+bool
+compile_member__JSONPath(JSONPath *self, char *key, size_t key_len)
+{
+	// NOTE: Takes the ownership of `key`.
+	JSONPathInstruction *instruction = push__JSONPath(self, JSON_PATH_OPCODE_MEMBER);
+
+	if (!instruction) {
+		free(key);
+
+		return false;
+	}
+
+	instruction->key = key;
+	instruction->key_len = key_len;
+	instruction->hash = hash__JSONValueObjectKeyValueMap(key, key_len);
+
+	return true;
+}
+
+bool
+compile_name__JSONPath(JSONPath *self, const char **path, const char *end)
+{
+	// A dot-notation name: ASCII letters, digits, `_`, `-`, `$` and any
+	// non-ASCII byte.
+	const char *start = *path;
+
+	while (*path < end && (isalnum((unsigned char)**path) || **path == '_' || **path == '-' || **path == '$' || (unsigned char)**path >= 0x80)) {
+		++*path;
+	}
+
+	size_t key_len = *path - start;
+
+	if (key_len == 0) {
+		return false;
+	}
+
+	char *key = malloc(key_len + 1);
+
+	if (!key) {
+		return false;
+	}
+
+	memcpy(key, start, key_len);
+	key[key_len] = '\0';
+
+	return compile_member__JSONPath(self, key, key_len);
+}
+
+bool
+compile_quoted__JSONPath(const char **path, const char *end, char **res, size_t *res_len)
+{
+	// `'name'` or `"name"`, `\` escapes the next character.
+	char quote = **path;
+	const char *start = ++*path;
+
+	*res = malloc(end - start + 1);
+	*res_len = 0;
+
+	if (!*res) {
+		return false;
+	}
+
+	for (; *path < end && **path != quote; ++*path) {
+		if (**path == '\\' && ++*path == end) {
+			break;
+		}
+
+		(*res)[(*res_len)++] = **path;
+	}
+
+	if (*path == end) {
+		free(*res);
+		*res = NULL;
+
+		return false;
+	}
+
+	(*res)[*res_len] = '\0';
+	++*path;
+
+	return true;
+}
+
+bool
+compile_index__JSONPath(JSONPath *self, const char **path, const char *end)
+{
+	bool is_negative = **path == '-';
+	int64_t index = 0;
+
+	if (is_negative) {
+		++*path;
+	}
+
+	if (*path == end || !isdigit((unsigned char)**path)) {
+		return false;
+	}
+
+	while (*path < end && isdigit((unsigned char)**path)) {
+		if (index > (INT64_MAX - 9) / 10) {
+			return false;
+		}
+
+		index = index * 10 + (*(*path)++ - '0');
+	}
+
+	JSONPathInstruction *instruction = push__JSONPath(self, JSON_PATH_OPCODE_INDEX);
+
+	if (!instruction) {
+		return false;
+	}
+
+	instruction->index = is_negative ? -index : index;
+
+	return true;
+}
+
+bool
+compile_filter__JSONPath(JSONPath *self, const char **path, const char *end)
+{
+	// filter  = "?(" "@" *( "." name / "[" ( index / quoted ) "]" ) [ comparison literal ] ")"
+	// literal = number / quoted / "true" / "false" / "null"
+	size_t filter_pc = self->len;
+
+	if (!push__JSONPath(self, JSON_PATH_OPCODE_FILTER)) {
+		return false;
+	}
+
+	*path += 2; // Skip `?(`
+
+	while (*path < end && **path == ' ') {
+		++*path;
+	}
+
+	if (*path == end || *(*path)++ != '@') {
+		return false;
+	}
+
+	while (*path < end && (**path == '.' || **path == '[')) {
+		bool is_compiled;
+
+		if (*(*path)++ == '.') {
+			is_compiled = compile_name__JSONPath(self, path, end);
+		} else {
+			if (*path < end && (**path == '\'' || **path == '"')) {
+				char *key;
+				size_t key_len;
+
+				is_compiled = compile_quoted__JSONPath(path, end, &key, &key_len) && compile_member__JSONPath(self, key, key_len);
+			} else {
+				is_compiled = *path < end && compile_index__JSONPath(self, path, end);
+			}
+
+			is_compiled = is_compiled && *path < end && *(*path)++ == ']';
+		}
+
+		if (!is_compiled) {
+			return false;
+		}
+	}
+
+	JSONPathInstruction *filter = &self->code[filter_pc];
+
+	filter->operand_len = self->len - filter_pc - 1;
+
+	while (*path < end && **path == ' ') {
+		++*path;
+	}
+
+	static const struct {
+		const char *s;
+		enum JSONPathComparison comparison;
+	} comparisons[] = {
+		{ "==", JSON_PATH_COMPARISON_EQ },
+		{ "!=", JSON_PATH_COMPARISON_NE },
+		{ "<=", JSON_PATH_COMPARISON_LE },
+		{ ">=", JSON_PATH_COMPARISON_GE },
+		{ "<", JSON_PATH_COMPARISON_LT },
+		{ ">", JSON_PATH_COMPARISON_GT }
+	};
+
+	filter->comparison = JSON_PATH_COMPARISON_EXISTS;
+
+	for (size_t i = 0; i < sizeof(comparisons) / sizeof(*comparisons); ++i) {
+		size_t len = strlen(comparisons[i].s);
+
+		if ((size_t)(end - *path) >= len && !memcmp(*path, comparisons[i].s, len)) {
+			filter->comparison = comparisons[i].comparison;
+			*path += len;
+
+			break;
+		}
+	}
+
+	if (filter->comparison != JSON_PATH_COMPARISON_EXISTS) {
+		while (*path < end && **path == ' ') {
+			++*path;
+		}
+
+		if (*path == end) {
+			return false;
+		}
+
+		size_t rest_len = end - *path;
+
+		if (**path == '\'' || **path == '"') {
+			filter->literal_kind = JSON_VALUE_KIND_STRING;
+
+			if (!compile_quoted__JSONPath(path, end, &filter->string, &filter->string_len)) {
+				return false;
+			}
+		} else if (rest_len >= 4 && !memcmp(*path, "true", 4)) {
+			filter->literal_kind = JSON_VALUE_KIND_BOOLEAN;
+			filter->boolean = true;
+			*path += 4;
+		} else if (rest_len >= 5 && !memcmp(*path, "false", 5)) {
+			filter->literal_kind = JSON_VALUE_KIND_BOOLEAN;
+			filter->boolean = false;
+			*path += 5;
+		} else if (rest_len >= 4 && !memcmp(*path, "null", 4)) {
+			filter->literal_kind = JSON_VALUE_KIND_NULL;
+			*path += 4;
+		} else {
+			struct JSONContentIterator iter = init__JSONContentIterator(*path, rest_len);
+
+			if (decode_double__JSON(&iter, &filter->number)) {
+				return false;
+			}
+
+			// Compared exactly with the integers of the document. The
+			// length was checked by `decode_double__JSON`.
+			char literal[JSON_DECODE_MAX_NUMBER_LEN];
+
+			memcpy(literal, *path, iter.count);
+			literal[iter.count] = '\0';
+
+			struct JSONCanonicalNumber number = canonical_number__JSONValue(literal, iter.count);
+
+			filter->is_integer = number.is_int;
+			filter->integer = number.i;
+			filter->literal_kind = JSON_VALUE_KIND_NUMBER;
+			*path += iter.count;
+		}
+
+		while (*path < end && **path == ' ') {
+			++*path;
+		}
+	}
+
+	return *path < end && *(*path)++ == ')';
+}
+
+bool
+compile_bracket__JSONPath(JSONPath *self, const char **path, const char *end)
+{
+	// NOTE: The path is right after `[`.
+	bool is_compiled;
+
+	if (*path == end) {
+		return false;
+	} else if (**path == '*') {
+		++*path;
+		is_compiled = push__JSONPath(self, JSON_PATH_OPCODE_WILDCARD) != NULL;
+	} else if (**path == '\'' || **path == '"') {
+		char *key;
+		size_t key_len;
+
+		is_compiled = compile_quoted__JSONPath(path, end, &key, &key_len) && compile_member__JSONPath(self, key, key_len);
+	} else if (**path == '?' && end - *path >= 2 && (*path)[1] == '(') {
+		is_compiled = compile_filter__JSONPath(self, path, end);
+	} else {
+		is_compiled = compile_index__JSONPath(self, path, end);
+	}
+
+	return is_compiled && *path < end && *(*path)++ == ']';
+}
+
+bool
+compile__JSONPath(JSONPath *self, const char *path, size_t path_len)
+{
+	const char *end = path + path_len;
+
+	*self = (JSONPath){ .code = NULL, .len = 0, .capacity = 0 };
+
+	if (path_len == 0 || *path++ != '$') {
+		return false;
+	}
+
+	while (path < end) {
+		bool is_compiled;
+
+		if (*path == '[') {
+			++path;
+			is_compiled = compile_bracket__JSONPath(self, &path, end);
+		} else if (*path == '.') {
+			++path;
+
+			if (path < end && *path == '.') {
+				++path;
+				is_compiled = push__JSONPath(self, JSON_PATH_OPCODE_DESCEND) != NULL;
+
+				// `..name`, `..*` or `..[...]`
+				if (is_compiled && path < end && *path == '[') {
+					++path;
+
+					if (compile_bracket__JSONPath(self, &path, end)) {
+						continue;
+					}
+
+					is_compiled = false;
+				}
+			} else {
+				is_compiled = true;
+			}
+
+			if (!is_compiled) {
+				// Falls through to the error
+			} else if (path < end && *path == '*') {
+				++path;
+				is_compiled = push__JSONPath(self, JSON_PATH_OPCODE_WILDCARD) != NULL;
+			} else {
+				is_compiled = compile_name__JSONPath(self, &path, end);
+			}
+		} else {
+			is_compiled = false;
+		}
+
+		if (!is_compiled) {
+			deinit__JSONPath(self);
+			*self = (JSONPath){ .code = NULL, .len = 0, .capacity = 0 };
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int
+compare_number__JSONPath(const JSONPathInstruction *filter, struct JSONCanonicalNumber number)
+{
+	if (number.is_int && filter->is_integer) {
+		return (number.i > filter->integer) - (number.i < filter->integer);
+	}
+
+	double x = number.is_int ? (double)number.i : number.d;
+
+	return (x > filter->number) - (x < filter->number);
+}
+
+bool
+match__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value)
+{
+	const JSONPathInstruction *filter = &self->code[pc];
+	JSONElement element;
+
+	// Follows the relative path of the operand
+	for (size_t i = pc + 1; i <= pc + filter->operand_len && value; ++i) {
+		const JSONPathInstruction *instruction = &self->code[i];
+
+		if (instruction->opcode == JSON_PATH_OPCODE_MEMBER) {
+			value = value->kind == JSON_VALUE_KIND_OBJECT
+				? get_hashed__JSONValueObjectKeyValueMap(value->object.map, instruction->key, instruction->key_len, instruction->hash)
+				: NULL;
+		} else {
+			int64_t index = instruction->index < 0 && value->kind == JSON_VALUE_KIND_ARRAY ? (int64_t)value->array.len + instruction->index : instruction->index;
+
+			value = index >= 0 ? get_element__JSONValue(value, index, &element) : NULL;
+		}
+	}
+
+	if (!value) {
+		return false;
+	} else if (filter->comparison == JSON_PATH_COMPARISON_EXISTS) {
+		return true;
+	} else if (value->kind != filter->literal_kind) {
+		return filter->comparison == JSON_PATH_COMPARISON_NE;
+	}
+
+	int order;
+
+	switch (value->kind) {
+		case JSON_VALUE_KIND_NUMBER:
+			order = compare_number__JSONPath(filter, canonical_number__JSONValue(value->number.buffer, value->number.len));
+
+			break;
+		case JSON_VALUE_KIND_STRING: {
+			size_t len = value->string.len < filter->string_len ? value->string.len : filter->string_len;
+
+			order = len ? memcmp(value->string.buffer, filter->string, len) : 0;
+
+			if (order == 0) {
+				order = (value->string.len > filter->string_len) - (value->string.len < filter->string_len);
+			}
+
+			break;
+		}
+		case JSON_VALUE_KIND_BOOLEAN:
+			if (filter->comparison != JSON_PATH_COMPARISON_EQ && filter->comparison != JSON_PATH_COMPARISON_NE) {
+				return false;
+			}
+
+			order = value->boolean != filter->boolean;
+
+			break;
+		case JSON_VALUE_KIND_NULL:
+			if (filter->comparison != JSON_PATH_COMPARISON_EQ && filter->comparison != JSON_PATH_COMPARISON_NE) {
+				return false;
+			}
+
+			order = 0;
+
+			break;
+		default:
+			return false;
+	}
+
+	switch (filter->comparison) {
+		case JSON_PATH_COMPARISON_EQ:
+			return order == 0;
+		case JSON_PATH_COMPARISON_NE:
+			return order != 0;
+		case JSON_PATH_COMPARISON_LT:
+			return order < 0;
+		case JSON_PATH_COMPARISON_LE:
+			return order <= 0;
+		case JSON_PATH_COMPARISON_GT:
+			return order > 0;
+		case JSON_PATH_COMPARISON_GE:
+			return order >= 0;
+		default:
+			UNREACHABLE("Unknown comparison");
+	}
+}
+
+bool
+eval_at__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value, JSONPathCallback callback, void *user_data)
+{
+	// NOTE: Returns false once the callback asked to stop.
+	if (pc == self->len) {
+		return callback(value, user_data);
+	}
+
+	const JSONPathInstruction *instruction = &self->code[pc];
+	size_t next_pc = pc + 1 + (instruction->opcode == JSON_PATH_OPCODE_FILTER ? instruction->operand_len : 0);
+	JSONElement element;
+	size_t len = value->kind == JSON_VALUE_KIND_ARRAY ? value->array.len : value->kind == JSON_VALUE_KIND_OBJECT ? value->object.map->len : 0;
+
+	switch (instruction->opcode) {
+		case JSON_PATH_OPCODE_MEMBER: {
+			const JSONValue *member = value->kind == JSON_VALUE_KIND_OBJECT
+				? get_hashed__JSONValueObjectKeyValueMap(value->object.map, instruction->key, instruction->key_len, instruction->hash)
+				: NULL;
+
+			return !member || eval_at__JSONPath(self, next_pc, member, callback, user_data);
+		}
+		case JSON_PATH_OPCODE_INDEX: {
+			if (value->kind != JSON_VALUE_KIND_ARRAY) {
+				return true;
+			}
+
+			int64_t index = instruction->index < 0 ? (int64_t)len + instruction->index : instruction->index;
+
+			return index < 0 || (uint64_t)index >= len || eval_at__JSONPath(self, next_pc, get_element__JSONValue(value, index, &element), callback, user_data);
+		}
+		case JSON_PATH_OPCODE_DESCEND:
+			return descend__JSONPath(self, next_pc, value, callback, user_data);
+		case JSON_PATH_OPCODE_WILDCARD:
+		case JSON_PATH_OPCODE_FILTER:
+			for (size_t i = 0; i < len; ++i) {
+				const JSONValue *child = value->kind == JSON_VALUE_KIND_ARRAY ? get_element__JSONValue(value, i, &element) : value->object.map->members[i].value;
+
+				if (instruction->opcode == JSON_PATH_OPCODE_FILTER && !match__JSONPath(self, pc, child)) {
+					continue;
+				}
+
+				if (!eval_at__JSONPath(self, next_pc, child, callback, user_data)) {
+					return false;
+				}
+			}
+
+			return true;
+		default:
+			UNREACHABLE("Unknown opcode");
+	}
+}
+
+bool
+descend__JSONPath(const JSONPath *self, size_t pc, const JSONValue *value, JSONPathCallback callback, void *user_data)
+{
+	if (!eval_at__JSONPath(self, pc, value, callback, user_data)) {
+		return false;
+	}
+
+	size_t len = value->kind == JSON_VALUE_KIND_ARRAY ? value->array.len : value->kind == JSON_VALUE_KIND_OBJECT ? value->object.map->len : 0;
+	JSONElement element;
+
+	for (size_t i = 0; i < len; ++i) {
+		const JSONValue *child = value->kind == JSON_VALUE_KIND_ARRAY ? get_element__JSONValue(value, i, &element) : value->object.map->members[i].value;
+
+		if (!descend__JSONPath(self, pc, child, callback, user_data)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void
+eval__JSONPath(const JSONPath *self, const JSONValue *value, JSONPathCallback callback, void *user_data)
+{
+	eval_at__JSONPath(self, 0, value, callback, user_data);
+}
+
+uint64_t
+closure__JSONPath(const JSONPath *self, uint64_t states)
+{
+	// `..` also matches the current value
+	for (size_t pc = 0; pc < self->len; ++pc) {
+		if ((states >> pc & 1) && self->code[pc].opcode == JSON_PATH_OPCODE_DESCEND) {
+			states |= (uint64_t)1 << (pc + 1);
+		}
+	}
+
+	return states;
+}
+
+uint64_t
+child_states__JSONPath(const JSONPath *self, uint64_t states, const char *key, size_t key_len, size_t index)
+{
+	// NOTE: `key` is NULL for array elements.
+	uint64_t res = 0;
+
+	states &= ~((uint64_t)1 << self->len);
+
+	while (states) {
+		size_t pc = trailing_zeros__JSONBlockMasks(states);
+		const JSONPathInstruction *instruction = &self->code[pc];
+
+		switch (instruction->opcode) {
+			case JSON_PATH_OPCODE_MEMBER:
+				if (key && key_len == instruction->key_len && (!key_len || !memcmp(key, instruction->key, key_len))) {
+					res |= (uint64_t)1 << (pc + 1);
+				}
+
+				break;
+			case JSON_PATH_OPCODE_INDEX:
+				if (!key && (int64_t)index == instruction->index) {
+					res |= (uint64_t)1 << (pc + 1);
+				}
+
+				break;
+			case JSON_PATH_OPCODE_WILDCARD:
+				res |= (uint64_t)1 << (pc + 1);
+
+				break;
+			case JSON_PATH_OPCODE_DESCEND:
+				res |= (uint64_t)1 << pc;
+
+				break;
+			default:
+				UNREACHABLE("Unsupported opcode");
+		}
+
+		states &= states - 1;
+	}
+
+	return closure__JSONPath(self, res);
+}
+
+bool
+push__JSONPathScan(struct JSONPathScan *self, size_t start, size_t end)
+{
+	if (self->len == self->capacity) {
+		size_t capacity = self->capacity ? self->capacity * 2 : 16;
+		struct JSONPathScanMatch *matches = realloc(self->matches, sizeof(struct JSONPathScanMatch) * capacity);
+
+		if (!matches) {
+			return false;
+		}
+
+		self->matches = matches;
+		self->capacity = capacity;
+	}
+
+	self->matches[self->len++] = (struct JSONPathScanMatch){ .start = start, .end = end };
+
+	return true;
+}
+
+void
+flush__JSONPathScan(struct JSONPathScan *self)
+{
+	for (size_t i = 0; i < self->len && !self->is_stopped; ++i) {
+		self->is_stopped = !self->callback(self->matches[i].start, self->matches[i].end, self->user_data);
+	}
+
+	self->len = 0;
+}
+
+uint32_t
+scan_value__JSONPath(const JSONPath *self, struct JSONContentIterator *iter, uint64_t states, size_t depth, struct JSONPathScan *scan)
+{
+	// NOTE: `states` is the set of the instructions to run on this value,
+	// bit `self->len` is set when the path ends on it. Subtrees without
+	// states are skipped without being looked at.
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+	size_t start = iter->count;
+	bool is_match = states >> self->len & 1;
+	uint32_t res;
+
+	if (states == ((uint64_t)1 << self->len) || (c != '{' && c != '[')) {
+		if ((res = skip_value__JSONContentIterator(iter))) {
+			return res;
+		}
+
+		if (!is_match) {
+			return SKIP_NO_ERROR;
+		} else if (scan->pending) {
+			return push__JSONPathScan(scan, start, iter->count) ? SKIP_NO_ERROR : SKIP_OUT_OF_MEMORY;
+		}
+
+		scan->is_stopped = !scan->callback(start, iter->count, scan->user_data);
+
+		return SKIP_NO_ERROR;
+	}
+
+	if (depth == JSON_SKIP_MAX_DEPTH) {
+		return SKIP_TOO_DEEP;
+	}
+
+	// The end of a matched container is only known once it is scanned, so
+	// the matches it contains are held back until it can be reported first.
+	size_t match = scan->len;
+
+	if (is_match) {
+		if (!push__JSONPathScan(scan, start, start)) {
+			return SKIP_OUT_OF_MEMORY;
+		}
+
+		++scan->pending;
+	}
+
+	unsigned char close = c == '{' ? '}' : ']';
+
+	++iter->count;
+
+	if (skip_whitespace__JSONContentIterator(iter) == close) {
+		++iter->count;
+	} else {
+		for (size_t index = 0;; ++index) {
+			uint64_t child_states;
+
+			if (close == '}') {
+				if (skip_whitespace__JSONContentIterator(iter) != '"') {
+					return SKIP_UNEXPECTED_CHARACTER;
+				}
+
+				size_t key_start = iter->count + 1;
+				bool has_escapes = false;
+
+				if ((res = skip_string__JSONContentIterator(iter, &has_escapes))) {
+					return res;
+				}
+
+				const char *key = iter->content + key_start;
+				size_t key_len = iter->count - 1 - key_start;
+				char unescaped_key[JSON_PATH_SCAN_MAX_KEY_LEN];
+
+				// SIZE_MAX for a long name, which no instruction can match
+				if (has_escapes) {
+					key_len = unescape__JSON(key, key_len, unescaped_key, sizeof(unescaped_key));
+					key = unescaped_key;
+				}
+
+				if (skip_whitespace__JSONContentIterator(iter) != ':') {
+					return SKIP_UNEXPECTED_CHARACTER;
+				}
+
+				++iter->count;
+				child_states = key_len == SIZE_MAX ? 0 : child_states__JSONPath(self, states, key, key_len, 0);
+			} else {
+				child_states = child_states__JSONPath(self, states, NULL, 0, index);
+			}
+
+			res = child_states
+				? scan_value__JSONPath(self, iter, child_states, depth + 1, scan)
+				: skip_value__JSONContentIterator(iter);
+
+			if (res || scan->is_stopped) {
+				return res;
+			}
+
+			c = skip_whitespace__JSONContentIterator(iter);
+			++iter->count;
+
+			if (c == close) {
+				break;
+			} else if (c != ',') {
+				--iter->count;
+
+				return c ? SKIP_UNEXPECTED_CHARACTER : SKIP_UNEXPECTED_END;
+			}
+		}
+	}
+
+	if (is_match) {
+		scan->matches[match].end = iter->count;
+
+		if (--scan->pending == 0) {
+			flush__JSONPathScan(scan);
+		}
+	}
+
+	return SKIP_NO_ERROR;
+}
+
+JSONStatus
+scan__JSONPath(const JSONPath *self, const char *content, size_t content_len, JSONPathMatchCallback callback, void *user_data)
+{
+	if (!content) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", 0);
+	}
+
+	if (self->len > JSON_PATH_SCAN_MAX_LEN) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Path too long", 0);
+	}
+
+	for (size_t pc = 0; pc < self->len; ++pc) {
+		const JSONPathInstruction *instruction = &self->code[pc];
+
+		if (instruction->opcode == JSON_PATH_OPCODE_FILTER || (instruction->opcode == JSON_PATH_OPCODE_INDEX && instruction->index < 0)) {
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unsupported path", 0);
+		}
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+	uint64_t states = closure__JSONPath(self, 1);
+	struct JSONPathScan scan = {
+		.callback = callback,
+		.user_data = user_data,
+		.is_stopped = false,
+		.matches = NULL,
+		.len = 0,
+		.capacity = 0,
+		.pending = 0
+	};
+	uint32_t res = SKIP_NO_ERROR;
+
+	// Each value of a NDJSON or concatenated sequence is matched on its own
+	while (!scan.is_stopped) {
+		skip_separators__JSONSequenceIterator(&iter);
+
+		if (iter.count == iter.len) {
+			break;
+		}
+
+		if ((res = scan_value__JSONPath(self, &iter, states, 0, &scan))) {
+			break;
+		}
+	}
+
+	free(scan.matches);
+
+	return skip_status__JSON(&iter, res);
+}
+
+void
+deinit__JSONPath(const JSONPath *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->code[i].key);
+		free(self->code[i].string);
+	}
+
+	free(self->code);
+}
+
+enum JSONColumnKind
+get_kind__JSONColumn(const JSONValue *value)
+{
+	switch (value->kind) {
+		case JSON_VALUE_KIND_NUMBER: {
+			struct JSONContentIterator iter = init__JSONContentIterator(value->number.buffer, value->number.len);
+			int64_t n;
+
+			return decode_int__JSON(&iter, &n) ? JSON_COLUMN_KIND_DOUBLE : JSON_COLUMN_KIND_INT;
+		}
+		case JSON_VALUE_KIND_STRING:
+			return JSON_COLUMN_KIND_STRING;
+		case JSON_VALUE_KIND_BOOLEAN:
+			return JSON_COLUMN_KIND_BOOLEAN;
+		case JSON_VALUE_KIND_NULL:
+			return JSON_COLUMN_KIND_NULL;
+		default:
+			return JSON_COLUMN_KIND_VALUE;
+	}
+}
+
+enum JSONColumnKind
+widen_kind__JSONColumn(enum JSONColumnKind kind, enum JSONColumnKind other)
+{
+	if (kind == other || other == JSON_COLUMN_KIND_NULL) {
+		return kind;
+	} else if (kind == JSON_COLUMN_KIND_NULL) {
+		return other;
+	} else if ((kind == JSON_COLUMN_KIND_INT && other == JSON_COLUMN_KIND_DOUBLE) || (kind == JSON_COLUMN_KIND_DOUBLE && other == JSON_COLUMN_KIND_INT)) {
+		return JSON_COLUMN_KIND_DOUBLE;
+	}
+
+	return JSON_COLUMN_KIND_VALUE;
+}
+
+bool
+init__JSONInternTable(JSONInternTable *self, size_t max_len, bool is_shared)
+{
+	*self = (JSONInternTable){
+		.entries = NULL,
+		.len = 0,
+		.entries_capacity = 0,
+		.index = NULL,
+		.capacity = 0,
+		.max_len = max_len,
+		.is_shared = is_shared
+	};
+
+#ifdef JSON_THREADS
+	return pthread_mutex_init(&self->mutex, NULL) == 0;
+#else
+	return true;
+#endif
+}
+
+bool
+grow_index__JSONInternTable(JSONInternTable *self)
+{
+	size_t capacity = self->capacity ? self->capacity * 2 : 64;
+	uint32_t *index = calloc(capacity, sizeof(uint32_t));
+
+	if (!index) {
+		return false;
+	}
+
+	free(self->index);
+
+	self->index = index;
+	self->capacity = capacity;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		size_t slot = self->entries[i].hash & (capacity - 1);
+
+		while (self->index[slot]) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+
+		self->index[slot] = i + 1;
+	}
+
+	return true;
+}
+
+const char *
+intern_locked__JSONInternTable(JSONInternTable *self, const char *s, size_t s_len)
+{
+	if (self->len + 1 >= self->capacity * JSON_INTERN_TABLE_LOAD_FACTOR && !grow_index__JSONInternTable(self)) {
+		return NULL;
+	}
+
+	size_t hash = hash__JSONValueObjectKeyValueMap(s, s_len);
+	size_t slot = hash & (self->capacity - 1);
+
+	while (self->index[slot]) {
+		const JSONInternEntry *entry = &self->entries[self->index[slot] - 1];
+
+		if (entry->hash == hash && entry->len == s_len && (s_len == 0 || !memcmp(entry->buffer, s, s_len))) {
+			return entry->buffer;
+		}
+
+		slot = (slot + 1) & (self->capacity - 1);
+	}
+
+	if (self->len == self->entries_capacity) {
+		size_t entries_capacity = self->entries_capacity ? self->entries_capacity * 2 : 64;
+		JSONInternEntry *entries = realloc(self->entries, sizeof(JSONInternEntry) * entries_capacity);
+
+		if (!entries) {
+			return NULL;
+		}
+
+		self->entries = entries;
+		self->entries_capacity = entries_capacity;
+	}
+
+	char *buffer = malloc(s_len + 1);
+
+	if (!buffer) {
+		return NULL;
+	}
+
+	if (s_len > 0) {
+		memcpy(buffer, s, s_len);
+	}
+
+	buffer[s_len] = '\0';
+
+	self->entries[self->len++] = (JSONInternEntry){ .buffer = buffer, .len = s_len, .hash = hash };
+	self->index[slot] = self->len;
+
+	return buffer;
+}
+
+const char *
+intern__JSONInternTable(JSONInternTable *self, const char *s, size_t s_len)
+{
+#ifdef JSON_THREADS
+	if (self->is_shared) {
+		pthread_mutex_lock(&self->mutex);
+
+		const char *res = intern_locked__JSONInternTable(self, s, s_len);
+
+		pthread_mutex_unlock(&self->mutex);
+
+		return res;
+	}
+#endif
+
+	return intern_locked__JSONInternTable(self, s, s_len);
+}
+
+void
+deinit__JSONInternTable(JSONInternTable *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->entries[i].buffer);
+	}
+
+	free(self->entries);
+	free(self->index);
+
+#ifdef JSON_THREADS
+	pthread_mutex_destroy(&self->mutex);
+#endif
+}
+
+JSONDocument *
+freeze__JSONDocument(const JSONValue *value)
+{
+	JSONDocument *self = malloc(sizeof(JSONDocument));
+
+	if (!self) {
+		return NULL;
+	}
+
+	*self = (JSONDocument){
+		.value = *value,
+		.ref_count = 1
+	};
+
+	return self;
+}
+
+JSONDocument *
+retain__JSONDocument(JSONDocument *self)
+{
+	// NOTE: The holder already keeps the document alive.
+	__atomic_fetch_add(&self->ref_count, 1, __ATOMIC_RELAXED);
+
+	return self;
+}
+
+void
+release__JSONDocument(JSONDocument *self)
+{
+	if (!self) {
+		return;
+	}
+
+	// NOTE: The last holder must see every read of the others before freeing.
+	if (__atomic_sub_fetch(&self->ref_count, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+
+	deinit__JSONValue(&self->value);
+	free(self);
+}
+
+bool
+init__JSONParseCache(JSONParseCache *self, size_t capacity, const JSONParseOptions *options)
+{
+	// The entries may be parsed by several threads at once
+	if (options && options->intern && !options->intern->is_shared) {
+		return false;
+	}
+
+	// Up to two entries per bucket
+	size_t buckets_len = 16;
+
+	while (buckets_len * 2 < capacity) {
+		buckets_len *= 2;
+	}
+
+	*self = (JSONParseCache){
+		.buckets = calloc(buckets_len, sizeof(JSONParseCacheEntry *)),
+		.buckets_len = buckets_len,
+		.capacity = capacity,
+		.head = NULL,
+		.tail = NULL,
+		.options = options ? *options : (JSONParseOptions){ 0 },
+		.has_options = options != NULL,
+		.stats = { 0 }
+	};
+
+	if (!self->buckets) {
+		return false;
+	}
+
+#ifdef JSON_THREADS
+	if (pthread_mutex_init(&self->mutex, NULL) != 0) {
+		free(self->buckets);
+
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+uint64_t
+hash__JSONParseCache(const char *content, size_t content_len)
+{
+	// NOTE: Hashes 8 bytes at a time, a collision only costs a comparison.
+	uint64_t hash = 0x9E3779B97F4A7C15ULL ^ content_len;
+	size_t i = 0;
+
+	for (; i + 8 <= content_len; i += 8) {
+		uint64_t word;
+
+		memcpy(&word, content + i, 8);
+
+		hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+		hash ^= hash >> 31;
+	}
+
+	for (; i < content_len; ++i) {
+		hash = (hash ^ (unsigned char)content[i]) * 0x94D049BB133111EBULL;
+	}
+
+	return hash ^ (hash >> 29);
+}
+
+void
+unlink__JSONParseCache(JSONParseCache *self, JSONParseCacheEntry *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		self->head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else {
+		self->tail = entry->prev;
+	}
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+void
+push_front__JSONParseCache(JSONParseCache *self, JSONParseCacheEntry *entry)
+{
+	entry->prev = NULL;
+	entry->next = self->head;
+
+	if (self->head) {
+		self->head->prev = entry;
+	} else {
+		self->tail = entry;
+	}
+
+	self->head = entry;
+}
+
+JSONParseCacheEntry *
+find__JSONParseCache(JSONParseCache *self, const char *content, size_t content_len, uint64_t hash)
+{
+	JSONParseCacheEntry *entry = self->buckets[hash & (self->buckets_len - 1)];
+
+	while (entry && !(entry->hash == hash && entry->content_len == content_len && (content_len == 0 || !memcmp(entry->content, content, content_len)))) {
+		entry = entry->chain;
+	}
+
+	return entry;
+}
+
+bool
+unref_locked__JSONParseCache(JSONParseCacheEntry *entry)
+{
+	// NOTE: Returns true for the last holder, which frees the entry once the
+	// lock is released.
+	return --entry->ref_count == 0;
+}
+
+void
+free__JSONParseCacheEntry(JSONParseCacheEntry *entry)
+{
+	deinit__JSONValueResult(&entry->res);
+	free(entry->content);
+	free(entry);
+}
+
+const JSONParseCacheEntry *
+parse__JSONParseCache(JSONParseCache *self, const char *content, size_t content_len)
+{
+	uint64_t hash = hash__JSONParseCache(content, content_len);
+
+#ifdef JSON_THREADS
+	pthread_mutex_lock(&self->mutex);
+#endif
+
+	JSONParseCacheEntry *entry = find__JSONParseCache(self, content, content_len, hash);
+
+	if (entry) {
+		++self->stats.hits;
+		++entry->ref_count;
+
+		unlink__JSONParseCache(self, entry);
+		push_front__JSONParseCache(self, entry);
+
+#ifdef JSON_THREADS
+		pthread_mutex_unlock(&self->mutex);
+#endif
+
+		return entry;
+	}
+
+	++self->stats.misses;
+
+#ifdef JSON_THREADS
+	pthread_mutex_unlock(&self->mutex);
+#endif
+
+	// The content is parsed without holding the lock
+	entry = malloc(sizeof(JSONParseCacheEntry));
+
+	char *content_copy = malloc(content_len + 1);
+
+	if (!entry || !content_copy) {
+		free(entry);
+		free(content_copy);
+
+		return NULL;
+	}
+
+	if (content_len > 0) {
+		memcpy(content_copy, content, content_len);
+	}
+
+	content_copy[content_len] = '\0';
+
+	*entry = (JSONParseCacheEntry){
+		.content = content_copy,
+		.content_len = content_len,
+		.hash = hash,
+		.res = parse_validated__JSON(content_copy, content_len, self->has_options ? &self->options : NULL),
+		.ref_count = 2, // The caller and the cache
+		.prev = NULL,
+		.next = NULL,
+		.chain = NULL
+	};
+
+#ifdef JSON_THREADS
+	pthread_mutex_lock(&self->mutex);
+
+	// Another thread may have parsed the same content in the meantime
+	JSONParseCacheEntry *other = find__JSONParseCache(self, content, content_len, hash);
+
+	if (other) {
+		++other->ref_count;
+
+		unlink__JSONParseCache(self, other);
+		push_front__JSONParseCache(self, other);
+
+		pthread_mutex_unlock(&self->mutex);
+
+		free__JSONParseCacheEntry(entry);
+
+		return other;
+	}
+#endif
+
+	JSONParseCacheEntry **bucket = &self->buckets[hash & (self->buckets_len - 1)];
+
+	entry->chain = *bucket;
+	*bucket = entry;
+
+	push_front__JSONParseCache(self, entry);
+
+	++self->stats.len;
+	self->stats.bytes += content_len;
+
+	// Evicts the least recently used entries, their holders keep them alive.
+	// The unused ones are chained to be freed after unlocking.
+	JSONParseCacheEntry *freed = NULL;
+
+	while (self->stats.len > self->capacity) {
+		JSONParseCacheEntry *evicted = self->tail;
+		JSONParseCacheEntry **chain = &self->buckets[evicted->hash & (self->buckets_len - 1)];
+
+		while (*chain != evicted) {
+			chain = &(*chain)->chain;
+		}
+
+		*chain = evicted->chain;
+
+		unlink__JSONParseCache(self, evicted);
+
+		--self->stats.len;
+		self->stats.bytes -= evicted->content_len;
+		++self->stats.evictions;
+
+		if (unref_locked__JSONParseCache(evicted)) {
+			evicted->chain = freed;
+			freed = evicted;
+		}
+	}
+
+#ifdef JSON_THREADS
+	pthread_mutex_unlock(&self->mutex);
+#endif
+
+	while (freed) {
+		JSONParseCacheEntry *next = freed->chain;
+
+		free__JSONParseCacheEntry(freed);
+		freed = next;
+	}
+
+	return entry;
+}
+
+void
+release__JSONParseCache(JSONParseCache *self, const JSONParseCacheEntry *entry)
+{
+	(void)self;
+
+	if (!entry) {
+		return;
+	}
+
+#ifdef JSON_THREADS
+	pthread_mutex_lock(&self->mutex);
+#endif
+
+	bool is_last = unref_locked__JSONParseCache((JSONParseCacheEntry *)entry);
+
+#ifdef JSON_THREADS
+	pthread_mutex_unlock(&self->mutex);
+#endif
+
+	// An entry still in the cache is never the last one
+	if (is_last) {
+		free__JSONParseCacheEntry((JSONParseCacheEntry *)entry);
+	}
+}
+
+JSONParseCacheStats
+get_stats__JSONParseCache(JSONParseCache *self)
+{
+#ifdef JSON_THREADS
+	pthread_mutex_lock(&self->mutex);
+#endif
+
+	JSONParseCacheStats stats = self->stats;
+
+#ifdef JSON_THREADS
+	pthread_mutex_unlock(&self->mutex);
+#endif
+
+	return stats;
+}
+
+void
+deinit__JSONParseCache(JSONParseCache *self)
+{
+	JSONParseCacheEntry *entry = self->head;
+
+	while (entry) {
+		JSONParseCacheEntry *next = entry->next;
+
+		if (unref_locked__JSONParseCache(entry)) {
+			free__JSONParseCacheEntry(entry);
+		}
+
+		entry = next;
+	}
+
+	free(self->buckets);
+
+#ifdef JSON_THREADS
+	pthread_mutex_destroy(&self->mutex);
+#endif
+}
+
+JSONColumnSchema
+init__JSONColumnSchema(void)
+{
+	return (JSONColumnSchema){
+		.columns = NULL,
+		.len = 0,
+		.capacity = 0,
+		.index = NULL,
+		.index_capacity = 0
+	};
+}
+
+JSONColumnShape *
+get_column__JSONColumnSchema(JSONColumnSchema *self, const char *name, size_t name_len, size_t hint)
+{
+	// NOTE: Records usually share their layout, so the column at `hint` is
+	// tried before hashing the name.
+	if (hint < self->len && self->columns[hint].name_len == name_len && !memcmp(self->columns[hint].name, name, name_len)) {
+		return &self->columns[hint];
+	}
+
+	if (!self->index) {
+		return NULL;
+	}
+
+	// NOTE: The capacity is a power of two.
+	size_t slot = hash__JSONValueObjectKeyValueMap(name, name_len) & (self->index_capacity - 1);
+
+	while (self->index[slot]) {
+		JSONColumnShape *column = &self->columns[self->index[slot] - 1];
+
+		if (column->name_len == name_len && !memcmp(column->name, name, name_len)) {
+			return column;
+		}
+
+		slot = (slot + 1) & (self->index_capacity - 1);
+	}
+
+	return NULL;
+}
+
+bool
+grow_index__JSONColumnSchema(JSONColumnSchema *self)
+{
+	size_t index_capacity = self->index_capacity ? self->index_capacity * 2 : 16;
+	uint32_t *index = calloc(index_capacity, sizeof(uint32_t));
+
+	if (!index) {
+		return false;
+	}
+
+	free(self->index);
+
+	self->index = index;
+	self->index_capacity = index_capacity;
+
+	for (size_t i = 0; i < self->len; ++i) {
+		const JSONColumnShape *column = &self->columns[i];
+		size_t slot = hash__JSONValueObjectKeyValueMap(column->name, column->name_len) & (self->index_capacity - 1);
+
+		while (self->index[slot]) {
+			slot = (slot + 1) & (self->index_capacity - 1);
+		}
+
+		self->index[slot] = i + 1;
+	}
+
+	return true;
+}
+
+bool
+add_column__JSONColumnSchema(JSONColumnSchema *self, const char *name, size_t name_len, enum JSONColumnKind kind)
+{
+	JSONColumnShape *column = get_column__JSONColumnSchema(self, name, name_len, self->len);
+
+	if (column) {
+		column->kind = widen_kind__JSONColumn(column->kind, kind);
+
+		return true;
+	}
+
+	if (self->len + 1 >= self->index_capacity * JSON_VALUE_OBJECT_KEY_VALUE_MAP_LOAD_FACTOR && !grow_index__JSONColumnSchema(self)) {
+		return false;
+	}
+
+	if (self->len == self->capacity) {
+		size_t capacity = self->capacity ? self->capacity * 2 : 8;
+		JSONColumnShape *columns = realloc(self->columns, sizeof(JSONColumnShape) * capacity);
+
+		if (!columns) {
+			return false;
+		}
+
+		self->columns = columns;
+		self->capacity = capacity;
+	}
+
+	char *column_name = malloc(name_len + 1);
+
+	if (!column_name) {
+		return false;
+	}
+
+	memcpy(column_name, name, name_len);
+	column_name[name_len] = '\0';
+
+	size_t slot = hash__JSONValueObjectKeyValueMap(name, name_len) & (self->index_capacity - 1);
+
+	while (self->index[slot]) {
+		slot = (slot + 1) & (self->index_capacity - 1);
+	}
+
+	self->columns[self->len++] = (JSONColumnShape){
+		.name = column_name,
+		.name_len = name_len,
+		.kind = kind
+	};
+	self->index[slot] = self->len;
+
+	return true;
+}
+
+bool
+infer__JSONColumnSchema(JSONColumnSchema *self, const JSONValue *records)
+{
+	if (records->kind != JSON_VALUE_KIND_ARRAY) {
+		return false;
+	}
+
+	JSONArrayIterator records_iter = init__JSONArrayIterator(records);
+	const JSONValue *record;
+
+	while ((record = next__JSONArrayIterator(&records_iter))) {
+		JSONObjectIterator iter = init__JSONObjectIterator(record);
+		const JSONValueObjectKeyValue *member;
+
+		for (size_t i = 0; (member = next__JSONObjectIterator(&iter)); ++i) {
+			enum JSONColumnKind kind = get_kind__JSONColumn(member->value);
+			JSONColumnShape *column = get_column__JSONColumnSchema(self, member->key.buffer, member->key.len, i);
+
+			if (column) {
+				column->kind = widen_kind__JSONColumn(column->kind, kind);
+			} else if (!add_column__JSONColumnSchema(self, member->key.buffer, member->key.len, kind)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void
+deinit__JSONColumnSchema(const JSONColumnSchema *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->columns[i].name);
+	}
+
+	free(self->columns);
+	free(self->index);
+}
+
+bool
+init__JSONColumn(JSONColumn *self, const JSONColumnShape *shape, size_t rows)
+{
+	*self = (JSONColumn){
+		.name = malloc(shape->name_len + 1),
+		.name_len = shape->name_len,
+		.kind = shape->kind,
+		.validity = calloc(rows / 64 + 1, sizeof(uint64_t)),
+		.null_count = 0
+	};
+
+	if (!self->name || !self->validity) {
+		return false;
+	}
+
+	memcpy(self->name, shape->name, shape->name_len + 1);
+
+	// NOTE: One more entry than needed, so that empty columns are not NULL.
+	switch (self->kind) {
+		case JSON_COLUMN_KIND_NULL:
+			return true;
+		case JSON_COLUMN_KIND_BOOLEAN:
+			return (self->booleans = calloc(rows + 1, sizeof(bool)));
+		case JSON_COLUMN_KIND_INT:
+			return (self->ints = calloc(rows + 1, sizeof(int64_t)));
+		case JSON_COLUMN_KIND_DOUBLE:
+			return (self->doubles = calloc(rows + 1, sizeof(double)));
+		case JSON_COLUMN_KIND_STRING:
+			return (self->offsets = calloc(rows + 1, sizeof(size_t)));
+		case JSON_COLUMN_KIND_VALUE:
+			return (self->values = calloc(rows + 1, sizeof(JSONValue *)));
+		default:
+			UNREACHABLE("Unknown column kind");
+	}
+}
+
+bool
+push__JSONColumn(JSONColumn *self, size_t row, const JSONValue *value, size_t *data_capacity)
+{
+	// NOTE: Returns false on allocation failure only, a value which does not
+	// fit the column is null.
+	bool is_valid = false;
+
+	if (value) {
+		switch (self->kind) {
+			case JSON_COLUMN_KIND_NULL:
+				break;
+			case JSON_COLUMN_KIND_BOOLEAN:
+				if ((is_valid = value->kind == JSON_VALUE_KIND_BOOLEAN)) {
+					self->booleans[row] = value->boolean;
+				}
+
+				break;
+			case JSON_COLUMN_KIND_INT:
+				if (value->kind == JSON_VALUE_KIND_NUMBER) {
+					struct JSONContentIterator iter = init__JSONContentIterator(value->number.buffer, value->number.len);
+
+					is_valid = !decode_int__JSON(&iter, &self->ints[row]);
+				}
+
+				break;
+			case JSON_COLUMN_KIND_DOUBLE:
+				if (value->kind == JSON_VALUE_KIND_NUMBER) {
+					struct JSONContentIterator iter = init__JSONContentIterator(value->number.buffer, value->number.len);
+
+					is_valid = !decode_double__JSON(&iter, &self->doubles[row]);
+				}
+
+				break;
+			case JSON_COLUMN_KIND_STRING: {
+				size_t len = self->offsets[row];
+
+				if ((is_valid = value->kind == JSON_VALUE_KIND_STRING)) {
+					if (len + value->string.len > *data_capacity) {
+						size_t capacity = *data_capacity ? *data_capacity * 2 : 256;
+
+						while (capacity < len + value->string.len) {
+							capacity *= 2;
+						}
+
+						char *data = realloc(self->data, capacity);
+
+						if (!data) {
+							return false;
+						}
+
+						self->data = data;
+						*data_capacity = capacity;
+					}
+
+					if (value->string.len > 0) {
+						memcpy(self->data + len, value->string.buffer, value->string.len);
+					}
+
+					len += value->string.len;
+				}
+
+				self->offsets[row + 1] = len;
+
+				break;
+			}
+			case JSON_COLUMN_KIND_VALUE:
+				self->values[row] = value;
+				is_valid = true;
+
+				break;
+			default:
+				UNREACHABLE("Unknown column kind");
+		}
+	} else if (self->kind == JSON_COLUMN_KIND_STRING) {
+		self->offsets[row + 1] = self->offsets[row];
+	}
+
+	if (is_valid) {
+		self->validity[row / 64] |= (uint64_t)1 << (row % 64);
+	} else {
+		++self->null_count;
+	}
+
+	return true;
+}
+
+void
+deinit__JSONColumn(const JSONColumn *self)
+{
+	free(self->name);
+	free(self->validity);
+	free(self->booleans);
+	free(self->ints);
+	free(self->doubles);
+	free(self->offsets);
+	free(self->data);
+	free(self->values);
+}
+
+bool
+extract__JSONColumns(JSONColumns *self, const JSONValue *records, const JSONColumnSchema *schema)
+{
+	*self = (JSONColumns){ .columns = NULL, .len = 0, .rows = 0 };
+
+	if (records->kind != JSON_VALUE_KIND_ARRAY) {
+		return false;
+	}
+
+	size_t rows = records->array.len;
+	size_t *data_capacities = calloc(schema->len + 1, sizeof(size_t));
+
+	self->columns = calloc(schema->len + 1, sizeof(JSONColumn));
+
+	if (!data_capacities || !self->columns) {
+		goto handle_err;
+	}
+
+	for (; self->len < schema->len; ++self->len) {
+		if (!init__JSONColumn(&self->columns[self->len], &schema->columns[self->len], rows)) {
+			++self->len;
+
+			goto handle_err;
+		}
+	}
+
+	// NOTE: The records are walked once, row by row, so that each record is
+	// only loaded once.
+	for (; self->rows < rows; ++self->rows) {
+		JSONElement element;
+		const JSONValue *record = get_element__JSONValue(records, self->rows, &element);
+		JSONObjectIterator iter = init__JSONObjectIterator(record);
+		size_t next = 0;
+
+		for (size_t i = 0; i < self->len; ++i) {
+			JSONColumn *column = &self->columns[i];
+			const JSONValue *value = NULL;
+
+			if (next < iter.len && iter.members[next].key.len == column->name_len && !memcmp(iter.members[next].key.buffer, column->name, column->name_len)) {
+				value = iter.members[next++].value;
+			} else if (iter.len > 0) {
+				value = get_member__JSONValue(record, column->name, column->name_len);
+			}
+
+			if (!push__JSONColumn(column, self->rows, value, &data_capacities[i])) {
+				goto handle_err;
+			}
+		}
+	}
+
+	free(data_capacities);
+
+	return true;
+
+handle_err:
+	free(data_capacities);
+	deinit__JSONColumns(self);
+
+	*self = (JSONColumns){ .columns = NULL, .len = 0, .rows = 0 };
+
+	return false;
+}
+
+const JSONColumn *
+get_column__JSONColumns(const JSONColumns *self, const char *name, size_t name_len)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		const JSONColumn *column = &self->columns[i];
+
+		if (column->name_len == name_len && !memcmp(column->name, name, name_len)) {
+			return column;
+		}
+	}
+
+	return NULL;
+}
+
+bool
+is_valid__JSONColumn(const JSONColumn *self, size_t row)
+{
+	return self->validity[row / 64] >> (row % 64) & 1;
+}
+
+void
+deinit__JSONColumns(const JSONColumns *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		deinit__JSONColumn(&self->columns[i]);
+	}
+
+	free(self->columns);
+}
+
+void
+deinit__JSONValue(const JSONValue *self)
+{
+	switch (self->kind) {
+		case JSON_VALUE_KIND_NUMBER:
+			deinit__JSONValueString(&self->number);
+
+			break;
+		case JSON_VALUE_KIND_BOOLEAN:
+		case JSON_VALUE_KIND_NULL:
+			break;
+		case JSON_VALUE_KIND_STRING:
+			deinit__JSONValueString(&self->string);
+
+			break;
+		case JSON_VALUE_KIND_ARRAY:
+			deinit__JSONValueArray(&self->array);
+
+			break;
+		case JSON_VALUE_KIND_OBJECT:
+			deinit__JSONValueObject(&self->object);
+
+			break;
+		default:
+			UNREACHABLE("unknown JSON value");
+	}
+}
+
+JSONValueResult
+init_ok__JSONValueResult(JSONValue value)
+{
+	return (JSONValueResult){
+		.kind = JSON_VALUE_RESULT_KIND_OK,
+		.ok = value,
+	};
+}
+
+JSONValueResult
+init_err__JSONValueResult(enum JSONValueResultError kind, const char *msg)
+{
+	return (JSONValueResult){
+		.kind = JSON_VALUE_RESULT_KIND_ERR,
+		.err = {
+			.kind = kind,
+			.msg = msg
+		},
+	};
+}
+
+bool
+is_err__JSONValueResult(const JSONValueResult *self)
+{
+	return self->kind == JSON_VALUE_RESULT_KIND_ERR;
+}
+
+const JSONValue *
+unwrap__JSONValueResult(const JSONValueResult *self)
+{
+	assert(self->kind == JSON_VALUE_RESULT_KIND_OK && "expected ok");
+
+	return &self->ok;
+}
+
+void
+deinit__JSONValueResult(const JSONValueResult *self)
+{
+	switch (self->kind) {
+		case JSON_VALUE_RESULT_KIND_OK:
+			deinit__JSONValue(&self->ok);
+
+			break;
+		case JSON_VALUE_RESULT_KIND_ERR:
+			break;
+		default:
+			UNREACHABLE("Unknown result");
+	}
+}
+
+bool
+parse_packed_array_value__JSON(struct JSONContentIterator *iter, JSONValueArray *res)
+{
+	// NOTE: Reads the elements straight into a packed buffer. Returns false,
+	// with `iter` back on the first element, as soon as the array turns out
+	// not to be packable, so that it is parsed again as an array of values.
+	size_t start = iter->count;
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+	enum JSONValueArrayKind kind = JSON_VALUE_ARRAY_KIND_INT;
+	JSONValueArray array = { .buffer = NULL, .len = 0, .capacity = 0 };
+
+	if ((c == 't' || c == 'f') && iter->options->pack_booleans) {
+		kind = JSON_VALUE_ARRAY_KIND_BOOLEAN;
+	} else if (!((c == '-' || isdigit(c)) && iter->options->pack_numbers)) {
+		return false;
+	}
+
+	for (;;) {
+		if (array.len == array.capacity && !resize__JSONValueArray(&array, kind, array.capacity ? array.capacity * 2 : 8)) {
+			goto fallback;
+		}
+
+		size_t element_start = iter->count;
+
+		// The packed numbers must print back to the same values, `-0` and
+		// the integers a double cannot hold exactly stay as values.
+		if (kind == JSON_VALUE_ARRAY_KIND_BOOLEAN) {
+			if (decode_boolean__JSON(iter, &array.booleans[array.len])) {
+				goto fallback;
+			}
+		} else if (kind == JSON_VALUE_ARRAY_KIND_DOUBLE || decode_int__JSON(iter, &array.ints[array.len])) {
+			// The integers read so far are converted in place
+			if (kind == JSON_VALUE_ARRAY_KIND_INT) {
+				for (size_t i = 0; i < array.len; ++i) {
+					if (array.ints[i] > JSON_PACKED_MAX_EXACT_INT || array.ints[i] < -JSON_PACKED_MAX_EXACT_INT) {
+						goto fallback;
+					}
+
+					array.doubles[i] = (double)array.ints[i];
+				}
+
+				kind = JSON_VALUE_ARRAY_KIND_DOUBLE;
+			}
+
+			iter->count = element_start;
+
+			if (decode_double__JSON(iter, &array.doubles[array.len]) || !isfinite(array.doubles[array.len])) {
+				goto fallback;
+			}
+
+			double number = array.doubles[array.len];
+			bool is_integer = true;
+
+			for (size_t i = element_start; i < iter->count && is_integer; ++i) {
+				is_integer = iter->content[i] != '.' && iter->content[i] != 'e' && iter->content[i] != 'E';
+			}
+
+			if ((number == 0 && signbit(number)) || (is_integer && (number >= JSON_PACKED_MAX_EXACT_INT || number <= -JSON_PACKED_MAX_EXACT_INT))) {
+				goto fallback;
+			}
+		} else if (array.ints[array.len] == 0 && iter->content[element_start] == '-') {
+			goto fallback;
+		}
+
+		++array.len;
+		c = skip_whitespace__JSONContentIterator(iter);
+		++iter->count;
+
+		if (c == ']') {
+			break;
+		} else if (c != ',') {
+			goto fallback;
+		}
+
+		skip_whitespace__JSONContentIterator(iter);
+	}
+
+	// Small packed arrays, such as coordinates, are common
+	if (array.capacity > array.len) {
+		resize__JSONValueArray(&array, kind, array.len);
+	}
+
+	// The integers read first may have been converted to doubles
+	get_header__JSONValueArray(&array)->kind = kind;
+
+	JSON_STATS_ADD(nodes[JSON_VALUE_KIND_NUMBER], kind != JSON_VALUE_ARRAY_KIND_BOOLEAN ? array.len : 0);
+	JSON_STATS_ADD(nodes[JSON_VALUE_KIND_BOOLEAN], kind == JSON_VALUE_ARRAY_KIND_BOOLEAN ? array.len : 0);
+
+	*res = array;
+
+	return true;
+
+fallback:
+	deinit__JSONValueArray(&array);
+	iter->count = start;
+
+	return false;
+}
+
+JSONValueResult
+parse_array_value__JSON(struct JSONContentIterator *iter)
+{
+	// See RFC 8259:
+	//
+	// 5.  Arrays
+	//
+	// [...]
+	//
+	// array = begin-array [ value *( value-separator value ) ] end-array
+	//
+	// [...]
+	if (!expect_character__JSONContentIterator(iter, '[',  true)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `[`");
+	}
+
+	uint32_t current = current__JSONContentIterator(iter);
+	JSONValueArray array = init__JSONValueArray();
+	bool share_shapes = iter->options && iter->options->share_shapes;
+	// Shape of the last object element, borrowed from it
+	struct JSONObjectShape *shape = NULL;
+
+	iter->shape = NULL;
+
+	if (iter->options && (iter->options->pack_numbers || iter->options->pack_booleans) && parse_packed_array_value__JSON(iter, &array)) {
+		return init_ok__JSONValueResult(init_array__JSONValue(array));
+	}
+
+	while (current && current != ']') {
+		iter->shape = shape;
+
+		JSONValueResult value_result = parse_value__JSON(iter);
+
+		iter->shape = NULL;
+
+		if (is_err__JSONValueResult(&value_result)) {
+			deinit__JSONValueArray(&array);
+
+			return value_result;
+		}
+
+		JSONValue *value = &value_result.ok;
+
+		// An object which does not follow the shape gives the next one
+		if (share_shapes && value->kind == JSON_VALUE_KIND_OBJECT && value->object.map->len > 0) {
+			shape = value->object.map->shape ? value->object.map->shape : share__JSONValueObjectKeyValueMap(value->object.map);
+		}
+
+		if (!push__JSONValueArray(&array, *value)) {
+			deinit__JSONValue(value);
+			deinit__JSONValueArray(&array);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+		}
+
+		skip_spaces__JSONContentIterator(iter);
+
+		if (!(current__JSONContentIterator(iter) == ']' || expect_character__JSONContentIterator(iter, ',', true))) {
+			deinit__JSONValueArray(&array);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+		}
+
+		current = current__JSONContentIterator(iter);
+	}
+
+	next__JSONContentIterator(iter); // Skip `]`
+
+	return init_ok__JSONValueResult(init_array__JSONValue(array));
+}
+
+uint32_t 
+parse_object_member_value__JSON(struct JSONContentIterator *iter, JSONValueObject *object)
+{
+	skip_spaces__JSONContentIterator(iter);
+
+	if (current__JSONContentIterator(iter) != '"') {
+		return PARSE_OBJECT_EXPECTED_MEMBER;
+	}
+
+	JSONValueObjectKeyValueMap *map = object->map;
+	const JSONValueString *shape_key = map->shape && map->len < map->shape->len ? &map->shape->keys[map->len] : NULL;
+	bool is_shared_name = false;
+	JSONValueResult name_result;
+
+	// The next name of the shape is first compared to the content, which
+	// avoids decoding and copying it.
+	if (shape_key && map->shape->is_raw && iter->len - iter->count >= shape_key->len + 2 && iter->content[iter->count + 1 + shape_key->len] == '"' && (shape_key->len == 0 || !memcmp(iter->content + iter->count + 1, shape_key->buffer, shape_key->len))) {
+		iter->count += shape_key->len + 2;
+		is_shared_name = true;
+	} else {
+		JSON_STATS_TIME_START(name_start);
+
+		name_result = parse_string_value__JSON(iter);
+
+		JSON_STATS_TIME_END(string_ns, name_start);
+
+		if (is_err__JSONValueResult(&name_result)) {
+			return PARSE_OBJECT_INVALID_MEMBER_NAME;
+		}
+
+		if (shape_key && eq__JSONValueString(&name_result.ok.string, shape_key)) {
+			deinit__JSONValueResult(&name_result);
+			is_shared_name = true;
+		} else if (map->shape && !unshare__JSONValueObjectKeyValueMap(map)) {
+			deinit__JSONValueResult(&name_result);
+
+			return PARSE_OBJECT_OUT_OF_MEMORY;
+		}
+	}
+
+	if (!expect_character__JSONContentIterator(iter, ':', true)) {
+		if (!is_shared_name) {
+			deinit__JSONValueResult(&name_result);
+		}
+
+		return PARSE_OBJECT_EXPECTED_VALUE_SEPARATOR;
+	}
+
+	JSONValueResult value_result = parse_value__JSON(iter);
+
+	if (is_err__JSONValueResult(&value_result)) {
+		if (!is_shared_name) {
+			deinit__JSONValueResult(&name_result);
+		}
+
+		return PARSE_OBJECT_INVALID_MEMBER_VALUE;
+	}
+	
+	const JSONValue *value = unwrap__JSONValueResult(&value_result);
+
+	JSON_STATS_TIME_START(insert_start);
+
+	uint32_t res = is_shared_name
+		? push_shared__JSONValueObjectKeyValueMap(map, *value)
+		: add_member__JSONValueObject(object, name_result.ok.string, *value);
+
+	JSON_STATS_TIME_END(object_insert_ns, insert_start);
+
+	switch (res) {
+		case OBJECT_KEY_VALUE_MAP_NO_ERROR:
+			return PARSE_OBJECT_NO_ERROR;
+		case OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY:
+			return PARSE_OBJECT_OUT_OF_MEMORY;
+		case OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY:
+			return PARSE_OBJECT_DUPLICATE_KEY;
+		default:
+			UNREACHABLE("Unknown status");
+	}
+}
+
+JSONValueResult
+parse_object_value__JSON(struct JSONContentIterator *iter)
+{
+	// See RFC 8259:
+	//
+	// 4.  Objects
+	//
+	// [...]
+	//
+	// object = begin-object [ member *( value-separator member ) ]
+    //          end-object
+	// member = string name-separator value
+	//
+	// [...]
+	if (!expect_character__JSONContentIterator(iter, '{', true)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `{`");
+	}
+
+	uint32_t current = current__JSONContentIterator(iter);
+	JSONValueObject object = init__JSONValueObject();
+	uint32_t res;
+
+	if (!object.map) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+	}
+
+	if (iter->shape) {
+		use_shape__JSONValueObjectKeyValueMap(object.map, iter->shape);
+		iter->shape = NULL;
+	}
+
+	while (current && current != '}') {
+		if ((res = parse_object_member_value__JSON(iter, &object))) {
+			goto handle_err;
+		}
+
+		skip_spaces__JSONContentIterator(iter);
+
+		if (!(current__JSONContentIterator(iter) == '}' || expect_character__JSONContentIterator(iter, ',', true))) {
+			deinit__JSONValueObject(&object);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+		}
+
+		current = current__JSONContentIterator(iter);
+	}
+
+	// Some members of the shape are missing
+	if (object.map->shape && object.map->len < object.map->shape->len && !unshare__JSONValueObjectKeyValueMap(object.map)) {
+		res = PARSE_OBJECT_OUT_OF_MEMORY;
+
+		goto handle_err;
+	}
+
+	next__JSONContentIterator(iter); // Skip `}`
+
+	return init_ok__JSONValueResult(init_object__JSONValue(object));
+
+handle_err:
+	deinit__JSONValueObject(&object);
+
+	switch (res) {
+		case PARSE_OBJECT_EXPECTED_MEMBER:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member");
+		case PARSE_OBJECT_EXPECTED_VALUE_SEPARATOR:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected value separator");
+		case PARSE_OBJECT_INVALID_MEMBER_NAME:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member name");
+		case PARSE_OBJECT_INVALID_MEMBER_VALUE:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member value");
+		case PARSE_OBJECT_OUT_OF_MEMORY:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+		case PARSE_OBJECT_DUPLICATE_KEY:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Duplicated key");
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+bool
+is_hex_character__JSON(uint32_t c)
+{
+	return isdigit(c) || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+uint32_t
+parse_string_escape_value__JSON(struct JSONContentIterator *iter, JSONValueString *string)
+{
+	uint32_t current = next__JSONContentIterator(iter);
+	uint32_t character_to_add;
+
+	switch (current) {
+		case '"':
+			character_to_add = '\"';
+
+			break;
+		case '\\':
+			character_to_add = '\\';
+
+			break;
+		case '/':
+			character_to_add = '/';
+
+			break;
+		case 'b':
+			character_to_add = '\b';
+
+			break;
+		case 'f':
+			character_to_add = '\f';
+
+			break;
+		case 'n':
+			character_to_add = '\n';
+
+			break;
+		case 'r':
+			character_to_add = '\r';
+
+			break;
+		case 't':
+			character_to_add = '\t';
+
+			break;
+		case 'u': {
+			uint32_t u1 = next__JSONContentIterator(iter);
+			uint32_t u2 = next__JSONContentIterator(iter);
+			uint32_t u3 = next__JSONContentIterator(iter);
+			uint32_t u4 = next__JSONContentIterator(iter);
+
+			if (is_hex_character__JSON(u1) &&
+				is_hex_character__JSON(u2) &&
+				is_hex_character__JSON(u3) &&
+				is_hex_character__JSON(u4)) {
+				char unicode_escape_value_s[] = {
+					'0', 'x', (char)u1, (char)u2, (char)u3, (char)u4, 0
+				};
+
+				character_to_add = strtol(&unicode_escape_value_s[0], NULL, 0);	
+			} else {
+				return PARSE_STRING_INVALID_UNICODE_ESCAPE;
+			}
+
+			break;
+		}
+		default:
+			return PARSE_STRING_UNKNOWN_ESCAPE;
+	}
+
+	if (!push__JSONValueString(string, character_to_add)) {
+		return PARSE_STRING_OUT_OF_MEMORY;
+	}
+
+	return PARSE_STRING_NO_ERROR;
+}
+
+JSONValueResult
+parse_string_value__JSON(struct JSONContentIterator *iter)
+{
+	// See RFC 8259:
+	//
+	// 7.  Strings
+	//
+	// [...]
+	//
+	// string = quotation-mark *char quotation-mark
+    // char = unescaped /
+    //     escape (
+    //         %x22 /          ; "    quotation mark  U+0022
+    //         %x5C /          ; \    reverse solidus U+005C
+    //         %x2F /          ; /    solidus         U+002F
+    //         %x62 /          ; b    backspace       U+0008
+    //         %x66 /          ; f    form feed       U+000C
+    //         %x6E /          ; n    line feed       U+000A
+    //         %x72 /          ; r    carriage return U+000D
+    //         %x74 /          ; t    tab             U+0009
+    //         %x75 4HEXDIG )  ; uXXXX                U+XXXX
+    // escape = %x5C              ; \
+    // quotation-mark = %x22      ; "
+    // unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
+	//
+	// [...]
+	if (!expect_character__JSONContentIterator(iter, '"', true)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `\"`");
+	}
+
+	uint32_t res = PARSE_STRING_NO_ERROR;
+	uint32_t current = current__JSONContentIterator(iter);
+	JSONValueString string = init__JSONValueString();
+
+	while (current && current != '"') {
+		switch (current) {
+			case '\\': {
+#ifdef JSON_STATS
+				size_t escape_start = iter->count;
+#endif
+
+				if ((res = parse_string_escape_value__JSON(iter, &string))) {
+					goto handle_err;
+				}
+
+				JSON_STATS_ADD(string_bytes_escaped, iter->count - escape_start + 1);
+
+				break;
+			}
+			default:
+				if (current < 0x20) {
+					return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Characters greater than 0x0 and less than 0x20 are invalid");
+				} else if (!push__JSONValueString(&string, current)) {
+					return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+				}
+		}
+
+		current = next__JSONContentIterator(iter);
+	}
+
+	next__JSONContentIterator(iter); // Skip `"`
+
+	JSON_STATS_ADD(string_bytes_copied, string.len);
+
+	return init_ok__JSONValueResult(init_string__JSONValue(string));
+
+handle_err:
+	switch (res) {
+		case PARSE_STRING_UNKNOWN_ESCAPE:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unknown escape");
+		case PARSE_STRING_OUT_OF_MEMORY:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+		case PARSE_STRING_INVALID_UNICODE_ESCAPE:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid unicode escape");
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+JSONValueResult
+parse_interned_string_value__JSON(struct JSONContentIterator *iter, JSONInternTable *table)
+{
+	// NOTE: Short ASCII strings without escapes are interned straight from
+	// the content, the other ones are decoded first.
+	size_t start = iter->count + 1;
+	size_t end = start;
+	bool is_raw = true;
+
+	while (end < iter->len && end - start <= table->max_len) {
+		unsigned char c = iter->content[end];
+
+		if (c == '"') {
+			break;
+		} else if (c < 0x20 || c >= 0x80 || c == '\\') {
+			is_raw = false;
+
+			break;
+		}
+
+		++end;
+	}
+
+	const char *buffer;
+	size_t len;
+
+	if (is_raw && end < iter->len && iter->content[end] == '"') {
+		len = end - start;
+		buffer = intern__JSONInternTable(table, iter->content + start, len);
+		iter->count = end + 1;
+	} else {
+		JSONValueResult res = parse_string_value__JSON(iter);
+
+		if (is_err__JSONValueResult(&res) || res.ok.string.len > table->max_len) {
+			return res;
+		}
+
+		len = res.ok.string.len;
+		buffer = intern__JSONInternTable(table, res.ok.string.buffer ? res.ok.string.buffer : "", len);
+
+		deinit__JSONValueResult(&res);
+	}
+
+	if (!buffer) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+	}
+
+	// Borrowed from the table
+	return init_ok__JSONValueResult(init_string__JSONValue((JSONValueString){ .buffer = (char *)buffer, .len = len, .capacity = 0 }));
+}
+
+uint32_t
+parse_number_minus_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+{
+	uint32_t current = current__JSONContentIterator(iter);
+
+	if (current == '-') {
+		next__JSONContentIterator(iter);
+
+		if (!push__JSONValueString(number, current)) {
+			return PARSE_NUMBER_OUT_OF_MEMORY;
+		}
+	}
+
+	return PARSE_NUMBER_NO_ERROR;
+}
+
+uint32_t
+parse_number_digits_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+{
+	uint32_t current = current__JSONContentIterator(iter);
+
+	while (isdigit(current)) {
+		if (!push__JSONValueString(number, current)) {
+			return PARSE_NUMBER_OUT_OF_MEMORY;
+		}
+
+		current = next__JSONContentIterator(iter);
+	}
+
+	return PARSE_NUMBER_NO_ERROR;
+}
+
+uint32_t
+parse_number_integer_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+{
+	uint32_t current = current__JSONContentIterator(iter);
+
+	if (!isdigit(current)) {
+		return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
+	} else if (current == '0') {
+		if (!push__JSONValueString(number, current)) {
+			return PARSE_NUMBER_OUT_OF_MEMORY;
+		}
+
+		next__JSONContentIterator(iter);
+
+		return PARSE_NUMBER_NO_ERROR;
+	}
+
+	return parse_number_digits_value__JSON(iter, number);
+}
+
+uint32_t
+parse_number_frac_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+{
+	uint32_t current = current__JSONContentIterator(iter);
+
+	if (current == '.') {
+		if (!push__JSONValueString(number, current)) {
+			return PARSE_NUMBER_OUT_OF_MEMORY;
+		}
+
+		current = next__JSONContentIterator(iter);
+
+		if (!isdigit(current)) {
+			return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
+		}
+
+		return parse_number_digits_value__JSON(iter, number);
+	}
+
+	return PARSE_NUMBER_NO_ERROR;
+}
+
+uint32_t
+parse_number_exp_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+{
+	uint32_t current = current__JSONContentIterator(iter);
+
+	if (current != 'e' && current != 'E') {
+		return PARSE_NUMBER_NO_ERROR;
+	}
+
+	if (!push__JSONValueString(number, current)) {
+		return PARSE_NUMBER_OUT_OF_MEMORY;
+	}
+
+	current = next__JSONContentIterator(iter);
+
+	if (current == '+' || current == '-') {
+		if (!push__JSONValueString(number, current)) {
+			return PARSE_NUMBER_OUT_OF_MEMORY;
+		}
+
+		current = next__JSONContentIterator(iter);
+	}
+
+	if (!isdigit(current)) {
+		return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
+	}
+
+	return parse_number_digits_value__JSON(iter, number);
+}
+
+JSONValueResult
+parse_number_value__JSON(struct JSONContentIterator *iter)
+{
+	// See RFC 8259:
+	//
+	// 6.  Numbers
+	//
+	// [...]
+	//
+	// number = [ minus ] int [ frac ] [ exp ]
+    // decimal-point = %x2E       ; .
+    // digit1-9 = %x31-39         ; 1-9
+    // e = %x65 / %x45            ; e E
+    // exp = e [ minus / plus ] 1*DIGIT
+    // frac = decimal-point 1*DIGIT
+	// int = zero / ( digit1-9 *DIGIT )
+    // minus = %x2D               ; -
+    // plus = %x2B                ; +
+    // zero = %x30                ; 0
+	//
+	// [...]
+	JSONValueString number = init__JSONValueString();
+	uint32_t res = PARSE_NUMBER_NO_ERROR;
+
+	if ((res = parse_number_minus_value__JSON(iter, &number))) {
+		goto handle_err;
+	} else if ((res = parse_number_integer_value__JSON(iter, &number))) {
+		goto handle_err;
+	} else if ((res = parse_number_frac_value__JSON(iter, &number))) {
+		goto handle_err;
+	} else if ((res = parse_number_exp_value__JSON(iter, &number))) {
+		goto handle_err;
+	}
+
+	return init_ok__JSONValueResult(init_number__JSONValue(number));
+
+handle_err:
+	switch (res) {
+		case PARSE_NUMBER_OUT_OF_MEMORY:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+		case PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have digits");
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+JSONValueResult
+parse_true_value__JSON(struct JSONContentIterator *iter)
+{
+	char expected[] = "true";
+
+	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `true`");
+	}
+
+	return init_ok__JSONValueResult(init_boolean__JSONValue(true));
+}
+
+JSONValueResult
+parse_false_value__JSON(struct JSONContentIterator *iter)
+{
+	char expected[] = "false";
+
+	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `false`");
+	}
+
+	return init_ok__JSONValueResult(init_boolean__JSONValue(false));
+}
+
+JSONValueResult
+parse_null_value__JSON(struct JSONContentIterator *iter)
+{
+	char expected[] = "null";
+
+	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `null`");
+	}
+
+	return init_ok__JSONValueResult(init_null__JSONValue());
+}
+
+JSONValueResult
+parse_value__JSON(struct JSONContentIterator *iter)
+{
+	skip_spaces__JSONContentIterator(iter);
+
+	JSONValueResult res;
+
+	switch (current__JSONContentIterator(iter)) {
+		case '[':
+			JSON_STATS_ENTER();
+			res = parse_array_value__JSON(iter);
+			JSON_STATS_LEAVE();
+
+			break;
+		case '{':
+			JSON_STATS_ENTER();
+			res = parse_object_value__JSON(iter);
+			JSON_STATS_LEAVE();
+
+			break;
+		case '"': {
+			JSON_STATS_TIME_START(string_start);
+
+			res = iter->options && iter->options->intern
+				? parse_interned_string_value__JSON(iter, iter->options->intern)
+				: parse_string_value__JSON(iter);
+
+			JSON_STATS_TIME_END(string_ns, string_start);
+
+			break;
+		}
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9': {
+			JSON_STATS_TIME_START(number_start);
+
+			res = parse_number_value__JSON(iter);
+
+			JSON_STATS_TIME_END(number_ns, number_start);
+
+			break;
+		}
+		case 't':
+			res = parse_true_value__JSON(iter);
+
+			break;
+		case 'f':
+			res = parse_false_value__JSON(iter);
+
+			break;
+		case 'n':
+			res = parse_null_value__JSON(iter);
+
+			break;
+		default:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character");
+	}
+
+	if (!is_err__JSONValueResult(&res)) {
+		JSON_STATS_ADD(nodes[res.ok.kind], 1);
+	}
+
+	return res;
+}
+
+JSONValueResult
+parse__JSON(const char *content, size_t content_len)
+{
+	return parse_with_options__JSON(content, content_len, NULL);
+}
+
+JSONValueResult
+parse_with_options__JSON(const char *content, size_t content_len, const JSONParseOptions *options)
+{
+#ifdef JSON_STATS
+	JSONParseStats *stats = options ? options->stats : NULL;
+
+	if (stats) {
+		*stats = (JSONParseStats){ 0 };
+	}
+#endif
+
+	if (!content) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content");
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+
+	iter.options = options;
+
+#ifdef JSON_STATS
+	if (stats) {
+		return parse_object_value_with_stats__JSON(&iter, stats);
+	}
+#endif
+
+	return parse_object_value__JSON(&iter);
+}
+
+JSONValueResult
+parse_validated__JSON(const char *content, size_t content_len, const JSONParseOptions *options)
+{
+	JSONStatus status = validate__JSON(content, content_len);
+
+	if (is_err__JSONStatus(&status)) {
+		return init_err__JSONValueResult(status.err.kind, status.err.msg);
+	}
+
+	return parse_with_options__JSON(content, content_len, options);
+}
+
+#ifdef JSON_STATS
+JSONValueResult
+parse_object_value_with_stats__JSON(struct JSONContentIterator *iter, JSONParseStats *stats)
+{
+	json_stats = stats;
+	json_stats_depth = 0;
+
+	uint64_t start = now_ns__JSONParseStats();
+
+	JSON_STATS_ENTER();
+
+	JSONValueResult res = parse_object_value__JSON(iter);
+
+	JSON_STATS_LEAVE();
+
+	if (!is_err__JSONValueResult(&res)) {
+		++stats->nodes[JSON_VALUE_KIND_OBJECT];
+	}
+
+	uint64_t total_ns = now_ns__JSONParseStats() - start;
+	uint64_t stages_ns = stats->string_ns + stats->number_ns + stats->object_insert_ns;
+
+	stats->bytes_consumed = iter->count;
+	stats->scan_ns = total_ns > stages_ns ? total_ns - stages_ns : 0;
+
+	json_stats = NULL;
+
+	return res;
+}
+
+JSONValueResult
+parse_with_stats__JSON(const char *content, size_t content_len, JSONParseStats *stats)
+{
+	const JSONParseOptions options = { .stats = stats };
+
+	return parse_with_options__JSON(content, content_len, &options);
+}
+#endif
+
+bool
+is_err__JSONStatus(const JSONStatus *self)
+{
+	return self->kind == JSON_VALUE_RESULT_KIND_ERR;
+}
+
+JSONStatus
+init_ok__JSONStatus(void)
+{
+	return (JSONStatus){
+		.kind = JSON_VALUE_RESULT_KIND_OK
+	};
+}
+
+JSONStatus
+init_err__JSONStatus(enum JSONValueResultError kind, const char *msg, size_t offset)
+{
+	return (JSONStatus){
+		.kind = JSON_VALUE_RESULT_KIND_ERR,
+		.err = {
+			.kind = kind,
+			.msg = msg,
+			.offset = offset
+		}
+	};
+}
+
+uint32_t
+hash__JSONStructDescriptor(const char *key, size_t key_len, uint32_t seed)
+{
+	// FNV-1a, cheaper than SipHash for short member names. The table is built
+	// from trusted field names, so hash flooding is not a concern.
+	uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+
+	for (size_t i = 0; i < key_len; ++i) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+
+	return hash ^ (hash >> 15);
+}
+
+bool
+is_valid__JSONFieldDescriptor(const JSONFieldDescriptor *self)
+{
+	switch (self->kind) {
+		case JSON_FIELD_KIND_INT:
+		case JSON_FIELD_KIND_DOUBLE:
+		case JSON_FIELD_KIND_BOOLEAN:
+		case JSON_FIELD_KIND_STRING:
+			return true;
+		case JSON_FIELD_KIND_STRUCT:
+			return self->descriptor != NULL;
+		case JSON_FIELD_KIND_ARRAY:
+			// Arrays of arrays have nowhere to store the inner lengths
+			switch (self->element_kind) {
+				case JSON_FIELD_KIND_INT:
+				case JSON_FIELD_KIND_DOUBLE:
+				case JSON_FIELD_KIND_BOOLEAN:
+				case JSON_FIELD_KIND_STRING:
+					return true;
+				case JSON_FIELD_KIND_STRUCT:
+					return self->descriptor != NULL;
+				default:
+					return false;
+			}
+		default:
+			return false;
+	}
+}
+
+bool
+fill_table__JSONStructDescriptor(JSONStructDescriptor *self, uint32_t *table, size_t table_len, uint32_t seed)
+{
+	memset(table, 0, sizeof(uint32_t) * table_len);
+
+	for (size_t i = 0; i < self->fields_len; ++i) {
+		const char *name = self->fields[i].name;
+		size_t slot = hash__JSONStructDescriptor(name, strlen(name), seed) & (table_len - 1);
+
+		if (table[slot]) {
+			return false;
+		}
+
+		table[slot] = i + 1;
+	}
+
+	return true;
+}
+
+bool
+prepare__JSONStructDescriptor(JSONStructDescriptor *self)
+{
+	if (self->table) {
+		return true;
+	}
+
+	for (size_t i = 0; i < self->fields_len; ++i) {
+		if (!is_valid__JSONFieldDescriptor(&self->fields[i])) {
+			return false;
+		}
+
+		for (size_t j = i + 1; j < self->fields_len; ++j) {
+			if (!strcmp(self->fields[i].name, self->fields[j].name)) {
+				return false;
+			}
+		}
+	}
+
+	size_t table_len = 2;
+
+	while (table_len < self->fields_len * 2) {
+		table_len <<= 1;
+	}
+
+	for (; table_len <= JSON_STRUCT_DESCRIPTOR_MAX_TABLE_LEN; table_len <<= 1) {
+		uint32_t *table = malloc(sizeof(uint32_t) * table_len);
+
+		if (!table) {
+			return false;
+		}
+
+		for (uint32_t seed = 0; seed < JSON_STRUCT_DESCRIPTOR_MAX_SEEDS; ++seed) {
+			if (!fill_table__JSONStructDescriptor(self, table, table_len, seed)) {
+				continue;
+			}
+
+			// Set before preparing the nested descriptors, so recursive
+			// descriptors are only prepared once.
+			self->seed = seed;
+			self->table = table;
+			self->table_len = table_len;
+
+			for (size_t i = 0; i < self->fields_len; ++i) {
+				if (self->fields[i].descriptor && !prepare__JSONStructDescriptor(self->fields[i].descriptor)) {
+					deinit__JSONStructDescriptor(self);
+
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		free(table);
+	}
+
+	return false;
+}
+
+void
+deinit__JSONStructDescriptor(JSONStructDescriptor *self)
+{
+	if (!self->table) {
+		return;
+	}
+
+	free(self->table);
+
+	self->table = NULL;
+	self->table_len = 0;
+
+	for (size_t i = 0; i < self->fields_len; ++i) {
+		if (self->fields[i].descriptor) {
+			deinit__JSONStructDescriptor(self->fields[i].descriptor);
+		}
+	}
+}
+
+const JSONFieldDescriptor *
+get_field__JSONStructDescriptor(const JSONStructDescriptor *self, const char *key, size_t key_len)
+{
+	uint32_t index = self->table[hash__JSONStructDescriptor(key, key_len, self->seed) & (self->table_len - 1)];
+
+	if (!index) {
+		return NULL;
+	}
+
+	const JSONFieldDescriptor *field = &self->fields[index - 1];
+
+	if (strncmp(field->name, key, key_len) || field->name[key_len]) {
+		return NULL;
+	}
+
+	return field;
+}
+
+uint32_t
+scan_number__JSONContentIterator(struct JSONContentIterator *self, bool *is_integer)
+{
+	// See RFC 8259, 6.  Numbers
+	*is_integer = true;
+
+	if (peek__JSONContentIterator(self) == '-') {
+		++self->count;
+	}
+
+	if (peek__JSONContentIterator(self) == '0') {
+		++self->count;
+	} else if (isdigit(peek__JSONContentIterator(self))) {
+		while (isdigit(peek__JSONContentIterator(self))) {
+			++self->count;
+		}
+	} else {
+		return DECODE_EXPECTED_NUMBER;
+	}
+
+	if (peek__JSONContentIterator(self) == '.') {
+		*is_integer = false;
+		++self->count;
+
+		if (!isdigit(peek__JSONContentIterator(self))) {
+			return DECODE_EXPECTED_NUMBER;
+		}
+
+		while (isdigit(peek__JSONContentIterator(self))) {
+			++self->count;
+		}
+	}
+
+	if (peek__JSONContentIterator(self) == 'e' || peek__JSONContentIterator(self) == 'E') {
+		*is_integer = false;
+		++self->count;
+
+		if (peek__JSONContentIterator(self) == '+' || peek__JSONContentIterator(self) == '-') {
+			++self->count;
+		}
+
+		if (!isdigit(peek__JSONContentIterator(self))) {
+			return DECODE_EXPECTED_NUMBER;
+		}
+
+		while (isdigit(peek__JSONContentIterator(self))) {
+			++self->count;
+		}
+	}
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_int__JSON(struct JSONContentIterator *iter, int64_t *res)
+{
+	size_t start = iter->count;
+	bool is_integer;
+	uint32_t status = scan_number__JSONContentIterator(iter, &is_integer);
+
+	if (status) {
+		return status == DECODE_EXPECTED_NUMBER ? DECODE_EXPECTED_INTEGER : status;
+	} else if (!is_integer) {
+		return DECODE_EXPECTED_INTEGER;
+	}
+
+	const char *digits = iter->content + start;
+	size_t digits_len = iter->count - start;
+	bool is_negative = *digits == '-';
+	uint64_t limit = is_negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+	uint64_t value = 0;
+
+	for (size_t i = is_negative; i < digits_len; ++i) {
+		uint64_t digit = digits[i] - '0';
+
+		if (value > (limit - digit) / 10) {
+			return DECODE_INTEGER_OVERFLOW;
+		}
+
+		value = value * 10 + digit;
+	}
+
+	*res = is_negative ? (int64_t)(0 - value) : (int64_t)value;
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_double__JSON(struct JSONContentIterator *iter, double *res)
+{
+	size_t start = iter->count;
+	bool is_integer;
+	uint32_t status = scan_number__JSONContentIterator(iter, &is_integer);
+
+	if (status) {
+		return status;
+	}
+
+	// NOTE: The content is not NUL-terminated, so the number is copied before
+	// calling strtod.
+	char number[JSON_DECODE_MAX_NUMBER_LEN];
+	size_t number_len = iter->count - start;
+
+	if (number_len >= JSON_DECODE_MAX_NUMBER_LEN) {
+		return DECODE_NUMBER_TOO_LONG;
+	}
+
+	memcpy(number, iter->content + start, number_len);
+	number[number_len] = 0;
+
+	*res = strtod(number, NULL);
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_boolean__JSON(struct JSONContentIterator *iter, bool *res)
+{
+	if (iter->len - iter->count >= 4 && !memcmp(iter->content + iter->count, "true", 4)) {
+		iter->count += 4;
+		*res = true;
+	} else if (iter->len - iter->count >= 5 && !memcmp(iter->content + iter->count, "false", 5)) {
+		iter->count += 5;
+		*res = false;
+	} else {
+		return DECODE_EXPECTED_BOOLEAN;
+	}
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_string__JSON(struct JSONContentIterator *iter, JSONStringSlice *res)
+{
+	if (peek__JSONContentIterator(iter) != '"') {
+		return DECODE_EXPECTED_STRING;
+	}
+
+	size_t start = iter->count + 1;
+	bool has_escapes = false;
+
+	if (skip_string__JSONContentIterator(iter, &has_escapes)) {
+		return DECODE_INVALID_VALUE;
+	}
+
+	*res = (JSONStringSlice){
+		.buffer = iter->content + start,
+		.len = iter->count - 1 - start,
+		.has_escapes = has_escapes
+	};
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_scalar__JSON(struct JSONContentIterator *iter, enum JSONFieldKind kind, JSONStructDescriptor *descriptor, char *res)
+{
+	if (peek__JSONContentIterator(iter) == 'n') {
+		if (iter->len - iter->count < 4 || memcmp(iter->content + iter->count, "null", 4)) {
+			return DECODE_INVALID_VALUE;
+		}
+
+		iter->count += 4;
+
+		return DECODE_NO_ERROR;
+	}
+
+	// NOTE: `res` may be misaligned for the field type when the descriptor
+	// was written by hand, hence the memcpy.
+	switch (kind) {
+		case JSON_FIELD_KIND_INT: {
+			int64_t value;
+			uint32_t status = decode_int__JSON(iter, &value);
+
+			if (!status) {
+				memcpy(res, &value, sizeof(value));
+			}
+
+			return status;
+		}
+		case JSON_FIELD_KIND_DOUBLE: {
+			double value;
+			uint32_t status = decode_double__JSON(iter, &value);
+
+			if (!status) {
+				memcpy(res, &value, sizeof(value));
+			}
+
+			return status;
+		}
+		case JSON_FIELD_KIND_BOOLEAN: {
+			bool value;
+			uint32_t status = decode_boolean__JSON(iter, &value);
+
+			if (!status) {
+				memcpy(res, &value, sizeof(value));
+			}
+
+			return status;
+		}
+		case JSON_FIELD_KIND_STRING: {
+			JSONStringSlice value;
+			uint32_t status = decode_string__JSON(iter, &value);
+
+			if (!status) {
+				memcpy(res, &value, sizeof(value));
+			}
+
+			return status;
+		}
+		case JSON_FIELD_KIND_STRUCT:
+			return decode_object__JSON(iter, descriptor, res);
+		default:
+			// Rejected by `prepare__JSONStructDescriptor`
+			return DECODE_INVALID_DESCRIPTOR;
+	}
+}
+
+uint32_t
+decode_array__JSON(struct JSONContentIterator *iter, const JSONFieldDescriptor *field, char *res)
+{
+	if (peek__JSONContentIterator(iter) == 'n') {
+		return decode_scalar__JSON(iter, JSON_FIELD_KIND_INT, NULL, NULL);
+	} else if (peek__JSONContentIterator(iter) != '[') {
+		return DECODE_EXPECTED_ARRAY;
+	}
+
+	++iter->count;
+
+	size_t len = 0;
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+
+	while (c != ']') {
+		uint32_t status;
+
+		if (len == field->capacity) {
+			return DECODE_ARRAY_CAPACITY_EXCEEDED;
+		} else if ((status = decode_scalar__JSON(iter, field->element_kind, field->descriptor, res + field->offset + len * field->element_size))) {
+			return status;
+		}
+
+		++len;
+		c = skip_whitespace__JSONContentIterator(iter);
+
+		if (c == ',') {
+			++iter->count;
+			skip_whitespace__JSONContentIterator(iter);
+		} else if (c != ']') {
+			return DECODE_EXPECTED_VALUE_SEPARATOR;
+		}
+	}
+
+	++iter->count; // Skip `]`
+
+	memcpy(res + field->len_offset, &len, sizeof(len));
+
+	return DECODE_NO_ERROR;
+}
+
+uint32_t
+decode_object__JSON(struct JSONContentIterator *iter, const JSONStructDescriptor *descriptor, char *res)
+{
+	// NOTE: Also covers the descriptors of nested structs, which are only
+	// prepared along with a valid parent.
+	if (!descriptor || !descriptor->table) {
+		return DECODE_INVALID_DESCRIPTOR;
+	} else if (peek__JSONContentIterator(iter) != '{') {
+		return DECODE_EXPECTED_OBJECT;
+	}
+
+	++iter->count;
+
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+
+	while (c != '}') {
+		if (c != '"') {
+			return DECODE_EXPECTED_MEMBER;
+		}
+
+		size_t key_start = iter->count + 1;
+		bool has_escapes = false;
+
+		if (skip_string__JSONContentIterator(iter, &has_escapes)) {
+			return DECODE_INVALID_VALUE;
+		}
+
+		const char *key = iter->content + key_start;
+		size_t key_len = iter->count - 1 - key_start;
+		char unescaped_key[JSON_STRUCT_DESCRIPTOR_MAX_KEY_LEN];
+
+		// Escaped names are rare, they are decoded on the stack. A name too
+		// long to be decoded cannot match any field.
+		if (has_escapes) {
+			key_len = unescape__JSON(key, key_len, unescaped_key, sizeof(unescaped_key));
+			key = unescaped_key;
+		}
+
+		if (skip_whitespace__JSONContentIterator(iter) != ':') {
+			return DECODE_EXPECTED_NAME_SEPARATOR;
+		}
+
+		++iter->count;
+		skip_whitespace__JSONContentIterator(iter);
+
+		const JSONFieldDescriptor *field = key_len != SIZE_MAX ? get_field__JSONStructDescriptor(descriptor, key, key_len) : NULL;
+		uint32_t status;
+
+		if (!field) {
+			status = skip_value__JSONContentIterator(iter) ? DECODE_INVALID_VALUE : DECODE_NO_ERROR;
+		} else if (field->kind == JSON_FIELD_KIND_ARRAY) {
+			status = decode_array__JSON(iter, field, res);
+		} else {
+			status = decode_scalar__JSON(iter, field->kind, field->descriptor, res + field->offset);
+		}
+
+		if (status) {
+			return status;
+		}
+
+		c = skip_whitespace__JSONContentIterator(iter);
+
+		if (c == ',') {
+			++iter->count;
+			c = skip_whitespace__JSONContentIterator(iter);
+
+			if (c == '}') {
+				return DECODE_EXPECTED_MEMBER;
+			}
+		} else if (c != '}') {
+			return DECODE_EXPECTED_VALUE_SEPARATOR;
+		}
+	}
+
+	++iter->count; // Skip `}`
+
+	return DECODE_NO_ERROR;
+}
+
+JSONStatus
+decode_status__JSON(const struct JSONContentIterator *iter, uint32_t res)
+{
+	switch (res) {
+		case DECODE_NO_ERROR:
+			return init_ok__JSONStatus();
+		case DECODE_EXPECTED_OBJECT:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `{`", iter->count);
+		case DECODE_EXPECTED_ARRAY:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `[`", iter->count);
+		case DECODE_EXPECTED_MEMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member", iter->count);
+		case DECODE_EXPECTED_NAME_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected name separator", iter->count);
+		case DECODE_EXPECTED_VALUE_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`", iter->count);
+		case DECODE_EXPECTED_INTEGER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected integer", iter->count);
+		case DECODE_EXPECTED_NUMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected number", iter->count);
+		case DECODE_EXPECTED_BOOLEAN:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected boolean", iter->count);
+		case DECODE_EXPECTED_STRING:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected string", iter->count);
+		case DECODE_INTEGER_OVERFLOW:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Integer overflow", iter->count);
+		case DECODE_NUMBER_TOO_LONG:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Number too long", iter->count);
+		case DECODE_ARRAY_CAPACITY_EXCEEDED:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Array capacity exceeded", iter->count);
+		case DECODE_INVALID_VALUE:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid value", iter->count);
+		case DECODE_TRAILING_CONTENT:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected content after the value", iter->count);
+		case DECODE_INVALID_DESCRIPTOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid or unprepared descriptor", iter->count);
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+JSONStatus
+decode__JSON(const char *content, size_t content_len, const JSONStructDescriptor *descriptor, void *out)
+{
+	if (!content) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", 0);
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+
+	skip_whitespace__JSONContentIterator(&iter);
+
+	uint32_t res = decode_object__JSON(&iter, descriptor, out);
+
+	if (res == DECODE_NO_ERROR && (skip_whitespace__JSONContentIterator(&iter), iter.count < iter.len)) {
+		res = DECODE_TRAILING_CONTENT;
+	}
+
+	return decode_status__JSON(&iter, res);
+}
+
+JSONStatus
+decode_prefix__JSON(const char *content, size_t content_len, const JSONStructDescriptor *descriptor, void *out, size_t *end)
+{
+	if (!content) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", 0);
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+
+	skip_whitespace__JSONContentIterator(&iter);
+
+	uint32_t res = decode_object__JSON(&iter, descriptor, out);
+
+	if (res == DECODE_NO_ERROR) {
+		*end = iter.count;
+	}
+
+	return decode_status__JSON(&iter, res);
+}
+
+JSONStatus
+skip_status__JSON(const struct JSONContentIterator *iter, uint32_t res)
+{
+	switch (res) {
+		case SKIP_NO_ERROR:
+			return init_ok__JSONStatus();
+		case SKIP_UNEXPECTED_END:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected end", iter->count);
+		case SKIP_UNEXPECTED_CHARACTER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character", iter->count);
+		case SKIP_MISMATCHED_BRACKET:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Mismatched bracket", iter->count);
+		case SKIP_TOO_DEEP:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Too deep", iter->count);
+		case SKIP_INVALID_STRING:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid string", iter->count);
+		case SKIP_INVALID_LITERAL:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `true`, `false` or `null`", iter->count);
+		case SKIP_INVALID_NUMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid number", iter->count);
+		case SKIP_OUT_OF_MEMORY:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory", iter->count);
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+JSONStatus
+skip_value__JSON(const char *content, size_t content_len, size_t offset, size_t *end)
+{
+	if (!content || offset > content_len) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", offset);
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+
+	iter.count = offset;
+
+	uint32_t res = skip_value__JSONContentIterator(&iter);
+
+	*end = iter.count;
+
+	return skip_status__JSON(&iter, res);
+}
+
+JSONStatus
+validate_status__JSON(const struct JSONContentIterator *iter, uint32_t res)
+{
+	switch (res) {
+		case VALIDATE_NO_ERROR:
+			return init_ok__JSONStatus();
+		case VALIDATE_UNEXPECTED_END:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected end", iter->count);
+		case VALIDATE_UNEXPECTED_CHARACTER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character", iter->count);
+		case VALIDATE_EXPECTED_MEMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member", iter->count);
+		case VALIDATE_EXPECTED_NAME_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected name separator", iter->count);
+		case VALIDATE_EXPECTED_VALUE_SEPARATOR:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,` or the end of the container", iter->count);
+		case VALIDATE_INVALID_NUMBER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid number", iter->count);
+		case VALIDATE_INVALID_LITERAL:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `true`, `false` or `null`", iter->count);
+		case VALIDATE_INVALID_ESCAPE:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid escape", iter->count);
+		case VALIDATE_INVALID_UTF8:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid UTF-8", iter->count);
+		case VALIDATE_CONTROL_CHARACTER:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unescaped control character", iter->count);
+		case VALIDATE_TOO_DEEP:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Too deep", iter->count);
+		case VALIDATE_TRAILING_CONTENT:
+			return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected content after the value", iter->count);
+		default:
+			UNREACHABLE("Unknown error");
+	}
+}
+
+JSONStatus
+validate__JSON(const char *content, size_t content_len)
+{
+	if (!content) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", 0);
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+	uint32_t res = validate_value__JSONContentIterator(&iter);
+
+	if (res == VALIDATE_NO_ERROR && (skip_whitespace__JSONContentIterator(&iter), iter.count < iter.len)) {
+		res = VALIDATE_TRAILING_CONTENT;
+	}
+
+	return validate_status__JSON(&iter, res);
+}
+
+JSONStatus
+minify__JSON(const char *content, size_t content_len, JSONWriteCallback write, void *user_data)
+{
+	return reformat__JSON(content, content_len, 0, write, user_data);
+}
+
+JSONStatus
+reformat__JSON(const char *content, size_t content_len, size_t indent, JSONWriteCallback write, void *user_data)
+{
+	if (!content) {
+		return init_err__JSONStatus(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content", 0);
+	}
+
+	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
+	struct JSONWriter writer = init__JSONWriter(write, user_data);
+
+	return format_status__JSON(&iter, format__JSON(&iter, &writer, indent));
+}
+
+JSONSequenceIterator
+init__JSONSequenceIterator(const char *content, size_t content_len)
+{
+	return (JSONSequenceIterator){
+		.content = content,
+		.content_len = content ? content_len : 0,
+		.offset = 0,
+		.read = NULL,
+		.user_data = NULL,
+		.buffer = NULL,
+		.buffer_capacity = 0,
+		.is_eof = true,
+		.is_resyncing = false,
+		.has_rs = false,
+		.scan = { 0 }
+	};
+}
+
+JSONSequenceIterator
+init_stream__JSONSequenceIterator(JSONReadCallback read, void *user_data)
+{
+	return (JSONSequenceIterator){
+		.content = NULL,
+		.content_len = 0,
+		.offset = 0,
+		.read = read,
+		.user_data = user_data,
+		.buffer = NULL,
+		.buffer_capacity = 0,
+		.is_eof = false,
+		.is_resyncing = false,
+		.has_rs = false,
+		.scan = { 0 }
+	};
+}
+
+bool
+next__JSONSequenceIterator(JSONSequenceIterator *self, JSONValueResult *res)
+{
+	for (;;) {
+		struct JSONContentIterator iter = init__JSONContentIterator(self->content, self->content_len);
+
+		iter.count = self->offset;
+
+		if (self->is_resyncing) {
+			// See RFC 7464, 2.3.  Handling of Malformed JSON Text Sequences
+			while (iter.count < iter.len && iter.content[iter.count] != JSON_SEQUENCE_RS && (self->has_rs || iter.content[iter.count] != '\n')) {
+				++iter.count;
+			}
+
+			self->is_resyncing = iter.count == iter.len;
+		}
+
+		if (!self->is_resyncing) {
+			size_t start = iter.count;
+
+			skip_separators__JSONSequenceIterator(&iter);
+			self->has_rs = self->has_rs || (iter.count > start && memchr(self->content + start, JSON_SEQUENCE_RS, iter.count - start));
+		}
+
+		self->offset = iter.count;
+
+		if (iter.count < iter.len && !self->is_resyncing) {
+			// A value followed by a RS is complete, otherwise it is only
+			// complete when its end is found before the end of the
+			// buffer (`12` could be the start of `123`).
+			if (self->is_eof || find_end__JSONSequenceIterator(self)) {
+				// NOTE: The parser does not recover from invalid UTF-8, the
+				// value is validated first.
+				struct JSONContentIterator validate_iter = iter;
+				uint32_t status = validate_value__JSONContentIterator(&validate_iter);
+
+				if (status) {
+					JSONStatus err = validate_status__JSON(&validate_iter, status);
+
+					*res = init_err__JSONValueResult(err.err.kind, err.err.msg);
+				} else {
+					*res = parse_value__JSON(&iter);
+				}
+
+				self->offset = validate_iter.count < iter.len ? validate_iter.count : iter.len;
+				self->is_resyncing = is_err__JSONValueResult(res);
+				memset(&self->scan, 0, sizeof(self->scan));
+
+				return true;
+			}
+		} else if (self->is_eof) {
+			return false;
+		}
+
+		if (!fill__JSONSequenceIterator(self)) {
+			// Gives up on the rest of the stream
+			self->offset = self->content_len;
+			self->is_eof = true;
+			self->is_resyncing = false;
+			*res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+
+			return true;
+		}
+	}
+}
+
+void
+deinit__JSONSequenceIterator(const JSONSequenceIterator *self)
+{
+	free(self->buffer);
+}
+
+#ifdef JSON_THREADS
+void
+parse_files__JSON(const char *const *paths, size_t paths_len, size_t threads, JSONValueResult *results)
+{
+	struct JSONBatch batch = {
+		.paths = paths,
+		.paths_len = paths_len,
+		.results = results,
+		.callback = NULL,
+		.user_data = NULL
+	};
+
+	parse_files_base__JSON(&batch, threads);
+}
+
+void
+parse_files_with_callback__JSON(const char *const *paths, size_t paths_len, size_t threads, JSONBatchCallback callback, void *user_data)
+{
+	struct JSONBatch batch = {
+		.paths = paths,
+		.paths_len = paths_len,
+		.results = NULL,
+		.callback = callback,
+		.user_data = user_data
+	};
+
+	parse_files_base__JSON(&batch, threads);
+}
+
+char *
+to_string_parallel__JSONValue(const JSONValue *self, size_t threads)
+{
+	struct JSONParallelPlan plan;
+
+	if (!serialize_parallel__JSONValue(self, threads, &plan)) {
+		return NULL;
+	}
+
+	size_t len = 0;
+
+	for (size_t i = 0; i < plan.len; ++i) {
+		len += plan.pieces[i].res.len;
+	}
+
+	char *res = malloc(len + 1);
+
+	if (res) {
+		size_t offset = 0;
+
+		for (size_t i = 0; i < plan.len; ++i) {
+			if (plan.pieces[i].res.len > 0) {
+				memcpy(res + offset, plan.pieces[i].res.buffer, plan.pieces[i].res.len);
+				offset += plan.pieces[i].res.len;
+			}
+		}
+
+		res[len] = '\0';
+	}
+
+	deinit__JSONParallelPlan(&plan);
+
+	return res;
+}
+
+bool
+to_string_chunks__JSONValue(const JSONValue *self, size_t threads, JSONStringChunks *res)
+{
+	struct JSONParallelPlan plan;
+
+	*res = (JSONStringChunks){ .buffer = NULL, .len = 0 };
+
+	if (!serialize_parallel__JSONValue(self, threads, &plan)) {
+		return false;
+	}
+
+	res->buffer = malloc(sizeof(JSONStringChunk) * plan.len);
+
+	if (!res->buffer) {
+		deinit__JSONParallelPlan(&plan);
+
+		return false;
+	}
+
+	// The buffers of the pieces are handed over to the chunks
+	for (size_t i = 0; i < plan.len; ++i) {
+		if (plan.pieces[i].res.len > 0) {
+			res->buffer[res->len++] = (JSONStringChunk){
+				.buffer = plan.pieces[i].res.buffer,
+				.len = plan.pieces[i].res.len
+			};
+			plan.pieces[i].res = init__JSONValueString();
+		}
+	}
+
+	deinit__JSONParallelPlan(&plan);
+
+	return true;
+}
+
+void
+deinit__JSONStringChunks(const JSONStringChunks *self)
+{
+	for (size_t i = 0; i < self->len; ++i) {
+		free(self->buffer[i].buffer);
+	}
+
+	free(self->buffer);
+}
+
+bool
+start__JSONReclaimer(JSONReclaimer *self, size_t capacity)
+{
+	*self = (JSONReclaimer){
+		.queue = capacity ? malloc(sizeof(JSONValue) * capacity) : NULL,
+		.capacity = capacity,
+		.head = 0,
+		.len = 0,
+		.is_busy = false,
+		.is_stopping = false,
+		.stats = { 0 }
+	};
+
+	if (!self->queue) {
+		return false;
+	}
+
+	pthread_mutex_init(&self->mutex, NULL);
+	pthread_cond_init(&self->not_empty, NULL);
+	pthread_cond_init(&self->drained, NULL);
+
+	if (pthread_create(&self->thread, NULL, &run__JSONReclaimer, self) != 0) {
+		pthread_cond_destroy(&self->drained);
+		pthread_cond_destroy(&self->not_empty);
+		pthread_mutex_destroy(&self->mutex);
+		free(self->queue);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool
+push__JSONReclaimer(JSONReclaimer *self, const JSONValue *value)
+{
+	pthread_mutex_lock(&self->mutex);
+
+	if (self->len == self->capacity) {
+		++self->stats.freed_inline;
+
+		pthread_mutex_unlock(&self->mutex);
+
+		deinit__JSONValue(value);
+
+		return false;
+	}
+
+	self->queue[(self->head + self->len) % self->capacity] = *value;
+	++self->len;
+	++self->stats.pushed;
+
+	if (self->len > self->stats.max_len) {
+		self->stats.max_len = self->len;
+	}
+
+	pthread_cond_signal(&self->not_empty);
+	pthread_mutex_unlock(&self->mutex);
+
+	return true;
+}
+
+void
+drain__JSONReclaimer(JSONReclaimer *self)
+{
+	pthread_mutex_lock(&self->mutex);
+
+	while (self->len > 0 || self->is_busy) {
+		pthread_cond_wait(&self->drained, &self->mutex);
+	}
+
+	pthread_mutex_unlock(&self->mutex);
+}
+
+JSONReclaimerStats
+get_stats__JSONReclaimer(JSONReclaimer *self)
+{
+	pthread_mutex_lock(&self->mutex);
+
+	JSONReclaimerStats stats = self->stats;
+
+	pthread_mutex_unlock(&self->mutex);
+
+	return stats;
+}
+
+void
+stop__JSONReclaimer(JSONReclaimer *self)
+{
+	pthread_mutex_lock(&self->mutex);
 
-	if (current == '-') {
-		next__JSONContentIterator(iter);
+	self->is_stopping = true;
 
-		if (!push__JSONValueString(number, current)) {
-			return PARSE_NUMBER_OUT_OF_MEMORY;
-		}
-	}
+	pthread_cond_signal(&self->not_empty);
+	pthread_mutex_unlock(&self->mutex);
+	pthread_join(self->thread, NULL);
 
-	return PARSE_NUMBER_NO_ERROR;
+	pthread_cond_destroy(&self->drained);
+	pthread_cond_destroy(&self->not_empty);
+	pthread_mutex_destroy(&self->mutex);
+	free(self->queue);
 }
+#endif
 
-uint32_t
-parse_number_digits_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+bool
+parse_segment__JSONProjection(const char **path, bool is_first, char *key, size_t *key_len, bool *is_elements)
 {
-	uint32_t current = current__JSONContentIterator(iter);
+	const char *c = *path;
 
-	while (isdigit(current)) {
-		if (!push__JSONValueString(number, current)) {
-			return PARSE_NUMBER_OUT_OF_MEMORY;
+	*is_elements = *c == '[';
+
+	if (*is_elements) {
+		if (strncmp(c, "[*]", 3)) {
+			return false;
 		}
 
-		current = next__JSONContentIterator(iter);
-	}
+		*path = c + 3;
 
-	return PARSE_NUMBER_NO_ERROR;
-}
+		return true;
+	} else if (!is_first && *c++ != '.') {
+		return false;
+	}
 
-uint32_t
-parse_number_integer_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
-{
-	uint32_t current = current__JSONContentIterator(iter);
+	*key_len = 0;
 
-	if (!isdigit(current)) {
-		return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
-	} else if (current == '0') {
-		if (!push__JSONValueString(number, current)) {
-			return PARSE_NUMBER_OUT_OF_MEMORY;
+	while (*c && *c != '.' && *c != '[') {
+		if (*c == '\\' && (c[1] == '.' || c[1] == '[' || c[1] == '\\')) {
+			++c;
 		}
 
-		next__JSONContentIterator(iter);
+		if (*key_len == JSON_PROJECTION_MAX_KEY_LEN) {
+			return false;
+		}
 
-		return PARSE_NUMBER_NO_ERROR;
+		key[(*key_len)++] = *c++;
 	}
 
-	return parse_number_digits_value__JSON(iter, number);
+	*path = c;
+
+	return *key_len > 0;
 }
 
-uint32_t
-parse_number_frac_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+void
+deinit__JSONProjectionNode(const JSONProjectionNode *self)
 {
-	uint32_t current = current__JSONContentIterator(iter);
+	for (size_t i = 0; i < self->members_len; ++i) {
+		deinit__JSONProjectionNode(&self->members[i]);
+	}
 
-	if (current == '.') {
-		if (!push__JSONValueString(number, current)) {
-			return PARSE_NUMBER_OUT_OF_MEMORY;
-		}
+	if (self->elements) {
+		deinit__JSONProjectionNode(self->elements);
+		free(self->elements);
+	}
 
-		current = next__JSONContentIterator(iter);
+	free(self->members);
+	free(self->key);
+}
 
-		if (!isdigit(current)) {
-			return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
+const JSONProjectionNode *
+get_member__JSONProjectionNode(const JSONProjectionNode *self, const char *key, size_t key_len)
+{
+	// Projections are small, comparing the raw names is cheaper than hashing
+	// every member of the document.
+	for (size_t i = 0; i < self->members_len; ++i) {
+		if (self->members[i].key_len == key_len && !memcmp(self->members[i].key, key, key_len)) {
+			return &self->members[i];
 		}
-
-		return parse_number_digits_value__JSON(iter, number);
 	}
 
-	return PARSE_NUMBER_NO_ERROR;
+	return NULL;
 }
 
-uint32_t
-parse_number_exp_value__JSON(struct JSONContentIterator *iter, JSONValueString *number)
+JSONProjection
+init__JSONProjection(void)
 {
-	uint32_t current = current__JSONContentIterator(iter);
+	return (JSONProjection){
+		.root = { 0 }
+	};
+}
 
-	if (current != 'e' && current != 'E') {
-		return PARSE_NUMBER_NO_ERROR;
+bool
+add_path__JSONProjection(JSONProjection *self, const char *path)
+{
+	char key[JSON_PROJECTION_MAX_KEY_LEN];
+	size_t key_len;
+	bool is_elements;
+
+	if (!*path) {
+		return false;
 	}
 
-	if (!push__JSONValueString(number, current)) {
-		return PARSE_NUMBER_OUT_OF_MEMORY;
+	// Checks the whole path before changing the trie
+	for (const char *c = path; *c;) {
+		if (!parse_segment__JSONProjection(&c, c == path, key, &key_len, &is_elements)) {
+			return false;
+		}
 	}
 
-	current = next__JSONContentIterator(iter);
+	JSONProjectionNode *node = &self->root;
 
-	if (current == '+' || current == '-') {
-		if (!push__JSONValueString(number, current)) {
-			return PARSE_NUMBER_OUT_OF_MEMORY;
+	for (const char *c = path; *c;) {
+		parse_segment__JSONProjection(&c, c == path, key, &key_len, &is_elements);
+
+		if (is_elements) {
+			if (!node->elements && !(node->elements = calloc(1, sizeof(JSONProjectionNode)))) {
+				return false;
+			}
+
+			node = node->elements;
+
+			continue;
 		}
 
-		current = next__JSONContentIterator(iter);
-	}
+		JSONProjectionNode *member = (JSONProjectionNode *)get_member__JSONProjectionNode(node, key, key_len);
 
-	if (!isdigit(current)) {
-		return PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS;
+		if (!member) {
+			JSONProjectionNode *members = realloc(node->members, (node->members_len + 1) * sizeof(JSONProjectionNode));
+
+			if (!members) {
+				return false;
+			}
+
+			node->members = members;
+			member = &members[node->members_len];
+			*member = (JSONProjectionNode){
+				.key = malloc(key_len + 1),
+				.key_len = key_len
+			};
+
+			if (!member->key) {
+				return false;
+			}
+
+			memcpy(member->key, key, key_len);
+			member->key[key_len] = 0;
+			++node->members_len;
+		}
+
+		node = member;
 	}
 
-	return parse_number_digits_value__JSON(iter, number);
+	node->is_leaf = true;
+
+	return true;
+}
+
+void
+deinit__JSONProjection(const JSONProjection *self)
+{
+	deinit__JSONProjectionNode(&self->root);
 }
 
 JSONValueResult
-parse_number_value__JSON(struct JSONContentIterator *iter)
+project_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *node, bool *is_present)
 {
-	// See RFC 8259:
-	//
-	// 6.  Numbers
-	//
-	// [...]
-	//
-	// number = [ minus ] int [ frac ] [ exp ]
-    // decimal-point = %x2E       ; .
-    // digit1-9 = %x31-39         ; 1-9
-    // e = %x65 / %x45            ; e E
-    // exp = e [ minus / plus ] 1*DIGIT
-    // frac = decimal-point 1*DIGIT
-	// int = zero / ( digit1-9 *DIGIT )
-    // minus = %x2D               ; -
-    // plus = %x2B                ; +
-    // zero = %x30                ; 0
-	//
-	// [...]
-	JSONValueString number = init__JSONValueString();
-	uint32_t res = PARSE_NUMBER_NO_ERROR;
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
 
-	if ((res = parse_number_minus_value__JSON(iter, &number))) {
-		goto handle_err;
-	} else if ((res = parse_number_integer_value__JSON(iter, &number))) {
-		goto handle_err;
-	} else if ((res = parse_number_frac_value__JSON(iter, &number))) {
-		goto handle_err;
-	} else if ((res = parse_number_exp_value__JSON(iter, &number))) {
-		goto handle_err;
+	*is_present = true;
+
+	if (node->is_leaf) {
+		return parse_value__JSON(iter);
+	} else if (c == '{' && node->members_len > 0) {
+		return project_object_value__JSON(iter, node);
+	} else if (c == '[' && node->elements) {
+		return project_array_value__JSON(iter, node->elements);
 	}
 
-	return init_ok__JSONValueResult(init_number__JSONValue(number));
+	// The value is not on any path
+	*is_present = false;
 
-handle_err:
-	switch (res) {
-		case PARSE_NUMBER_OUT_OF_MEMORY:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
-		case PARSE_NUMBER_EXPECTED_TO_HAVE_DIGITS:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have digits");
-		default:
-			UNREACHABLE("Unknown error");
+	if (skip_value__JSONContentIterator(iter)) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid value");
 	}
+
+	return init_ok__JSONValueResult(init_null__JSONValue());
 }
 
 JSONValueResult
-parse_true_value__JSON(struct JSONContentIterator *iter)
+project_array_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *elements)
 {
-	char expected[] = "true";
+	++iter->count; // Skip `[`
 
-	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `true`");
-	}
+	JSONValueArray array = init__JSONValueArray();
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
 
-	return init_ok__JSONValueResult(init_boolean__JSONValue(true));
-}
+	while (c != ']') {
+		bool is_present;
+		JSONValueResult value_result = elements
+			? project_value__JSON(iter, elements, &is_present)
+			: init_ok__JSONValueResult(init_null__JSONValue());
 
-JSONValueResult
-parse_false_value__JSON(struct JSONContentIterator *iter)
-{
-	char expected[] = "false";
+		if (!elements && skip_value__JSONContentIterator(iter)) {
+			value_result = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid value");
+		}
 
-	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `false`");
+		if (is_err__JSONValueResult(&value_result)) {
+			deinit__JSONValueArray(&array);
+
+			return value_result;
+		} else if (!push__JSONValueArray(&array, value_result.ok)) {
+			deinit__JSONValueResult(&value_result);
+			deinit__JSONValueArray(&array);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+		}
+
+		c = skip_whitespace__JSONContentIterator(iter);
+
+		if (c == ',') {
+			++iter->count;
+			c = skip_whitespace__JSONContentIterator(iter);
+
+			if (c == ']') {
+				deinit__JSONValueArray(&array);
+
+				return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character");
+			}
+		} else if (c != ']') {
+			deinit__JSONValueArray(&array);
+
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+		}
 	}
 
-	return init_ok__JSONValueResult(init_boolean__JSONValue(false));
+	++iter->count; // Skip `]`
+
+	return init_ok__JSONValueResult(init_array__JSONValue(array));
 }
 
 JSONValueResult
-parse_null_value__JSON(struct JSONContentIterator *iter)
+project_object_value__JSON(struct JSONContentIterator *iter, const JSONProjectionNode *node)
 {
-	char expected[] = "null";
+	++iter->count; // Skip `{`
 
-	if (!expect_characters__JSONContentIterator(iter, expected, sizeof(expected) - 1)) {
-		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `null`");
+	JSONValueObject object = init__JSONValueObject();
+	JSONValueResult res;
+	unsigned char c = skip_whitespace__JSONContentIterator(iter);
+
+	if (!object.map) {
+		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
 	}
 
-	return init_ok__JSONValueResult(init_null__JSONValue());
-}
+	while (c != '}') {
+		if (c != '"') {
+			res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member");
 
-JSONValueResult
-parse_value__JSON(struct JSONContentIterator *iter)
-{
-	skip_spaces__JSONContentIterator(iter);
+			goto handle_err;
+		}
 
-	switch (current__JSONContentIterator(iter)) {
-		case '[':
-			return parse_array_value__JSON(iter);
-		case '{':
-			return parse_object_value__JSON(iter);
-		case '"':
-			return parse_string_value__JSON(iter);
-		case '-':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			return parse_number_value__JSON(iter);
-		case 't':
-			return parse_true_value__JSON(iter);
-		case 'f':
-			return parse_false_value__JSON(iter);
-		case 'n':
-			return parse_null_value__JSON(iter);
-		default:
-			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Unexpected character");
+		size_t key_start = iter->count + 1;
+		bool has_escapes = false;
+
+		if (skip_string__JSONContentIterator(iter, &has_escapes)) {
+			res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member name");
+
+			goto handle_err;
+		}
+
+		const char *key = iter->content + key_start;
+		size_t key_len = iter->count - 1 - key_start;
+		char unescaped_key[JSON_PROJECTION_MAX_KEY_LEN];
+
+		// A name too long to be decoded on the stack cannot match any path.
+		if (has_escapes) {
+			key_len = unescape__JSON(key, key_len, unescaped_key, sizeof(unescaped_key));
+			key = unescaped_key;
+		}
+
+		if (skip_whitespace__JSONContentIterator(iter) != ':') {
+			res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected value separator");
+
+			goto handle_err;
+		}
+
+		++iter->count;
+
+		const JSONProjectionNode *member = key_len != SIZE_MAX ? get_member__JSONProjectionNode(node, key, key_len) : NULL;
+
+		if (!member) {
+			if (skip_value__JSONContentIterator(iter)) {
+				res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Invalid member value");
+
+				goto handle_err;
+			}
+		} else {
+			bool is_present;
+			JSONValueResult value_result = project_value__JSON(iter, member, &is_present);
+
+			if (is_err__JSONValueResult(&value_result)) {
+				res = value_result;
+
+				goto handle_err;
+			}
+
+			if (is_present) {
+				JSONValueString name = init__JSONValueString();
+
+				if (!push_characters__JSONValueString(&name, member->key, member->key_len)) {
+					deinit__JSONValueResult(&value_result);
+					res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+
+					goto handle_err;
+				}
+
+				switch (add_member__JSONValueObject(&object, name, value_result.ok)) {
+					case OBJECT_KEY_VALUE_MAP_NO_ERROR:
+						break;
+					case OBJECT_KEY_VALUE_MAP_OUT_OF_MEMORY:
+						res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY, "Out of memory");
+
+						goto handle_err;
+					case OBJECT_KEY_VALUE_MAP_DUPLICATE_KEY:
+						res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Duplicated key");
+
+						goto handle_err;
+					default:
+						UNREACHABLE("Unknown status");
+				}
+			}
+		}
+
+		c = skip_whitespace__JSONContentIterator(iter);
+
+		if (c == ',') {
+			++iter->count;
+			c = skip_whitespace__JSONContentIterator(iter);
+
+			if (c == '}') {
+				res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected member");
+
+				goto handle_err;
+			}
+		} else if (c != '}') {
+			res = init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected `,`");
+
+			goto handle_err;
+		}
 	}
+
+	++iter->count; // Skip `}`
+
+	return init_ok__JSONValueResult(init_object__JSONValue(object));
+
+handle_err:
+	deinit__JSONValueObject(&object);
+
+	return res;
 }
 
 JSONValueResult
-parse__JSON(const char *content, size_t content_len)
+parse_projection__JSON(const char *content, size_t content_len, const JSONProjection *projection)
 {
 	if (!content) {
 		return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "No content");
@@ -1752,5 +9328,12 @@ parse__JSON(const char *content, size_t content_len)
 
 	struct JSONContentIterator iter = init__JSONContentIterator(content, content_len);
 
-	return parse_object_value__JSON(&iter);
+	switch (skip_whitespace__JSONContentIterator(&iter)) {
+		case '{':
+			return project_object_value__JSON(&iter, &projection->root);
+		case '[':
+			return project_array_value__JSON(&iter, projection->root.elements);
+		default:
+			return init_err__JSONValueResult(JSON_VALUE_RESULT_ERROR_PARSE_FAILED, "Expected to have `{` or `[`");
+	}
 }
@@ -27,6 +27,11 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+#ifdef JSON_THREADS
+#include <pthread.h>
+#endif
 
 enum JSONValueKind {
 	JSON_VALUE_KIND_NUMBER,
@@ -40,33 +45,69 @@ enum JSONValueKind {
 typedef struct JSONValueString {
 	char *buffer;
 	size_t len;
-	size_t capacity;
+	size_t capacity; // 0 if `buffer` is borrowed, e.g. from a JSONInternTable
 } JSONValueString;
 
+// How the elements of an array are stored. The packed kinds are only built by
+// `parse_with_options__JSON`.
+enum JSONValueArrayKind {
+	JSON_VALUE_ARRAY_KIND_VALUES, // `buffer`
+	JSON_VALUE_ARRAY_KIND_INT, // `ints`
+	JSON_VALUE_ARRAY_KIND_DOUBLE, // `doubles`
+	JSON_VALUE_ARRAY_KIND_BOOLEAN // `booleans`
+};
+
+// State of the elements of an array or of the map of an object, kept in the
+// same allocation: before the elements of an array, in the map of an object.
+typedef struct JSONValueShared {
+	size_t ref_count; // Holders of the buffer, see `clone__JSONValue`
+	uint64_t hash; // 0 until computed, see `hash__JSONValue`
+} JSONValueShared;
+
+// The kind of the elements is kept with them, see `get_kind__JSONValueArray`.
 typedef struct JSONValueArray {
-	struct JSONValue *buffer;
+	union {
+		struct JSONValue *buffer;
+		int64_t *ints;
+		double *doubles;
+		bool *booleans;
+	};
 	size_t len;
 	size_t capacity;
 } JSONValueArray;
 
+// Returns how the elements of `self` are stored. An array without elements is
+// an array of values.
+enum JSONValueArrayKind
+get_kind__JSONValueArray(const JSONValueArray *self);
+
 typedef struct JSONValueObjectKeyValue {
 	JSONValueString key;
 	struct JSONValue *value;
 } JSONValueObjectKeyValue;
 
-typedef struct JSONValueObjectBucket {
-	JSONValueObjectKeyValue pair;
-	struct JSONValueObjectBucket *next;
-} JSONValueObjectBucket;
+struct JSONObjectShape;
 
 typedef struct JSONValueObjectKeyValueMap {
-	JSONValueObjectBucket **buckets;
+	JSONValueObjectKeyValue *members; // In insertion order
 	size_t len;
+	size_t members_capacity;
+	// Open addressing table of `capacity` slots, 0 for an empty slot,
+	// otherwise the index of the member + 1.
+	uint32_t *index;
 	size_t capacity;
+	// When not NULL, the member names and `index` are borrowed from a shape
+	// shared with other objects, see `JSONParseOptions`. Kept here rather
+	// than in `JSONValueObject`, so the objects without a shape do not pay for
+	// it in every value.
+	struct JSONObjectShape *shape;
+	JSONValueShared shared; // Holders of the map, see `clone__JSONValue`
 } JSONValueObjectKeyValueMap;
 
+// The map is held behind a pointer, so that a `JSONValue` stays as large as a
+// string.
 typedef struct JSONValueObject {
-	JSONValueObjectKeyValueMap map;
+	JSONValueObjectKeyValueMap *map;
 } JSONValueObject;
 
 typedef struct JSONValue {
@@ -83,6 +124,270 @@ typedef struct JSONValue {
 char *
 to_string__JSONValue(const JSONValue *self);
 
+// Returns the value of the member named `key`, or NULL if `self` is not an
+// object or has no such member.
+const JSONValue *
+get_member__JSONValue(const JSONValue *self, const char *key, size_t key_len);
+
+// Looks a member name up in many objects, e.g. in every record of an array.
+// When the objects share a shape (see `JSONParseOptions`), the index of the
+// member in the shape is remembered and the lookup does not hash.
+typedef struct JSONMemberCache {
+	const char *key; // Borrowed
+	size_t key_len;
+	size_t hash;
+	const struct JSONObjectShape *shape;
+	size_t index;
+} JSONMemberCache;
+
+JSONMemberCache
+init__JSONMemberCache(const char *key, size_t key_len);
+
+// Same as `get_member__JSONValue`, through `cache`.
+const JSONValue *
+get_cached_member__JSONValue(const JSONValue *self, JSONMemberCache *cache);
+
+// Iterates over the members of an object in insertion order.
+typedef struct JSONObjectIterator {
+	const JSONValueObjectKeyValue *members;
+	size_t len;
+	size_t index;
+} JSONObjectIterator;
+
+// Yields no member if `self` is not an object.
+JSONObjectIterator
+init__JSONObjectIterator(const JSONValue *self);
+
+// Returns NULL after the last member.
+const JSONValueObjectKeyValue *
+next__JSONObjectIterator(JSONObjectIterator *self);
+
+#define JSON_PACKED_NUMBER_MAX_LEN 32
+
+// Room for an element of a packed array, which has no `JSONValue` of its own.
+typedef struct JSONElement {
+	JSONValue value;
+	char number[JSON_PACKED_NUMBER_MAX_LEN];
+} JSONElement;
+
+// Returns the element at `index` of the array `self`, or NULL if there is
+// none. The elements of packed arrays are built in `element`, and are only
+// valid until it is reused. Packed doubles are formatted in their shortest
+// form which reads back as the same double.
+const JSONValue *
+get_element__JSONValue(const JSONValue *self, size_t index, JSONElement *element);
+
+typedef struct JSONArrayIterator {
+	const JSONValue *array; // NULL if not an array
+	size_t len;
+	size_t index;
+	JSONElement element; // The current element of a packed array
+} JSONArrayIterator;
+
+// Yields no element if `self` is not an array.
+JSONArrayIterator
+init__JSONArrayIterator(const JSONValue *self);
+
+// Returns NULL after the last element. An element of a packed array is only
+// valid until the next call.
+const JSONValue *
+next__JSONArrayIterator(JSONArrayIterator *self);
+
+typedef struct JSONPointerToken {
+	char *key; // Unescaped, NUL-terminated
+	size_t key_len;
+	size_t hash; // Hash of `key` in the object index
+	size_t index; // Array index, SIZE_MAX if `key` is not one
+} JSONPointerToken;
+
+// A JSON Pointer (RFC 6901) parsed once, to be evaluated against many
+// values.
+typedef struct JSONPointer {
+	JSONPointerToken *tokens;
+	size_t len;
+} JSONPointer;
+
+// Compiles a pointer such as `/data/items/0/price`. Returns false on a
+// malformed pointer or allocation failure.
+bool
+compile__JSONPointer(JSONPointer *self, const char *pointer, size_t pointer_len);
+
+// Returns the value `self` points to in `value`, or NULL if there is none.
+// An element of a packed array is built in `element`, see
+// `get_element__JSONValue`.
+const JSONValue *
+get__JSONPointer(const JSONPointer *self, const JSONValue *value, JSONElement *element);
+
+// Replaces the value `self` points to in `root` with a clone of `value` (see
+// `clone__JSONValue`), or adds it when the last token names a missing member,
+// or is the length of an array or `-`. `value` may belong to another value,
+// e.g. an overlay. Only the arrays and objects on the path which are shared
+// with clones are copied, and the packed arrays on it are unpacked into
+// values. Returns false if the parent of the value does not exist, or on
+// allocation failure.
+bool
+set__JSONPointer(const JSONPointer *self, JSONValue *root, const JSONValue *value);
+
+// Removes the value `self` points to in `root`, copying the path like
+// `set__JSONPointer`. Returns false if there is no such value (the root
+// cannot be removed), or on allocation failure.
+bool
+remove__JSONPointer(const JSONPointer *self, JSONValue *root);
+
+void
+deinit__JSONPointer(const JSONPointer *self);
+
+enum JSONPathOpcode {
+	JSON_PATH_OPCODE_MEMBER, // `.name`, `['name']`
+	JSON_PATH_OPCODE_INDEX, // `[1]`, `[-1]` from the end
+	JSON_PATH_OPCODE_WILDCARD, // `.*`, `[*]`
+	JSON_PATH_OPCODE_DESCEND, // `..`, the value and all its descendants
+	// `[?(@.a.b > 1)]`, followed by the `operand_len` MEMBER or INDEX
+	// instructions of `@.a.b`
+	JSON_PATH_OPCODE_FILTER
+};
+
+enum JSONPathComparison {
+	JSON_PATH_COMPARISON_EXISTS, // `[?(@.a)]`
+	JSON_PATH_COMPARISON_EQ,
+	JSON_PATH_COMPARISON_NE,
+	JSON_PATH_COMPARISON_LT,
+	JSON_PATH_COMPARISON_LE,
+	JSON_PATH_COMPARISON_GT,
+	JSON_PATH_COMPARISON_GE
+};
+
+typedef struct JSONPathInstruction {
+	enum JSONPathOpcode opcode;
+	char *key; // MEMBER, NUL-terminated
+	size_t key_len;
+	size_t hash;
+	int64_t index; // INDEX
+	// FILTER
+	size_t operand_len;
+	enum JSONPathComparison comparison;
+	enum JSONValueKind literal_kind;
+	double number;
+	bool is_integer; // `number` is exactly `integer`
+	int64_t integer;
+	char *string;
+	size_t string_len;
+	bool boolean;
+} JSONPathInstruction;
+
+// A JSONPath compiled to a sequence of instructions.
+typedef struct JSONPath {
+	JSONPathInstruction *code;
+	size_t len;
+	size_t capacity;
+} JSONPath;
+
+// Compiles a JSONPath made of `$`, `.name`, `['name']`, `[1]`, `[-1]`, `.*`,
+// `[*]`, `..` and filters comparing a relative path to a literal, such as
+// `$.orders[*][?(@.qty > 10)].sku`. Returns false on a malformed or
+// unsupported path, or on allocation failure.
+bool
+compile__JSONPath(JSONPath *self, const char *path, size_t path_len);
+
+// Receives a value matched by a JSONPath, borrowed from the evaluated value.
+// Returns false to stop the evaluation.
+typedef bool (*JSONPathCallback)(const JSONValue *value, void *user_data);
+
+// Hands the values matched by `self` in `value` to `callback`, in document
+// order. The elements of packed arrays are only valid during the callback.
+void
+eval__JSONPath(const JSONPath *self, const JSONValue *value, JSONPathCallback callback, void *user_data);
+
+void
+deinit__JSONPath(const JSONPath *self);
+
+enum JSONColumnKind {
+	JSON_COLUMN_KIND_NULL, // Only null or missing values
+	JSON_COLUMN_KIND_BOOLEAN, // `booleans`
+	JSON_COLUMN_KIND_INT, // `ints`, integers fitting in an int64_t
+	JSON_COLUMN_KIND_DOUBLE, // `doubles`, any number
+	JSON_COLUMN_KIND_STRING, // `offsets` and `data`
+	JSON_COLUMN_KIND_VALUE // `values`, arrays, objects and mixed kinds
+};
+
+typedef struct JSONColumnShape {
+	char *name; // NUL-terminated
+	size_t name_len;
+	enum JSONColumnKind kind;
+} JSONColumnShape;
+
+// The columns of an array of records, in the order their names were first
+// seen.
+typedef struct JSONColumnSchema {
+	JSONColumnShape *columns;
+	size_t len;
+	size_t capacity;
+	// Open addressing table of `index_capacity` slots, 0 for an empty slot,
+	// otherwise the index of the column + 1.
+	uint32_t *index;
+	size_t index_capacity;
+} JSONColumnSchema;
+
+JSONColumnSchema
+init__JSONColumnSchema(void);
+
+// Adds a column, or widens the kind of the column already named `name`.
+// Returns false on allocation failure.
+bool
+add_column__JSONColumnSchema(JSONColumnSchema *self, const char *name, size_t name_len, enum JSONColumnKind kind);
+
+// Adds the members of the objects in the array `records` to `self`, widening
+// the kinds of the columns to fit all their values: INT and DOUBLE give
+// DOUBLE, other mixes give VALUE. Returns false if `records` is not an array
+// or on allocation failure.
+bool
+infer__JSONColumnSchema(JSONColumnSchema *self, const JSONValue *records);
+
+void
+deinit__JSONColumnSchema(const JSONColumnSchema *self);
+
+typedef struct JSONColumn {
+	char *name; // NUL-terminated
+	size_t name_len;
+	enum JSONColumnKind kind;
+	// Bit `row % 64` of `validity[row / 64]` is set if the row has a value
+	uint64_t *validity;
+	size_t null_count;
+	// The buffer of `kind` has one entry per row, 0 for a null row
+	bool *booleans;
+	int64_t *ints;
+	double *doubles;
+	size_t *offsets; // `rows + 1` offsets of the strings in `data`
+	char *data; // Unescaped, not NUL-terminated
+	const JSONValue **values; // Borrowed from the records
+} JSONColumn;
+
+// Struct-of-arrays view of an array of records.
+typedef struct JSONColumns {
+	JSONColumn *columns;
+	size_t len;
+	size_t rows;
+} JSONColumns;
+
+// Extracts the columns of `schema` from the array `records`, one row per
+// element. Missing members, elements which are not objects and values which
+// do not fit the kind of their column are null. The members are looked up at
+// the position they had in the previous record first, so records with the
+// same layout are extracted without hashing. Returns false if `records` is
+// not an array or on allocation failure.
+bool
+extract__JSONColumns(JSONColumns *self, const JSONValue *records, const JSONColumnSchema *schema);
+
+// Returns the column named `name`, or NULL if there is none.
+const JSONColumn *
+get_column__JSONColumns(const JSONColumns *self, const char *name, size_t name_len);
+
+bool
+is_valid__JSONColumn(const JSONColumn *self, size_t row);
+
+void
+deinit__JSONColumns(const JSONColumns *self);
+
 enum JSONValueResultKind {
 	JSON_VALUE_RESULT_KIND_OK,
 	JSON_VALUE_RESULT_KIND_ERR
@@ -90,7 +395,9 @@ enum JSONValueResultKind {
 
 enum JSONValueResultError {
 	JSON_VALUE_RESULT_ERROR_PARSE_FAILED,
-	JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY
+	JSON_VALUE_RESULT_ERROR_OUT_OF_MEMORY,
+	JSON_VALUE_RESULT_ERROR_WRITE_FAILED,
+	JSON_VALUE_RESULT_ERROR_READ_FAILED
 };
 
 typedef struct JSONValueResult {
@@ -116,4 +423,521 @@ deinit__JSONValueResult(const JSONValueResult *self);
 JSONValueResult
 parse__JSON(const char *content, size_t content_len);
 
+typedef struct JSONInternEntry {
+	char *buffer; // NUL-terminated
+	size_t len;
+	size_t hash;
+} JSONInternEntry;
+
+// A single immutable copy of each short string met while parsing, shared by
+// all the values built with the table. Two strings interned in the same table
+// are equal if and only if their buffers are the same pointer.
+typedef struct JSONInternTable {
+	JSONInternEntry *entries;
+	size_t len;
+	size_t entries_capacity;
+	uint32_t *index; // Open addressing table of `capacity` slots, like objects
+	size_t capacity;
+	size_t max_len; // Longer strings are not interned
+	bool is_shared; // Used by several threads at once
+#ifdef JSON_THREADS
+	pthread_mutex_t mutex;
+#endif
+} JSONInternTable;
+
+// Interns the strings of at most `max_len` bytes. `is_shared` makes the table
+// safe to use from several threads (only with `JSON_ENABLE_THREADS`). Returns
+// false if the mutex cannot be created.
+bool
+init__JSONInternTable(JSONInternTable *self, size_t max_len, bool is_shared);
+
+// Returns the interned copy of `s`, or NULL on allocation failure.
+const char *
+intern__JSONInternTable(JSONInternTable *self, const char *s, size_t s_len);
+
+// Must only be called once the values which borrow its strings are released.
+void
+deinit__JSONInternTable(JSONInternTable *self);
+
+typedef struct JSONParseOptions {
+	// Stores the arrays made only of numbers as packed int64_t buffers, or as
+	// double buffers if one of them is not an integer fitting in an int64_t.
+	// Arrays with `-0`, or with an integer a double cannot hold exactly when
+	// doubles are needed, are stored as values.
+	bool pack_numbers;
+	// Stores the arrays made only of booleans as packed bool buffers.
+	bool pack_booleans;
+	// The objects of an array with the same member names, in the same order,
+	// share a single copy of the names and of the index.
+	bool share_shapes;
+	// The short string values are interned in this table, which must outlive
+	// the parsed value. NULL to copy every string.
+	JSONInternTable *intern;
+#ifdef JSON_STATS
+	// Receives the statistics of the parse, see `JSONParseStats`. NULL to
+	// collect none. Must not be used by several parses at once.
+	struct JSONParseStats *stats;
+#endif
+} JSONParseOptions;
+
+// Same as `parse__JSON`, with `options`.
+JSONValueResult
+parse_with_options__JSON(const char *content, size_t content_len, const JSONParseOptions *options);
+
+// Returns a copy of `self` in O(1): its arrays and objects are shared with
+// `self` until either value is edited with `set__JSONPointer` or
+// `remove__JSONPointer`. `self` can meanwhile be read or cloned by other
+// threads, e.g. when it is the value of a `JSONDocument`.
+JSONValueResult
+clone__JSONValue(const JSONValue *self);
+
+// Returns a hash of the content of `self`, which ignores the order of the
+// members of objects and the spelling of numbers (`1`, `1.0` and `1e0` are
+// equal). Numbers are compared by their exact decimal values, also beyond the
+// range of int64_t or double. The hashes of arrays and objects are computed once and kept with
+// their buffers, so they are shared by clones, and only recomputed along the
+// path edited by `set__JSONPointer` or `remove__JSONPointer`.
+uint64_t
+hash__JSONValue(const JSONValue *self);
+
+// Returns true if `self` and `other` have the same content, in the sense of
+// `hash__JSONValue`. Arrays and objects whose hashes differ are rejected at
+// once; equal hashes are confirmed by comparing the contents, except for the
+// buffers shared by clones.
+bool
+eq__JSONValue(const JSONValue *self, const JSONValue *other);
+
+enum JSONDiffKind {
+	JSON_DIFF_KIND_ADDED, // `before` is NULL
+	JSON_DIFF_KIND_REMOVED, // `after` is NULL
+	JSON_DIFF_KIND_CHANGED
+};
+
+// Receives a difference at `pointer`, a NUL-terminated JSON Pointer. The
+// values are borrowed, the elements of packed arrays only for the duration of
+// the call. Returns false to stop the diff.
+typedef bool (*JSONDiffCallback)(enum JSONDiffKind kind, const char *pointer, size_t pointer_len, const JSONValue *before, const JSONValue *after, void *user_data);
+
+// Hands the differences from `before` to `after` to `callback`. Only the
+// subtrees whose hashes differ are descended into.
+// Arrays are compared element by element. Returns false on allocation
+// failure.
+bool
+diff__JSONValue(const JSONValue *before, const JSONValue *after, JSONDiffCallback callback, void *user_data);
+
+// An immutable document which can be held and read by several threads at once
+// without locking.
+typedef struct JSONDocument {
+	JSONValue value; // Must not be modified
+	size_t ref_count; // Updated atomically
+} JSONDocument;
+
+// Takes the ownership of `value` and returns a document held once. Returns
+// NULL on allocation failure, in which case `value` is left untouched.
+JSONDocument *
+freeze__JSONDocument(const JSONValue *value);
+
+// Holds `self` once more, e.g. before handing it to another thread.
+JSONDocument *
+retain__JSONDocument(JSONDocument *self);
+
+// The last release frees the document with `deinit__JSONValue`.
+void
+release__JSONDocument(JSONDocument *self);
+
+// A parse result shared by the holders of a cache entry. Its value must not
+// be modified.
+typedef struct JSONParseCacheEntry {
+	char *content; // Copy of the parsed content, compared on lookup
+	size_t content_len;
+	uint64_t hash;
+	JSONValueResult res;
+	size_t ref_count; // Holders, the cache included while the entry is in it
+	struct JSONParseCacheEntry *prev; // More recently used
+	struct JSONParseCacheEntry *next; // Less recently used
+	struct JSONParseCacheEntry *chain; // Next entry of the same bucket
+} JSONParseCacheEntry;
+
+typedef struct JSONParseCacheStats {
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t len; // Entries in the cache
+	size_t bytes; // Content bytes held by the entries in the cache
+} JSONParseCacheStats;
+
+// A bounded LRU of parse results keyed by a hash of the content. Safe to use
+// from several threads at once with `JSON_ENABLE_THREADS`.
+typedef struct JSONParseCache {
+	JSONParseCacheEntry **buckets;
+	size_t buckets_len;
+	size_t capacity; // Maximum number of entries
+	JSONParseCacheEntry *head; // Most recently used
+	JSONParseCacheEntry *tail; // Least recently used
+	JSONParseOptions options;
+	bool has_options;
+	JSONParseCacheStats stats;
+#ifdef JSON_THREADS
+	pthread_mutex_t mutex;
+#endif
+} JSONParseCache;
+
+// Keeps the results of up to `capacity` distinct contents, parsed with
+// `options` (NULL for `parse__JSON`). The intern table of `options`, if any,
+// must be shared (see `init__JSONInternTable`) since the contents may be
+// parsed by several threads at once. Returns false on allocation failure or
+// with a table which is not shared.
+bool
+init__JSONParseCache(JSONParseCache *self, size_t capacity, const JSONParseOptions *options);
+
+// Returns the entry of `content`, parsing it only if it is not cached yet.
+// The content is validated first, so that invalid UTF-8 gives an error
+// result. Parse errors are cached too. The entry must be handed back with
+// `release__JSONParseCache`. Returns NULL on allocation failure.
+const JSONParseCacheEntry *
+parse__JSONParseCache(JSONParseCache *self, const char *content, size_t content_len);
+
+// Releases an entry returned by `parse__JSONParseCache`. An entry evicted from
+// the cache is freed by its last holder. Does nothing with NULL.
+void
+release__JSONParseCache(JSONParseCache *self, const JSONParseCacheEntry *entry);
+
+JSONParseCacheStats
+get_stats__JSONParseCache(JSONParseCache *self);
+
+// Every entry must have been released.
+void
+deinit__JSONParseCache(JSONParseCache *self);
+
+typedef struct JSONStatus {
+	enum JSONValueResultKind kind;
+	struct {
+		enum JSONValueResultError kind;
+		const char *msg;
+		size_t offset; // Byte offset in the content
+	} err;
+} JSONStatus;
+
+bool
+is_err__JSONStatus(const JSONStatus *self);
+
+// Skips the value starting at `offset` in `content`, leading whitespace
+// included, and sets `*end` to the offset right after it. Inside objects and
+// arrays only the brackets and the strings are checked.
+JSONStatus
+skip_value__JSON(const char *content, size_t content_len, size_t offset, size_t *end);
+
+// Receives the byte range [start, end) of a value matched by `scan__JSONPath`.
+// Returns false to stop the scan.
+typedef bool (*JSONPathMatchCallback)(size_t start, size_t end, void *user_data);
+
+// Matches `self` against each value of `content`, a single JSON text or a
+// sequence of them such as NDJSON, without building any `JSONValue`. The
+// subtrees which cannot match are skipped structurally. A match is reported
+// before the matches it contains, which are held back until the end of the
+// matched value is reached. Filters and negative indices are not supported.
+JSONStatus
+scan__JSONPath(const JSONPath *self, const char *content, size_t content_len, JSONPathMatchCallback callback, void *user_data);
+
+// Checks that `content` is a single JSON text conforming to RFC 8259 (any
+// top-level value, UTF-8 included) without allocating or building any
+// `JSONValue`.
+JSONStatus
+validate__JSON(const char *content, size_t content_len);
+
+// Receives the output of a transform in chunks. Returns false to stop it.
+typedef bool (*JSONWriteCallback)(const char *buffer, size_t len, void *user_data);
+
+// Copies the JSON text in `content` to `write` without its insignificant
+// whitespace, in constant memory and keeping the member order. The grammar,
+// numbers and literals are checked, strings only up to their closing quote,
+// see `validate__JSON`.
+JSONStatus
+minify__JSON(const char *content, size_t content_len, JSONWriteCallback write, void *user_data);
+
+// Same as `minify__JSON`, but puts each member and element on its own line,
+// indented by `indent` spaces per level.
+JSONStatus
+reformat__JSON(const char *content, size_t content_len, size_t indent, JSONWriteCallback write, void *user_data);
+
+// Reads up to `len` bytes into `buffer`. Returns the number of bytes read, 0
+// at the end of the stream.
+typedef size_t (*JSONReadCallback)(char *buffer, size_t len, void *user_data);
+
+// Iterates over the values of a sequence of JSON texts, either concatenated
+// (`{} [1] "a" 2`) or separated by RS as in RFC 7464 (`application/json-seq`).
+// The values can be of any kind.
+typedef struct JSONSequenceIterator {
+	const char *content;
+	size_t content_len;
+	size_t offset; // Byte offset of the next value in `content`
+	// Stream only, `content` is then the read buffer, reused between values.
+	JSONReadCallback read;
+	void *user_data;
+	char *buffer;
+	size_t buffer_capacity;
+	bool is_eof;
+	bool is_resyncing; // Skipping to the next separator after a malformed text
+	bool has_rs; // RS were met, the iteration only resyncs on them
+	// Stream only, where the search for the end of an incomplete value
+	// resumes after the next read.
+	struct {
+		size_t len; // Bytes of the value already scanned
+		size_t depth;
+		bool is_in_string;
+		bool is_escaped;
+	} scan;
+} JSONSequenceIterator;
+
+JSONSequenceIterator
+init__JSONSequenceIterator(const char *content, size_t content_len);
+
+// Reads the sequence from `read`. A value is only parsed once it has been
+// completely buffered, each byte is scanned once while waiting for its end.
+JSONSequenceIterator
+init_stream__JSONSequenceIterator(JSONReadCallback read, void *user_data);
+
+// Returns false at the end of the sequence. Otherwise `*res` holds the next
+// value, to release with `deinit__JSONValueResult`, or the error of a
+// malformed text (invalid UTF-8 included). After an error the iteration
+// resumes at the next RS, or at the next line feed when no RS was met so far,
+// and ends if there is none.
+bool
+next__JSONSequenceIterator(JSONSequenceIterator *self, JSONValueResult *res);
+
+void
+deinit__JSONSequenceIterator(const JSONSequenceIterator *self);
+
+enum JSONFieldKind {
+	JSON_FIELD_KIND_INT, // int64_t
+	JSON_FIELD_KIND_DOUBLE, // double
+	JSON_FIELD_KIND_BOOLEAN, // bool
+	JSON_FIELD_KIND_STRING, // JSONStringSlice
+	JSON_FIELD_KIND_STRUCT, // Nested struct described by `descriptor`
+	JSON_FIELD_KIND_ARRAY // Inline array of `capacity` elements of `element_kind`
+};
+
+// A string borrowed from the decoded content. The escapes are not decoded.
+typedef struct JSONStringSlice {
+	const char *buffer;
+	size_t len;
+	bool has_escapes;
+} JSONStringSlice;
+
+// Decodes the escapes of `s`, the content of a string without its quotation
+// marks (e.g. a `JSONStringSlice`), into `res`. Returns the decoded length,
+// or SIZE_MAX if an escape is invalid or if `res` is too small.
+size_t
+unescape__JSON(const char *s, size_t s_len, char *res, size_t res_capacity);
+
+typedef struct JSONFieldDescriptor {
+	const char *name;
+	size_t offset;
+	enum JSONFieldKind kind;
+	// JSON_FIELD_KIND_STRUCT, or JSON_FIELD_KIND_ARRAY of JSON_FIELD_KIND_STRUCT
+	struct JSONStructDescriptor *descriptor;
+	// JSON_FIELD_KIND_ARRAY, the length is stored as a size_t at `len_offset`
+	enum JSONFieldKind element_kind;
+	size_t element_size;
+	size_t capacity;
+	size_t len_offset;
+} JSONFieldDescriptor;
+
+typedef struct JSONStructDescriptor {
+	const JSONFieldDescriptor *fields;
+	size_t fields_len;
+	// Perfect hash from member names to fields, filled by
+	// `prepare__JSONStructDescriptor`.
+	uint32_t seed;
+	uint32_t *table;
+	size_t table_len;
+} JSONStructDescriptor;
+
+#define JSON_FIELD(type, member, field_kind) \
+	{ .name = #member, .offset = offsetof(type, member), .kind = field_kind }
+#define JSON_STRUCT_FIELD(type, member, struct_descriptor) \
+	{ .name = #member, .offset = offsetof(type, member), .kind = JSON_FIELD_KIND_STRUCT, .descriptor = struct_descriptor }
+#define JSON_ARRAY_FIELD(type, member, len_member, array_element_kind, struct_descriptor) \
+	{ \
+		.name = #member, \
+		.offset = offsetof(type, member), \
+		.kind = JSON_FIELD_KIND_ARRAY, \
+		.descriptor = struct_descriptor, \
+		.element_kind = array_element_kind, \
+		.element_size = sizeof(((type *)0)->member[0]), \
+		.capacity = sizeof(((type *)0)->member) / sizeof(((type *)0)->member[0]), \
+		.len_offset = offsetof(type, len_member) \
+	}
+
+// Builds the perfect hash of `self` and of the nested descriptors. Returns
+// false on allocation failure, duplicate field names, arrays of arrays, or
+// struct fields (and arrays of structs) without a descriptor.
+bool
+prepare__JSONStructDescriptor(JSONStructDescriptor *self);
+
+void
+deinit__JSONStructDescriptor(JSONStructDescriptor *self);
+
+// Decodes the object in `content` into `out` without building any
+// `JSONValue`. Unknown members are skipped, `null` leaves a field untouched.
+// Only whitespace may follow the object. A descriptor which is not prepared
+// gives an error.
+JSONStatus
+decode__JSON(const char *content, size_t content_len, const JSONStructDescriptor *descriptor, void *out);
+
+// Same as `decode__JSON`, but the object may be followed by other content,
+// `end` receives the offset right after it.
+JSONStatus
+decode_prefix__JSON(const char *content, size_t content_len, const JSONStructDescriptor *descriptor, void *out, size_t *end);
+
+// A trie of key paths, a node is either a member name or `[*]`.
+typedef struct JSONProjectionNode {
+	char *key;
+	size_t key_len;
+	bool is_leaf; // The whole value is kept
+	struct JSONProjectionNode *members;
+	size_t members_len;
+	struct JSONProjectionNode *elements; // `[*]`
+} JSONProjectionNode;
+
+typedef struct JSONProjection {
+	JSONProjectionNode root;
+} JSONProjection;
+
+JSONProjection
+init__JSONProjection(void);
+
+// Adds a key path such as `user.id` or `events[*].ts`. `\` escapes `.`, `[`
+// and `\` in member names. Returns false on a malformed path or allocation
+// failure.
+bool
+add_path__JSONProjection(JSONProjection *self, const char *path);
+
+void
+deinit__JSONProjection(const JSONProjection *self);
+
+// Parses the object or array in `content`, building only the values on the
+// paths of `projection`. Every other subtree is skipped without being
+// decoded. Array elements which do not match are kept as `null`.
+JSONValueResult
+parse_projection__JSON(const char *content, size_t content_len, const JSONProjection *projection);
+
+#ifdef JSON_THREADS
+// Only available when the library is built with `JSON_ENABLE_THREADS`.
+
+// Receives the result of the file at `index`, from the worker thread which
+// parsed it. `res` must be released with `deinit__JSONValueResult`.
+typedef void (*JSONBatchCallback)(size_t index, JSONValueResult res, void *user_data);
+
+// Parses the files at `paths` with `parse__JSON` on `threads` threads (0 for
+// one per online CPU), the calling thread included. Each file is validated
+// first, so that invalid UTF-8 gives an error result for that file. The next files are opened
+// and prefetched with `posix_fadvise` while the previous ones are parsed.
+// `results` receives the result of each file at the same index.
+void
+parse_files__JSON(const char *const *paths, size_t paths_len, size_t threads, JSONValueResult *results);
+
+// Same as `parse_files__JSON`, but hands each result to `callback` as soon as
+// it is parsed, possibly from several threads at once.
+void
+parse_files_with_callback__JSON(const char *const *paths, size_t paths_len, size_t threads, JSONBatchCallback callback, void *user_data);
+
+// Serializes `self` like `to_string__JSONValue`, on `threads` threads (0 for
+// one per online CPU). Large arrays and objects are split into ranges of
+// elements serialized concurrently into separate buffers, which are then
+// copied into the returned string.
+char *
+to_string_parallel__JSONValue(const JSONValue *self, size_t threads);
+
+typedef struct JSONStringChunk {
+	char *buffer; // Not NUL-terminated
+	size_t len;
+} JSONStringChunk;
+
+typedef struct JSONStringChunks {
+	JSONStringChunk *buffer;
+	size_t len;
+} JSONStringChunks;
+
+// Same as `to_string_parallel__JSONValue`, but hands over the buffers as they
+// are instead of copying them, e.g. to write them with `writev(2)`.
+bool
+to_string_chunks__JSONValue(const JSONValue *self, size_t threads, JSONStringChunks *res);
+
+void
+deinit__JSONStringChunks(const JSONStringChunks *self);
+
+typedef struct JSONReclaimerStats {
+	size_t pushed; // Values handed over to the reclaimer thread
+	size_t reclaimed; // Values freed by the reclaimer thread
+	size_t freed_inline; // Values freed by `push__JSONReclaimer` on a full queue
+	size_t max_len; // Largest number of values waiting in the queue
+	uint64_t reclaim_ns; // Time spent freeing by the reclaimer thread
+} JSONReclaimerStats;
+
+// Frees values on a background thread, so that dropping a large document
+// does not delay the thread which dropped it.
+typedef struct JSONReclaimer {
+	pthread_mutex_t mutex;
+	pthread_cond_t not_empty;
+	pthread_cond_t drained;
+	pthread_t thread;
+	JSONValue *queue; // Ring buffer of `capacity` values
+	size_t capacity;
+	size_t head;
+	size_t len;
+	bool is_busy; // A value is being freed
+	bool is_stopping;
+	JSONReclaimerStats stats;
+} JSONReclaimer;
+
+// Starts the reclaimer thread. At most `capacity` values wait in the queue,
+// which bounds the memory held by the reclaimer. Returns false if the queue
+// cannot be allocated or the thread cannot be created.
+bool
+start__JSONReclaimer(JSONReclaimer *self, size_t capacity);
+
+// Hands `value` over to the reclaimer thread, which takes its ownership.
+// When the queue is full, `value` is freed on the calling thread and false is
+// returned.
+bool
+push__JSONReclaimer(JSONReclaimer *self, const JSONValue *value);
+
+// Waits until every value pushed so far has been freed.
+void
+drain__JSONReclaimer(JSONReclaimer *self);
+
+JSONReclaimerStats
+get_stats__JSONReclaimer(JSONReclaimer *self);
+
+// Frees the values still in the queue and stops the reclaimer thread.
+void
+stop__JSONReclaimer(JSONReclaimer *self);
+#endif
+
+#ifdef JSON_STATS
+// Only available when the library is built with `JSON_ENABLE_STATS`.
+typedef struct JSONParseStats {
+	size_t bytes_consumed;
+	size_t nodes[JSON_VALUE_KIND_NULL + 1]; // Indexed by `enum JSONValueKind`
+	size_t max_depth;
+	size_t string_bytes_copied;
+	size_t string_bytes_escaped;
+	size_t object_resizes;
+	size_t object_probes;
+	size_t object_max_probe_len;
+	size_t allocations;
+	// Time split across the parse stages, in nanoseconds. Member names are
+	// accounted to `string_ns`, everything else to `scan_ns`.
+	uint64_t scan_ns;
+	uint64_t string_ns;
+	uint64_t number_ns;
+	uint64_t object_insert_ns;
+} JSONParseStats;
+
+// Same as `parse_with_options__JSON` with only `stats` set.
+JSONValueResult
+parse_with_stats__JSON(const char *content, size_t content_len, JSONParseStats *stats);
+#endif
+
 #endif // JSON_H
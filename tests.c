@@ -0,0 +1,1845 @@
+/*
+* MIT License
+*
+* Copyright (c) 2025 ArthurPV
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "json.h"
+#include "tests_schema.h"
+
+// Usage: json_tests
+//
+// Checks the public API of the library, plus the regressions fixed in it.
+// Prints each failed check and exits with 1 if there is any.
+
+#define FATAL(msg, ...) \
+	do { \
+		fprintf(stderr, "FATAL(%d): "msg"\n", __LINE__, ##__VA_ARGS__); \
+		exit(1); \
+	} while (0)
+
+#define CHECK(cond) \
+	do { \
+		++checks; \
+		if (!(cond)) { \
+			fprintf(stderr, "FAIL(%s:%d): %s\n", __func__, __LINE__, #cond); \
+			++failures; \
+		} \
+	} while (0)
+
+static size_t checks = 0;
+static size_t failures = 0;
+
+typedef struct TestPoint {
+	int64_t x;
+	int64_t y;
+} TestPoint;
+
+typedef struct TestMessage {
+	int64_t id;
+	double score;
+	bool is_active;
+	JSONStringSlice name;
+	TestPoint origin;
+	int64_t tags[4];
+	size_t tags_len;
+} TestMessage;
+static JSONFieldDescriptor point_fields__Test[] = {
+	JSON_FIELD(TestPoint, x, JSON_FIELD_KIND_INT),
+	JSON_FIELD(TestPoint, y, JSON_FIELD_KIND_INT)
+};
+
+static JSONStructDescriptor point_descriptor__Test = {
+	.fields = point_fields__Test,
+	.fields_len = sizeof(point_fields__Test) / sizeof(*point_fields__Test)
+};
+
+static JSONFieldDescriptor message_fields__Test[] = {
+	JSON_FIELD(TestMessage, id, JSON_FIELD_KIND_INT),
+	JSON_FIELD(TestMessage, score, JSON_FIELD_KIND_DOUBLE),
+	JSON_FIELD(TestMessage, is_active, JSON_FIELD_KIND_BOOLEAN),
+	JSON_FIELD(TestMessage, name, JSON_FIELD_KIND_STRING),
+	JSON_STRUCT_FIELD(TestMessage, origin, &point_descriptor__Test),
+	JSON_ARRAY_FIELD(TestMessage, tags, tags_len, JSON_FIELD_KIND_INT, NULL)
+};
+
+static JSONStructDescriptor message_descriptor__Test = {
+	.fields = message_fields__Test,
+	.fields_len = sizeof(message_fields__Test) / sizeof(*message_fields__Test)
+};
+
+struct TestSource {
+	const char *content;
+	size_t len;
+	size_t offset;
+	size_t chunk_len;
+};
+
+struct TestMatches {
+	const char *content;
+	char buffer[512];
+	size_t limit; // Stops the scan after this many matches
+};
+
+#ifdef JSON_THREADS
+struct TestReader {
+	JSONDocument *document;
+	bool is_same;
+};
+#endif
+
+struct TestDiff {
+	char buffer[512];
+	size_t len;
+};
+
+static JSONValue
+parse__Test(const char *content, const JSONParseOptions *options);
+
+static void
+free__Test(JSONValue value);
+
+static bool
+is_string__Test(const JSONValue *value, const char *expected);
+
+static bool
+is_ok__Test(JSONStatus status);
+
+#ifdef JSON_STATS
+static void
+stats__Test(void);
+#endif
+
+static JSONStatus
+decode_string__Test(const char *content, TestMessage *message);
+
+static void
+decode__Test(void);
+
+static void
+codegen__Test(void);
+
+static JSONValue
+parse_projection__Test(const char *content, const char *const *paths, size_t paths_len);
+
+static void
+projection__Test(void);
+
+static void
+skip__Test(void);
+
+static void
+validate__Test(void);
+
+static bool
+write__Test(const char *buffer, size_t len, void *user_data);
+
+static void
+format__Test(void);
+
+static size_t
+read__Test(char *buffer, size_t len, void *user_data);
+
+static void
+collect_sequence__Test(JSONSequenceIterator *iter, char *res);
+
+static void
+sequence__Test(void);
+
+#ifdef JSON_THREADS
+static void
+write_file__Test(const char *path, const char *content);
+
+static void
+count_batch__Test(size_t index, JSONValueResult res, void *user_data);
+
+static void
+batch__Test(void);
+#endif
+
+#ifdef JSON_THREADS
+static void
+serialize_parallel__Test(void);
+#endif
+
+#ifdef JSON_THREADS
+static void
+reclaimer__Test(void);
+#endif
+
+static void
+iterator__Test(void);
+
+static void
+pointer__Test(void);
+
+static bool
+collect__Test(const JSONValue *value, void *user_data);
+
+static void
+eval__Test(const JSONValue *value, const char *path, char *res);
+
+static void
+path__Test(void);
+
+static bool
+collect_range__Test(size_t start, size_t end, void *user_data);
+
+static JSONStatus
+scan_string__Test(const char *content, const char *path, size_t limit, struct TestMatches *matches);
+
+static void
+scan__Test(void);
+
+static bool
+is_cell__Test(const JSONColumn *column, size_t row, const JSONValue *value);
+
+static void
+columns__Test(void);
+
+static void
+packed__Test(void);
+
+static void
+shape__Test(void);
+
+static void
+intern__Test(void);
+
+static void
+cache__Test(void);
+
+#ifdef JSON_THREADS
+static void *
+read_document__Test(void *data);
+#endif
+
+static void
+document__Test(void);
+
+static bool
+set__Test(JSONValue *root, const char *pointer, const char *value);
+
+static bool
+remove__Test(JSONValue *root, const char *pointer);
+
+static void
+copy_on_write__Test(void);
+
+static bool
+collect_diff__Test(enum JSONDiffKind kind, const char *pointer, size_t pointer_len, const JSONValue *before, const JSONValue *after, void *user_data);
+
+static void
+hash__Test(void);
+
+JSONValue
+parse__Test(const char *content, const JSONParseOptions *options)
+{
+	JSONValueResult res = options
+		? parse_with_options__JSON(content, strlen(content), options)
+		: parse__JSON(content, strlen(content));
+
+	if (is_err__JSONValueResult(&res)) {
+		FATAL("Cannot parse %s: %s", content, res.err.msg);
+	}
+
+	return res.ok;
+}
+
+void
+free__Test(JSONValue value)
+{
+	JSONValueResult res = { .kind = JSON_VALUE_RESULT_KIND_OK, .ok = value };
+
+	deinit__JSONValueResult(&res);
+}
+
+bool
+is_string__Test(const JSONValue *value, const char *expected)
+{
+	char *s = value ? to_string__JSONValue(value) : NULL;
+	bool res = s && !strcmp(s, expected);
+
+	if (!res) {
+		fprintf(stderr, "  got %s, expected %s\n", s ? s : "NULL", expected);
+	}
+
+	free(s);
+
+	return res;
+}
+
+bool
+is_ok__Test(JSONStatus status)
+{
+	return !is_err__JSONStatus(&status);
+}
+
+#ifdef JSON_STATS
+void
+stats__Test(void)
+{
+	const char *content = "{\"a\": [1, 2.5, {\"b\": \"x\\ny\"}], \"c\": true, \"d\": null}";
+	JSONParseStats stats;
+	JSONValueResult res = parse_with_stats__JSON(content, strlen(content), &stats);
+
+	CHECK(!is_err__JSONValueResult(&res));
+	CHECK(stats.bytes_consumed == strlen(content));
+	CHECK(stats.nodes[JSON_VALUE_KIND_OBJECT] == 2 && stats.nodes[JSON_VALUE_KIND_ARRAY] == 1);
+	CHECK(stats.nodes[JSON_VALUE_KIND_NUMBER] == 2 && stats.nodes[JSON_VALUE_KIND_STRING] == 1);
+	CHECK(stats.nodes[JSON_VALUE_KIND_BOOLEAN] == 1 && stats.nodes[JSON_VALUE_KIND_NULL] == 1);
+	CHECK(stats.max_depth == 3);
+	CHECK(stats.string_bytes_escaped == 2);
+	CHECK(stats.allocations > 0);
+	deinit__JSONValueResult(&res);
+
+	// The statistics are reset by each parse
+	content = "{}";
+	res = parse_with_stats__JSON(content, strlen(content), &stats);
+	CHECK(!is_err__JSONValueResult(&res));
+	CHECK(stats.bytes_consumed == 2 && stats.nodes[JSON_VALUE_KIND_OBJECT] == 1 && stats.nodes[JSON_VALUE_KIND_NUMBER] == 0);
+	deinit__JSONValueResult(&res);
+
+	content = "{\"a\": tru}";
+	res = parse_with_stats__JSON(content, strlen(content), &stats);
+	CHECK(is_err__JSONValueResult(&res));
+
+	// With the other options
+	const JSONParseOptions options = { .pack_numbers = true, .stats = &stats };
+
+	content = "{\"a\": [1, 2, 3], \"b\": {\"c\": [4.5]}}";
+	res = parse_with_options__JSON(content, strlen(content), &options);
+	CHECK(!is_err__JSONValueResult(&res));
+	CHECK(get_kind__JSONValueArray(&get_member__JSONValue(&res.ok, "a", 1)->array) == JSON_VALUE_ARRAY_KIND_INT);
+	CHECK(stats.bytes_consumed == strlen(content) && stats.nodes[JSON_VALUE_KIND_NUMBER] == 4);
+	CHECK(stats.nodes[JSON_VALUE_KIND_OBJECT] == 2 && stats.max_depth == 3);
+	deinit__JSONValueResult(&res);
+}
+#endif
+
+JSONStatus
+decode_string__Test(const char *content, TestMessage *message)
+{
+	*message = (TestMessage){ .id = -1 };
+
+	return decode__JSON(content, strlen(content), &message_descriptor__Test, message);
+}
+
+void
+decode__Test(void)
+{
+	TestMessage message;
+
+	CHECK(is_ok__Test(decode_string__Test("{\"id\": 7, \"score\": 2.5, \"is_active\": true, \"name\": \"a\\\"b\", \"origin\": {\"x\": 1, \"y\": -2}, \"tags\": [3, 4]}", &message)));
+	CHECK(message.id == 7 && message.score == 2.5 && message.is_active);
+	CHECK(message.name.len == 4 && !memcmp(message.name.buffer, "a\\\"b", 4) && message.name.has_escapes);
+	CHECK(message.origin.x == 1 && message.origin.y == -2);
+	CHECK(message.tags_len == 2 && message.tags[0] == 3 && message.tags[1] == 4);
+
+	// Unknown members are skipped, null leaves the field untouched
+	CHECK(is_ok__Test(decode_string__Test("{\"extra\": {\"a\": [true, null, \"]\"]}, \"id\": null, \"score\": 1}", &message)));
+	CHECK(message.id == -1 && message.score == 1);
+
+	CHECK(!is_ok__Test(decode_string__Test("{\"tags\": [1, 2, 3, 4, 5]}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"id\": \"7\"}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"id\": 7", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("[]", &message)));
+
+	// Regression: the literals of skipped members were only checked on their
+	// first letter, and trailing content was accepted.
+	CHECK(!is_ok__Test(decode_string__Test("{\"a\":tru}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"a\":nulx, \"id\": 1}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"a\":1., \"id\": 1}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"a\":-, \"id\": 1}", &message)));
+	CHECK(is_ok__Test(decode_string__Test("{\"a\":true}", &message)));
+	CHECK(!is_ok__Test(decode_string__Test("{\"id\": 1} hello", &message)));
+	CHECK(is_ok__Test(decode_string__Test("{\"id\": 1} \n", &message)));
+
+	const char *content = "{\"id\": 3} {\"id\": 4}";
+	size_t end = 0;
+
+	message = (TestMessage){ 0 };
+	CHECK(is_ok__Test(decode_prefix__JSON(content, strlen(content), &message_descriptor__Test, &message, &end)));
+	CHECK(message.id == 3 && end == 9);
+
+	// Regression: arrays of arrays and structs without a descriptor made the
+	// decoding exit or crash, they are rejected by prepare instead.
+	JSONFieldDescriptor invalid_fields[] = {
+		JSON_ARRAY_FIELD(TestMessage, tags, tags_len, JSON_FIELD_KIND_ARRAY, NULL),
+		JSON_STRUCT_FIELD(TestMessage, origin, NULL),
+		JSON_ARRAY_FIELD(TestMessage, tags, tags_len, JSON_FIELD_KIND_STRUCT, NULL)
+	};
+
+	content = "{\"tags\": [[1]], \"origin\": {}}";
+
+	for (size_t i = 0; i < sizeof(invalid_fields) / sizeof(*invalid_fields); ++i) {
+		JSONStructDescriptor descriptor = { .fields = &invalid_fields[i], .fields_len = 1 };
+
+		CHECK(!prepare__JSONStructDescriptor(&descriptor) && !descriptor.table);
+		CHECK(!is_ok__Test(decode__JSON(content, strlen(content), &descriptor, &message)));
+	}
+
+	JSONStructDescriptor invalid = { .fields = invalid_fields, .fields_len = 1 };
+	JSONFieldDescriptor parent_fields[] = { JSON_STRUCT_FIELD(TestMessage, origin, &invalid) };
+	JSONStructDescriptor parent = { .fields = parent_fields, .fields_len = 1 };
+
+	CHECK(!prepare__JSONStructDescriptor(&parent) && !parent.table && !invalid.table);
+	CHECK(!is_ok__Test(decode__JSON(content, strlen(content), &parent, &message)));
+}
+
+void
+codegen__Test(void)
+{
+	// Parses with the parser generated from tests.schema.json
+	TestEvent event = { 0 };
+	const char *plain = "{\"id\": 1, \"ts\": 2, \"name\": \"a\"}";
+
+	CHECK(is_ok__Test(parse__TestEvent(plain, strlen(plain), &event)));
+	CHECK(event.id == 1 && event.ts == 2);
+	CHECK(event.name.len == 1 && event.name.buffer[0] == 'a');
+
+	// Escaped member names match as their decoded names
+	const char *escaped = "{\"i\\u0064\":3,\"t\\u0073\":4,\"\\u006eame\":\"b\"}";
+
+	memset(&event, 0, sizeof(event));
+	CHECK(is_ok__Test(parse__TestEvent(escaped, strlen(escaped), &event)));
+	CHECK(event.id == 3 && event.ts == 4);
+	CHECK(event.name.len == 1 && event.name.buffer[0] == 'b');
+
+	// Unknown members are skipped, even when they are escaped or longer than
+	// any known member
+	const char *unknown = "{\"id\":5,\"i\\u0065\":0,\"\\u0069d_long_name\":[1],\"ts\":6}";
+
+	CHECK(is_ok__Test(parse__TestEvent(unknown, strlen(unknown), &event)));
+	CHECK(event.id == 5 && event.ts == 6);
+
+	const char *missing[] = {
+		"{\"id\": 1}",
+		"{\"i\\u0065\": 1, \"ts\": 2}",
+	};
+
+	for (size_t i = 0; i < sizeof(missing) / sizeof(*missing); ++i) {
+		CHECK(!is_ok__Test(parse__TestEvent(missing[i], strlen(missing[i]), &event)));
+	}
+}
+
+JSONValue
+parse_projection__Test(const char *content, const char *const *paths, size_t paths_len)
+{
+	JSONProjection projection = init__JSONProjection();
+
+	for (size_t i = 0; i < paths_len; ++i) {
+		if (!add_path__JSONProjection(&projection, paths[i])) {
+			FATAL("Cannot add %s", paths[i]);
+		}
+	}
+
+	JSONValueResult res = parse_projection__JSON(content, strlen(content), &projection);
+
+	deinit__JSONProjection(&projection);
+
+	if (is_err__JSONValueResult(&res)) {
+		FATAL("Cannot project %s: %s", content, res.err.msg);
+	}
+
+	return res.ok;
+}
+
+void
+projection__Test(void)
+{
+	const char *content = "{\"user\": {\"id\": 7, \"name\": \"x\", \"tags\": [1, 2]}, \"events\": [{\"ts\": 1, \"v\": [true]}, 3, {\"v\": 2}, {\"ts\": \"a\\u0062\"}], \"big\": {\"deep\": [[[\"]\"]]]}}";
+	const char *paths[] = { "user.id", "events[*].ts", "missing.x" };
+	JSONValue value = parse_projection__Test(content, paths, 3);
+
+	// Elements which do not match are kept as null to preserve the indices
+	CHECK(is_string__Test(&value, "{\"user\":{\"id\":7},\"events\":[{\"ts\":1},null,{},{\"ts\":\"ab\"}]}"));
+	free__Test(value);
+
+	// A leaf keeps its whole value, and wins over the longer paths below it
+	const char *leaves[] = { "user", "user.id", "big.deep" };
+
+	value = parse_projection__Test(content, leaves, 3);
+	CHECK(is_string__Test(&value, "{\"user\":{\"id\":7,\"name\":\"x\",\"tags\":[1,2]},\"big\":{\"deep\":[[[\"]\"]]]}}"));
+	free__Test(value);
+
+	// Escaped member names are matched once unescaped
+	const char *escaped[] = { "a\\.b", "c" };
+
+	value = parse_projection__Test("{\"a.b\": 1, \"\\u0063\": 2, \"a\": {\"b\": 3}}", escaped, 2);
+	CHECK(is_string__Test(&value, "{\"a.b\":1,\"c\":2}"));
+	free__Test(value);
+
+	// The brackets and strings of the skipped subtrees are still checked
+	JSONProjection projection = init__JSONProjection();
+	const char *invalid[] = { "{\"a\": 1, \"b\": [1}", "{\"a\": 1, \"b\": \"x}", "{\"b\": {\"c\": 1}, \"a\": tru}", "{\"a\": 1" };
+
+	CHECK(add_path__JSONProjection(&projection, "a"));
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i) {
+		JSONValueResult res = parse_projection__JSON(invalid[i], strlen(invalid[i]), &projection);
+
+		CHECK(is_err__JSONValueResult(&res));
+		deinit__JSONValueResult(&res);
+	}
+
+	const char *malformed[] = { "", "a..b", "a[", "a[0]" };
+
+	for (size_t i = 0; i < sizeof(malformed) / sizeof(*malformed); ++i) {
+		CHECK(!add_path__JSONProjection(&projection, malformed[i]));
+	}
+
+	deinit__JSONProjection(&projection);
+}
+
+void
+skip__Test(void)
+{
+	const char *content = " {\"a\": [1, \"]}\\\"\", {\"b\": null}], \"c\": -1.5e3} tail";
+	size_t end = 0;
+
+	CHECK(is_ok__Test(skip_value__JSON(content, strlen(content), 0, &end)));
+	CHECK(end == strlen(content) - 5);
+	CHECK(is_ok__Test(skip_value__JSON(content, strlen(content), 7, &end)));
+	CHECK(content[end] == ',');
+
+	const struct {
+		const char *content;
+		bool is_valid;
+		size_t end;
+	} cases[] = {
+		{ "true", true, 4 },
+		{ "false,", true, 5 },
+		{ "null]", true, 4 },
+		{ "12", true, 2 },
+		{ "-0.5e+2 ", true, 7 },
+		{ "\"\"", true, 2 },
+		{ "[]", true, 2 },
+		{ "tru", false, 0 },
+		{ "nul", false, 0 },
+		{ "nope", false, 0 },
+		{ "1.", false, 0 },
+		{ "-", false, 0 },
+		{ "1e+", false, 0 },
+		{ "[1, 2", false, 0 },
+		{ "[}", false, 0 },
+		{ "\"abc", false, 0 },
+		{ "", false, 0 }
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		JSONStatus status = skip_value__JSON(cases[i].content, strlen(cases[i].content), 0, &end);
+
+		CHECK(is_ok__Test(status) == cases[i].is_valid);
+		CHECK(!cases[i].is_valid || end == cases[i].end);
+	}
+
+	// Deeper than the skip limit
+	size_t depth = 2000;
+	char *deep = malloc(depth * 2 + 1);
+
+	memset(deep, '[', depth);
+	memset(deep + depth, ']', depth);
+	deep[depth * 2] = '\0';
+	CHECK(!is_ok__Test(skip_value__JSON(deep, depth * 2, 0, &end)));
+	free(deep);
+}
+
+void
+validate__Test(void)
+{
+	const struct {
+		const char *content;
+		bool is_valid;
+	} cases[] = {
+		{ "{\"a\": [1, -2.5e+3, true, false, null, \"x\\u00e9\\n\"], \"b\": {}}", true },
+		{ " 12 ", true },
+		{ "\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"", true },
+		{ "\"\\ud83d\\ude00\"", true },
+		{ "[]", true },
+		{ "", false },
+		{ "{\"a\": 1,}", false },
+		{ "[1 2]", false },
+		{ "[01]", false },
+		{ "[1.]", false },
+		{ "[\"\\x\"]", false },
+		{ "[\"\\u12\"]", false },
+		{ "[\"a\tb\"]", false },
+		{ "{\"a\": 1} {}", false },
+		// Invalid UTF-8: truncated, overlong, surrogate, beyond U+10FFFF
+		{ "\"\xc3\"", false },
+		{ "\"\xc0\xaf\"", false },
+		{ "\"\xed\xa0\x80\"", false },
+		{ "\"\xf4\x90\x80\x80\"", false },
+		{ "\"\xff\"", false }
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		JSONStatus status = validate__JSON(cases[i].content, strlen(cases[i].content));
+
+		if (is_ok__Test(status) != cases[i].is_valid) {
+			fprintf(stderr, "  %s\n", cases[i].content);
+		}
+
+		CHECK(is_ok__Test(status) == cases[i].is_valid);
+	}
+
+	JSONStatus status = validate__JSON("[1, tru]", 8);
+
+	CHECK(!is_ok__Test(status) && status.err.offset == 4);
+
+	size_t depth = 1000;
+	char *deep = malloc(depth * 2);
+
+	memset(deep, '[', depth);
+	memset(deep + depth, ']', depth);
+	CHECK(is_ok__Test(validate__JSON(deep, depth * 2)));
+	CHECK(!is_ok__Test(validate__JSON(deep, depth * 2 - 1)));
+	free(deep);
+}
+
+bool
+write__Test(const char *buffer, size_t len, void *user_data)
+{
+	char *res = user_data;
+
+	strncat(res, buffer, len);
+
+	return true;
+}
+
+void
+format__Test(void)
+{
+	const char *content = "{ \"a\" : [1, 2, {\"b\": null}],\n\"c\": \"x y\", \"d\": -1.5e3, \"e\": {}, \"f\": [] }";
+	char res[512] = "";
+
+	CHECK(is_ok__Test(minify__JSON(content, strlen(content), &write__Test, res)));
+	CHECK(!strcmp(res, "{\"a\":[1,2,{\"b\":null}],\"c\":\"x y\",\"d\":-1.5e3,\"e\":{},\"f\":[]}"));
+
+	res[0] = '\0';
+	content = "{\"a\":[1,{}],\"b\":[]}";
+	CHECK(is_ok__Test(reformat__JSON(content, strlen(content), 2, &write__Test, res)));
+	CHECK(!strcmp(res, "{\n  \"a\": [\n    1,\n    {}\n  ],\n  \"b\": []\n}"));
+
+	// Regression: missing separators were not detected
+	const char *invalid[] = {
+		"[1 2]", "[true false]", "{\"a\" \"b\"}", "{\"a\": 1 \"b\": 2}", "[1,,2]", "[1,]", "{\"a\":1,}",
+		"[,1]", "[tru]", "[01]", "[1.]", "{1:2}", "{\"a\":}", "]", "[}", ":", "truex", "1 2"
+	};
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i) {
+		res[0] = '\0';
+
+		if (is_ok__Test(minify__JSON(invalid[i], strlen(invalid[i]), &write__Test, res))) {
+			fprintf(stderr, "  %s was minified to %s\n", invalid[i], res);
+			CHECK(false);
+		}
+	}
+}
+
+size_t
+read__Test(char *buffer, size_t len, void *user_data)
+{
+	struct TestSource *source = user_data;
+	size_t read_len = source->len - source->offset;
+
+	if (read_len > source->chunk_len) {
+		read_len = source->chunk_len;
+	}
+
+	if (read_len > len) {
+		read_len = len;
+	}
+
+	memcpy(buffer, source->content + source->offset, read_len);
+	source->offset += read_len;
+
+	return read_len;
+}
+
+void
+collect_sequence__Test(JSONSequenceIterator *iter, char *res)
+{
+	JSONValueResult value;
+
+	res[0] = '\0';
+
+	while (next__JSONSequenceIterator(iter, &value)) {
+		char *s = is_err__JSONValueResult(&value) ? NULL : to_string__JSONValue(&value.ok);
+
+		if (*res) {
+			strcat(res, " ");
+		}
+
+		strcat(res, s ? s : "ERR");
+		free(s);
+		deinit__JSONValueResult(&value);
+	}
+
+	deinit__JSONSequenceIterator(iter);
+}
+
+void
+sequence__Test(void)
+{
+	const struct {
+		const char *content;
+		const char *expected;
+	} cases[] = {
+		{ "true false null 12 -3.5e2 \"x\" [1] {\"a\":[]}", "true false null 12 -3.5e2 \"x\" [1] {\"a\":[]}" },
+		{ "{\"a\":1}\n{\"a\":2}\n", "{\"a\":1} {\"a\":2}" },
+		{ "\x1e{\"a\":1}\n\x1e[2]\n", "{\"a\":1} [2]" },
+		{ "", "" },
+		// Regression: invalid UTF-8 used to abort the process
+		{ "1\n\"\xff\xfe\"\n2\n", "1 ERR 2" },
+		{ "\x1e\"\xc3\x28\" 3\n\x1e" "4\n", "ERR 4" },
+		{ "{\"a\":tru}\n7\n", "ERR 7" },
+		{ "[1,\n2", "ERR" }
+	};
+	char res[512];
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		JSONSequenceIterator iter = init__JSONSequenceIterator(cases[i].content, strlen(cases[i].content));
+
+		collect_sequence__Test(&iter, res);
+
+		if (strcmp(res, cases[i].expected)) {
+			fprintf(stderr, "  %s gave %s\n", cases[i].content, res);
+		}
+
+		CHECK(!strcmp(res, cases[i].expected));
+
+		// The same sequence read in small chunks
+		for (size_t chunk_len = 1; chunk_len <= 7; chunk_len += 3) {
+			struct TestSource source = {
+				.content = cases[i].content,
+				.len = strlen(cases[i].content),
+				.offset = 0,
+				.chunk_len = chunk_len
+			};
+
+			iter = init_stream__JSONSequenceIterator(&read__Test, &source);
+			collect_sequence__Test(&iter, res);
+
+			if (strcmp(res, cases[i].expected)) {
+				fprintf(stderr, "  %s read by %zu gave %s\n", cases[i].content, chunk_len, res);
+			}
+
+			CHECK(!strcmp(res, cases[i].expected));
+		}
+	}
+}
+
+#ifdef JSON_THREADS
+void
+write_file__Test(const char *path, const char *content)
+{
+	FILE *file = fopen(path, "wb");
+
+	if (!file || fwrite(content, 1, strlen(content), file) != strlen(content) || fclose(file)) {
+		FATAL("Cannot write %s", path);
+	}
+}
+
+void
+count_batch__Test(size_t index, JSONValueResult res, void *user_data)
+{
+	size_t *oks = user_data;
+
+	// Called from several threads at once
+	if (!is_err__JSONValueResult(&res)) {
+		__atomic_fetch_add(&oks[index], 1, __ATOMIC_RELAXED);
+	}
+
+	deinit__JSONValueResult(&res);
+}
+
+void
+batch__Test(void)
+{
+	// Written in the working directory, which CTest sets to the build
+	// directory.
+	const char *contents[] = { "{\"a\": [1, 2]}", "{\"a\": tru}", "{}", "{\"b\": \"x\"}", "{\"c\": \"\xff\"}" };
+	const char *paths[] = {
+		"json_tests_batch_0.json",
+		"json_tests_batch_1.json",
+		"json_tests_batch_2.json",
+		"json_tests_batch_3.json",
+		"json_tests_batch_4.json",
+		"json_tests_batch_missing.json"
+	};
+	// Regression: invalid UTF-8 used to abort the process from a worker
+	const char *expected[] = { "{\"a\":[1,2]}", NULL, "{}", "{\"b\":\"x\"}", NULL, NULL };
+	size_t paths_len = sizeof(paths) / sizeof(*paths);
+	JSONValueResult results[sizeof(paths) / sizeof(*paths)];
+
+	for (size_t i = 0; i < sizeof(contents) / sizeof(*contents); ++i) {
+		write_file__Test(paths[i], contents[i]);
+	}
+
+	for (size_t threads = 1; threads <= 3; ++threads) {
+		parse_files__JSON(paths, paths_len, threads, results);
+
+		for (size_t i = 0; i < paths_len; ++i) {
+			CHECK(expected[i] ? !is_err__JSONValueResult(&results[i]) && is_string__Test(&results[i].ok, expected[i]) : is_err__JSONValueResult(&results[i]));
+			CHECK(i != 4 || results[i].err.kind == JSON_VALUE_RESULT_ERROR_PARSE_FAILED);
+			deinit__JSONValueResult(&results[i]);
+		}
+	}
+
+	size_t oks[sizeof(paths) / sizeof(*paths)] = { 0 };
+
+	parse_files_with_callback__JSON(paths, paths_len, 0, &count_batch__Test, oks);
+
+	for (size_t i = 0; i < paths_len; ++i) {
+		CHECK(oks[i] == (expected[i] ? 1 : 0));
+	}
+
+	for (size_t i = 0; i < sizeof(contents) / sizeof(*contents); ++i) {
+		remove(paths[i]);
+	}
+}
+#endif
+
+#ifdef JSON_THREADS
+void
+serialize_parallel__Test(void)
+{
+	// Large enough for the containers to be split at several depths
+	size_t len = 20000;
+	char *content = malloc(len * 64);
+	size_t content_len = 0;
+
+	content_len += sprintf(content + content_len, "{\"records\": [");
+
+	for (size_t i = 0; i < len; ++i) {
+		content_len += sprintf(content + content_len, "%s{\"id\": %zu, \"s\": \"\\u00e9%zu\", \"v\": [%zu.5, true, null]}", i ? ", " : "", i, i, i);
+	}
+
+	content_len += sprintf(content + content_len, "], \"index\": {");
+
+	for (size_t i = 0; i < len / 10; ++i) {
+		content_len += sprintf(content + content_len, "%s\"k%zu\": [%zu]", i ? ", " : "", i, i);
+	}
+
+	content_len += sprintf(content + content_len, "}, \"empty\": [], \"n\": 1}");
+
+	const JSONParseOptions options = { .pack_numbers = true };
+	JSONValue values[] = { parse__Test(content, NULL), parse__Test(content, &options), parse__Test("{\"a\": 1}", NULL) };
+
+	for (size_t i = 0; i < sizeof(values) / sizeof(*values); ++i) {
+		char *serial = to_string__JSONValue(&values[i]);
+
+		for (size_t threads = 1; threads <= 8; threads *= 2) {
+			char *parallel = to_string_parallel__JSONValue(&values[i], threads);
+
+			CHECK(parallel && !strcmp(parallel, serial));
+			free(parallel);
+
+			JSONStringChunks chunks;
+			size_t chunks_len = 0;
+			bool is_same = true;
+
+			CHECK(to_string_chunks__JSONValue(&values[i], threads, &chunks));
+
+			for (size_t j = 0; j < chunks.len; ++j) {
+				is_same = is_same && !memcmp(serial + chunks_len, chunks.buffer[j].buffer, chunks.buffer[j].len);
+				chunks_len += chunks.buffer[j].len;
+			}
+
+			CHECK(is_same && chunks_len == strlen(serial));
+			deinit__JSONStringChunks(&chunks);
+		}
+
+		free(serial);
+		free__Test(values[i]);
+	}
+
+	free(content);
+}
+#endif
+
+#ifdef JSON_THREADS
+void
+reclaimer__Test(void)
+{
+	JSONReclaimer reclaimer;
+	size_t len = 50;
+
+	CHECK(start__JSONReclaimer(&reclaimer, 4));
+
+	for (size_t i = 0; i < len; ++i) {
+		JSONValue value = parse__Test("{\"a\": [1, {\"b\": \"c\"}], \"d\": \"e\"}", NULL);
+
+		push__JSONReclaimer(&reclaimer, &value);
+	}
+
+	drain__JSONReclaimer(&reclaimer);
+
+	JSONReclaimerStats stats = get_stats__JSONReclaimer(&reclaimer);
+
+	// The values which did not fit in the queue were freed inline
+	CHECK(stats.pushed + stats.freed_inline == len);
+	CHECK(stats.reclaimed == stats.pushed);
+	CHECK(stats.max_len <= 4);
+
+	// The values still queued are freed by stop
+	JSONValue value = parse__Test("{\"a\": [1]}", NULL);
+
+	push__JSONReclaimer(&reclaimer, &value);
+	stop__JSONReclaimer(&reclaimer);
+}
+#endif
+
+void
+iterator__Test(void)
+{
+	JSONValue value = parse__Test("{\"z\": 1, \"a\": [2, \"x\", null], \"m\": {}, \"b\": true}", NULL);
+	const char *names[] = { "z", "a", "m", "b" };
+	JSONObjectIterator iter = init__JSONObjectIterator(&value);
+	const JSONValueObjectKeyValue *member;
+	size_t len = 0;
+
+	// The members come in insertion order
+	while ((member = next__JSONObjectIterator(&iter))) {
+		CHECK(len < 4 && member->key.len == 1 && member->key.buffer[0] == names[len][0]);
+		CHECK(member->value == get_member__JSONValue(&value, names[len], 1));
+		++len;
+	}
+
+	CHECK(len == 4 && !next__JSONObjectIterator(&iter));
+
+	JSONArrayIterator array_iter = init__JSONArrayIterator(get_member__JSONValue(&value, "a", 1));
+	const JSONValue *element;
+	const char *elements[] = { "2", "\"x\"", "null" };
+
+	len = 0;
+
+	while ((element = next__JSONArrayIterator(&array_iter))) {
+		CHECK(len < 3 && is_string__Test(element, elements[len]));
+		++len;
+	}
+
+	CHECK(len == 3);
+
+	CHECK(is_string__Test(&value, "{\"z\":1,\"a\":[2,\"x\",null],\"m\":{},\"b\":true}"));
+
+	// Nothing to iterate over in the other kinds of values, nor in empty ones
+	iter = init__JSONObjectIterator(get_member__JSONValue(&value, "a", 1));
+	CHECK(!next__JSONObjectIterator(&iter));
+	iter = init__JSONObjectIterator(get_member__JSONValue(&value, "m", 1));
+	CHECK(!next__JSONObjectIterator(&iter));
+	array_iter = init__JSONArrayIterator(&value);
+	CHECK(!next__JSONArrayIterator(&array_iter));
+
+	// Large objects grow their index without losing any member
+	char content[16384] = "{";
+
+	for (size_t i = 0; i < 1000; ++i) {
+		sprintf(content + strlen(content), "%s\"k%zu\": %zu", i ? ", " : "", i, i);
+	}
+
+	strcat(content, "}");
+	free__Test(value);
+	value = parse__Test(content, NULL);
+	iter = init__JSONObjectIterator(&value);
+	len = 0;
+
+	while ((member = next__JSONObjectIterator(&iter))) {
+		char name[16];
+
+		sprintf(name, "k%zu", len++);
+		CHECK(!strcmp(member->key.buffer, name) && get_member__JSONValue(&value, name, strlen(name)) == member->value);
+	}
+
+	CHECK(len == 1000);
+	free__Test(value);
+}
+
+void
+pointer__Test(void)
+{
+	JSONValue value = parse__Test("{\"a\": [1, {\"b\": \"c\"}], \"m~n\": 1, \"s/t\": 2, \"\": 3, \"10\": 4}", NULL);
+	const struct {
+		const char *pointer;
+		const char *expected; // NULL if nothing is pointed to
+	} cases[] = {
+		{ "", "{\"a\":[1,{\"b\":\"c\"}],\"m~n\":1,\"s/t\":2,\"\":3,\"10\":4}" },
+		{ "/a/1/b", "\"c\"" },
+		{ "/a/0", "1" },
+		{ "/m~0n", "1" },
+		{ "/s~1t", "2" },
+		{ "/", "3" },
+		{ "/10", "4" },
+		{ "/a/2", NULL },
+		{ "/a/01", NULL },
+		{ "/a/-", NULL },
+		{ "/a/1/b/c", NULL },
+		{ "/missing", NULL }
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		JSONPointer pointer;
+
+		CHECK(compile__JSONPointer(&pointer, cases[i].pointer, strlen(cases[i].pointer)));
+
+		JSONElement element;
+		const JSONValue *res = get__JSONPointer(&pointer, &value, &element);
+
+		CHECK(cases[i].expected ? is_string__Test(res, cases[i].expected) : !res);
+		deinit__JSONPointer(&pointer);
+	}
+
+	const char *malformed[] = { "a", "/~", "/~2", "/a~" };
+
+	for (size_t i = 0; i < sizeof(malformed) / sizeof(*malformed); ++i) {
+		JSONPointer pointer;
+
+		CHECK(!compile__JSONPointer(&pointer, malformed[i], strlen(malformed[i])));
+	}
+
+	free__Test(value);
+
+	// Regression: the elements of packed arrays could not be pointed to,
+	// replaced or removed
+	const JSONParseOptions options = { .pack_numbers = true, .pack_booleans = true };
+	JSONValue packed = parse__Test("{\"a\": [1, 2.5, 3], \"b\": [true, false]}", &options);
+	JSONPointer pointer;
+	JSONElement element;
+
+	CHECK(compile__JSONPointer(&pointer, "/a/1", 4));
+	CHECK(is_string__Test(get__JSONPointer(&pointer, &packed, &element), "2.5"));
+	deinit__JSONPointer(&pointer);
+	CHECK(compile__JSONPointer(&pointer, "/b/0", 4));
+	CHECK(is_string__Test(get__JSONPointer(&pointer, &packed, &element), "true"));
+	deinit__JSONPointer(&pointer);
+	CHECK(compile__JSONPointer(&pointer, "/a/3", 4));
+	CHECK(!get__JSONPointer(&pointer, &packed, &element));
+	deinit__JSONPointer(&pointer);
+
+	// The packed arrays on the path are unpacked, the clones keep them
+	JSONValueResult res = clone__JSONValue(&packed);
+	JSONValue copy = res.ok;
+
+	CHECK(!is_err__JSONValueResult(&res));
+	CHECK(set__Test(&copy, "/a/1", "\"x\""));
+	CHECK(set__Test(&copy, "/a/-", "4"));
+	CHECK(remove__Test(&copy, "/b/0"));
+	CHECK(!remove__Test(&copy, "/b/1"));
+	CHECK(is_string__Test(&copy, "{\"a\":[1,\"x\",3,4],\"b\":[false]}"));
+	CHECK(is_string__Test(&packed, "{\"a\":[1,2.5,3],\"b\":[true,false]}"));
+
+	free__Test(copy);
+	free__Test(packed);
+}
+
+bool
+collect__Test(const JSONValue *value, void *user_data)
+{
+	char *buffer = user_data;
+	char *s = to_string__JSONValue(value);
+
+	if (*buffer) {
+		strcat(buffer, " ");
+	}
+
+	strcat(buffer, s);
+	free(s);
+
+	return true;
+}
+
+void
+eval__Test(const JSONValue *value, const char *path, char *res)
+{
+	JSONPath compiled;
+
+	res[0] = '\0';
+
+	if (!compile__JSONPath(&compiled, path, strlen(path))) {
+		strcpy(res, "INVALID");
+
+		return;
+	}
+
+	eval__JSONPath(&compiled, value, &collect__Test, res);
+	deinit__JSONPath(&compiled);
+}
+
+void
+path__Test(void)
+{
+	JSONValue value = parse__Test(
+		"{\"store\": {\"book\": ["
+		"{\"author\": \"Rees\", \"price\": 8.95},"
+		"{\"author\": \"Waugh\", \"price\": 12.99, \"isbn\": \"0-553\"},"
+		"{\"author\": \"Tolkien\", \"price\": 22.99, \"isbn\": \"0-395\"}],"
+		"\"bicycle\": {\"price\": 19.95}},"
+		"\"ids\": [9007199254740993, 9007199254740992, 1.5, 2],"
+		"\"\": [1]}", NULL);
+	const struct {
+		const char *path;
+		const char *expected;
+	} cases[] = {
+		{ "$.store.book[*].author", "\"Rees\" \"Waugh\" \"Tolkien\"" },
+		{ "$..author", "\"Rees\" \"Waugh\" \"Tolkien\"" },
+		{ "$.store..price", "8.95 12.99 22.99 19.95" },
+		{ "$.store.book[-1].author", "\"Tolkien\"" },
+		{ "$.store.book[5]", "" },
+		{ "$.store.book[?(@.isbn)].author", "\"Waugh\" \"Tolkien\"" },
+		{ "$.store.book[?(@.price < 10)].author", "\"Rees\"" },
+		{ "$.store.book[?(@.author == 'Waugh')].price", "12.99" },
+		{ "$.store.book[?(@.author != \"Waugh\")].price", "8.95 22.99" },
+		{ "$['']", "[1]" },
+		// Integers beyond 2^53 are compared exactly
+		{ "$.ids[?(@ == 9007199254740993)]", "9007199254740993" },
+		{ "$.ids[?(@ > 1.5)]", "9007199254740993 9007199254740992 2" },
+		{ "store", "INVALID" },
+		{ "$.", "INVALID" },
+		{ "$[", "INVALID" },
+		{ "$..[1", "INVALID" },
+		{ "$..['abc", "INVALID" },
+		{ "$[?(@.a >)]", "INVALID" },
+		// Regression: the unterminated literal was freed twice
+		{ "$[?(@.a == 'abc", "INVALID" },
+		{ "$..[?(@.a == 'x", "INVALID" }
+	};
+	char res[512];
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		eval__Test(&value, cases[i].path, res);
+
+		if (strcmp(res, cases[i].expected)) {
+			fprintf(stderr, "  %s gave %s\n", cases[i].path, res);
+		}
+
+		CHECK(!strcmp(res, cases[i].expected));
+	}
+
+	free__Test(value);
+}
+
+bool
+collect_range__Test(size_t start, size_t end, void *user_data)
+{
+	struct TestMatches *matches = user_data;
+	size_t len = strlen(matches->buffer);
+
+	snprintf(matches->buffer + len, sizeof(matches->buffer) - len, "%s%.*s", len ? " " : "", (int)(end - start), matches->content + start);
+
+	return --matches->limit > 0;
+}
+
+JSONStatus
+scan_string__Test(const char *content, const char *path, size_t limit, struct TestMatches *matches)
+{
+	JSONPath compiled;
+
+	*matches = (struct TestMatches){ .content = content, .buffer = "", .limit = limit };
+
+	if (!compile__JSONPath(&compiled, path, strlen(path))) {
+		FATAL("Cannot compile %s", path);
+	}
+
+	JSONStatus status = scan__JSONPath(&compiled, content, strlen(content), &collect_range__Test, matches);
+
+	deinit__JSONPath(&compiled);
+
+	return status;
+}
+
+void
+scan__Test(void)
+{
+	struct TestMatches matches;
+	const char *nested = "{\"a\": {\"a\": {\"a\": 1}}, \"b\": [{\"a\": 2}], \"c\": \"{\\\"a\\\": 3}\"}";
+
+	// A match is reported before the matches it contains
+	CHECK(is_ok__Test(scan_string__Test(nested, "$..a", SIZE_MAX, &matches)));
+	CHECK(!strcmp(matches.buffer, "{\"a\": {\"a\": 1}} {\"a\": 1} 1 2"));
+
+	CHECK(is_ok__Test(scan_string__Test(nested, "$..a", 2, &matches)));
+	CHECK(!strcmp(matches.buffer, "{\"a\": {\"a\": 1}} {\"a\": 1}"));
+
+	CHECK(is_ok__Test(scan_string__Test(nested, "$.b[0].a", SIZE_MAX, &matches)));
+	CHECK(!strcmp(matches.buffer, "2"));
+
+	CHECK(is_ok__Test(scan_string__Test("{\"k\\u0065y\": 1, \"key\": 2}", "$.key", SIZE_MAX, &matches)));
+	CHECK(!strcmp(matches.buffer, "1 2"));
+
+	// Each value of a sequence is matched on its own
+	CHECK(is_ok__Test(scan_string__Test("{\"a\": 1}\n{\"b\": {\"a\": 2}}\n[{\"a\": 3}]\n", "$..a", SIZE_MAX, &matches)));
+	CHECK(!strcmp(matches.buffer, "1 2 3"));
+
+	CHECK(!is_ok__Test(scan_string__Test("{\"a\": tru}", "$.a", SIZE_MAX, &matches)));
+	CHECK(!is_ok__Test(scan_string__Test("{\"x\": tru, \"a\": 1}", "$.a", SIZE_MAX, &matches)));
+	CHECK(!is_ok__Test(scan_string__Test("{\"a\": {\"a\": [1,}}}", "$..a", SIZE_MAX, &matches)));
+	CHECK(!strcmp(matches.buffer, ""));
+	CHECK(!is_ok__Test(scan_string__Test("{\"a\": 1", "$.a", SIZE_MAX, &matches)));
+
+	JSONPath path;
+
+	CHECK(compile__JSONPath(&path, "$[-1]", 5));
+	CHECK(!is_ok__Test(scan__JSONPath(&path, "[1]", 3, &collect_range__Test, &matches)));
+	deinit__JSONPath(&path);
+}
+
+bool
+is_cell__Test(const JSONColumn *column, size_t row, const JSONValue *value)
+{
+	// `value` is the member of the record, NULL if it is missing
+	if (!value || value->kind == JSON_VALUE_KIND_NULL) {
+		return !is_valid__JSONColumn(column, row);
+	} else if (!is_valid__JSONColumn(column, row)) {
+		return false;
+	}
+
+	switch (column->kind) {
+		case JSON_COLUMN_KIND_BOOLEAN:
+			return value->kind == JSON_VALUE_KIND_BOOLEAN && column->booleans[row] == value->boolean;
+		case JSON_COLUMN_KIND_INT:
+			return value->kind == JSON_VALUE_KIND_NUMBER && column->ints[row] == strtoll(value->number.buffer, NULL, 10);
+		case JSON_COLUMN_KIND_DOUBLE:
+			return value->kind == JSON_VALUE_KIND_NUMBER && column->doubles[row] == strtod(value->number.buffer, NULL);
+		case JSON_COLUMN_KIND_STRING:
+			return value->kind == JSON_VALUE_KIND_STRING
+				&& column->offsets[row + 1] - column->offsets[row] == value->string.len
+				&& (!value->string.len || !memcmp(column->data + column->offsets[row], value->string.buffer, value->string.len));
+		case JSON_COLUMN_KIND_VALUE:
+			return column->values[row] == value;
+		default:
+			return false;
+	}
+}
+
+void
+columns__Test(void)
+{
+	JSONValue value = parse__Test(
+		"{\"records\": ["
+		"{\"id\": 1, \"price\": 2, \"name\": \"a\\tb\", \"ok\": true, \"mixed\": 1, \"tags\": [1]},"
+		"{\"id\": 2, \"price\": 2.5, \"name\": \"\", \"ok\": false, \"mixed\": \"x\", \"extra\": null},"
+		"{\"price\": null, \"id\": 3, \"ok\": null, \"tags\": {}},"
+		"7,"
+		"{\"id\": 4, \"name\": \"\\u00e9\", \"price\": -1e3, \"mixed\": [true]}"
+		"]}", NULL);
+	const JSONValue *records = get_member__JSONValue(&value, "records", 7);
+	JSONColumnSchema schema = init__JSONColumnSchema();
+	JSONColumns columns;
+
+	CHECK(infer__JSONColumnSchema(&schema, records));
+	CHECK(extract__JSONColumns(&columns, records, &schema));
+	CHECK(columns.rows == 5 && columns.len == 7);
+
+	const struct {
+		const char *name;
+		enum JSONColumnKind kind;
+	} expected[] = {
+		{ "id", JSON_COLUMN_KIND_INT },
+		{ "price", JSON_COLUMN_KIND_DOUBLE },
+		{ "name", JSON_COLUMN_KIND_STRING },
+		{ "ok", JSON_COLUMN_KIND_BOOLEAN },
+		{ "mixed", JSON_COLUMN_KIND_VALUE },
+		{ "tags", JSON_COLUMN_KIND_VALUE },
+		{ "extra", JSON_COLUMN_KIND_NULL }
+	};
+
+	// The columns come in the order their names were first seen, and hold
+	// the values of the records.
+	for (size_t i = 0; i < columns.len && i < sizeof(expected) / sizeof(*expected); ++i) {
+		const JSONColumn *column = &columns.columns[i];
+
+		CHECK(!strcmp(column->name, expected[i].name) && column->kind == expected[i].kind);
+		CHECK(get_column__JSONColumns(&columns, expected[i].name, strlen(expected[i].name)) == column);
+
+		size_t null_count = 0;
+
+		for (size_t row = 0; row < columns.rows; ++row) {
+			JSONElement element;
+			const JSONValue *record = get_element__JSONValue(records, row, &element);
+			const JSONValue *member = get_member__JSONValue(record, column->name, column->name_len);
+
+			if (!is_cell__Test(column, row, member)) {
+				fprintf(stderr, "  %s at row %zu\n", column->name, row);
+				CHECK(false);
+			}
+
+			null_count += !is_valid__JSONColumn(column, row);
+		}
+
+		CHECK(column->null_count == null_count);
+	}
+
+	CHECK(!get_column__JSONColumns(&columns, "missing", 7));
+	deinit__JSONColumns(&columns);
+
+	// A schema built by hand only extracts its columns, with their kinds
+	JSONColumnSchema only = init__JSONColumnSchema();
+
+	CHECK(add_column__JSONColumnSchema(&only, "price", 5, JSON_COLUMN_KIND_INT));
+	CHECK(extract__JSONColumns(&columns, records, &only));
+	CHECK(columns.len == 1 && columns.columns[0].kind == JSON_COLUMN_KIND_INT);
+	CHECK(is_valid__JSONColumn(&columns.columns[0], 0) && columns.columns[0].ints[0] == 2);
+	CHECK(!is_valid__JSONColumn(&columns.columns[0], 1));
+	deinit__JSONColumns(&columns);
+
+	CHECK(!infer__JSONColumnSchema(&only, &value));
+	CHECK(!extract__JSONColumns(&columns, &value, &only));
+
+	deinit__JSONColumnSchema(&only);
+	deinit__JSONColumnSchema(&schema);
+	free__Test(value);
+}
+
+void
+packed__Test(void)
+{
+	const JSONParseOptions options = { .pack_numbers = true, .pack_booleans = true };
+	const struct {
+		const char *content;
+		enum JSONValueArrayKind kind;
+		const char *expected;
+	} cases[] = {
+		{ "{\"a\": [1, 2, -3]}", JSON_VALUE_ARRAY_KIND_INT, "{\"a\":[1,2,-3]}" },
+		{ "{\"a\": [1, 2.5, -3e2]}", JSON_VALUE_ARRAY_KIND_DOUBLE, "{\"a\":[1,2.5,-300]}" },
+		{ "{\"a\": [true, false]}", JSON_VALUE_ARRAY_KIND_BOOLEAN, "{\"a\":[true,false]}" },
+		{ "{\"a\": [true, 1]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[true,1]}" },
+		{ "{\"a\": []}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[]}" },
+		{ "{\"a\": [9223372036854775807, -9223372036854775808]}", JSON_VALUE_ARRAY_KIND_INT, "{\"a\":[9223372036854775807,-9223372036854775808]}" },
+		{ "{\"a\": [9007199254740993]}", JSON_VALUE_ARRAY_KIND_INT, "{\"a\":[9007199254740993]}" },
+		{ "{\"a\": [9007199254740992, 0.5]}", JSON_VALUE_ARRAY_KIND_DOUBLE, "{\"a\":[9007199254740992,0.5]}" },
+		// Regression: -0 and integers beyond 2^53 did not round trip
+		{ "{\"a\": [-0]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[-0]}" },
+		{ "{\"a\": [1, -0.0]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[1,-0.0]}" },
+		{ "{\"a\": [9007199254740993, 0.5]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[9007199254740993,0.5]}" },
+		{ "{\"a\": [0.5, 9007199254740993]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[0.5,9007199254740993]}" },
+		{ "{\"a\": [-9007199254740993, 0.5]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[-9007199254740993,0.5]}" },
+		{ "{\"a\": [12345678901234567890123]}", JSON_VALUE_ARRAY_KIND_VALUES, "{\"a\":[12345678901234567890123]}" }
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i) {
+		JSONValue value = parse__Test(cases[i].content, &options);
+		const JSONValue *array = get_member__JSONValue(&value, "a", 1);
+
+		CHECK(get_kind__JSONValueArray(&array->array) == cases[i].kind);
+		CHECK(is_string__Test(&value, cases[i].expected));
+		free__Test(value);
+	}
+
+	// The kind is kept with the elements, so a value is no larger than a
+	// string and its own kind
+	CHECK(sizeof(JSONValueArray) <= sizeof(JSONValueString));
+	CHECK(sizeof(JSONValue) == sizeof(JSONValueString) + sizeof(void *));
+
+	JSONValue value = parse__Test("{\"a\": [10, 20, 30], \"b\": [true, false]}", &options);
+	const JSONValue *array = get_member__JSONValue(&value, "a", 1);
+	JSONElement element;
+
+	CHECK(is_string__Test(get_element__JSONValue(array, 1, &element), "20"));
+	CHECK(!get_element__JSONValue(array, 3, &element));
+
+	JSONArrayIterator iter = init__JSONArrayIterator(get_member__JSONValue(&value, "b", 1));
+	const JSONValue *boolean;
+	size_t len = 0;
+
+	while ((boolean = next__JSONArrayIterator(&iter))) {
+		CHECK(boolean->kind == JSON_VALUE_KIND_BOOLEAN && boolean->boolean == (len++ == 0));
+	}
+
+	CHECK(len == 2);
+	free__Test(value);
+}
+
+void
+shape__Test(void)
+{
+	const JSONParseOptions options = { .share_shapes = true };
+	const char *content = "{\"recs\": [{\"x\": 1, \"y\": \"a\"}, {\"x\": 2, \"y\": \"b\"}, {\"y\": \"c\", \"x\": 3}, {\"x\": 4}, {\"x\": 5, \"y\": \"d\"}]}";
+	JSONValue value = parse__Test(content, &options);
+	JSONValue plain = parse__Test(content, NULL);
+	const JSONValue *records = get_member__JSONValue(&value, "recs", 4);
+	const JSONValue *recs[5];
+
+	for (size_t i = 0; i < 5; ++i) {
+		JSONElement element;
+
+		recs[i] = get_element__JSONValue(records, i, &element);
+	}
+
+	// Consecutive records with the same names in the same order share them,
+	// through the map of each object, which is the only part of an object held
+	// in its value
+	CHECK(sizeof(JSONValueObject) == sizeof(JSONValueObjectKeyValueMap *));
+	CHECK(recs[0]->object.map->shape && recs[0]->object.map->shape == recs[1]->object.map->shape);
+	CHECK(recs[2]->object.map->shape != recs[0]->object.map->shape);
+	CHECK(recs[0]->object.map->members[0].key.buffer == recs[1]->object.map->members[0].key.buffer);
+	CHECK(eq__JSONValue(&value, &plain) && is_string__Test(&value, "{\"recs\":[{\"x\":1,\"y\":\"a\"},{\"x\":2,\"y\":\"b\"},{\"y\":\"c\",\"x\":3},{\"x\":4},{\"x\":5,\"y\":\"d\"}]}"));
+
+	// The cached lookups give the same members as the plain ones, whatever
+	// the shape of each record.
+	JSONMemberCache x = init__JSONMemberCache("x", 1);
+	JSONMemberCache y = init__JSONMemberCache("y", 1);
+
+	for (size_t i = 0; i < 5; ++i) {
+		CHECK(get_cached_member__JSONValue(recs[i], &x) == get_member__JSONValue(recs[i], "x", 1));
+		CHECK(get_cached_member__JSONValue(recs[i], &y) == get_member__JSONValue(recs[i], "y", 1));
+	}
+
+	CHECK(!get_cached_member__JSONValue(recs[3], &y) && !get_cached_member__JSONValue(records, &x));
+
+	// Duplicate names in a record which starts like the previous one
+	JSONValueResult res = parse_with_options__JSON("{\"r\": [{\"a\": 1, \"b\": 2}, {\"a\": 1, \"a\": 2}]}", 40, &options);
+
+	CHECK(is_err__JSONValueResult(&res));
+
+	free__Test(plain);
+	free__Test(value);
+}
+
+void
+intern__Test(void)
+{
+	JSONInternTable strings;
+
+	CHECK(init__JSONInternTable(&strings, 8, false));
+
+	const JSONParseOptions options = { .intern = &strings };
+	JSONValue a = parse__Test("{\"s\": \"ok\", \"t\": [\"ok\", \"e\\u0301\", \"a long string value\"]}", &options);
+	JSONValue b = parse__Test("{\"u\": \"ok\", \"v\": \"e\\u0301\", \"w\": \"a long string value\"}", &options);
+	const JSONValue *s = get_member__JSONValue(&a, "s", 1);
+	const JSONValue *t = get_member__JSONValue(&a, "t", 1);
+	JSONElement elements[3];
+	const JSONValue *t_ok = get_element__JSONValue(t, 0, &elements[0]);
+	const JSONValue *t_e = get_element__JSONValue(t, 1, &elements[1]);
+	const JSONValue *t_long = get_element__JSONValue(t, 2, &elements[2]);
+
+	// The short strings of both documents share one buffer, which they borrow
+	CHECK(s->string.buffer == t_ok->string.buffer);
+	CHECK(s->string.buffer == get_member__JSONValue(&b, "u", 1)->string.buffer && s->string.capacity == 0);
+	CHECK(t_e->string.buffer == get_member__JSONValue(&b, "v", 1)->string.buffer);
+	CHECK(s->string.buffer == intern__JSONInternTable(&strings, "ok", 2));
+
+	// The long ones are copied
+	CHECK(t_long->string.buffer != get_member__JSONValue(&b, "w", 1)->string.buffer && t_long->string.capacity != 0);
+	CHECK(is_string__Test(&a, "{\"s\":\"ok\",\"t\":[\"ok\",\"e\xcc\x81\",\"a long string value\"]}"));
+
+	// The table, not the documents, owns the interned buffers
+	free__Test(a);
+	CHECK(is_string__Test(&b, "{\"u\":\"ok\",\"v\":\"e\xcc\x81\",\"w\":\"a long string value\"}"));
+	free__Test(b);
+
+	CHECK(intern__JSONInternTable(&strings, "", 0) == intern__JSONInternTable(&strings, "", 0));
+	CHECK(strings.len == 3);
+	deinit__JSONInternTable(&strings);
+}
+
+void
+cache__Test(void)
+{
+	JSONParseCache cache;
+	const char *a = "{\"a\": 1}";
+	const char *b = "{\"b\": [2]}";
+	const char *c = "{\"c\": tru}";
+
+	CHECK(init__JSONParseCache(&cache, 2, NULL));
+
+	const JSONParseCacheEntry *first = parse__JSONParseCache(&cache, a, strlen(a));
+	const JSONParseCacheEntry *hit = parse__JSONParseCache(&cache, a, strlen(a));
+
+	// The same content gives the same entry
+	CHECK(first && first == hit && is_string__Test(&first->res.ok, "{\"a\":1}"));
+	release__JSONParseCache(&cache, hit);
+
+	JSONParseCacheStats stats = get_stats__JSONParseCache(&cache);
+
+	CHECK(stats.hits == 1 && stats.misses == 1 && stats.len == 1 && stats.bytes == strlen(a));
+
+	// Parse errors are cached too
+	const JSONParseCacheEntry *error = parse__JSONParseCache(&cache, c, strlen(c));
+
+	CHECK(error && is_err__JSONValueResult(&error->res));
+	release__JSONParseCache(&cache, error);
+	error = parse__JSONParseCache(&cache, c, strlen(c));
+	CHECK(error && is_err__JSONValueResult(&error->res));
+	release__JSONParseCache(&cache, error);
+
+	// `a` is the least recently used entry, it is evicted by `b` but stays
+	// valid until its holder releases it.
+	const JSONParseCacheEntry *second = parse__JSONParseCache(&cache, b, strlen(b));
+
+	stats = get_stats__JSONParseCache(&cache);
+	CHECK(stats.hits == 2 && stats.misses == 3 && stats.evictions == 1 && stats.len == 2);
+	CHECK(is_string__Test(&first->res.ok, "{\"a\":1}") && is_string__Test(&second->res.ok, "{\"b\":[2]}"));
+	release__JSONParseCache(&cache, first);
+	release__JSONParseCache(&cache, second);
+
+	// A content evicted is parsed again
+	first = parse__JSONParseCache(&cache, a, strlen(a));
+	stats = get_stats__JSONParseCache(&cache);
+	CHECK(first && stats.misses == 4 && stats.evictions == 2);
+	release__JSONParseCache(&cache, first);
+
+	// Regression: invalid UTF-8 used to abort the process
+	const char *invalid = "{\"a\": \"\xff\"}";
+
+	error = parse__JSONParseCache(&cache, invalid, strlen(invalid));
+	CHECK(error && is_err__JSONValueResult(&error->res) && error->res.err.kind == JSON_VALUE_RESULT_ERROR_PARSE_FAILED);
+	CHECK(parse__JSONParseCache(&cache, invalid, strlen(invalid)) == error);
+	release__JSONParseCache(&cache, error);
+	release__JSONParseCache(&cache, error);
+	release__JSONParseCache(&cache, NULL);
+	deinit__JSONParseCache(&cache);
+
+	// The options are used for every parse
+	const JSONParseOptions options = { .pack_numbers = true };
+
+	CHECK(init__JSONParseCache(&cache, 1, &options));
+	second = parse__JSONParseCache(&cache, b, strlen(b));
+	CHECK(second && get_kind__JSONValueArray(&get_member__JSONValue(&second->res.ok, "b", 1)->array) == JSON_VALUE_ARRAY_KIND_INT);
+	release__JSONParseCache(&cache, second);
+	deinit__JSONParseCache(&cache);
+}
+
+#ifdef JSON_THREADS
+void *
+read_document__Test(void *data)
+{
+	struct TestReader *reader = data;
+	const JSONValue *value = &reader->document->value;
+
+	reader->is_same = true;
+
+	for (size_t i = 0; i < 100; ++i) {
+		char *s = to_string__JSONValue(value);
+		JSONElement element;
+
+		reader->is_same = reader->is_same && s && !strcmp(s, "{\"a\":[1,{\"b\":\"c\"}]}");
+		reader->is_same = reader->is_same && get_element__JSONValue(get_member__JSONValue(value, "a", 1), 0, &element);
+		free(s);
+	}
+
+	release__JSONDocument(reader->document);
+
+	return NULL;
+}
+#endif
+
+void
+document__Test(void)
+{
+	JSONValue value = parse__Test("{\"a\": [1, {\"b\": \"c\"}]}", NULL);
+	JSONDocument *document = freeze__JSONDocument(&value);
+
+	CHECK(document && document->ref_count == 1);
+	CHECK(retain__JSONDocument(document) == document && document->ref_count == 2);
+	release__JSONDocument(document);
+	CHECK(document->ref_count == 1 && is_string__Test(&document->value, "{\"a\":[1,{\"b\":\"c\"}]}"));
+
+#ifdef JSON_THREADS
+	// Each reader holds the document and releases it, the last one to finish
+	// may free it.
+	struct TestReader readers[4];
+	pthread_t threads[4];
+
+	for (size_t i = 0; i < 4; ++i) {
+		readers[i].document = retain__JSONDocument(document);
+		CHECK(!pthread_create(&threads[i], NULL, &read_document__Test, &readers[i]));
+	}
+
+	release__JSONDocument(document);
+
+	for (size_t i = 0; i < 4; ++i) {
+		pthread_join(threads[i], NULL);
+		CHECK(readers[i].is_same);
+	}
+#else
+	release__JSONDocument(document);
+#endif
+}
+
+bool
+set__Test(JSONValue *root, const char *pointer, const char *value)
+{
+	// The value is parsed as a member, since the top-level value must be an
+	// object.
+	char content[256];
+	JSONPointer compiled;
+
+	snprintf(content, sizeof(content), "{\"v\": %s}", value);
+
+	JSONValue holder = parse__Test(content, NULL);
+
+	if (!compile__JSONPointer(&compiled, pointer, strlen(pointer))) {
+		FATAL("Cannot compile %s", pointer);
+	}
+
+	bool res = set__JSONPointer(&compiled, root, get_member__JSONValue(&holder, "v", 1));
+
+	deinit__JSONPointer(&compiled);
+	free__Test(holder);
+
+	return res;
+}
+
+bool
+remove__Test(JSONValue *root, const char *pointer)
+{
+	JSONPointer compiled;
+
+	if (!compile__JSONPointer(&compiled, pointer, strlen(pointer))) {
+		FATAL("Cannot compile %s", pointer);
+	}
+
+	bool res = remove__JSONPointer(&compiled, root);
+
+	deinit__JSONPointer(&compiled);
+
+	return res;
+}
+
+void
+copy_on_write__Test(void)
+{
+	const char *content = "{\"a\": [1, {\"b\": \"c\"}, [true, null]], \"recs\": [{\"x\": 1}, {\"x\": 2}], \"e\": {}}";
+	const char *original = "{\"a\":[1,{\"b\":\"c\"},[true,null]],\"recs\":[{\"x\":1},{\"x\":2}],\"e\":{}}";
+	JSONValue value = parse__Test(content, NULL);
+	JSONValueResult res = clone__JSONValue(&value);
+
+	CHECK(!is_err__JSONValueResult(&res));
+
+	JSONValue copy = res.ok;
+
+	CHECK(is_string__Test(&copy, original));
+	CHECK(set__Test(&copy, "/a/1/b", "{\"z\": 1}"));
+	CHECK(set__Test(&copy, "/recs/1/y", "\"t\""));
+	CHECK(set__Test(&copy, "/a/-", "7"));
+	CHECK(set__Test(&copy, "/a/4", "8"));
+	CHECK(set__Test(&copy, "/e/k", "[]"));
+	CHECK(remove__Test(&copy, "/recs/0"));
+	CHECK(remove__Test(&copy, "/a/2/0"));
+	CHECK(is_string__Test(&copy, "{\"a\":[1,{\"b\":{\"z\":1}},[null],7,8],\"recs\":[{\"x\":2,\"y\":\"t\"}],\"e\":{\"k\":[]}}"));
+
+	// The original is left untouched
+	CHECK(is_string__Test(&value, original));
+
+	CHECK(!set__Test(&copy, "/missing/k", "1"));
+	CHECK(!set__Test(&copy, "/a/9", "1"));
+	CHECK(!set__Test(&copy, "/a/x", "1"));
+	CHECK(!remove__Test(&copy, ""));
+	CHECK(!remove__Test(&copy, "/nope"));
+	CHECK(!remove__Test(&copy, "/a/9"));
+
+	// A clone of a clone shares with both
+	res = clone__JSONValue(&copy);
+
+	JSONValue second = res.ok;
+
+	CHECK(remove__Test(&second, "/a"));
+	CHECK(is_string__Test(&second, "{\"recs\":[{\"x\":2,\"y\":\"t\"}],\"e\":{\"k\":[]}}"));
+	free__Test(copy);
+	CHECK(is_string__Test(&second, "{\"recs\":[{\"x\":2,\"y\":\"t\"}],\"e\":{\"k\":[]}}"));
+	CHECK(set__Test(&second, "", "[1]"));
+	CHECK(is_string__Test(&second, "[1]"));
+	free__Test(second);
+	CHECK(is_string__Test(&value, original));
+
+	// Packed arrays are unpacked to be edited
+	const JSONParseOptions options = { .pack_numbers = true, .share_shapes = true };
+	JSONValue packed = parse__Test("{\"n\": [1, 2], \"recs\": [{\"x\": 1}, {\"x\": 2}]}", &options);
+
+	CHECK(set__Test(&packed, "/n/0", "3"));
+	CHECK(is_string__Test(&packed, "{\"n\":[3,2],\"recs\":[{\"x\":1},{\"x\":2}]}"));
+	CHECK(set__Test(&packed, "/n", "[3]"));
+	CHECK(set__Test(&packed, "/recs/1/x", "5"));
+	CHECK(is_string__Test(&packed, "{\"n\":[3],\"recs\":[{\"x\":1},{\"x\":5}]}"));
+	free__Test(packed);
+	free__Test(value);
+}
+
+bool
+collect_diff__Test(enum JSONDiffKind kind, const char *pointer, size_t pointer_len, const JSONValue *before, const JSONValue *after, void *user_data)
+{
+	static const char *kinds[] = { "+", "-", "~" };
+	struct TestDiff *diff = user_data;
+	size_t len = strlen(diff->buffer);
+
+	(void)before;
+	(void)after;
+	snprintf(diff->buffer + len, sizeof(diff->buffer) - len, "%s%s%.*s", len ? " " : "", kinds[kind], (int)pointer_len, pointer);
+	++diff->len;
+
+	return true;
+}
+
+void
+hash__Test(void)
+{
+	const JSONParseOptions options = { .pack_numbers = true, .pack_booleans = true, .share_shapes = true };
+	const char *a_content = "{\"a\": 1, \"n\": [1, 2, 3e0], \"f\": [1.5, 2], \"t\": [true, false], \"o\": {\"x\": [1, {\"z\": \"q\"}]}, \"s/~\": \"k\"}";
+	const char *b_content = "{\"s/~\": \"k\", \"o\": {\"x\": [1.0, {\"z\": \"q\"}]}, \"t\": [true, false], \"f\": [15e-1, 2.0], \"n\": [1.0, 2, 3], \"a\": 1e0}";
+	JSONValue a = parse__Test(a_content, NULL);
+	JSONValue b = parse__Test(b_content, NULL);
+	JSONValue packed_a = parse__Test(a_content, &options);
+	JSONValue packed_b = parse__Test(b_content, &options);
+
+	// The member order and the spelling of numbers do not matter
+	CHECK(hash__JSONValue(&a) == hash__JSONValue(&b));
+	CHECK(hash__JSONValue(&a) == hash__JSONValue(&packed_a));
+	CHECK(hash__JSONValue(&packed_a) == hash__JSONValue(&packed_b));
+	CHECK(eq__JSONValue(&a, &b) && eq__JSONValue(&a, &packed_b) && eq__JSONValue(&packed_a, &b));
+
+	struct TestDiff diff = { .buffer = "", .len = 0 };
+
+	CHECK(diff__JSONValue(&a, &packed_b, &collect_diff__Test, &diff));
+	CHECK(diff.len == 0);
+
+	JSONValue c = parse__Test("{\"a\": 2, \"n\": [1, 2], \"t\": [true, true], \"o\": {\"x\": [1, {\"z\": \"r\"}]}, \"s/~\": \"k\", \"new\": null}", &options);
+
+	CHECK(!eq__JSONValue(&a, &c));
+	CHECK(diff__JSONValue(&a, &c, &collect_diff__Test, &diff));
+	CHECK(!strcmp(diff.buffer, "~/a -/n/2 -/f ~/t/1 ~/o/x/1/z +/new"));
+
+	// Edits only invalidate the hashes along their path
+	JSONValueResult res = clone__JSONValue(&a);
+	JSONValue copy = res.ok;
+
+	CHECK(eq__JSONValue(&a, &copy));
+	CHECK(set__Test(&copy, "/o/x/1/z", "\"r\""));
+	CHECK(!eq__JSONValue(&a, &copy) && hash__JSONValue(&a) != hash__JSONValue(&copy));
+	CHECK(set__Test(&copy, "/o/x/1/z", "\"q\""));
+	CHECK(eq__JSONValue(&a, &copy) && hash__JSONValue(&a) == hash__JSONValue(&copy));
+
+	uint64_t hash = hash__JSONValue(&b);
+
+	CHECK(set__Test(&b, "/s~1~0", "\"K\""));
+	CHECK(hash__JSONValue(&b) != hash && !eq__JSONValue(&a, &b));
+
+	diff = (struct TestDiff){ .buffer = "", .len = 0 };
+	CHECK(diff__JSONValue(&a, &b, &collect_diff__Test, &diff));
+	CHECK(!strcmp(diff.buffer, "~/s~1~0"));
+
+	// Values which only differ in their numbers beyond 2^53
+	JSONValue big = parse__Test("{\"n\": 9007199254740993}", NULL);
+	JSONValue rounded = parse__Test("{\"n\": 9007199254740992}", NULL);
+
+	CHECK(!eq__JSONValue(&big, &rounded));
+
+	// Numbers beyond int64_t and doubles are compared as decimals
+	const struct {
+		const char *a;
+		const char *b;
+		bool is_eq;
+	} numbers[] = {
+		{ "{\"n\": 12345678901234567890123}", "{\"n\": 12345678901234567890124}", false },
+		{ "{\"n\": 12345678901234567890123}", "{\"n\": 1234567890123456789012.3e1}", true },
+		{ "{\"n\": 1e400}", "{\"n\": 2e400}", false },
+		{ "{\"n\": 1e400}", "{\"n\": 10E+399}", true },
+		{ "{\"n\": -1e400}", "{\"n\": 1e400}", false },
+		{ "{\"n\": 0.1}", "{\"n\": 0.10000000000000001}", false },
+		{ "{\"n\": 0.1}", "{\"n\": 1e-1}", true },
+		{ "{\"n\": 0.00120}", "{\"n\": 12e-4}", true },
+		{ "{\"n\": 9223372036854775808}", "{\"n\": 9.223372036854775808e18}", true },
+		{ "{\"n\": -9223372036854775808}", "{\"n\": -92233720368547758.08e2}", true },
+		{ "{\"n\": 100}", "{\"n\": 1.00e2}", true },
+		{ "{\"n\": 0}", "{\"n\": -0.0e5}", true },
+		{ "{\"n\": 1.5}", "{\"n\": 15}", false },
+	};
+
+	for (size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); ++i) {
+		JSONValue x = parse__Test(numbers[i].a, NULL);
+		JSONValue y = parse__Test(numbers[i].b, NULL);
+
+		CHECK(eq__JSONValue(&x, &y) == numbers[i].is_eq);
+		CHECK(!numbers[i].is_eq || hash__JSONValue(&x) == hash__JSONValue(&y));
+		free__Test(x);
+		free__Test(y);
+	}
+
+	// Packed doubles are compared by their shortest decimals
+	JSONValue spelled = parse__Test("{\"n\": [0.1, 1e300, 2.50, -3]}", NULL);
+	JSONValue packed = parse__Test("{\"n\": [1e-1, 1.0e300, 2.5, -3.0]}", &options);
+
+	CHECK(get_kind__JSONValueArray(&packed.object.map->members[0].value->array) == JSON_VALUE_ARRAY_KIND_DOUBLE);
+	CHECK(eq__JSONValue(&spelled, &packed) && hash__JSONValue(&spelled) == hash__JSONValue(&packed));
+
+	free__Test(spelled);
+	free__Test(packed);
+	free__Test(a);
+	free__Test(b);
+	free__Test(packed_a);
+	free__Test(packed_b);
+	free__Test(c);
+	free__Test(copy);
+	free__Test(big);
+	free__Test(rounded);
+}
+
+int
+main(void)
+{
+	if (!prepare__JSONStructDescriptor(&message_descriptor__Test)) {
+		FATAL("Cannot prepare the descriptor");
+	}
+
+#ifdef JSON_STATS
+	stats__Test();
+#endif
+	decode__Test();
+	codegen__Test();
+	projection__Test();
+	skip__Test();
+	validate__Test();
+	format__Test();
+	sequence__Test();
+#ifdef JSON_THREADS
+	batch__Test();
+#endif
+#ifdef JSON_THREADS
+	serialize_parallel__Test();
+#endif
+#ifdef JSON_THREADS
+	reclaimer__Test();
+#endif
+	iterator__Test();
+	pointer__Test();
+	path__Test();
+	scan__Test();
+	columns__Test();
+	packed__Test();
+	shape__Test();
+	intern__Test();
+	cache__Test();
+	document__Test();
+	copy_on_write__Test();
+	hash__Test();
+
+	deinit__JSONStructDescriptor(&message_descriptor__Test);
+
+	printf("%zu checks, %zu failures\n", checks, failures);
+
+	return failures ? 1 : 0;
+}